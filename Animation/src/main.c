@@ -1,13 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h> // for srand().
+#include <time.h> // for seeding the RNG.
 
 #include "animation.h"
 
 
 int main(void)
 {
-	srand(time(NULL)); // Initialization of the pseudo-random number generator.
+	setRandomSeed(time(NULL)); // Initialization of the pseudo-random number generator.
 
 
 	// Animating the recognition of the medical dataset:
@@ -1,12 +1,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
 
 #include <mysql.h>
 
 #include "api.h"
 #include "parsing.h"
 #include "processing.h"
+#include "medrec_cache.h"
 
 
 #ifdef LOCAL_TESTING
@@ -24,65 +26,96 @@
 typedef enum {SYMPTOM_CHECK, ILLNESS_CHECK} CheckMode;
 
 
-static MYSQL *mysql;
-static char query_buffer[MAX_QUERY_LENGTH];
+// Max number of diagnostics whose illnesses and probabilities are written by a single multi-row INSERT:
+#define MAX_DIAGS_PER_INSERT DIAG_BATCH_SIZE
 
+// Enough for the longest multi-row INSERT, with less than 48 characters per row:
+#define MAX_INSERT_QUERY_LENGTH (100 + 48 * MAX_DIAGS_PER_INSERT * DIAG_ILLNESS_NUMBER)
 
-// MySQL queries:
 
+// Each thread has its own connection to the database:
+static __thread MYSQL *mysql;
+static __thread char query_buffer[MAX_QUERY_LENGTH];
+static __thread char insert_query_buffer[MAX_INSERT_QUERY_LENGTH];
+static __thread int insert_query_length;
+
+
+// MySQL prepared statements. Parameters are marked by '?':
+
+// Args: id_diag
 #define READ_DIAGNOSTIC_QUERY															\
-	"SELECT doct.id_diag, date_diag, doct.criticity, ill.id_ill, illp.probability\n"	\
+	"SELECT date_diag, doct.criticity, ill.id_ill, illp.probability\n"					\
 	"FROM doctor_diagnostic as doct\n"													\
 	"INNER JOIN illness_probability as illp ON doct.id_diag = illp.id_diag\n"			\
 	"INNER JOIN illness as ill ON ill.id_ill = illp.id_ill\n"							\
-	"WHERE doct.id_diag = %d;"															\
+	"WHERE doct.id_diag = ?;"															\
 
 
+// Args: id_socdet
 #define GET_MEDREC_ID_QUERY																\
 	"SELECT patient.id_medrec\n"														\
 	"FROM patient_medical_record as patient\n"											\
 	"INNER JOIN social_details as social ON patient.id_socdet = social.id_socdet\n"		\
-	"WHERE patient.id_socdet = %d;"														\
+	"WHERE patient.id_socdet = ?;"														\
 
 
-#define READ_MEDREC_DIAGS_NUMBER_QUERY													\
-	"SELECT COUNT(doctor.id_medrec) as diagnosticNumber\n"								\
+// Medical record info, followed by its last diagnostics with their illnesses: one row per illness,
+// or a single row with NULL diagnostic columns if there is none. Args: id_socdet, MAX_DIAGS_READ, id_socdet
+#define READ_MEDREC_QUERY																\
+	"SELECT patient.id_medrec, social.gender, social.birthdate, patient.id_blgrp,\n"	\
+	"patient.weight, patient.height,\n"													\
+	"last.id_diag, last.date_diag, last.criticity, illp.id_ill, illp.probability\n"		\
 	"FROM patient_medical_record as patient\n"											\
 	"INNER JOIN social_details as social ON patient.id_socdet = social.id_socdet\n"		\
-	"INNER JOIN doctor_diagnostic as doctor ON patient.id_medrec = doctor.id_medrec\n"	\
-	"WHERE patient.id_socdet = %d;"														\
+	"LEFT JOIN (\n"																		\
+	"	SELECT doctor.id_diag, doctor.date_diag, doctor.criticity, doctor.id_medrec\n"	\
+	"	FROM doctor_diagnostic as doctor\n"												\
+	"	INNER JOIN patient_medical_record as p ON doctor.id_medrec = p.id_medrec\n"		\
+	"	WHERE p.id_socdet = ?\n"														\
+	"	ORDER BY doctor.id_diag DESC\n"													\
+	"	LIMIT ?\n"																		\
+	") as last ON last.id_medrec = patient.id_medrec\n"									\
+	"LEFT JOIN illness_probability as illp ON last.id_diag = illp.id_diag\n"			\
+	"WHERE patient.id_socdet = ?\n"														\
+	"ORDER BY last.id_diag DESC;"														\
 
 
-#define READ_MEDREC_INFO_QUERY															\
-	"SELECT patient.id_medrec, social.gender, social.birthdate, patient.id_blgrp,\n"	\
-	"patient.weight, patient.height\n"													\
-	"FROM patient_medical_record as patient\n"											\
-	"INNER JOIN social_details as social ON patient.id_socdet = social.id_socdet\n"		\
-	"WHERE patient.id_socdet = %d;"														\
+typedef enum {READ_DIAGNOSTIC_STMT, GET_MEDREC_ID_STMT, READ_MEDREC_STMT, STATEMENT_NUMBER} StatementID;
 
+static const char *const StatementQueries[STATEMENT_NUMBER] = {READ_DIAGNOSTIC_QUERY, GET_MEDREC_ID_QUERY, READ_MEDREC_QUERY};
 
-#define READ_MEDREC_LAST_DIAGS_QUERY													\
-	"SELECT doctor.id_diag\n"															\
-	"FROM doctor_diagnostic as doctor\n"												\
-	"WHERE doctor.id_medrec = %d\n"														\
-	"ORDER BY doctor.id_diag DESC\n"													\
-	"LIMIT %d;"																			\
+// Prepared once per connection, on first use:
+static __thread MYSQL_STMT *Statements[STATEMENT_NUMBER];
 
 
-// Args: ID_AUTO_INCREMENT, criticity, id_med_rec, ID_DOC_DEFAULT
+// 'my_bool' or 'bool', depending on the MySQL version:
+typedef __typeof__(*((MYSQL_BIND*) NULL) -> is_null) BindBool;
+
+// Binding of parameters and results, from/to the given variables:
+#define BIND_INT(ptr) {.buffer_type = MYSQL_TYPE_LONG, .buffer = (ptr)}
+#define BIND_FLOAT(ptr) {.buffer_type = MYSQL_TYPE_FLOAT, .buffer = (ptr)}
+#define BIND_STRING(str, size, length_ptr) {.buffer_type = MYSQL_TYPE_STRING, .buffer = (str), .buffer_length = (size), .length = (length_ptr)}
+#define BIND_NULLABLE_INT(ptr, is_null_ptr) {.buffer_type = MYSQL_TYPE_LONG, .buffer = (ptr), .is_null = (is_null_ptr)}
+
+
+// Text queries:
+
+// Multi-row inserts, followed by comma separated rows:
+
 #define INSERT_DIAG_INFO_QUERY															\
-	"INSERT INTO doctor_diagnostic VALUES(%d, %f, CURDATE(), %d, %d);"					\
+	"INSERT INTO doctor_diagnostic VALUES\n"											\
 
 
-// Args: id_diag, illness, probability
 #define INSERT_DIAG_ILLNESS_AND_PROBA_QUERY												\
-	"INSERT INTO illness_probability VALUES(%d, %d, %f);"								\
+	"INSERT INTO illness_probability VALUES\n"											\
 
 
-// Args: id_diag, illness, probability, 5 times
-#define INSERT_DIAG_ILLNESS_AND_PROBA_QUERY_PACKED_5									\
-	"INSERT INTO illness_probability VALUES\n"											\
-	"(%d, %d, %f), (%d, %d, %f), (%d, %d, %f), (%d, %d, %f), (%d, %d, %f);"				\
+// Args: ID_AUTO_INCREMENT, criticity, id_med_rec, ID_DOC_DEFAULT
+#define DIAG_INFO_ROW "(%d, %f, CURDATE(), %d, %d)"
+
+
+// Args: id_diag, illness, probability
+#define DIAG_ILLNESS_AND_PROBA_ROW "(%d, %d, %f)"
 
 
 #define FETCH_ILLNESSES_NUMBER_QUERY													\
@@ -126,6 +159,135 @@ static char query_buffer[MAX_QUERY_LENGTH];
 })
 
 
+// Appends some text formatted like printf() to 'insert_query_buffer'. Returns 1 on success, 0 if the buffer is too small:
+static int appendToInsertQuery(const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+
+	int nb_writtenChar = vsnprintf(insert_query_buffer + insert_query_length,
+		MAX_INSERT_QUERY_LENGTH - insert_query_length, format, args);
+
+	va_end(args);
+
+	if (nb_writtenChar < 0 || nb_writtenChar >= MAX_INSERT_QUERY_LENGTH - insert_query_length)
+	{
+		printf("\n'insert_query_buffer' too small to hold the current query.\n");
+		return 0;
+	}
+
+	insert_query_length += nb_writtenChar;
+
+	return 1;
+}
+
+
+// Sends the query contained in 'insert_query_buffer'. Returns 1 on success, 0 else:
+static int sendInsertQuery(void)
+{
+	if (DEBUG_MODE)
+		printf("\nCurrent MySQL query:\n\n%s\n\n", insert_query_buffer);
+
+	if (mysql_real_query(mysql, insert_query_buffer, insert_query_length) != 0)
+	{
+		printf("\nInvalid MySQL query:\n\n%s\n\n%s\n\n", insert_query_buffer, mysql_error(mysql));
+		return 0;
+	}
+
+	return 1;
+}
+
+
+// Returns the given prepared statement of the calling thread, preparing it if needed. Returns NULL on failure.
+static MYSQL_STMT* getStatement(StatementID id)
+{
+	if (Statements[id] != NULL)
+		return Statements[id];
+
+	MYSQL_STMT *stmt = mysql_stmt_init(mysql);
+
+	if (stmt == NULL)
+	{
+		printf("\nNot enough memory to create a MySQL statement.\n");
+		return NULL;
+	}
+
+	if (mysql_stmt_prepare(stmt, StatementQueries[id], strlen(StatementQueries[id])) != 0)
+	{
+		printf("\nCould not prepare the MySQL statement:\n\n%s\n\n%s\n\n", StatementQueries[id], mysql_stmt_error(stmt));
+		mysql_stmt_close(stmt);
+		return NULL;
+	}
+
+	Statements[id] = stmt;
+
+	return stmt;
+}
+
+
+// Executes the given prepared statement with the given parameters, and fetches its whole result set,
+// whose rows will be written in 'results' by mysql_stmt_fetch(). Returns the statement on success, NULL else.
+// mysql_stmt_free_result() must be called once the rows have been read.
+static MYSQL_STMT* executeStatement(StatementID id, MYSQL_BIND *params, MYSQL_BIND *results)
+{
+	MYSQL_STMT *stmt = getStatement(id);
+
+	if (stmt == NULL)
+		return NULL;
+
+	if (DEBUG_MODE)
+		printf("\nCurrent MySQL statement:\n\n%s\n\n", StatementQueries[id]);
+
+	if (mysql_stmt_bind_param(stmt, params) || mysql_stmt_execute(stmt) ||
+		mysql_stmt_bind_result(stmt, results) || mysql_stmt_store_result(stmt))
+	{
+		printf("\nInvalid MySQL statement:\n\n%s\n\n%s\n\n", StatementQueries[id], mysql_stmt_error(stmt));
+		mysql_stmt_free_result(stmt);
+		return NULL;
+	}
+
+	return stmt;
+}
+
+
+// Returns 1 if a row has been fetched, 0 else:
+static inline int fetchRow(MYSQL_STMT *stmt)
+{
+	int status = mysql_stmt_fetch(stmt);
+
+	return status == 0 || status == MYSQL_DATA_TRUNCATED; // Truncated strings are still usable.
+}
+
+
+// Must be called once before any thread (apart from the main one) uses the database. Returns 1 on success, 0 else.
+int initDatabaseLibrary(void)
+{
+	if (mysql_library_init(0, NULL, NULL) != 0)
+	{
+		printf("\nCould not initialize the MySQL library.\n");
+		return 0;
+	}
+
+	return 1;
+}
+
+
+// Must be called by each new thread using the database, before any query:
+void initDatabaseThread(void)
+{
+	mysql_thread_init();
+}
+
+
+// Disconnects the calling thread from the database, and frees its MySQL ressources. Call this before the thread ends:
+void endDatabaseThread(void)
+{
+	disconnectFromDatabase();
+
+	mysql_thread_end();
+}
+
+
 // Does nothing if already connected! Returns 1 on success, 0 else.
 int connectToDatabase(void)
 {
@@ -184,6 +346,14 @@ void disconnectFromDatabase(void)
 	if (mysql == NULL)
 		return;
 
+	for (int i = 0; i < STATEMENT_NUMBER; ++i)
+	{
+		if (Statements[i] != NULL)
+			mysql_stmt_close(Statements[i]);
+
+		Statements[i] = NULL;
+	}
+
 	mysql_close(mysql);
 	free(mysql);
 	mysql = NULL;
@@ -208,15 +378,19 @@ int readDiagnostic(Diagnostic *diag, int id_diag)
 		return 0;
 	}
 
-	MYSQL_RES *result = NULL;
-	MYSQL_ROW row = NULL;
+	char date_diag[DATE_MAX_LENGTH];
+	unsigned long date_length;
+	float criticity, probability;
+	int id_ill;
 
-	if (!sendQuery(READ_DIAGNOSTIC_QUERY, id_diag))
-		return 0;
+	MYSQL_BIND params[] = {BIND_INT(&id_diag)};
 
-	result = mysql_use_result(mysql);
+	MYSQL_BIND results[] = {BIND_STRING(date_diag, DATE_MAX_LENGTH, &date_length), BIND_FLOAT(&criticity),
+		BIND_INT(&id_ill), BIND_FLOAT(&probability)};
 
-	if (result == NULL)
+	MYSQL_STMT *stmt = executeStatement(READ_DIAGNOSTIC_STMT, params, results);
+
+	if (stmt == NULL)
 	{
 		printf("Cannot output a diagnostic: invalid MySQL query.\n\n");
 		return 0;
@@ -226,16 +400,22 @@ int readDiagnostic(Diagnostic *diag, int id_diag)
 
 	diag -> id_diag = id_diag;
 
-	while (illness_index < DIAG_ILLNESS_NUMBER && (row = mysql_fetch_row(result))) // assignment and testing!
+	while (illness_index < DIAG_ILLNESS_NUMBER && fetchRow(stmt))
 	{
-		snprintf(diag -> date_diag, DATE_MAX_LENGTH - 1, "%s", row[1]);
-		diag -> criticity = strtof(row[2], NULL);
-		diag -> illnessArray[illness_index] = atoi(row[3]) - 1; // Illnesses starts from 1 in the database!
-		diag -> illnessProbabilityArray[illness_index] = strtof(row[4], NULL);
+		snprintf(diag -> date_diag, DATE_MAX_LENGTH - 1, "%.*s", (int) date_length, date_diag);
+		diag -> criticity = criticity;
+		diag -> illnessArray[illness_index] = id_ill - 1; // Illnesses starts from 1 in the database!
+		diag -> illnessProbabilityArray[illness_index] = probability;
 		++illness_index;
 	}
 
-	mysql_free_result(result);
+	mysql_stmt_free_result(stmt);
+
+	if (illness_index == 0) // 'date_diag' and the other outputs have not been set.
+	{
+		printf("Cannot find the diagnostic: %d\n", id_diag);
+		return 0;
+	}
 
 	return 1;
 }
@@ -250,174 +430,154 @@ int getMedicalRecordId(int id_socdet)
 		return 0;
 	}
 
-	MYSQL_RES *result = NULL;
-	MYSQL_ROW row = NULL;
+	int id_medrec = 0;
 
-	if (!sendQuery(GET_MEDREC_ID_QUERY, id_socdet))
-		return 0;
+	MYSQL_BIND params[] = {BIND_INT(&id_socdet)};
+	MYSQL_BIND results[] = {BIND_INT(&id_medrec)};
 
-	result = mysql_use_result(mysql);
+	MYSQL_STMT *stmt = executeStatement(GET_MEDREC_ID_STMT, params, results);
 
-	if (result == NULL)
+	if (stmt == NULL)
 	{
 		printf("\nCannot get the 'id_medrec': invalid MySQL query.\n");
 		return 0;
 	}
 
-	if ((row = mysql_fetch_row(result)) == NULL)
+	if (!fetchRow(stmt))
 	{
 		printf("\nCannot get the 'id_medrec': %d\n", id_socdet);
-		mysql_free_result(result);
-		return 0;
+		id_medrec = 0;
 	}
 
-	short id_medrec = atoi(row[0]);
-
-	mysql_free_result(result);
+	mysql_stmt_free_result(stmt);
 
 	return id_medrec;
 }
 
 
-// Reads a medical record from the database, including (at most) the last 'MAX_DIAGS_READ' diagnostics.
-// Returns NULL on failure. This will require a freeMedicalRecord() call afterhand.
+// Reads a medical record from the database, including (at most) the last 'MAX_DIAGS_READ' diagnostics,
+// with a single query. Recently read records are taken from the cache instead. Returns NULL on failure.
+// This will require a freeMedicalRecord() call afterhand.
 MedicalRecord* readMedicalRecord(int id_socdet)
 {
-	if (!connectToDatabase())
-	{
-		printf("\nCannot read a medical record: not connected to the database.\n");
-		return NULL;
-	}
-
-	MYSQL_RES *result = NULL;
-	MYSQL_ROW row = NULL;
-
-	/////////////////////////////////////////////////////
-	// Getting the number of diagnostics from the medical record:
+	return readMedicalRecordInArena(id_socdet, NULL);
+}
 
-	short diagnosticNumber = 0; // default.
 
-	if (MAX_DIAGS_READ > 0)
-	{
-		if (!sendQuery(READ_MEDREC_DIAGS_NUMBER_QUERY, id_socdet))
-			return NULL;
-
-		result = mysql_use_result(mysql);
+// Same as readMedicalRecord(), the medical record being allocated in the given arena if not NULL.
+// It must not be freed then: it lives until the arena is reset. The cache still keeps its own copy.
+MedicalRecord* readMedicalRecordInArena(int id_socdet, Arena *arena)
+{
+	MedicalRecord *cached_medrec = getCachedMedicalRecordInArena(id_socdet, arena);
 
-		if (result == NULL)
-		{
-			printf("\nCannot read a medical record: invalid MySQL query.\n\n");
-			return NULL;
-		}
+	if (cached_medrec != NULL)
+		return cached_medrec;
 
-		if ((row = mysql_fetch_row(result)) == NULL)
-		{
-			printf("\nCannot get the number of diagnostics for the patient: %d\n", id_socdet);
-			mysql_free_result(result);
-			return NULL;
-		}
+	// A diagnostic written during the query below makes the read record stale, and not to be cached:
+	const unsigned int cache_generation = getMedicalRecordGeneration(id_socdet);
 
-		diagnosticNumber = atoi(row[0]);
+	if (!connectToDatabase())
+	{
+		printf("\nCannot read a medical record: not connected to the database.\n");
+		return NULL;
+	}
 
-		if (diagnosticNumber > MAX_DIAGS_READ)
-			diagnosticNumber = MAX_DIAGS_READ;
+	// Columns of the joined query:
 
-		mysql_free_result(result); // Needs to be be freed before a new query is done !!!
-	}
+	int id_medrec, gender, id_blgrp, weight, height, id_diag, id_ill;
+	char birthdate[DATE_MAX_LENGTH], date_diag[DATE_MAX_LENGTH];
+	unsigned long birthdate_length, date_length;
+	float criticity, probability;
+	BindBool diag_is_null, illness_is_null;
 
-	/////////////////////////////////////////////////////
-	// Getting general data from the medical record:
+	int diags_read_max = MAX_DIAGS_READ;
 
-	MedicalRecord *medrec = allocateMedicalRecord(diagnosticNumber);
+	MYSQL_BIND params[] = {BIND_INT(&id_socdet), BIND_INT(&diags_read_max), BIND_INT(&id_socdet)};
 
-	if (!sendQuery(READ_MEDREC_INFO_QUERY, id_socdet))
+	MYSQL_BIND results[] =
 	{
-		freeMedicalRecord(&medrec);
-		return NULL;
-	}
+		BIND_INT(&id_medrec), BIND_INT(&gender), BIND_STRING(birthdate, DATE_MAX_LENGTH, &birthdate_length),
+		BIND_INT(&id_blgrp), BIND_INT(&weight), BIND_INT(&height),
+		BIND_NULLABLE_INT(&id_diag, &diag_is_null), BIND_STRING(date_diag, DATE_MAX_LENGTH, &date_length),
+		BIND_FLOAT(&criticity), BIND_NULLABLE_INT(&id_ill, &illness_is_null), BIND_FLOAT(&probability)
+	};
 
-	result = mysql_use_result(mysql);
+	MYSQL_STMT *stmt = executeStatement(READ_MEDREC_STMT, params, results);
 
-	if (result == NULL)
+	if (stmt == NULL)
 	{
 		printf("\nCannot read a medical record: invalid MySQL query.\n\n");
-		freeMedicalRecord(&medrec);
 		return NULL;
 	}
 
-	if ((row = mysql_fetch_row(result)) == NULL)
+	if (!fetchRow(stmt))
 	{
 		printf("\nCannot get the medical record info for the patient: %d\n", id_socdet);
-		freeMedicalRecord(&medrec);
-		mysql_free_result(result);
+		mysql_stmt_free_result(stmt);
 		return NULL;
 	}
 
-	medrec -> id_medrec = atoi(row[0]);
-	medrec -> gender = atoi(row[1]);
-	medrec -> age = getAge(row[2]);
-	medrec -> id_blgrp = atoi(row[3]);
-	medrec -> weight = atoi(row[4]);
-	medrec -> height = atoi(row[5]);
-	medrec -> diagnosticNumber = diagnosticNumber;
+	// Room for the maximum number of diagnostics, the actual number being known once all rows are read:
+	MedicalRecord *medrec = allocateMedicalRecordInArena(arena, MAX_DIAGS_READ);
 
-	mysql_free_result(result); // Needs to be be freed before a new query is done !!!
-
-	/////////////////////////////////////////////////////
-	// Getting the diagnostics from the medical record:
+	if (medrec == NULL)
+	{
+		mysql_stmt_free_result(stmt);
+		return NULL;
+	}
 
-	const int id_medrec = getMedicalRecordId(id_socdet);
+	birthdate[MIN(birthdate_length, DATE_MAX_LENGTH - 1)] = '\0';
 
-	int *id_diag_buffer = NULL; // declared here, so we can go to 'failure' if needed.
+	medrec -> id_medrec = id_medrec;
+	medrec -> gender = gender;
+	medrec -> age = getAge(birthdate);
+	medrec -> id_blgrp = id_blgrp;
+	medrec -> weight = weight;
+	medrec -> height = height;
 
-	if (!sendQuery(READ_MEDREC_LAST_DIAGS_QUERY, id_medrec, MAX_DIAGS_READ))
-		goto failure;
+	// Rows are sorted by diagnostic, from the most recent one:
 
-	result = mysql_use_result(mysql);
+	int diagnosticNumber = 0, illness_index = 0, last_id_diag = 0;
 
-	if (result == NULL)
-		goto failure;
+	do
+	{
+		if (diag_is_null) // No diagnostic at all.
+			break;
 
-	// Buffering the id_diag values, in order to be able to call readDiagnostic()...
+		if (diagnosticNumber == 0 || id_diag != last_id_diag) // New diagnostic.
+		{
+			if (diagnosticNumber == MAX_DIAGS_READ)
+				break;
 
-	id_diag_buffer = (int*) calloc(diagnosticNumber, sizeof(int));
+			Diagnostic *diag = medrec -> diagnosticArray + diagnosticNumber;
 
-	if (id_diag_buffer == NULL)
-	{
-		printf("\nNot enough memory to create a diagnostic buffer.\n");
-		goto failure;
-	}
+			diag -> id_diag = id_diag;
+			diag -> criticity = criticity;
+			snprintf(diag -> date_diag, DATE_MAX_LENGTH - 1, "%.*s", (int) date_length, date_diag);
 
-	for (int i = 0; i < diagnosticNumber; ++i)
-	{
-		row = mysql_fetch_row(result);
+			last_id_diag = id_diag;
+			illness_index = 0;
+			++diagnosticNumber;
+		}
 
-		if (row == NULL)
-			goto failure;
+		if (!illness_is_null && illness_index < DIAG_ILLNESS_NUMBER)
+		{
+			Diagnostic *diag = medrec -> diagnosticArray + diagnosticNumber - 1;
 
-		id_diag_buffer[i] = atoi(row[0]);
+			diag -> illnessArray[illness_index] = id_ill - 1; // Illnesses starts from 1 in the database!
+			diag -> illnessProbabilityArray[illness_index] = probability;
+			++illness_index;
+		}
 	}
+	while (fetchRow(stmt));
 
-	mysql_free_result(result); // Needs to be be freed before a new query is done !!!
-
-	// Now, fetching each diagnostic:
+	medrec -> diagnosticNumber = diagnosticNumber;
 
-	for (int i = 0; i < diagnosticNumber; ++i)
-	{
-		if (!readDiagnostic(medrec -> diagnosticArray + i, id_diag_buffer[i]))
-			goto failure;
-	}
+	mysql_stmt_free_result(stmt);
 
-	free(id_diag_buffer);
+	cacheMedicalRecord(id_socdet, medrec, cache_generation);
 
 	return medrec;
-
-	failure:
-		printf("\nCannot read a medical record.\n\n");
-		free(id_diag_buffer);
-		freeMedicalRecord(&medrec);
-		mysql_free_result(result);
-		return NULL;
 }
 
 
@@ -438,54 +598,118 @@ int writeDiagnostic(const Diagnostic *diagnostic, int id_socdet)
 
 	const int id_medrec = getMedicalRecordId(id_socdet);
 
-	/////////////////////////////////////////////////////
-	// Inserting in the database the diagnostic info:
+	int new_id = 0;
 
-	if (!sendQuery(INSERT_DIAG_INFO_QUERY, ID_AUTO_INCREMENT, diagnostic -> criticity, id_medrec, ID_DOC_DEFAULT))
+	if (!writeDiagnosticBatch(diagnostic, &id_medrec, &id_socdet, 1, &new_id))
 		return 0;
 
-	int new_id = mysql_insert_id(mysql); // ID of the newly inserted entry.
+	return new_id;
+}
 
-	if (new_id == 0)
+
+// Writes several diagnostics on the database with a single transaction. Their infos are inserted one row at a time,
+// for each 'id_diag' to be read from mysql_insert_id(): the IDs of a multi-row INSERT may not be consecutive. Their
+// illnesses and probabilities are inserted by multi-row INSERTs of up to 'DIAG_BATCH_SIZE' diagnostics.
+// 'id_medrecArray' and 'id_socdetArray' hold the patient of each diagnostic.
+// Their new 'id_diag' are written in 'new_ids', if not NULL. Returns 1 on success, 0 else, in which case nothing is written.
+int writeDiagnosticBatch(const Diagnostic *diagArray, const int *id_medrecArray, const int *id_socdetArray,
+	int diag_number, int *new_ids)
+{
+	if (diagArray == NULL || id_medrecArray == NULL || id_socdetArray == NULL)
 	{
-		printf("\nCould not insert a diagnostic into the database!\n");
+		printf("\nNULL diagnostics.\n");
 		return 0;
 	}
 
-	/////////////////////////////////////////////////////
-	// Inserting in the database the diagnostic illnesses and probabilities:
-	// Careful: illnesses starts from 1 in the database!
+	if (diag_number <= 0)
+		return 1;
 
-	#if PACK_ILLNESS_PROBA && DIAG_ILLNESS_NUMBER != 5
-		#pragma message "Could not use the packed writing optimization."
-	#endif
+	if (!connectToDatabase())
+	{
+		printf("\nCannot write a diagnostic: not connected to the database.\n");
+		return 0;
+	}
 
-	if (PACK_ILLNESS_PROBA && DIAG_ILLNESS_NUMBER == 5) // faster, but hardcoded with size 5.
+	if (!sendQuery("START TRANSACTION;"))
+		return 0;
+
+	for (int batch_start = 0; batch_start < diag_number; batch_start += MAX_DIAGS_PER_INSERT)
 	{
-		if (!sendQuery(INSERT_DIAG_ILLNESS_AND_PROBA_QUERY_PACKED_5,
-			new_id, diagnostic -> illnessArray[0] + 1, diagnostic -> illnessProbabilityArray[0],
-			new_id, diagnostic -> illnessArray[1] + 1, diagnostic -> illnessProbabilityArray[1],
-			new_id, diagnostic -> illnessArray[2] + 1, diagnostic -> illnessProbabilityArray[2],
-			new_id, diagnostic -> illnessArray[3] + 1, diagnostic -> illnessProbabilityArray[3],
-			new_id, diagnostic -> illnessArray[4] + 1, diagnostic -> illnessProbabilityArray[4]))
+		const int batch_size = MIN(MAX_DIAGS_PER_INSERT, diag_number - batch_start);
+
+		const Diagnostic *batch_diags = diagArray + batch_start;
+
+		int diag_ids[MAX_DIAGS_PER_INSERT];
+
+		/////////////////////////////////////////////////////
+		// Inserting in the database the diagnostics info:
+
+		for (int i = 0; i < batch_size; ++i)
 		{
-			return 0;
+			insert_query_length = 0;
+
+			if (!appendToInsertQuery(INSERT_DIAG_INFO_QUERY) || !appendToInsertQuery(DIAG_INFO_ROW ";", ID_AUTO_INCREMENT,
+				batch_diags[i].criticity, id_medrecArray[batch_start + i], ID_DOC_DEFAULT) || !sendInsertQuery())
+			{
+				goto rollback;
+			}
+
+			diag_ids[i] = mysql_insert_id(mysql);
+
+			if (diag_ids[i] == 0)
+			{
+				printf("\nCould not insert a diagnostic into the database!\n");
+				goto rollback;
+			}
 		}
-	}
 
-	else // generic.
-	{
-		for (int i = 0; i < DIAG_ILLNESS_NUMBER; ++i)
+		/////////////////////////////////////////////////////
+		// Inserting in the database the diagnostics illnesses and probabilities:
+		// Careful: illnesses starts from 1 in the database!
+
+		insert_query_length = 0;
+
+		if (!appendToInsertQuery(INSERT_DIAG_ILLNESS_AND_PROBA_QUERY))
+			goto rollback;
+
+		for (int i = 0; i < batch_size; ++i)
 		{
-			if (!sendQuery(INSERT_DIAG_ILLNESS_AND_PROBA_QUERY, new_id, diagnostic -> illnessArray[i] + 1,
-				diagnostic -> illnessProbabilityArray[i]))
+			for (int j = 0; j < DIAG_ILLNESS_NUMBER; ++j)
 			{
-				return 0;
+				if (!appendToInsertQuery(i == 0 && j == 0 ? DIAG_ILLNESS_AND_PROBA_ROW : ",\n" DIAG_ILLNESS_AND_PROBA_ROW,
+					diag_ids[i], batch_diags[i].illnessArray[j] + 1, batch_diags[i].illnessProbabilityArray[j]))
+				{
+					goto rollback;
+				}
 			}
 		}
+
+		if (!appendToInsertQuery(";") || !sendInsertQuery())
+			goto rollback;
+
+		if (new_ids != NULL)
+		{
+			for (int i = 0; i < batch_size; ++i)
+				new_ids[batch_start + i] = diag_ids[i];
+		}
 	}
 
-	return new_id;
+	if (mysql_commit(mysql) != 0)
+	{
+		printf("\nCould not commit the diagnostics: %s\n", mysql_error(mysql));
+		goto rollback;
+	}
+
+	// The cached medical records are now outdated:
+	for (int i = 0; i < diag_number; ++i)
+		invalidateCachedMedicalRecord(id_socdetArray[i]);
+
+	return 1;
+
+	rollback:
+		printf("\nCould not write %d diagnostics, rolling back.\n", diag_number);
+		mysql_rollback(mysql);
+		return 0;
 }
 
 
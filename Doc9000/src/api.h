@@ -5,7 +5,19 @@
 #include "medical_structs.h"
 
 
-// Does nothing if already connected! Returns 1 on success, 0 else.
+// Must be called once before any thread (apart from the main one) uses the database. Returns 1 on success, 0 else.
+int initDatabaseLibrary(void);
+
+
+// Must be called by each new thread using the database, before any query:
+void initDatabaseThread(void);
+
+
+// Disconnects the calling thread from the database, and frees its MySQL ressources. Call this before the thread ends:
+void endDatabaseThread(void);
+
+
+// Does nothing if already connected! Each thread has its own connection. Returns 1 on success, 0 else.
 int connectToDatabase(void);
 
 
@@ -22,15 +34,30 @@ int readDiagnostic(Diagnostic *diag, int id_diag);
 int getMedicalRecordId(int id_socdet);
 
 
-// Reads a medical record from the database, including (at most) the last 'MAX_DIAGS_READ' diagnostics.
-// Returns NULL on failure. This will require a freeMedicalRecord() call afterhand.
+// Reads a medical record from the database, including (at most) the last 'MAX_DIAGS_READ' diagnostics,
+// with a single query. Recently read records are taken from the cache instead. Returns NULL on failure.
+// This will require a freeMedicalRecord() call afterhand.
 MedicalRecord* readMedicalRecord(int id_socdet);
 
 
+// Same as readMedicalRecord(), the medical record being allocated in the given arena if not NULL.
+// It must not be freed then: it lives until the arena is reset. The cache still keeps its own copy.
+MedicalRecord* readMedicalRecordInArena(int id_socdet, Arena *arena);
+
+
 // Writes a diagnostic on the database. Returns the new 'id_diag' on success, 0 else.
 int writeDiagnostic(const Diagnostic *diagnostic, int id_socdet);
 
 
+// Writes several diagnostics on the database with a single transaction. Their infos are inserted one row at a time,
+// for each 'id_diag' to be read from mysql_insert_id(): the IDs of a multi-row INSERT may not be consecutive. Their
+// illnesses and probabilities are inserted by multi-row INSERTs of up to 'DIAG_BATCH_SIZE' diagnostics.
+// 'id_medrecArray' and 'id_socdetArray' hold the patient of each diagnostic.
+// Their new 'id_diag' are written in 'new_ids', if not NULL. Returns 1 on success, 0 else, in which case nothing is written.
+int writeDiagnosticBatch(const Diagnostic *diagArray, const int *id_medrecArray, const int *id_socdetArray,
+	int diag_number, int *new_ids);
+
+
 // Compares backups strings to those on the database, for all the relevant tables.
 // Returns 1 on success, 0 else.
 int checkBackupsIntegrity(void);
@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+
+static inline size_t alignSize(size_t size)
+{
+	return (size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+}
+
+
+// Creates an arena of the given initial capacity, in bytes. Returns NULL if there is not enough memory.
+Arena* createArena(size_t capacity)
+{
+	Arena *arena = (Arena*) calloc(1, sizeof(Arena));
+
+	if (arena == NULL)
+	{
+		printf("\nNot enough memory to create an arena.\n");
+		return NULL;
+	}
+
+	arena -> Capacity = alignSize(capacity);
+	arena -> Memory = (unsigned char*) malloc(arena -> Capacity);
+
+	if (arena -> Memory == NULL)
+	{
+		printf("\nNot enough memory to create an arena.\n");
+		free(arena);
+		return NULL;
+	}
+
+	return arena;
+}
+
+
+// Frees the arena passed by address, all its allocations included, and sets it to NULL.
+void freeArena(Arena **arena)
+{
+	if (arena == NULL || *arena == NULL)
+		return;
+
+	resetArena(*arena); // Freeing the overflows.
+
+	free((*arena) -> Overflows);
+	free((*arena) -> Memory);
+	free(*arena);
+	*arena = NULL;
+}
+
+
+// Returns 'size' bytes set to 0, from the given arena, or from the heap if 'arena' is NULL
+// (to be freed by the caller then). Returns NULL if there is not enough memory.
+void* arenaAlloc(Arena *arena, size_t size)
+{
+	if (arena == NULL)
+		return calloc(1, size);
+
+	size = alignSize(size);
+
+	arena -> Requested += size;
+
+	if (arena -> Used + size <= arena -> Capacity)
+	{
+		void *block = arena -> Memory + arena -> Used;
+
+		arena -> Used += size;
+
+		memset(block, 0, size);
+		return block;
+	}
+
+	// Full arena: allocating on the heap until the next reset.
+
+	if (arena -> OverflowNumber == arena -> OverflowCapacity)
+	{
+		const int new_capacity = arena -> OverflowCapacity == 0 ? 16 : 2 * arena -> OverflowCapacity;
+
+		void **overflows = (void**) realloc(arena -> Overflows, new_capacity * sizeof(void*));
+
+		if (overflows == NULL)
+			return NULL;
+
+		arena -> Overflows = overflows;
+		arena -> OverflowCapacity = new_capacity;
+	}
+
+	void *block = calloc(1, size);
+
+	if (block == NULL)
+		return NULL;
+
+	arena -> Overflows[arena -> OverflowNumber++] = block;
+
+	return block;
+}
+
+
+// Frees all the allocations made since the last reset, growing the arena if it has been too small:
+void resetArena(Arena *arena)
+{
+	if (arena == NULL)
+		return;
+
+	for (int i = 0; i < arena -> OverflowNumber; ++i)
+		free(arena -> Overflows[i]);
+
+	arena -> OverflowNumber = 0;
+
+	if (arena -> Requested > arena -> Capacity)
+	{
+		unsigned char *memory = (unsigned char*) malloc(arena -> Requested);
+
+		if (memory != NULL) // Else keeping the current memory.
+		{
+			free(arena -> Memory);
+			arena -> Memory = memory;
+			arena -> Capacity = arena -> Requested;
+		}
+	}
+
+	arena -> Used = 0;
+	arena -> Requested = 0;
+}
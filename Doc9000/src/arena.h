@@ -0,0 +1,47 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+
+#include <stddef.h>
+
+
+// Bump allocator for the objects living as long as a single request, e.g the prediagnostics and medical records
+// of a diagnostic batch: they are not freed one by one, but all at once by resetArena().
+// When the arena is full, the allocations are made on the heap until the next reset, which then grows the arena
+// to the size used since the previous reset. In a steady state, a request thus costs no heap allocation at all.
+// Not thread safe: each thread uses its own arena.
+
+
+#define ARENA_ALIGNMENT 16 // Enough for any of the structs allocated here, and the alignment of malloc() on 64 bits.
+
+
+typedef struct
+{
+	unsigned char *Memory;
+	size_t Capacity;
+	size_t Used;
+	size_t Requested;		// Bytes requested since the last reset, Memory being full or not.
+	void **Overflows;		// Heap allocations made since the arena is full, freed at the next reset.
+	int OverflowNumber;
+	int OverflowCapacity;
+} Arena;
+
+
+// Creates an arena of the given initial capacity, in bytes. Returns NULL if there is not enough memory.
+Arena* createArena(size_t capacity);
+
+
+// Frees the arena passed by address, all its allocations included, and sets it to NULL.
+void freeArena(Arena **arena);
+
+
+// Returns 'size' bytes set to 0, from the given arena, or from the heap if 'arena' is NULL
+// (to be freed by the caller then). Returns NULL if there is not enough memory.
+void* arenaAlloc(Arena *arena, size_t size);
+
+
+// Frees all the allocations made since the last reset, growing the arena if it has been too small:
+void resetArena(Arena *arena);
+
+
+#endif
@@ -1,11 +1,59 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "backups.h"
 #include "utilities.h"
 
 
+///////////////////////////////////////////////////////////////
+// Compiled assets file:
+
+// A header, followed by the criticities, the offsets of the names in the names table (illnesses first), the start
+// of each illness symptoms list, the symptoms lists, and the names table. Each section is naturally aligned.
+
+#define ASSETS_FILE_MAGIC "DocAsst" // 8 bytes, with the '\0'.
+#define ASSETS_FILE_VERSION 2
+#define ASSETS_FILE_ENDIANNESS 0x01020304u // Read differently on a machine of another endianness.
+
+
+typedef struct
+{
+	char Magic[8];
+	uint32_t Version;
+	uint32_t Endianness;
+	uint64_t FileSize;
+	uint64_t Checksum;			// FNV-1a hash of everything after the header.
+	uint64_t SourceHash;		// FNV-1a hash of the base dataset the file was compiled from.
+	uint64_t SourceSize;
+	uint32_t IllnessNumber;
+	uint32_t SymptomNumber;
+	uint32_t DataSymptomNumber;	// Total length of the symptoms lists.
+	uint32_t NamesSize;
+	uint64_t CriticitiesOffset;	// float[IllnessNumber]
+	uint64_t NameOffsetsOffset;	// uint32_t[IllnessNumber + SymptomNumber]
+	uint64_t ListStartsOffset;	// uint32_t[IllnessNumber + 1]
+	uint64_t SymptomsOffset;	// Symptom[DataSymptomNumber]
+	uint64_t NamesOffset;		// char[NamesSize], '\0' terminated names.
+} AssetsFileHeader;
+
+
+// Read only mapping of the compiled assets file, into which the names and criticities arrays may point:
+static unsigned char *AssetsMapping;
+static size_t AssetsMappingSize;
+
+// Last stamp of the base dataset computed by this process. Its modification time is kept in memory only,
+// for the compiled assets file not to depend on it: it changes on each checkout.
+static uint64_t SourceStampSize;
+static int64_t SourceStampModTime = -1;
+static uint64_t SourceStampHash;
+
+
 ///////////////////////////////////////////////////////////////
 // Private inclusions:
 
@@ -94,7 +142,7 @@ ParsingStatus saveParsingResults(void)
 }
 
 
-// Load 'IllnessNumber', 'SymptomNumber', and the criticites from the related file.
+// Load 'IllnessNumber', 'SymptomNumber', and the criticites from the compiled assets file.
 ParsingStatus loadCriticities(void)
 {
 	// Do not call 'checkNumberValues()' for this, it would cause an infinite loop:
@@ -103,127 +151,470 @@ ParsingStatus loadCriticities(void)
 
 	freeCriticityArray(); // In case number values are incorrect.
 
-	FILE *file_criticity = fopen(CRITICITIES_FILENAME, "rb");
-
-	if (file_criticity == NULL)
+	if (loadCompiledAssets(NULL) != LOADING_SUCCESSFUL)
 	{
-		printf("\nFile '%s' not found, reparsing the base dataset.\n", CRITICITIES_FILENAME);
+		printf("\nReparsing the base dataset, for compiling its assets.\n");
 		parseBaseDataset(NULL);
 		return REPARSING;
 	}
 
-	if (fread(&IllnessNumber, sizeof(IllnessNumber), 1, file_criticity) != 1)
-	{
-		printf("\nReparsing! Could not retrieve 'IllnessNumber' from '%s'.\n", CRITICITIES_FILENAME);
-		fclose(file_criticity);
-		parseBaseDataset(NULL);
+	printf("\nCriticities loaded succesfully.\n");
+
+	return LOADING_SUCCESSFUL;
+}
+
+
+// Loads 'IllnessStringArray' and 'SymptomStringArray' in memory from the compiled assets file:
+ParsingStatus loadStringNames(void)
+{
+	if (checkNumberValues() == REPARSING)
 		return REPARSING;
+
+	if (IllnessStringArray != NULL && SymptomStringArray != NULL)
+	{
+		buildNameIndexes(); // Only if not already built.
+		return RESSOURCES_EXIST;
 	}
 
-	if (fread(&SymptomNumber, sizeof(SymptomNumber), 1, file_criticity) != 1)
+	freeStringsArrays(); // In case only one is NULL.
+
+	if (loadCompiledAssets(NULL) != LOADING_SUCCESSFUL)
 	{
-		printf("\nReparsing! Could not retrieve 'SymptomNumber' from '%s'.\n", CRITICITIES_FILENAME);
-		fclose(file_criticity);
+		printf("\nReparsing the base dataset, for compiling its assets.\n");
 		parseBaseDataset(NULL);
 		return REPARSING;
 	}
 
-	// printf("\nIllness number: %d\nSymptom number: %d\n", IllnessNumber, SymptomNumber);
+	printf("\nString names loaded succesfully.\n");
+	return LOADING_SUCCESSFUL;
+}
+
+
+///////////////////////////////////////////////////////////////
+// Compiled assets:
+
 
-	CriticityArray = (float*) calloc(IllnessNumber, sizeof(float));
+static inline uint64_t alignOffset(uint64_t offset, uint64_t alignment)
+{
+	return (offset + alignment - 1) / alignment * alignment;
+}
 
-	size_t criticities_read = fread(CriticityArray, sizeof(float), IllnessNumber, file_criticity);
 
-	if (criticities_read != IllnessNumber)
+// Gets the size and hash of the base dataset. Returns 0 if it cannot be read.
+// It is not hashed again if its size and modification time did not change since the last call:
+static int baseDatasetStamp(uint64_t *size, uint64_t *hash)
+{
+	int fd = open(SRC_BASE_DATASET, O_RDONLY);
+
+	if (fd < 0)
+		return 0;
+
+	struct stat st;
+
+	if (fstat(fd, &st) != 0)
 	{
-		printf("\nReparsing! Could only read %ld criticities from '%s'.\n", criticities_read, CRITICITIES_FILENAME);
-		freeCriticityArray();
-		fclose(file_criticity);
-		parseBaseDataset(NULL);
-		return REPARSING;
+		close(fd);
+		return 0;
 	}
 
-	fclose(file_criticity);
+	*size = st.st_size;
 
-	printf("\nCriticities loaded succesfully.\n");
+	if (st.st_mtime == SourceStampModTime && (uint64_t) st.st_size == SourceStampSize)
+	{
+		*hash = SourceStampHash;
+		close(fd);
+		return 1;
+	}
 
-	return LOADING_SUCCESSFUL;
+	if (st.st_size == 0)
+	{
+		*hash = dataHash(NULL, 0);
+		close(fd);
+		return 1;
+	}
+
+	void *source = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	close(fd);
+
+	if (source == MAP_FAILED)
+		return 0;
+
+	*hash = dataHash((const unsigned char*) source, st.st_size);
+
+	munmap(source, st.st_size);
+
+	SourceStampSize = st.st_size;
+	SourceStampModTime = st.st_mtime;
+	SourceStampHash = *hash;
+
+	return 1;
 }
 
 
-// Loads the strings from the given file:
-static ParsingStatus loadStringFile(char *filename, short string_number, char **string_array, char *buffer)
+// Writes the compiled assets file from the given header and the 'header -> FileSize' bytes following it in 'body'.
+// A temporary file is written first, then renamed: processes having mapped the previous file are not affected.
+// Returns 1 on success, 0 otherwise:
+static int writeCompiledAssets(const AssetsFileHeader *header, const unsigned char *body)
 {
-	FILE *file = fopen(filename, "r");
+	char tmp_filename[MAX_FILENAME_PATH_LENGTH];
+	snprintf(tmp_filename, MAX_FILENAME_PATH_LENGTH, "%s.tmp", COMPILED_ASSETS_FILENAME);
+
+	FILE *file = fopen(tmp_filename, "wb");
 
 	if (file == NULL)
 	{
-		printf("\nFile '%s' not found, reparsing the base dataset.\n", filename);
-		freeStringsArrays();
-		parseBaseDataset(NULL);
+		printf("\nCould not write to: '%s'.\n", tmp_filename);
+		return 0;
+	}
+
+	const uint64_t body_size = header -> FileSize - sizeof(AssetsFileHeader);
+
+	const int write_success = fwrite(header, sizeof(AssetsFileHeader), 1, file) == 1 &&
+		fwrite(body, 1, body_size, file) == body_size;
+
+	if (fclose(file) != 0 || !write_success || rename(tmp_filename, COMPILED_ASSETS_FILENAME) != 0)
+	{
+		printf("\nCould not write to: '%s'.\n", COMPILED_ASSETS_FILENAME);
+		remove(tmp_filename);
+		return 0;
+	}
+
+	return 1;
+}
+
+
+// Compiles the illnesses and symptoms names, the criticities and the given medical data (one per illness) into a
+// single file, mapped at start-up by loadCompiledAssets(). Returns SAVING_SUCCESSFUL, or PARSING_FAILED.
+ParsingStatus saveCompiledAssets(const MedicalData *medData)
+{
+	if (checkRessources() != RESSOURCES_EXIST || medData == NULL)
+	{
+		printf("\nCannot compile the assets: nothing to compile.\n");
+		return PARSING_FAILED;
+	}
+
+	AssetsFileHeader header =
+	{
+		.Magic = ASSETS_FILE_MAGIC,
+		.Version = ASSETS_FILE_VERSION,
+		.Endianness = ASSETS_FILE_ENDIANNESS,
+		.IllnessNumber = IllnessNumber,
+		.SymptomNumber = SymptomNumber
+	};
+
+	if (!baseDatasetStamp(&header.SourceSize, &header.SourceHash))
+	{
+		printf("\nCannot compile the assets: '%s' cannot be read.\n", SRC_BASE_DATASET);
+		return PARSING_FAILED;
+	}
+
+	const int names_number = IllnessNumber + SymptomNumber;
+
+	for (int i = 0; i < IllnessNumber; ++i)
+		header.DataSymptomNumber += medData[i].symptomNumber;
+
+	for (int i = 0; i < names_number; ++i)
+	{
+		const char *name = i < IllnessNumber ? IllnessStringArray[i] : SymptomStringArray[i - IllnessNumber];
+		header.NamesSize += strlen(name) + 1;
+	}
+
+	// Placing the sections:
+
+	header.CriticitiesOffset = sizeof(AssetsFileHeader);
+	header.NameOffsetsOffset = alignOffset(header.CriticitiesOffset + IllnessNumber * sizeof(float), sizeof(uint32_t));
+	header.ListStartsOffset = header.NameOffsetsOffset + names_number * sizeof(uint32_t);
+	header.SymptomsOffset = alignOffset(header.ListStartsOffset + (IllnessNumber + 1) * sizeof(uint32_t), sizeof(Symptom));
+	header.NamesOffset = header.SymptomsOffset + header.DataSymptomNumber * sizeof(Symptom);
+	header.FileSize = header.NamesOffset + header.NamesSize;
+
+	unsigned char *buffer = (unsigned char*) calloc(header.FileSize, 1);
+
+	if (buffer == NULL)
+	{
+		printf("\nNot enough memory to compile the assets.\n");
+		return PARSING_FAILED;
+	}
+
+	memcpy(buffer + header.CriticitiesOffset, CriticityArray, IllnessNumber * sizeof(float));
+
+	uint32_t *name_offsets = (uint32_t*) (buffer + header.NameOffsetsOffset);
+	uint32_t name_offset = 0;
+
+	for (int i = 0; i < names_number; ++i)
+	{
+		const char *name = i < IllnessNumber ? IllnessStringArray[i] : SymptomStringArray[i - IllnessNumber];
+		const size_t length = strlen(name) + 1;
+
+		name_offsets[i] = name_offset;
+		memcpy(buffer + header.NamesOffset + name_offset, name, length);
+		name_offset += length;
+	}
+
+	uint32_t *list_starts = (uint32_t*) (buffer + header.ListStartsOffset);
+	Symptom *symptoms = (Symptom*) (buffer + header.SymptomsOffset);
+
+	list_starts[0] = 0;
+
+	for (int i = 0; i < IllnessNumber; ++i)
+	{
+		memcpy(symptoms + list_starts[i], medData[i].symptomArray, medData[i].symptomNumber * sizeof(Symptom));
+		list_starts[i + 1] = list_starts[i] + medData[i].symptomNumber;
+	}
+
+	header.Checksum = dataHash(buffer + sizeof(AssetsFileHeader), header.FileSize - sizeof(AssetsFileHeader));
+
+	const int write_success = writeCompiledAssets(&header, buffer + sizeof(AssetsFileHeader));
+
+	free(buffer);
+
+	return write_success ? SAVING_SUCCESSFUL : PARSING_FAILED;
+}
+
+
+// Returns NULL if the given mapped assets file is valid and compiled from the current base dataset,
+// or the reason why it is not:
+static const char* checkCompiledAssets(const unsigned char *mapping, uint64_t mapping_size)
+{
+	const AssetsFileHeader *header = (const AssetsFileHeader*) mapping;
+
+	if (mapping_size < sizeof(AssetsFileHeader) || memcmp(header -> Magic, ASSETS_FILE_MAGIC, 8) != 0)
+		return "not a compiled assets file";
+
+	if (header -> Endianness != ASSETS_FILE_ENDIANNESS)
+		return "compiled on a machine of different endianness";
+
+	if (header -> Version != ASSETS_FILE_VERSION)
+		return "unsupported version";
+
+	if (header -> FileSize != mapping_size)
+		return "truncated file";
+
+	const uint64_t names_number = (uint64_t) header -> IllnessNumber + header -> SymptomNumber;
+
+	if (header -> IllnessNumber == 0 || header -> IllnessNumber >= MAX_ILLNESS_NUMBER ||
+		header -> SymptomNumber == 0 || header -> SymptomNumber >= MAX_SYMPTOM_NUMBER ||
+		header -> CriticitiesOffset < sizeof(AssetsFileHeader) || header -> CriticitiesOffset % sizeof(float) != 0 ||
+		header -> CriticitiesOffset + header -> IllnessNumber * sizeof(float) > header -> NameOffsetsOffset ||
+		header -> NameOffsetsOffset % sizeof(uint32_t) != 0 ||
+		header -> NameOffsetsOffset + names_number * sizeof(uint32_t) > header -> ListStartsOffset ||
+		header -> ListStartsOffset % sizeof(uint32_t) != 0 ||
+		header -> ListStartsOffset + (header -> IllnessNumber + 1) * sizeof(uint32_t) > header -> SymptomsOffset ||
+		header -> SymptomsOffset % sizeof(Symptom) != 0 ||
+		header -> SymptomsOffset + header -> DataSymptomNumber * sizeof(Symptom) > header -> NamesOffset ||
+		header -> NamesOffset + header -> NamesSize != mapping_size || header -> NamesSize == 0)
+	{
+		return "invalid sections";
+	}
+
+	if (dataHash(mapping + sizeof(AssetsFileHeader), mapping_size - sizeof(AssetsFileHeader)) != header -> Checksum)
+		return "wrong checksum";
+
+	// Names, which must be '\0' terminated and not too long for the existing code:
+
+	const uint32_t *name_offsets = (const uint32_t*) (mapping + header -> NameOffsetsOffset);
+	const char *names = (const char*) (mapping + header -> NamesOffset);
+
+	if (names[header -> NamesSize - 1] != '\0')
+		return "invalid names";
+
+	for (uint64_t i = 0; i < names_number; ++i)
+	{
+		if (name_offsets[i] >= header -> NamesSize || strlen(names + name_offsets[i]) >= MAX_NAME_LENGTH)
+			return "invalid names";
+	}
+
+	// Symptoms lists:
+
+	const uint32_t *list_starts = (const uint32_t*) (mapping + header -> ListStartsOffset);
+	const Symptom *symptoms = (const Symptom*) (mapping + header -> SymptomsOffset);
+
+	if (list_starts[0] != 0 || list_starts[header -> IllnessNumber] != header -> DataSymptomNumber)
+		return "invalid symptoms lists";
+
+	for (uint32_t i = 0; i < header -> IllnessNumber; ++i)
+	{
+		if (list_starts[i + 1] < list_starts[i] || list_starts[i + 1] - list_starts[i] > MAX_SYMPTOM_PER_DATA)
+			return "invalid symptoms lists";
+	}
+
+	for (uint32_t k = 0; k < header -> DataSymptomNumber; ++k)
+	{
+		if (symptoms[k] < 0 || symptoms[k] >= (int) header -> SymptomNumber)
+			return "invalid symptoms lists";
+	}
+
+	// Base dataset, whose content must be the one the file was compiled from. Without it, the file is used as is:
+
+	uint64_t source_size, source_hash;
+
+	if (!baseDatasetStamp(&source_size, &source_hash))
+		return NULL;
+
+	if (source_size != header -> SourceSize || source_hash != header -> SourceHash)
+		return "outdated base dataset";
+
+	return NULL;
+}
+
+
+// Maps the compiled assets file, if not already done:
+static ParsingStatus mapCompiledAssets(void)
+{
+	if (AssetsMapping != NULL)
+		return RESSOURCES_EXIST;
+
+	int fd = open(COMPILED_ASSETS_FILENAME, O_RDONLY);
+
+	if (fd < 0)
+	{
+		printf("\nFile '%s' not found.\n", COMPILED_ASSETS_FILENAME);
 		return REPARSING;
 	}
 
-	short i = 0;
+	struct stat st;
 
-	while (i < string_number && fgets(buffer, MAX_NAME_LENGTH, file) != NULL)
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
 	{
-		buffer[strlen(buffer) - 1] = '\0'; // removing the ending '\n'. strlen(buffer) > 0.
+		printf("\nCannot read the file '%s'.\n", COMPILED_ASSETS_FILENAME);
+		close(fd);
+		return REPARSING;
+	}
+
+	void *mapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
 
-		strcpy(string_array[i], buffer);
-		++i;
+	close(fd); // The mapping stays valid.
+
+	if (mapping == MAP_FAILED)
+	{
+		printf("\nCannot map the file '%s'.\n", COMPILED_ASSETS_FILENAME);
+		return REPARSING;
 	}
 
-	fclose(file);
+	const char *error = checkCompiledAssets((const unsigned char*) mapping, st.st_size);
 
-	if (i < string_number)
+	if (error != NULL)
 	{
-		printf("\nReparsing! Too few strings read: %d vs %d.\n", i, string_number);
-		freeStringsArrays();
-		parseBaseDataset(NULL);
+		printf("\nCannot use the compiled assets '%s': %s.\n", COMPILED_ASSETS_FILENAME, error);
+		munmap(mapping, st.st_size);
 		return REPARSING;
 	}
 
+	AssetsMapping = (unsigned char*) mapping;
+	AssetsMappingSize = st.st_size;
+
 	return LOADING_SUCCESSFUL;
 }
 
 
-// Loads 'IllnessStringArray' and 'SymptomStringArray' in memory from the related files:
-ParsingStatus loadStringNames(void)
+// Maps the compiled assets file, and points the names and criticities arrays which are not loaded yet into it.
+// If 'medData' is not NULL, it is filled with a copy of the medical data, one per illness. Returns LOADING_SUCCESSFUL,
+// or REPARSING if the file is missing, invalid, or compiled from another base dataset: it then needs to be rebuilt.
+ParsingStatus loadCompiledAssets(MedicalData **medData)
 {
-	if (checkNumberValues() == REPARSING)
+	if (mapCompiledAssets() == REPARSING)
 		return REPARSING;
 
-	if (IllnessStringArray != NULL && SymptomStringArray != NULL)
-		return RESSOURCES_EXIST;
-
-	freeStringsArrays(); // In case only one is NULL.
+	const AssetsFileHeader *header = (const AssetsFileHeader*) AssetsMapping;
 
-	IllnessStringArray = createCharMatrix(IllnessNumber, MAX_NAME_LENGTH);
-	SymptomStringArray = createCharMatrix(SymptomNumber, MAX_NAME_LENGTH);
+	// Resources loaded from another parsing must match:
 
-	if (IllnessStringArray == NULL || SymptomStringArray == NULL)
+	if ((IllnessNumber != 0 && IllnessNumber != header -> IllnessNumber) ||
+		(SymptomNumber != 0 && SymptomNumber != header -> SymptomNumber))
 	{
-		printf("\nNot enough memory to create strings arrays.\n");
-		exit(EXIT_FAILURE);
+		printf("\nThe compiled assets do not match the loaded ressources.\n");
+		releaseCompiledAssets();
+		return REPARSING;
 	}
 
-	char buffer[MAX_NAME_LENGTH];
+	IllnessNumber = header -> IllnessNumber;
+	SymptomNumber = header -> SymptomNumber;
 
-	ParsingStatus status_illness = loadStringFile(ILLNESS_LIST_FILENAME, IllnessNumber, IllnessStringArray, buffer);
+	if (CriticityArray == NULL)
+		CriticityArray = (float*) (AssetsMapping + header -> CriticitiesOffset);
 
-	if (status_illness != LOADING_SUCCESSFUL)
+	if (IllnessStringArray == NULL && SymptomStringArray == NULL)
 	{
-		return status_illness;
+		// Only the arrays of pointers are allocated, the names being read from the mapping:
+
+		IllnessStringArray = (char**) calloc(IllnessNumber, sizeof(char*));
+		SymptomStringArray = (char**) calloc(SymptomNumber, sizeof(char*));
+
+		if (IllnessStringArray == NULL || SymptomStringArray == NULL)
+		{
+			printf("\nNot enough memory to create strings arrays.\n");
+			exit(EXIT_FAILURE);
+		}
+
+		const uint32_t *name_offsets = (const uint32_t*) (AssetsMapping + header -> NameOffsetsOffset);
+		char *names = (char*) (AssetsMapping + header -> NamesOffset);
+
+		for (int i = 0; i < IllnessNumber; ++i)
+			IllnessStringArray[i] = names + name_offsets[i];
+
+		for (int i = 0; i < SymptomNumber; ++i)
+			SymptomStringArray[i] = names + name_offsets[IllnessNumber + i];
+
+		buildNameIndexes();
 	}
 
-	ParsingStatus status_symptom = loadStringFile(SYMPTOM_LIST_FILENAME, SymptomNumber, SymptomStringArray, buffer);
+	if (medData == NULL)
+		return LOADING_SUCCESSFUL;
+
+	// Copying the medical data, which is owned by the caller:
+
+	const uint32_t *list_starts = (const uint32_t*) (AssetsMapping + header -> ListStartsOffset);
+	const Symptom *symptoms = (const Symptom*) (AssetsMapping + header -> SymptomsOffset);
+
+	*medData = (MedicalData*) calloc(IllnessNumber, sizeof(MedicalData));
+
+	if (*medData == NULL)
+	{
+		printf("\nNot enough memory to allocate to 'medData'.\n");
+		exit(EXIT_FAILURE);
+	}
 
-	if (status_symptom != LOADING_SUCCESSFUL)
+	for (int i = 0; i < IllnessNumber; ++i)
 	{
-		return status_symptom;
+		(*medData)[i].illness = i;
+		(*medData)[i].symptomNumber = list_starts[i + 1] - list_starts[i];
+		(*medData)[i].symptomArray = (Symptom*) calloc((*medData)[i].symptomNumber, sizeof(Symptom));
+
+		if ((*medData)[i].symptomArray == NULL)
+		{
+			printf("\nNot enough memory to allocate to 'medData[%d]'.\n", i);
+			freeMedicalData(medData, IllnessNumber);
+			exit(EXIT_FAILURE);
+		}
+
+		memcpy((*medData)[i].symptomArray, symptoms + list_starts[i], (*medData)[i].symptomNumber * sizeof(Symptom));
 	}
 
-	printf("\nString names loaded succesfully.\n");
 	return LOADING_SUCCESSFUL;
 }
+
+
+// Returns 1 if the given address is in the compiled assets mapping, 0 otherwise:
+int inCompiledAssets(const void *address)
+{
+	return AssetsMapping != NULL && (const unsigned char*) address >= AssetsMapping &&
+		(const unsigned char*) address < AssetsMapping + AssetsMappingSize;
+}
+
+
+// Unmaps the compiled assets, once neither the names nor the criticities point into them anymore:
+void releaseCompiledAssets(void)
+{
+	if (AssetsMapping == NULL || inCompiledAssets(CriticityArray) ||
+		(IllnessStringArray != NULL && IllnessNumber > 0 && inCompiledAssets(IllnessStringArray[0])) ||
+		(SymptomStringArray != NULL && SymptomNumber > 0 && inCompiledAssets(SymptomStringArray[0])))
+	{
+		return;
+	}
+
+	munmap(AssetsMapping, AssetsMappingSize);
+
+	AssetsMapping = NULL;
+	AssetsMappingSize = 0;
+}
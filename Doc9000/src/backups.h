@@ -9,12 +9,31 @@
 ParsingStatus saveParsingResults(void);
 
 
-// Load 'IllnessNumber', 'SymptomNumber', and the criticites from the related file.
+// Load 'IllnessNumber', 'SymptomNumber', and the criticites from the compiled assets file.
 ParsingStatus loadCriticities(void);
 
 
-// Loads 'IllnessStringArray' and 'SymptomStringArray' in memory from the related files:
+// Loads 'IllnessStringArray' and 'SymptomStringArray' in memory from the compiled assets file:
 ParsingStatus loadStringNames(void);
 
 
+// Compiles the illnesses and symptoms names, the criticities and the given medical data (one per illness) into a
+// single file, mapped at start-up by loadCompiledAssets(). Returns SAVING_SUCCESSFUL, or PARSING_FAILED.
+ParsingStatus saveCompiledAssets(const MedicalData *medData);
+
+
+// Maps the compiled assets file, and points the names and criticities arrays which are not loaded yet into it.
+// If 'medData' is not NULL, it is filled with a copy of the medical data, one per illness. Returns LOADING_SUCCESSFUL,
+// or REPARSING if the file is missing, invalid, or compiled from another base dataset: it then needs to be rebuilt.
+ParsingStatus loadCompiledAssets(MedicalData **medData);
+
+
+// Returns 1 if the given address is in the compiled assets mapping, 0 otherwise:
+int inCompiledAssets(const void *address);
+
+
+// Unmaps the compiled assets, once neither the names nor the criticities point into them anymore:
+void releaseCompiledAssets(void);
+
+
 #endif
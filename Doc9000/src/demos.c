@@ -1,5 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include <time.h>
 
 #include "demos.h"
@@ -9,6 +11,7 @@
 #include "auth.h"
 #include "prediagnostic_file.h"
 #include "diagnostic_making.h"
+#include "medrec_cache.h"
 
 
 #define ADD_SEPARATOR() \
@@ -231,6 +234,74 @@ int testDiagnosticProduction(void)
 }
 
 
+// Checking that batched diagnostics are the same as single ones, and that invalid prediagnostics are skipped:
+int testBatchedDiagnostics(void)
+{
+	ADD_SEPARATOR();
+	printf("-> Making a batch of diagnostics:\n");
+
+	Symptom declaredSymptoms_1[] = {getSymptomID("cough"), getSymptomID("wheezing"), getSymptomID("dyspnea")};
+	Symptom declaredSymptoms_2[] = {getSymptomID("fever"), getSymptomID("headache")};
+
+	float declaredSymptomsConfidences[] = {1., 0.8, 0.6};
+
+	PreDiagnostic prediag_1 =
+	{
+		.timestamp = time(NULL),
+		.id_socdet = 51,
+		.patientConfidenceLevel = 1.,
+		.symptomNumber = ARRAY_LENGTH(declaredSymptoms_1),
+		.declaredSymptoms = declaredSymptoms_1,
+		.declaredSymptomsConfidences = declaredSymptomsConfidences
+	};
+
+	PreDiagnostic prediag_2 = prediag_1;
+	prediag_2.patientConfidenceLevel = 0.5;
+	prediag_2.symptomNumber = ARRAY_LENGTH(declaredSymptoms_2);
+	prediag_2.declaredSymptoms = declaredSymptoms_2;
+
+	PreDiagnostic prediag_invalid = prediag_1;
+	prediag_invalid.symptomNumber = 0;
+
+	const PreDiagnostic *prediagArray[] = {&prediag_1, &prediag_invalid, &prediag_2, NULL};
+	const int expected_results[] = {1, 0, 1, 0};
+
+	const int batch_size = ARRAYS_COMPARE_LENGTH(prediagArray, expected_results);
+
+	Diagnostic diagArray[batch_size];
+	int results[batch_size];
+
+	makeDiagnosticBatch(diagArray, results, prediagArray, NULL, batch_size);
+
+	int result = 1;
+
+	for (int i = 0; i < batch_size; ++i)
+	{
+		result &= results[i] == expected_results[i];
+
+		if (!results[i] || !makeDiagnostic(prediagArray[i], NULL))
+			continue;
+
+		const Diagnostic *single_diag = getFilledDiagnostic();
+
+		result &= fabsf(single_diag -> criticity - diagArray[i].criticity) < 1e-5f;
+
+		for (int j = 0; j < DIAG_ILLNESS_NUMBER; ++j)
+		{
+			result &= single_diag -> illnessArray[j] == diagArray[i].illnessArray[j];
+			result &= fabsf(single_diag -> illnessProbabilityArray[j] - diagArray[i].illnessProbabilityArray[j]) < 1e-5f;
+		}
+	}
+
+	ADD_SEPARATOR();
+
+	if (!result)
+		printf("-> FAILED test: 'testBatchedDiagnostics'.\n");
+
+	return result;
+}
+
+
 // Trying to read a diagnostic from the database:
 int testReadDiagnostic(int id_diag)
 {
@@ -271,6 +342,430 @@ int testReadMedicalRecord(int id_socdet)
 }
 
 
+// Checking the medical records cache: copies, invalidation, and eviction of the least recently used record.
+int testMedicalRecordCache(void)
+{
+	ADD_SEPARATOR();
+	printf("-> Checking the medical records cache:\n");
+
+	if (MEDREC_CACHE_SIZE <= 0)
+	{
+		printf("-> Cache disabled.\n");
+		ADD_SEPARATOR();
+		return 1;
+	}
+
+	freeMedicalRecordCache();
+
+	MedicalRecord *medrec = allocateMedicalRecord(1);
+	medrec -> id_medrec = 12;
+	medrec -> age = 40;
+	medrec -> diagnosticArray[0].criticity = 0.5f;
+
+	const int id_socdet = 1, other_id_socdet = 2;
+
+	int result = getCachedMedicalRecord(id_socdet) == NULL;
+
+	cacheMedicalRecord(id_socdet, medrec, getMedicalRecordGeneration(id_socdet));
+	medrec -> age = 41; // Must not affect the cached copy.
+
+	MedicalRecord *cached = getCachedMedicalRecord(id_socdet);
+
+	result &= cached != NULL && cached != medrec && cached -> id_medrec == 12 && cached -> age == 40 &&
+		cached -> diagnosticNumber == 1 && cached -> diagnosticArray[0].criticity == 0.5f;
+
+	freeMedicalRecord(&cached);
+
+	// A record read before an invalidation must not be cached afterwards:
+
+	const unsigned int generation = getMedicalRecordGeneration(id_socdet);
+
+	invalidateCachedMedicalRecord(id_socdet);
+
+	result &= getCachedMedicalRecord(id_socdet) == NULL;
+
+	cacheMedicalRecord(id_socdet, medrec, generation);
+
+	result &= getCachedMedicalRecord(id_socdet) == NULL;
+
+	// Filling the cache, while keeping the first record recently used:
+
+	cacheMedicalRecord(id_socdet, medrec, getMedicalRecordGeneration(id_socdet));
+	cacheMedicalRecord(other_id_socdet, medrec, getMedicalRecordGeneration(other_id_socdet));
+
+	for (int i = 0; i < MEDREC_CACHE_SIZE; ++i)
+	{
+		cached = getCachedMedicalRecord(id_socdet);
+		result &= cached != NULL;
+		freeMedicalRecord(&cached);
+
+		cacheMedicalRecord(100 + i, medrec, getMedicalRecordGeneration(100 + i));
+	}
+
+	cached = getCachedMedicalRecord(id_socdet);
+	result &= cached != NULL;
+	freeMedicalRecord(&cached);
+
+	result &= getCachedMedicalRecord(other_id_socdet) == NULL; // Evicted.
+
+	printMedicalRecordCacheStats();
+
+	freeMedicalRecord(&medrec);
+	freeMedicalRecordCache();
+
+	ADD_SEPARATOR();
+
+	if (!result)
+		printf("-> FAILED test: 'testMedicalRecordCache'.\n");
+
+	return result;
+}
+
+
+// Checking that the generated datasets only depend on their seed, and not on the number of generating threads:
+int testDatasetGeneration(void)
+{
+	ADD_SEPARATOR();
+	printf("-> Checking the dataset generation:\n");
+
+	const int inputs_number = 5000;
+
+	double time_1 = get_time();
+
+	Inputs *dataset = createDataset(inputs_number, LEARNING_DATASET_SEED, 1);
+
+	double time_2 = get_time();
+
+	Inputs *dataset_parallel = createDataset(inputs_number, LEARNING_DATASET_SEED, DATASET_THREAD_NUMBER + 1);
+
+	double time_3 = get_time();
+
+	Inputs *dataset_other = createDataset(inputs_number, VALIDATION_DATASET_SEED, DATASET_THREAD_NUMBER + 1);
+
+	const size_t questions_bytes = sizeof(Number) * inputs_number * (dataset -> QuestionsSize + 1);
+	const size_t answers_bytes = sizeof(Number) * inputs_number * dataset -> AnswersSize;
+
+	int result = memcmp(dataset -> QuestionsData, dataset_parallel -> QuestionsData, questions_bytes) == 0 &&
+		memcmp(dataset -> AnswersData, dataset_parallel -> AnswersData, answers_bytes) == 0 &&
+		memcmp(dataset -> QuestionsData, dataset_other -> QuestionsData, questions_bytes) != 0;
+
+	printf("\nGeneration time of %d inputs: %.4f s with 1 thread, %.4f s with %d threads.\n\n", inputs_number,
+		time_2 - time_1, time_3 - time_2, DATASET_THREAD_NUMBER + 1);
+
+	freeInputs(&dataset_other);
+	freeInputs(&dataset_parallel);
+	freeInputs(&dataset);
+
+	ADD_SEPARATOR();
+
+	if (!result)
+		printf("-> FAILED test: 'testDatasetGeneration'.\n");
+
+	return result;
+}
+
+
+// Checking that every illness and symptom name is found back from its hashed index, and that unknown names are not:
+int testNameLookup(void)
+{
+	ADD_SEPARATOR();
+	printf("-> Checking the illnesses and symptoms names lookup:\n");
+
+	const short illness_number = getIllnessNumber(), symptom_number = getSymptomNumber();
+	const int repeats = 100;
+
+	int errors = 0;
+
+	double time_1 = get_time();
+
+	for (int r = 0; r < repeats; ++r)
+	{
+		for (Illness illness = 0; illness < illness_number; ++illness)
+			errors += getIllnessID(getIllnessName(illness)) != illness;
+
+		for (Symptom symptom = 0; symptom < symptom_number; ++symptom)
+			errors += getSymptomID(getSymptomName(symptom)) != symptom;
+	}
+
+	double time_2 = get_time();
+
+	errors += getSymptomID("unknown_symptom_name") != 0;
+	errors += getIllnessID("unknown_illness_name") != 0;
+
+	printf("\n%d lookups, %.1f ns per lookup. Errors: %d\n\n", repeats * (illness_number + symptom_number),
+		1e9 * (time_2 - time_1) / (repeats * (illness_number + symptom_number)), errors);
+
+	ADD_SEPARATOR();
+
+	if (errors != 0)
+		printf("-> FAILED test: 'testNameLookup'.\n");
+
+	return errors == 0;
+}
+
+
+// Checking that prediagnostics read in a too small arena are valid, and that the arena then grows to hold them:
+int testRequestArena(void)
+{
+	ADD_SEPARATOR();
+	printf("-> Checking the requests arena:\n");
+
+	Symptom declaredSymptoms[] = {8, 12, 21};
+	float declaredSymptomsConfidences[] = {0.5, 1., 0.25};
+
+	PreDiagnostic prediag =
+	{
+		.timestamp = time(NULL),
+		.id_socdet = 42,
+		.patientConfidenceLevel = 1.,
+		.symptomNumber = ARRAYS_COMPARE_LENGTH(declaredSymptoms, declaredSymptomsConfidences),
+		.declaredSymptoms = declaredSymptoms,
+		.declaredSymptomsConfidences = declaredSymptomsConfidences
+	};
+
+	if (!writePreDiagnosticFile(&prediag))
+	{
+		printf("-> FAILED test: 'testRequestArena'.\n");
+		return 0;
+	}
+
+	const char *filename = lastGeneratedPreDiagnosticFilename();
+	const int request_number = 8, rounds = 2;
+
+	Arena *arena = createArena(sizeof(PreDiagnostic)); // Too small for a single prediagnostic.
+
+	int errors = arena == NULL, overflows[2] = {0};
+
+	for (int round = 0; round < rounds && arena != NULL; ++round)
+	{
+		for (int r = 0; r < request_number; ++r)
+		{
+			PreDiagnostic *read_prediag = readPreDiagnosticFileInArena(filename, arena);
+
+			errors += read_prediag == NULL;
+
+			if (read_prediag == NULL)
+				continue;
+
+			errors += read_prediag -> id_socdet != 42 || read_prediag -> symptomNumber != prediag.symptomNumber;
+
+			for (int i = 0; i < prediag.symptomNumber && i < read_prediag -> symptomNumber; ++i)
+			{
+				errors += read_prediag -> declaredSymptoms[i] != declaredSymptoms[i];
+				errors += read_prediag -> declaredSymptomsConfidences[i] != declaredSymptomsConfidences[i];
+			}
+		}
+
+		overflows[round] = arena -> OverflowNumber;
+		resetArena(arena);
+	}
+
+	freeArena(&arena);
+	remove(filename);
+
+	printf("\nHeap allocations: %d in the first round, %d in the second. Errors: %d\n\n", overflows[0], overflows[1], errors);
+
+	ADD_SEPARATOR();
+
+	const int success = errors == 0 && overflows[0] > 0 && overflows[1] == 0;
+
+	if (!success)
+		printf("-> FAILED test: 'testRequestArena'.\n");
+
+	return success;
+}
+
+
+// Writing prediagnostics in a batch container, and reading them back. A truncated last record must be detected:
+int testPreDiagnosticBatchFile(void)
+{
+	ADD_SEPARATOR();
+	printf("-> Checking the prediagnostics batch containers:\n");
+
+	Symptom declaredSymptoms[] = {8, no_symptom, 12, 21};
+	float declaredSymptomsConfidences[] = {0.5, 0.75, 1., 0.25};
+
+	PreDiagnostic prediag =
+	{
+		.timestamp = time(NULL),
+		.patientConfidenceLevel = 1.,
+		.symptomNumber = ARRAYS_COMPARE_LENGTH(declaredSymptoms, declaredSymptomsConfidences),
+		.declaredSymptoms = declaredSymptoms,
+		.declaredSymptomsConfidences = declaredSymptomsConfidences
+	};
+
+	const int record_number = 1000;
+
+	PreDiagnosticBatchWriter *writer = createPreDiagnosticBatchWriter();
+
+	int errors = writer == NULL;
+
+	for (int r = 0; r < record_number && writer != NULL; ++r)
+	{
+		prediag.id_socdet = r;
+		errors += !appendPreDiagnosticToBatch(writer, &prediag);
+	}
+
+	errors += writer != NULL && !closePreDiagnosticBatchWriter(&writer);
+
+	char filename[MAX_FILENAME_PATH_LENGTH];
+	snprintf(filename, MAX_FILENAME_PATH_LENGTH, "%s", lastGeneratedPreDiagnosticFilename());
+
+	// Appending an incomplete record, as left by a crashed emitter:
+
+	FILE *file = fopen(filename, "ab");
+
+	if (file != NULL)
+	{
+		const int record_size = 100;
+		fwrite(&record_size, sizeof(int), 1, file);
+		fwrite(&record_size, sizeof(int), 1, file);
+		fclose(file);
+	}
+
+	Arena *arena = createArena(REQUEST_ARENA_SIZE);
+
+	double time_1 = get_time();
+
+	PreDiagnosticBatchFile *batch = openPreDiagnosticBatchFile(filename);
+
+	PreDiagnostic *read_prediag;
+
+	int read_number = 0;
+
+	size_t last_offset = BATCH_HEADER_SIZE; // Of the truncated record, once all are read.
+
+	while (readNextPreDiagnostic(batch, &read_prediag, arena))
+	{
+		last_offset = batch -> offset;
+
+		errors += read_prediag == NULL || read_prediag -> id_socdet != read_number || read_prediag -> symptomNumber != 3;
+
+		if (read_prediag != NULL && read_prediag -> symptomNumber == 3)
+		{
+			errors += read_prediag -> declaredSymptoms[1] != 12 || read_prediag -> declaredSymptomsConfidences[1] != 1.f;
+			errors += read_prediag -> declaredSymptoms[2] != 21 || read_prediag -> declaredSymptomsConfidences[2] != 0.25f;
+		}
+
+		++read_number;
+
+		if (read_number % DIAG_BATCH_SIZE == 0)
+			resetArena(arena);
+	}
+
+	double time_2 = get_time();
+
+	errors += batch == NULL || !batch -> truncated || read_number != record_number;
+
+	// Copying the first and the truncated records, as done with failed records:
+
+	PreDiagnosticBatchWriter *copy_writer = createPreDiagnosticBatchWriter();
+
+	errors += !copyBatchRecord(copy_writer, batch, BATCH_HEADER_SIZE) || !copyBatchRecord(copy_writer, batch, last_offset);
+	errors += copy_writer == NULL || !closePreDiagnosticBatchWriter(&copy_writer);
+
+	PreDiagnosticBatchFile *copy = openPreDiagnosticBatchFile(lastGeneratedPreDiagnosticFilename());
+
+	int copy_number = 0;
+
+	while (readNextPreDiagnostic(copy, &read_prediag, arena))
+		errors += read_prediag == NULL || read_prediag -> id_socdet != copy_number++;
+
+	errors += copy == NULL || !copy -> truncated || copy_number != 1;
+
+	closePreDiagnosticBatchFile(&copy);
+	remove(lastGeneratedPreDiagnosticFilename());
+
+	closePreDiagnosticBatchFile(&batch);
+	freeArena(&arena);
+	remove(filename);
+
+	printf("\n%d records read in %.3f ms. Errors: %d\n\n", read_number, 1000. * (time_2 - time_1), errors);
+
+	ADD_SEPARATOR();
+
+	if (errors != 0)
+		printf("-> FAILED test: 'testPreDiagnosticBatchFile'.\n");
+
+	return errors == 0;
+}
+
+
+// Checking that truncated or oversized prediagnostic files are rejected, without any allocation:
+int testTruncatedPreDiagnosticFiles(void)
+{
+	ADD_SEPARATOR();
+	printf("-> Checking the rejection of truncated prediagnostic files:\n");
+
+	Symptom declaredSymptoms[] = {8, 12, 21};
+	float declaredSymptomsConfidences[] = {0.5, 1., 0.25};
+
+	PreDiagnostic prediag =
+	{
+		.timestamp = time(NULL),
+		.id_socdet = 42,
+		.patientConfidenceLevel = 1.,
+		.symptomNumber = ARRAYS_COMPARE_LENGTH(declaredSymptoms, declaredSymptomsConfidences),
+		.declaredSymptoms = declaredSymptoms,
+		.declaredSymptomsConfidences = declaredSymptomsConfidences
+	};
+
+	unsigned char content[64] = {0};
+
+	const int file_size = 4 * prediag.symptomNumber + 18;
+
+	int errors = !writePreDiagnosticFile(&prediag);
+
+	const char *filename = lastGeneratedPreDiagnosticFilename();
+
+	FILE *file = fopen(filename, "rb");
+
+	errors += file == NULL || fread(content, 1, sizeof(content), file) != file_size;
+
+	if (file != NULL)
+		fclose(file);
+
+	Arena *arena = createArena(REQUEST_ARENA_SIZE);
+
+	// Every size but the right one must be rejected:
+
+	for (int size = 0; size <= file_size + 1 && errors == 0; ++size)
+	{
+		file = fopen(filename, "wb");
+
+		if (file == NULL)
+		{
+			++errors;
+			break;
+		}
+
+		fwrite(content, 1, size, file);
+		fclose(file);
+
+		PreDiagnostic *read_prediag = readPreDiagnosticFileInArena(filename, arena);
+
+		if (size == file_size)
+			errors += read_prediag == NULL || read_prediag -> id_socdet != 42 || read_prediag -> declaredSymptoms[2] != 21;
+		else
+			errors += read_prediag != NULL || arena -> Requested != 0;
+
+		resetArena(arena);
+	}
+
+	freeArena(&arena);
+	remove(filename);
+
+	printf("\nErrors: %d\n\n", errors);
+
+	ADD_SEPARATOR();
+
+	if (errors != 0)
+		printf("-> FAILED test: 'testTruncatedPreDiagnosticFiles'.\n");
+
+	return errors == 0;
+}
+
+
 // Tries to write a diagnostic to the local database,
 // does nothing on the real one, to not clutter it.
 int testWriteDiagnostic(int id_socdet)
@@ -22,6 +22,10 @@ int test_WriteAndRead_PreDiagnosticFile(void);
 int testDiagnosticProduction(void);
 
 
+// Checking that batched diagnostics are the same as single ones, and that invalid prediagnostics are skipped:
+int testBatchedDiagnostics(void);
+
+
 // Trying to read a diagnostic from the database:
 int testReadDiagnostic(int id_diag);
 
@@ -30,6 +34,30 @@ int testReadDiagnostic(int id_diag);
 int testReadMedicalRecord(int id_socdet);
 
 
+// Checking the medical records cache: copies, invalidation, and eviction of the least recently used record.
+int testMedicalRecordCache(void);
+
+
+// Checking that the generated datasets only depend on their seed, and not on the number of generating threads:
+int testDatasetGeneration(void);
+
+
+// Checking that every illness and symptom name is found back from its hashed index, and that unknown names are not:
+int testNameLookup(void);
+
+
+// Checking that prediagnostics read in a too small arena are valid, and that the arena then grows to hold them:
+int testRequestArena(void);
+
+
+// Writing prediagnostics in a batch container, and reading them back. A truncated last record must be detected:
+int testPreDiagnosticBatchFile(void);
+
+
+// Checking that truncated or oversized prediagnostic files are rejected, without any allocation:
+int testTruncatedPreDiagnosticFiles(void);
+
+
 // Tries to write a diagnostic to the local database,
 // does nothing on the real one, to not clutter it.
 int testWriteDiagnostic(int id_socdet);
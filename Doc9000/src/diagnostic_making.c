@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <pthread.h>
 
 #include "diagnostic_making.h"
 #include "parsing.h"
@@ -9,27 +10,88 @@
 #include "api.h"
 
 
+// Ressources needed to make diagnostics. Each thread making diagnostics has its own:
+typedef struct
+{
+	NeuralNetwork *network; // 'NetworkLoaded' for the main thread, a replica sharing its nets for the others.
+	QuantizedNetwork *quantizedNetwork; // Same, with 'QuantizedLoaded'. NULL without INT8_INFERENCE.
+	Inputs *inputsToFill;
+	Diagnostic diagnosticToFill;
+	int bufferIndexGreaterValues[DIAG_ILLNESS_NUMBER];
+	int batchRowIndex[DIAG_BATCH_SIZE]; // Rows of 'inputsToFill' used by each prediagnostic of the current batch.
+	Arena *arena; // Prediagnostics and medical records of the current request, reset once it is processed.
+} RecognitionScratch;
+
+
 static NeuralNetwork *NetworkLoaded;
-static Inputs *InputsToFill;
-static Diagnostic DiagnosticToFill;
-static int BufferIndexGreaterValues[DIAG_ILLNESS_NUMBER];
+static QuantizedNetwork *QuantizedLoaded;
+static RecognitionScratch MainScratch;
+static __thread RecognitionScratch *ThreadScratch; // NULL if the thread uses 'MainScratch'.
+
 static unsigned int WrittenDiagCount;
+static pthread_mutex_t WrittenDiagCountMutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+// Returns the recognition ressources of the calling thread:
+static RecognitionScratch* getScratch(void);
+
+
+// Creates the inputs to fill with the prediagnostics data:
+static Inputs* createInputsToFill(void);
+
+
+// Creates the arena of a thread's requests:
+static Arena* createArenaOrExit(void);
+
+
+// Runs a single propagation on the 'batch_size' first questions of the scratch inputs:
+static void predictBatch(RecognitionScratch *scratch, int batch_size);
+
+
+// Fills a diagnostic from the network answer of the given prediagnostic:
+static void fillDiagnostic(RecognitionScratch *scratch, Diagnostic *diag, const Number *answer,
+	const PreDiagnostic *prediag, const MedicalRecord *medrec);
+
+
+// Fetches the medical records of at most DIAG_BATCH_SIZE read prediagnostics, some of which can be NULL, makes their
+// diagnostics and writes them. The prediagnostics and medical records live in the given arena, which is then reset.
+// 'results' is filled with 1 for each written diagnostic, and 0 else. Returns the number of successes.
+static int processReadPreDiagnostics(PreDiagnostic **prediagArray, int *results, int batch_size, Arena *arena);
+
+
+// Copies the record of the given container starting at 'record_offset' to the failed records container, created
+// with the given filename at the first failure. 'failures_saved' is set to 0 if that fails.
+static void saveFailedRecord(PreDiagnosticBatchWriter **failed_writer, const char *failed_filename,
+	const PreDiagnosticBatchFile *batch, size_t record_offset, int *failures_saved);
+
+
+// Writes the successfully made diagnostics of a batch on the database, with a single transaction. If that fails,
+// each diagnostic is written on its own, for a faulty one not to discard the others. 'results' is updated
+// accordingly, and the number of written diagnostics is returned.
+static int writeDiagnostics(const Diagnostic *diagArray, int *results, const PreDiagnostic *const *prediagArray,
+	const MedicalRecord *const *medrecArray, int batch_size);
 
 
 // Returns the count of diagnostics which were successfully
 // made and written on the database, since the program started.
 unsigned int getWrittenDiagnosticCount(void)
 {
-	return WrittenDiagCount;
+	pthread_mutex_lock(&WrittenDiagCountMutex);
+
+	unsigned int count = WrittenDiagCount;
+
+	pthread_mutex_unlock(&WrittenDiagCountMutex);
+
+	return count;
 }
 
 
-// Returns the should-be-filled current diagnostic. In order for this to be relevant,
-// a makeDiagnostic() (or a function calling it) must be issued beforehand. Do not
+// Returns the should-be-filled current diagnostic of the calling thread. In order for this to be
+// relevant, a makeDiagnostic() (or a function calling it) must be issued beforehand. Do not
 // try to free this ressource.
 const Diagnostic* getFilledDiagnostic(void)
 {
-	return &DiagnosticToFill;
+	return &(getScratch() -> diagnosticToFill);
 }
 
 
@@ -49,7 +111,7 @@ const NeuralNetwork* getLoaded_NeuralNetwork(void)
 // frequently may slow down the whole application.
 void initRecognitionRessources(void)
 {
-	if (NetworkLoaded != NULL && InputsToFill != NULL)
+	if (NetworkLoaded != NULL && MainScratch.inputsToFill != NULL)
 		return;
 
 	freeRecognitionRessources(); // In case only one is NULL!
@@ -57,9 +119,12 @@ void initRecognitionRessources(void)
 	////////////////////////////////////////////////////////////
 	// Loading the neural network:
 
-	const int max_batch_size = 1; // 1 is enough here, the learning phase is over.
+	const int max_batch_size = DIAG_BATCH_SIZE; // The learning phase is over, this is only for batched diagnostics.
+
+	NetworkLoaded = mapNetworkFile(NEURAL_NET_FILE_PATH, max_batch_size);
 
-	NetworkLoaded = loadNetwork(NEURAL_NET_DIR_PATH, max_batch_size);
+	if (NetworkLoaded == NULL) // Falling back to the folder format.
+		NetworkLoaded = loadNetwork(NEURAL_NET_DIR_PATH, max_batch_size);
 
 	if (NetworkLoaded == NULL)
 	{
@@ -68,9 +133,8 @@ void initRecognitionRessources(void)
 	}
 
 	////////////////////////////////////////////////////////////
-	// Creating an input to fill with the prediagnostic data:
+	// Creating the inputs to fill with the prediagnostics data:
 
-	const int questions_number = 1;
 	const int questions_size = network_inputSize(NetworkLoaded);
 	const int answers_size = network_outputSize(NetworkLoaded);
 
@@ -86,20 +150,79 @@ void initRecognitionRessources(void)
 		exit(EXIT_FAILURE);
 	}
 
-	Number **questions = createMatrix(questions_number, questions_size);
-	InputsToFill = createInputs(questions_number, questions_size, answers_size, questions, NULL);
+	MainScratch.network = NetworkLoaded;
+	MainScratch.inputsToFill = createInputsToFill();
+	MainScratch.arena = createArenaOrExit();
+
+	if (INT8_INFERENCE)
+	{
+		QuantizedLoaded = quantizeNetwork(NetworkLoaded, max_batch_size);
+		MainScratch.quantizedNetwork = QuantizedLoaded;
+	}
 
 	printf("Recognition ressouces were successfully loaded.\n");
 }
 
 
-// Frees the neural network and the Inputs struct from memory. Call this upon program exit.
+// Frees the neural network and the Inputs struct from memory. Call this upon program exit,
+// once every thread has called freeThreadRecognitionRessources().
 void freeRecognitionRessources(void)
 {
-	freeInputs(&InputsToFill); // frees the question array! Careful...
+	freeInputs(&(MainScratch.inputsToFill)); // frees the question array! Careful...
+	freeQuantizedNetwork(&QuantizedLoaded);
 	freeNetwork(&NetworkLoaded);
+	freeArena(&(MainScratch.arena));
+
+	MainScratch.network = NULL;
+	MainScratch.quantizedNetwork = NULL;
+
+	// N.B: 'inputsToFill', 'QuantizedLoaded' and 'NetworkLoaded' have been reset to NULL.
+}
+
+
+// Gives its own recognition ressources to the calling thread, which shares the nets of the loaded network.
+// Must be called by each thread making diagnostics (apart from the main one), after initRecognitionRessources().
+void initThreadRecognitionRessources(void)
+{
+	if (ThreadScratch != NULL)
+		return;
+
+	if (NetworkLoaded == NULL)
+	{
+		printf("\nThe recognition ressources must be loaded before any thread uses them.\n\n");
+		exit(EXIT_FAILURE);
+	}
+
+	ThreadScratch = (RecognitionScratch*) calloc(1, sizeof(RecognitionScratch));
+
+	if (ThreadScratch == NULL)
+	{
+		printf("\nNot enough memory to create the recognition ressources of a thread.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	ThreadScratch -> network = createNetworkReplica(NetworkLoaded, DIAG_BATCH_SIZE);
+	ThreadScratch -> inputsToFill = createInputsToFill();
+	ThreadScratch -> arena = createArenaOrExit();
+
+	if (QuantizedLoaded != NULL)
+		ThreadScratch -> quantizedNetwork = createQuantizedReplica(QuantizedLoaded, DIAG_BATCH_SIZE);
+}
 
-	// N.B: 'InputsToFill' and 'NetworkLoaded' have been reset to NULL.
+
+// Frees the recognition ressources of the calling thread. Call this before the thread ends:
+void freeThreadRecognitionRessources(void)
+{
+	if (ThreadScratch == NULL)
+		return;
+
+	freeInputs(&(ThreadScratch -> inputsToFill));
+	freeQuantizedReplica(&(ThreadScratch -> quantizedNetwork));
+	freeNetworkReplica(&(ThreadScratch -> network));
+	freeArena(&(ThreadScratch -> arena));
+
+	free(ThreadScratch);
+	ThreadScratch = NULL;
 }
 
 
@@ -109,93 +232,307 @@ void freeRecognitionRessources(void)
 // and 0 else. This should _not_ break the whole program in case of failure.
 int diagnosticProcessing(const char *prediag_filename)
 {
-	PreDiagnostic *prediag = readPreDiagnosticFile(prediag_filename);
+	initRecognitionRessources(); // to be sure ressouces are loaded.
+
+	Arena *arena = getScratch() -> arena; // Holds the prediagnostic and the medical record, until the end of the request.
+
+	PreDiagnostic *prediag = readPreDiagnosticFileInArena(prediag_filename, arena);
 
 	if (prediag == NULL)
-		return 0;
+		goto failure;
 
 	if (VERBOSE_MODE >= 2)
 		printPreDiagnostic(prediag);
 
 	const int id_socdet = prediag -> id_socdet;
 
-	MedicalRecord *medrec = readMedicalRecord(id_socdet); // returns NULL if id_socdet = 0.
+	MedicalRecord *medrec = readMedicalRecordInArena(id_socdet, arena); // returns NULL if id_socdet = 0.
 
 	if (!makeDiagnostic(prediag, medrec)) // accepts a NULL medrec.
 		goto failure;
 
-	if (!writeDiagnostic(&DiagnosticToFill, id_socdet))
+	if (!writeDiagnostic(getFilledDiagnostic(), id_socdet))
 		goto failure;
 
+	pthread_mutex_lock(&WrittenDiagCountMutex);
 	++WrittenDiagCount;
+	pthread_mutex_unlock(&WrittenDiagCountMutex);
 
-	freeMedicalRecord(&medrec);
-	freePreDiagnostic(&prediag);
+	resetArena(arena);
 	return 1;
 
 	failure:
-		freeMedicalRecord(&medrec);
-		freePreDiagnostic(&prediag);
+		resetArena(arena);
 		return 0;
 }
 
 
+// Whole event chain for 'file_number' diagnostics, like diagnosticProcessing(), but making all
+// the diagnostics of each DIAG_BATCH_SIZE files at once. 'results' is filled with 1 for each
+// successfully processed file, and 0 else. Returns the number of successes.
+int diagnosticProcessingBatch(const char *const *prediag_filenames, int *results, int file_number)
+{
+	PreDiagnostic *prediagArray[DIAG_BATCH_SIZE];
+
+	initRecognitionRessources(); // to be sure ressouces are loaded.
+
+	Arena *arena = getScratch() -> arena; // Holds the prediagnostics and medical records, until the end of each batch.
+
+	int success_number = 0;
+
+	for (int batch_start = 0; batch_start < file_number; batch_start += DIAG_BATCH_SIZE)
+	{
+		const int batch_size = MIN(DIAG_BATCH_SIZE, file_number - batch_start);
+
+		for (int i = 0; i < batch_size; ++i)
+			prediagArray[i] = readPreDiagnosticFileInArena(prediag_filenames[batch_start + i], arena);
+
+		success_number += processReadPreDiagnostics(prediagArray, results + batch_start, batch_size, arena);
+	}
+
+	pthread_mutex_lock(&WrittenDiagCountMutex);
+	WrittenDiagCount += success_number;
+	pthread_mutex_unlock(&WrittenDiagCountMutex);
+
+	return success_number;
+}
+
+
+// Whole event chain for the prediagnostics of a batch container, like diagnosticProcessingBatch(), its records being
+// read DIAG_BATCH_SIZE at a time from the mapped container. 'record_number' is set to the number of records, invalid
+// ones included, a container which cannot be opened or whose last record is truncated counting as one more invalid
+// record. The failed records are copied to a new container named 'failed_filename', for the container not to be
+// processed again whole: 'failures_saved' is set to 1 if there is no failure or if all of them have been copied,
+// and 0 else. Returns the number of successes.
+int diagnosticProcessingBatchFile(const char *batch_filename, const char *failed_filename, int *record_number,
+	int *failures_saved)
+{
+	PreDiagnostic *prediagArray[DIAG_BATCH_SIZE];
+	int results[DIAG_BATCH_SIZE];
+	size_t record_offsets[DIAG_BATCH_SIZE + 1];
+
+	initRecognitionRessources(); // to be sure ressouces are loaded.
+
+	Arena *arena = getScratch() -> arena; // Holds the prediagnostics and medical records, until the end of each batch.
+
+	PreDiagnosticBatchFile *batch = openPreDiagnosticBatchFile(batch_filename);
+
+	*record_number = 1;
+	*failures_saved = 0; // Moved whole to the failed directory if it cannot be opened.
+
+	if (batch == NULL)
+		return 0;
+
+	PreDiagnosticBatchWriter *failed_writer = NULL;
+
+	int success_number = 0, batch_size = 0;
+
+	*failures_saved = 1;
+
+	do
+	{
+		batch_size = 0;
+		record_offsets[0] = batch -> offset;
+
+		while (batch_size < DIAG_BATCH_SIZE && readNextPreDiagnostic(batch, prediagArray + batch_size, arena))
+			record_offsets[++batch_size] = batch -> offset;
+
+		if (batch_size > 0)
+			success_number += processReadPreDiagnostics(prediagArray, results, batch_size, arena);
+
+		for (int i = 0; i < batch_size; ++i)
+		{
+			if (!results[i])
+				saveFailedRecord(&failed_writer, failed_filename, batch, record_offsets[i], failures_saved);
+		}
+	}
+	while (batch_size == DIAG_BATCH_SIZE);
+
+	if (batch -> truncated)
+		saveFailedRecord(&failed_writer, failed_filename, batch, record_offsets[batch_size], failures_saved);
+
+	if (failed_writer != NULL && !closePreDiagnosticBatchWriter(&failed_writer))
+		*failures_saved = 0;
+
+	*record_number = batch -> recordIndex + batch -> truncated;
+
+	closePreDiagnosticBatchFile(&batch);
+
+	pthread_mutex_lock(&WrittenDiagCountMutex);
+	WrittenDiagCount += success_number;
+	pthread_mutex_unlock(&WrittenDiagCountMutex);
+
+	return success_number;
+}
+
+
 // Fills a diagnostic struct from a prediagnostic and a medical record, if there is
 // at least one valid symptom in the given prediagnostic. A NULL medical record can be
 // given, in order to work only with the prediagnostic. Returns 1 on success, 0 else.
 int makeDiagnostic(const PreDiagnostic *prediag, const MedicalRecord *medrec)
+{
+	int result = 0;
+
+	makeDiagnosticBatch(&(getScratch() -> diagnosticToFill), &result, &prediag, &medrec, 1);
+
+	return result;
+}
+
+
+// Batched version of makeDiagnostic(): fills the 'batch_size' diagnostics of 'diagArray' with a single
+// propagation for each DIAG_BATCH_SIZE prediagnostics. 'medrecArray' can be NULL, as well as any of its
+// elements. 'results' is filled with 1 for each diagnostic made, and 0 else. Returns the number of successes.
+int makeDiagnosticBatch(Diagnostic *diagArray, int *results, const PreDiagnostic *const *prediagArray,
+	const MedicalRecord *const *medrecArray, int batch_size)
 {
 	initRecognitionRessources(); // to be sure ressouces are loaded.
 
-	if (prediag == NULL)
+	if (diagArray == NULL || results == NULL || prediagArray == NULL)
 	{
-		printf("\nCannot output a new diagnostic: NULL inputs.\n");
+		printf("\nCannot output new diagnostics: NULL arrays.\n");
 		return 0;
 	}
 
-	if (countValidSymptoms(prediag) == 0)
+	RecognitionScratch *scratch = getScratch();
+
+	int success_number = 0;
+
+	for (int batch_start = 0; batch_start < batch_size; batch_start += DIAG_BATCH_SIZE)
 	{
-		printf("Cannot output a diagnostic: no valid symptom as input.\n");
-		return 0;
+		const int current_batch_size = MIN(DIAG_BATCH_SIZE, batch_size - batch_start);
+
+		//////////////////////////////////////////////////////
+		// Feed the inputs content, only with valid prediagnostics:
+
+		int rows_number = 0;
+
+		for (int i = 0; i < current_batch_size; ++i)
+		{
+			const PreDiagnostic *prediag = prediagArray[batch_start + i];
+
+			scratch -> batchRowIndex[i] = -1;
+			results[batch_start + i] = 0;
+
+			if (prediag == NULL)
+			{
+				printf("\nCannot output a new diagnostic: NULL inputs.\n");
+				continue;
+			}
+
+			if (countValidSymptoms(prediag) == 0)
+			{
+				printf("Cannot output a diagnostic: no valid symptom as input.\n");
+				continue;
+			}
+
+			fillQuestion(scratch -> inputsToFill -> Questions[rows_number], prediag);
+
+			scratch -> batchRowIndex[i] = rows_number++;
+		}
+
+		if (rows_number == 0)
+			continue;
+
+		//////////////////////////////////////////////////////
+		// Recognition, for the whole batch at once:
+
+		predictBatch(scratch, rows_number);
+
+		//////////////////////////////////////////////////////
+		// Filling the Diagnostics:
+
+		for (int i = 0; i < current_batch_size; ++i)
+		{
+			if (scratch -> batchRowIndex[i] < 0)
+				continue;
+
+			const MedicalRecord *medrec = medrecArray == NULL ? NULL : medrecArray[batch_start + i];
+
+			fillDiagnostic(scratch, diagArray + batch_start + i, scratch -> inputsToFill -> Answers[scratch -> batchRowIndex[i]],
+				prediagArray[batch_start + i], medrec);
+
+			results[batch_start + i] = 1;
+			++success_number;
+		}
 	}
 
-	//////////////////////////////////////////////////////
-	// Feed the inputs content:
+	return success_number;
+}
 
-	fillQuestion(InputsToFill -> Questions[0], prediag);
 
-	//////////////////////////////////////////////////////
-	// Recognition:
+// Returns the recognition ressources of the calling thread:
+static RecognitionScratch* getScratch(void)
+{
+	return ThreadScratch != NULL ? ThreadScratch : &MainScratch;
+}
 
-	prediction(NetworkLoaded, InputsToFill);
 
-	const Number *the_answer = InputsToFill -> Answers[0];
+// Creates the inputs to fill with the prediagnostics data:
+static Inputs* createInputsToFill(void)
+{
+	const int questions_number = DIAG_BATCH_SIZE;
+	const int questions_size = network_inputSize(NetworkLoaded);
+	const int answers_size = network_outputSize(NetworkLoaded);
 
-	// Finding the 'DIAG_ILLNESS_NUMBER' most probable illnesses:
+	// Answers are allocated here, for prediction() would otherwise only allocate the rows of the first batch.
+	// Contiguous questions being propagated in place, without being copied to the network first input:
+	return createContiguousInputs(questions_number, questions_size, answers_size);
+}
+
+
+// Creates the arena of a thread's requests:
+static Arena* createArenaOrExit(void)
+{
+	Arena *arena = createArena(REQUEST_ARENA_SIZE);
+
+	if (arena == NULL)
+	{
+		printf("\nNot enough memory to create the requests arena.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	return arena;
+}
 
-	findGreaterValuesIndex(BufferIndexGreaterValues, DIAG_ILLNESS_NUMBER,
-		the_answer, network_outputSize(NetworkLoaded));
 
-	//////////////////////////////////////////////////////
-	// Filling the Diagnostic:
+// Runs a single propagation on the 'batch_size' first questions of the scratch inputs:
+static void predictBatch(RecognitionScratch *scratch, int batch_size)
+{
+	*(int*) &(scratch -> inputsToFill -> InputNumber) = batch_size;
+
+	if (scratch -> quantizedNetwork != NULL)
+		quantizedPrediction(scratch -> quantizedNetwork, scratch -> inputsToFill);
+	else
+		prediction(scratch -> network, scratch -> inputsToFill);
+
+	*(int*) &(scratch -> inputsToFill -> InputNumber) = DIAG_BATCH_SIZE; // Needed for freeing the inputs.
+}
+
+
+// Fills a diagnostic from the network answer of the given prediagnostic:
+static void fillDiagnostic(RecognitionScratch *scratch, Diagnostic *diag, const Number *answer,
+	const PreDiagnostic *prediag, const MedicalRecord *medrec)
+{
+	// Finding the 'DIAG_ILLNESS_NUMBER' most probable illnesses:
+
+	findGreaterValuesIndex(scratch -> bufferIndexGreaterValues, DIAG_ILLNESS_NUMBER,
+		answer, network_outputSize(scratch -> network));
 
-	DiagnosticToFill.id_diag = 0; // Will be set automatically by the database.
-	snprintf(DiagnosticToFill.date_diag, DATE_MAX_LENGTH, "%s", ""); // same.
+	diag -> id_diag = 0; // Will be set automatically by the database.
+	snprintf(diag -> date_diag, DATE_MAX_LENGTH, "%s", ""); // same.
 
-	DiagnosticToFill.criticity = criticity(the_answer, prediag, medrec);
+	diag -> criticity = criticity(answer, prediag, medrec);
 
 	for (int i = 0; i < DIAG_ILLNESS_NUMBER; ++i)
 	{
-		short illness_index = BufferIndexGreaterValues[i];
+		short illness_index = scratch -> bufferIndexGreaterValues[i];
 
-		DiagnosticToFill.illnessArray[i] = illness_index;
-		DiagnosticToFill.illnessProbabilityArray[i] = the_answer[illness_index];
+		diag -> illnessArray[i] = illness_index;
+		diag -> illnessProbabilityArray[i] = answer[illness_index];
 	}
 
 	if (VERBOSE_MODE >= 2)
-		printDiagnostic(&DiagnosticToFill);
-
-	return 1;
+		printDiagnostic(diag);
 }
 
 
@@ -217,3 +554,92 @@ void fillQuestion(Number *question, const PreDiagnostic *prediag)
 		enterSymptom(question, prediag -> declaredSymptoms[i], prediag -> declaredSymptomsConfidences[i]);
 	}
 }
+
+
+// Fetches the medical records of at most DIAG_BATCH_SIZE read prediagnostics, some of which can be NULL, makes their
+// diagnostics and writes them. The prediagnostics and medical records live in the given arena, which is then reset.
+// 'results' is filled with 1 for each written diagnostic, and 0 else. Returns the number of successes.
+static int processReadPreDiagnostics(PreDiagnostic **prediagArray, int *results, int batch_size, Arena *arena)
+{
+	MedicalRecord *medrecArray[DIAG_BATCH_SIZE] = {NULL};
+	Diagnostic diagArray[DIAG_BATCH_SIZE];
+
+	for (int i = 0; i < batch_size; ++i)
+	{
+		if (prediagArray[i] == NULL)
+			continue;
+
+		if (VERBOSE_MODE >= 2)
+			printPreDiagnostic(prediagArray[i]);
+
+		medrecArray[i] = readMedicalRecordInArena(prediagArray[i] -> id_socdet, arena); // returns NULL if id_socdet = 0.
+	}
+
+	makeDiagnosticBatch(diagArray, results, (const PreDiagnostic *const *) prediagArray,
+		(const MedicalRecord *const *) medrecArray, batch_size); // accepts NULL prediags and medrecs.
+
+	const int success_number = writeDiagnostics(diagArray, results, (const PreDiagnostic *const *) prediagArray,
+		(const MedicalRecord *const *) medrecArray, batch_size);
+
+	resetArena(arena);
+
+	return success_number;
+}
+
+
+// Copies the record of the given container starting at 'record_offset' to the failed records container, created
+// with the given filename at the first failure. 'failures_saved' is set to 0 if that fails.
+static void saveFailedRecord(PreDiagnosticBatchWriter **failed_writer, const char *failed_filename,
+	const PreDiagnosticBatchFile *batch, size_t record_offset, int *failures_saved)
+{
+	if (!*failures_saved)
+		return;
+
+	if (*failed_writer == NULL)
+		*failed_writer = createPreDiagnosticBatchWriterAt(failed_filename);
+
+	if (!copyBatchRecord(*failed_writer, batch, record_offset))
+		*failures_saved = 0;
+}
+
+
+// Writes the successfully made diagnostics of a batch on the database, with a single transaction. If that fails,
+// each diagnostic is written on its own, for a faulty one not to discard the others. 'results' is updated
+// accordingly, and the number of written diagnostics is returned.
+static int writeDiagnostics(const Diagnostic *diagArray, int *results, const PreDiagnostic *const *prediagArray,
+	const MedicalRecord *const *medrecArray, int batch_size)
+{
+	Diagnostic writtenDiags[DIAG_BATCH_SIZE];
+	int id_medrecArray[DIAG_BATCH_SIZE], id_socdetArray[DIAG_BATCH_SIZE], batch_indexes[DIAG_BATCH_SIZE];
+
+	int written_number = 0;
+
+	for (int i = 0; i < batch_size; ++i)
+	{
+		if (!results[i])
+			continue;
+
+		const int id_socdet = prediagArray[i] -> id_socdet;
+
+		writtenDiags[written_number] = diagArray[i];
+		id_socdetArray[written_number] = id_socdet;
+		id_medrecArray[written_number] = medrecArray[i] != NULL ? medrecArray[i] -> id_medrec : getMedicalRecordId(id_socdet);
+		batch_indexes[written_number] = i;
+		++written_number;
+	}
+
+	if (writeDiagnosticBatch(writtenDiags, id_medrecArray, id_socdetArray, written_number, NULL))
+		return written_number;
+
+	int success_number = 0;
+
+	for (int k = 0; k < written_number; ++k)
+	{
+		if (writeDiagnosticBatch(writtenDiags + k, id_medrecArray + k, id_socdetArray + k, 1, NULL))
+			++success_number;
+		else
+			results[batch_indexes[k]] = 0;
+	}
+
+	return success_number;
+}
@@ -10,8 +10,8 @@
 unsigned int getWrittenDiagnosticCount(void);
 
 
-// Returns the should-be-filled current diagnostic. In order for this to be relevant,
-// a makeDiagnostic() (or a function calling it) must be issued beforehand. Do not
+// Returns the should-be-filled current diagnostic of the calling thread. In order for this to be
+// relevant, a makeDiagnostic() (or a function calling it) must be issued beforehand. Do not
 // try to free this ressource.
 const Diagnostic* getFilledDiagnostic(void);
 
@@ -28,10 +28,20 @@ const NeuralNetwork* getLoaded_NeuralNetwork(void);
 void initRecognitionRessources(void);
 
 
-// Frees the neural network and the Inputs struct from memory. Call this upon program exit.
+// Frees the neural network and the Inputs struct from memory. Call this upon program exit,
+// once every thread has called freeThreadRecognitionRessources().
 void freeRecognitionRessources(void);
 
 
+// Gives its own recognition ressources to the calling thread, which shares the nets of the loaded network.
+// Must be called by each thread making diagnostics (apart from the main one), after initRecognitionRessources().
+void initThreadRecognitionRessources(void);
+
+
+// Frees the recognition ressources of the calling thread. Call this before the thread ends:
+void freeThreadRecognitionRessources(void);
+
+
 // Whole event chain for 1 diagnostic: reads the prediagnostic file, fetches the linked
 // medical record from the database, makes a diagnostic, and then writes it into the database,
 // assuming there is at least one valid symptom in the given prediagnostic. Returns 1 on success,
@@ -39,12 +49,35 @@ void freeRecognitionRessources(void);
 int diagnosticProcessing(const char *prediag_filename);
 
 
+// Whole event chain for 'file_number' diagnostics, like diagnosticProcessing(), but making all
+// the diagnostics of each DIAG_BATCH_SIZE files at once. 'results' is filled with 1 for each
+// successfully processed file, and 0 else. Returns the number of successes.
+int diagnosticProcessingBatch(const char *const *prediag_filenames, int *results, int file_number);
+
+
+// Whole event chain for the prediagnostics of a batch container, like diagnosticProcessingBatch(), its records being
+// read DIAG_BATCH_SIZE at a time from the mapped container. 'record_number' is set to the number of records, invalid
+// ones included, a container which cannot be opened or whose last record is truncated counting as one more invalid
+// record. The failed records are copied to a new container named 'failed_filename', for the container not to be
+// processed again whole: 'failures_saved' is set to 1 if there is no failure or if all of them have been copied,
+// and 0 else. Returns the number of successes.
+int diagnosticProcessingBatchFile(const char *batch_filename, const char *failed_filename, int *record_number,
+	int *failures_saved);
+
+
 // Fills a diagnostic struct from a prediagnostic and a medical record, if there is
 // at least one valid symptom in the given prediagnostic. A NULL medical record can be
 // given, in order to work only with the prediagnostic. Returns 1 on success, 0 else.
 int makeDiagnostic(const PreDiagnostic *prediag, const MedicalRecord *medrec);
 
 
+// Batched version of makeDiagnostic(): fills the 'batch_size' diagnostics of 'diagArray' with a single
+// propagation for each DIAG_BATCH_SIZE prediagnostics. 'medrecArray' can be NULL, as well as any of its
+// elements. 'results' is filled with 1 for each diagnostic made, and 0 else. Returns the number of successes.
+int makeDiagnosticBatch(Diagnostic *diagArray, int *results, const PreDiagnostic *const *prediagArray,
+	const MedicalRecord *const *medrecArray, int batch_size);
+
+
 // Fills the given question with the relevant data from a prediagnostic:
 void fillQuestion(Number *question, const PreDiagnostic *prediag);
 
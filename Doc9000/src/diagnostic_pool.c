@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "diagnostic_pool.h"
+#include "diagnostic_making.h"
+#include "parsing.h"
+#include "api.h"
+#include "prediagnostic_file.h"
+
+
+// At least one element, for the arrays to be valid:
+#define WORKER_ARRAY_SIZE MAX(DIAG_WORKER_NUMBER, 1)
+
+#define MIN_WORKER_BATCH_SIZE MAX(DIAG_BATCH_SIZE / WORKER_ARRAY_SIZE, 1)
+
+
+static pthread_t Workers[WORKER_ARRAY_SIZE];
+static int WorkersStarted, StopRequested;
+
+// Circular queue of prediagnostic files, with their arrival time:
+static char Queue[DIAG_QUEUE_SIZE][MAX_FILENAME_PATH_LENGTH];
+static double QueueTimes[DIAG_QUEUE_SIZE];
+static int QueueHead, QueueCount;
+
+static int PendingFiles; // Queued, or being processed.
+static int FailsNumber; // Since the last waitDiagnosticWorkers() call.
+
+static pthread_mutex_t QueueMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t QueueNotEmpty = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t QueueNotFull = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t WorkersIdle = PTHREAD_COND_INITIALIZER;
+
+
+// Loop of each worker: pops some prediagnostics from the queue, and processes them.
+static void* diagnosticWorkerLoop(void *arg);
+
+
+// Moves a file from the source directory to the processed or failed directory. Returns 1 on success, 0 else.
+static int moveToDestDir(const char *full_path_src, int processed);
+
+
+// Returns 1 if the given file is not in the source directory anymore, 0 else. This happens to a file both found by
+// the start-up scan and notified by inotify: it has already been processed, and must not count as a failure.
+static int alreadyMoved(const char *full_path_src);
+
+
+// Starts the workers, if DIAG_WORKER_NUMBER > 0. Does nothing if already started.
+void startDiagnosticWorkers(void)
+{
+	if (WorkersStarted || DIAG_WORKER_NUMBER <= 0)
+		return;
+
+	// Shared ressources must be loaded before the workers start, for they are lazily loaded otherwise:
+
+	if (!initDatabaseLibrary())
+		return;
+
+	getCriticityArray();
+	getSymptomName(no_symptom); // Loads the strings arrays.
+	initRecognitionRessources();
+
+	StopRequested = 0;
+
+	for (int w = 0; w < DIAG_WORKER_NUMBER; ++w)
+	{
+		if (pthread_create(Workers + w, NULL, diagnosticWorkerLoop, NULL) != 0)
+		{
+			printf("\nCould not create the diagnostic worker %d.\n", w);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	WorkersStarted = 1;
+
+	if (VERBOSE_MODE >= 1)
+		printf("Started %d diagnostic workers.\n", DIAG_WORKER_NUMBER);
+}
+
+
+// Waits for the queued prediagnostics to be processed, and stops the workers.
+void stopDiagnosticWorkers(void)
+{
+	if (!WorkersStarted)
+		return;
+
+	pthread_mutex_lock(&QueueMutex);
+
+	StopRequested = 1;
+	pthread_cond_broadcast(&QueueNotEmpty);
+
+	pthread_mutex_unlock(&QueueMutex);
+
+	for (int w = 0; w < DIAG_WORKER_NUMBER; ++w)
+		pthread_join(Workers[w], NULL);
+
+	WorkersStarted = 0;
+}
+
+
+// Returns 1 if the workers are running, 0 else.
+int diagnosticWorkersStarted(void)
+{
+	return WorkersStarted;
+}
+
+
+// Adds a prediagnostic file to the queue, waiting for some room if it is full:
+void pushPrediagnosticFile(const char *prediag_filename)
+{
+	pthread_mutex_lock(&QueueMutex);
+
+	while (QueueCount == DIAG_QUEUE_SIZE)
+		pthread_cond_wait(&QueueNotFull, &QueueMutex);
+
+	const int tail = (QueueHead + QueueCount) % DIAG_QUEUE_SIZE;
+
+	snprintf(Queue[tail], MAX_FILENAME_PATH_LENGTH, "%s", prediag_filename);
+	QueueTimes[tail] = get_time();
+
+	++QueueCount;
+	++PendingFiles;
+
+	pthread_cond_signal(&QueueNotEmpty);
+	pthread_mutex_unlock(&QueueMutex);
+}
+
+
+// Waits for all the queued prediagnostics to be processed. Returns the number of failures among them.
+int waitDiagnosticWorkers(void)
+{
+	pthread_mutex_lock(&QueueMutex);
+
+	while (PendingFiles > 0)
+		pthread_cond_wait(&WorkersIdle, &QueueMutex);
+
+	int fails_number = FailsNumber;
+	FailsNumber = 0;
+
+	pthread_mutex_unlock(&QueueMutex);
+
+	return fails_number;
+}
+
+
+// Loop of each worker: pops some prediagnostics from the queue, and processes them.
+static void* diagnosticWorkerLoop(void *arg)
+{
+	initDatabaseThread();
+	initThreadRecognitionRessources();
+
+	char batch_filenames[DIAG_BATCH_SIZE][MAX_FILENAME_PATH_LENGTH];
+	const char *batch_filenames_array[DIAG_BATCH_SIZE];
+
+	for (int i = 0; i < DIAG_BATCH_SIZE; ++i)
+		batch_filenames_array[i] = batch_filenames[i];
+
+	while (1)
+	{
+		pthread_mutex_lock(&QueueMutex);
+
+		while (QueueCount == 0 && !StopRequested)
+			pthread_cond_wait(&QueueNotEmpty, &QueueMutex);
+
+		if (QueueCount == 0) // Stop requested, and nothing left to do.
+		{
+			pthread_mutex_unlock(&QueueMutex);
+			break;
+		}
+
+		// Waiting a bit for a full batch, whose diagnostics are then written by a single transaction:
+
+		const double deadline = QueueTimes[QueueHead] + DIAG_WRITE_DEADLINE;
+
+		const struct timespec deadline_ts = {.tv_sec = deadline, .tv_nsec = (deadline - (time_t) deadline) * 1e9};
+
+		while (QueueCount > 0 && QueueCount < DIAG_BATCH_SIZE && !StopRequested && get_time() < deadline)
+			pthread_cond_timedwait(&QueueNotEmpty, &QueueMutex, &deadline_ts);
+
+		if (QueueCount == 0) // Taken by other workers.
+		{
+			pthread_mutex_unlock(&QueueMutex);
+			continue;
+		}
+
+		// Sharing the queued files between the workers, by batches of at most DIAG_BATCH_SIZE. Small bursts
+		// are not split too much, for the diagnostics to be written by as few transactions as possible:
+
+		const int fair_share = MAX((QueueCount + DIAG_WORKER_NUMBER - 1) / DIAG_WORKER_NUMBER, MIN_WORKER_BATCH_SIZE);
+
+		int batch_size = MIN(QueueCount, MIN(DIAG_BATCH_SIZE, fair_share));
+
+		for (int i = 0; i < batch_size; ++i)
+		{
+			memcpy(batch_filenames[i], Queue[QueueHead], MAX_FILENAME_PATH_LENGTH);
+			QueueHead = (QueueHead + 1) % DIAG_QUEUE_SIZE;
+		}
+
+		QueueCount -= batch_size;
+
+		pthread_cond_broadcast(&QueueNotFull);
+		pthread_mutex_unlock(&QueueMutex);
+
+		int fails_number = processPrediagnosticFiles(batch_filenames_array, batch_size);
+
+		pthread_mutex_lock(&QueueMutex);
+
+		FailsNumber += fails_number;
+		PendingFiles -= batch_size;
+
+		if (PendingFiles == 0)
+			pthread_cond_broadcast(&WorkersIdle);
+
+		pthread_mutex_unlock(&QueueMutex);
+	}
+
+	freeThreadRecognitionRessources();
+	endDatabaseThread();
+
+	return NULL;
+}
+
+
+// Makes the diagnostics of the given prediagnostic files from the source directory, and moves
+// each of them to the processed or failed directory. Returns the number of failures. Batch containers
+// are processed whole, each of their failed records counting as a failure: those are copied to a container
+// of the same name in the failed directory, and the container is moved to the processed one. It is moved
+// whole to the failed directory only if they could not be copied.
+int processPrediagnosticFiles(const char *const *prediag_filenames, int file_number)
+{
+	const char *single_filenames[DIAG_BATCH_SIZE];
+	int results[DIAG_BATCH_SIZE];
+
+	int fails_number = 0;
+
+	for (int batch_start = 0; batch_start < file_number; batch_start += DIAG_BATCH_SIZE)
+	{
+		const int batch_size = MIN(DIAG_BATCH_SIZE, file_number - batch_start);
+
+		int single_number = 0;
+
+		for (int i = 0; i < batch_size; ++i)
+		{
+			const char *full_path_src = prediag_filenames[batch_start + i];
+
+			if (!isPreDiagnosticBatchFilename(full_path_src))
+			{
+				single_filenames[single_number++] = full_path_src;
+				continue;
+			}
+
+			char full_path_failed[MAX_FILENAME_PATH_LENGTH];
+
+			snprintf(full_path_failed, MAX_FILENAME_PATH_LENGTH, "%s%s", PREDIAGS_FAILED_FOLDER,
+				full_path_src + strlen(PREDIAGS_SRC_FOLDER));
+
+			int record_number, failures_saved;
+
+			const int success_number = diagnosticProcessingBatchFile(full_path_src, full_path_failed,
+				&record_number, &failures_saved);
+			const int record_fails = record_number - success_number;
+
+			if (success_number == 0 && alreadyMoved(full_path_src))
+				continue;
+
+			fails_number += record_fails + !moveToDestDir(full_path_src, failures_saved);
+		}
+
+		diagnosticProcessingBatch(single_filenames, results, single_number);
+
+		for (int i = 0; i < single_number; ++i)
+		{
+			if (!results[i] && alreadyMoved(single_filenames[i]))
+				continue;
+
+			int move_result = moveToDestDir(single_filenames[i], results[i]);
+
+			if (!results[i] || !move_result)
+				++fails_number;
+		}
+	}
+
+	return fails_number;
+}
+
+
+// Moves a file from the source directory to the processed or failed directory. Returns 1 on success, 0 else.
+static int moveToDestDir(const char *full_path_src, int processed)
+{
+	char full_path_dest[MAX_FILENAME_PATH_LENGTH];
+
+	const char *filename = full_path_src + strlen(PREDIAGS_SRC_FOLDER);
+
+	char *dest_dir = processed ? PREDIAGS_PROCESSED_FOLDER : PREDIAGS_FAILED_FOLDER;
+
+	snprintf(full_path_dest, MAX_FILENAME_PATH_LENGTH, "%s%s", dest_dir, filename);
+
+	return moveFile(full_path_dest, full_path_src);
+}
+
+
+// Returns 1 if the given file is not in the source directory anymore, 0 else. This happens to a file both found by
+// the start-up scan and notified by inotify: it has already been processed, and must not count as a failure.
+static int alreadyMoved(const char *full_path_src)
+{
+	return access(full_path_src, F_OK) != 0 && errno == ENOENT;
+}
@@ -0,0 +1,38 @@
+#ifndef DIAGNOSTIC_POOL_H
+#define DIAGNOSTIC_POOL_H
+
+
+// Pool of DIAG_WORKER_NUMBER threads making diagnostics, fed with prediagnostic files by a bounded queue.
+// Each worker has its own database connection and recognition ressources, and processes the queued
+// files by batches of at most DIAG_BATCH_SIZE.
+
+
+// Starts the workers, if DIAG_WORKER_NUMBER > 0. Does nothing if already started.
+void startDiagnosticWorkers(void);
+
+
+// Waits for the queued prediagnostics to be processed, and stops the workers.
+void stopDiagnosticWorkers(void);
+
+
+// Returns 1 if the workers are running, 0 else.
+int diagnosticWorkersStarted(void);
+
+
+// Adds a prediagnostic file to the queue, waiting for some room if it is full:
+void pushPrediagnosticFile(const char *prediag_filename);
+
+
+// Waits for all the queued prediagnostics to be processed. Returns the number of failures among them.
+int waitDiagnosticWorkers(void);
+
+
+// Makes the diagnostics of the given prediagnostic files from the source directory, and moves
+// each of them to the processed or failed directory. Returns the number of failures. Batch containers
+// are processed whole, each of their failed records counting as a failure: those are copied to a container
+// of the same name in the failed directory, and the container is moved to the processed one. It is moved
+// whole to the failed directory only if they could not be copied.
+int processPrediagnosticFiles(const char *const *prediag_filenames, int file_number);
+
+
+#endif
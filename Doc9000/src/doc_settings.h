@@ -19,8 +19,10 @@
 #define ILLNESS_LIST_FILENAME "../data/generated/backups/illness_list.data"
 #define SYMPTOM_LIST_FILENAME "../data/generated/backups/symptom_list.data"
 #define CRITICITIES_FILENAME  "../data/generated/backups/criticities.bin"
+#define COMPILED_ASSETS_FILENAME "../data/generated/backups/medical_assets.bin" // Mapped at start-up, see backups.c
 
 #define NEURAL_NET_DIR_PATH "../data/generated/Doc_brain/"
+#define NEURAL_NET_FILE_PATH "../data/generated/Doc_brain.bin" // Same network, mapped at once. Preferred when present.
 
 #define AUTH_KEY_FILE  "../data/auth/key.bin"
 #define AUTH_EXPL_FILE "../data/auth/auth_example.bin"
@@ -37,6 +39,7 @@
 #define PREDIAGS_FAILED_FOLDER    "../prediags/prediags_failed/"
 
 #define PREDIAGS_FILENAME_FORMAT "Patient_%d_%ld_BehaviorAnalysis.bin"
+#define PREDIAGS_BATCH_FILENAME_FORMAT "Batch_%d_%ld_%d_BehaviorAnalysis.bin" // Emitter pid, timestamp, and container count.
 
 
 ///////////////////////////////////////////////////////////////
@@ -61,9 +64,13 @@
 // Helpful for using less RAM, and speed up data fetching from the database. Can be set to 0:
 #define MAX_DIAGS_READ 3
 
-// Used for trying to pack the writing of illnesses and their probabilities.
-// The packing is hardcoded internally, and will be enabled only when 'DIAG_ILLNESS_NUMBER' = 5.
-#define PACK_ILLNESS_PROBA 1
+// Medical records are cached in memory, for patients sending several prediagnostics. Cache size can be set to 0:
+#define MEDREC_CACHE_SIZE 1024
+#define MEDREC_CACHE_TTL 600. // In seconds. Cached medical records older than this are read again.
+
+// Diagnostics are written by batches, with one transaction and multi-row inserts. Workers wait this long
+// (in seconds) for a full batch of prediagnostics, before processing what they have. Can be set to 0:
+#define DIAG_WRITE_DEADLINE 0.05
 
 
 ///////////////////////////////////////////////////////////////
@@ -73,7 +80,13 @@
 #define VERBOSE_MODE 1 // For messages in the console, during the event loop.
 	// 0 -> nothing, 1 -> successes/failures count, 2 -> messages from 1, read filenames, plus prediagnostics and diagnostics.
 
-#define FETCHING_COOLDOWN 1.0 // In seconds.
+#define USE_INOTIFY 1 // Prediagnostics are fetched as soon as they are written (Linux only). Polling is used otherwise.
+#define FETCHING_COOLDOWN 1.0 // In seconds. Polling period, without inotify.
+#define DIAG_BATCH_SIZE 64 // Max number of prediagnostics whose diagnostics are made by a single propagation.
+#define INT8_INFERENCE 0 // Diagnostics made by an int8 copy of the network: faster, but its answers may slightly differ.
+#define DIAG_WORKER_NUMBER 4 // Threads making the diagnostics, each with its own database connection. 0 -> done by the event loop.
+#define DIAG_QUEUE_SIZE 256 // Max number of prediagnostics waiting for a worker.
+#define REQUEST_ARENA_SIZE (1 << 18) // In bytes. Initial size of the arena of each thread making diagnostics, grown if needed.
 #define CLEANUP_COOLDOWN (3600. * 24. * 7.) // 1 week worth of seconds
 // #define CLEANUP_COOLDOWN 7 // For testing: 7 seconds.
 
@@ -105,6 +118,11 @@
 #define VALUE_ABSENT_SYMPTOM 0.f // Default value written in inputs.
 #define SYMPTOM_THESHOLD 0.5f // Useful for generating the learning dataset.
 
+#define LEARNING_THREAD_NUMBER 4 // Each learning batch is split between those threads. Can be set to 1.
+#define DATASET_THREAD_NUMBER 4 // Threads generating the datasets, which only depend on their seed.
+#define LEARNING_DATASET_SEED 1
+#define VALIDATION_DATASET_SEED 2 // Must differ from the learning one, for the validation to be meaningful.
+
 
 ///////////////////////////////////////////////////////////////
 // Medical structs settings:
@@ -17,27 +17,59 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <termios.h>
+#include <limits.h> // for NAME_MAX.
 // #include <sys/select.h>
 // #include <errno.h>
 // #include <fcntl.h>
 // #include <time.h>
 
+#if defined __linux__
+	#include <sys/inotify.h>
+#endif
+
 #include "event_loop.h"
 #include "diagnostic_making.h"
+#include "diagnostic_pool.h"
+#include "medrec_cache.h"
+#include "prediagnostic_file.h"
 
 
 #define ESC_KEY 27
 
+#define IS_QUIT_KEY(c) ((c) == 'q' || (c) == 'Q' || (c) == ESC_KEY)
+
+// Enough for at least 64 events of the longest filename:
+#define INOTIFY_BUFFER_SIZE (64 * (sizeof(struct inotify_event) + NAME_MAX + 1))
+
 
 // Low level functions to handle user input, taken from rosettacode.org:
 static void set_mode(int want_key);
 static int get_key(void);
 
 
+// Adds a prediagnostic file from the source directory to the current batch, which is processed
+// once full. If the diagnostic workers are running, the file is queued for them instead.
+// Returns the new batch size, and updates the failures number:
+static int addToBatch(const char *filename, int batch_size, int *fails_number);
+
+
+// Makes the diagnostics of the collected prediagnostics, moves their files, and returns the number
+// of failures. With the diagnostic workers running, waits for the queued prediagnostics instead:
+static int processBatch(int batch_size);
+
+
+// Event loop driven by inotify. Returns 1 if stopped by the user, and 0 if inotify is not
+// usable (or the source directory has been removed), in which case the polling loop takes over:
+static int inotifyEventLoop(void);
+
+
 static struct termios old, new;
 
 static char Full_path_src[MAX_FILENAME_PATH_LENGTH];
-static char Full_path_dest[MAX_FILENAME_PATH_LENGTH];
+
+// Prediagnostics collected for the next batch of diagnostics:
+static char Batch_paths_src[DIAG_BATCH_SIZE][MAX_FILENAME_PATH_LENGTH];
+static const char *Batch_paths_array[DIAG_BATCH_SIZE];
 
 static const unsigned int fetchingCooldownInMicroSeconds = FETCHING_COOLDOWN * 1000000;
 static const unsigned int CleanupThreshold = (float) CLEANUP_COOLDOWN / FETCHING_COOLDOWN + 0.5f;
@@ -60,6 +92,19 @@ void diagnosticEventLoop(void)
 
 	printf("\n-> This process can be stopped by pressing either the 'q' key or ESC.\n\n");
 
+	startDiagnosticWorkers();
+
+	if (USE_INOTIFY && inotifyEventLoop())
+	{
+		stopDiagnosticWorkers();
+
+		if (VERBOSE_MODE >= 1)
+			printMedicalRecordCacheStats();
+
+		printf("\nEnd of the event loop.\n");
+		return;
+	}
+
 	int read_char; // keep this an int!
 	unsigned int epoch = 0;
 
@@ -92,10 +137,15 @@ void diagnosticEventLoop(void)
 			}
 		}
 
-		if (read_char == 'q' || read_char == 'Q' || read_char == ESC_KEY)
+		if (IS_QUIT_KEY(read_char))
 			break; // Ressources will have to be freed!
 	}
 
+	stopDiagnosticWorkers();
+
+	if (VERBOSE_MODE >= 1)
+		printMedicalRecordCacheStats();
+
 	printf("\nEnd of the event loop.\n");
 }
 
@@ -116,29 +166,16 @@ double diagnosticFullProcess(void)
 		return 0.;
 	}
 
-	int diags_number = 0, fails_number = 0;
+	int diags_number = 0, fails_number = 0, batch_size = 0;
 
 	struct dirent *dir = NULL;
 
 	while ((dir = readdir(directory)) != NULL)
 	{
-		if (dir -> d_type == DT_REG) // Condition to check regular file.
+		// Condition to check regular file. Batch containers still being written are processed once complete:
+		if (dir -> d_type == DT_REG && !isPartialPreDiagnosticBatchFilename(dir -> d_name))
 		{
-			snprintf(Full_path_src, MAX_FILENAME_PATH_LENGTH, "%s%s", PREDIAGS_SRC_FOLDER, dir -> d_name);
-
-			if (VERBOSE_MODE >= 2)
-				printf("Trying to process the file: '%s'.\n", Full_path_src);
-
-			int diag_result = diagnosticProcessing(Full_path_src);
-
-			char *dest_dir = diag_result ? PREDIAGS_PROCESSED_FOLDER : PREDIAGS_FAILED_FOLDER;
-
-			snprintf(Full_path_dest, MAX_FILENAME_PATH_LENGTH, "%s%s", dest_dir, dir -> d_name);
-
-			int move_result = moveFile(Full_path_dest, Full_path_src);
-
-			if (!diag_result || !move_result)
-				++fails_number;
+			batch_size = addToBatch(dir -> d_name, batch_size, &fails_number);
 
 			++diags_number;
 		}
@@ -146,6 +183,8 @@ double diagnosticFullProcess(void)
 
 	closedir(directory);
 
+	fails_number += processBatch(batch_size); // Remaining prediagnostics.
+
 	double time_elapsed = get_time() - time_start;
 
 	if (VERBOSE_MODE >= 1 && diags_number > 0)
@@ -194,6 +233,201 @@ void cleanupProcess(void)
 }
 
 
+// Adds a prediagnostic file from the source directory to the current batch, which is processed
+// once full. If the diagnostic workers are running, the file is queued for them instead.
+// Returns the new batch size, and updates the failures number:
+static int addToBatch(const char *filename, int batch_size, int *fails_number)
+{
+	snprintf(Batch_paths_src[batch_size], MAX_FILENAME_PATH_LENGTH, "%s%s", PREDIAGS_SRC_FOLDER, filename);
+
+	if (VERBOSE_MODE >= 2)
+		printf("Trying to process the file: '%s'.\n", Batch_paths_src[batch_size]);
+
+	if (diagnosticWorkersStarted())
+	{
+		pushPrediagnosticFile(Batch_paths_src[batch_size]);
+		return 0;
+	}
+
+	++batch_size;
+
+	if (batch_size == DIAG_BATCH_SIZE)
+	{
+		*fails_number += processBatch(batch_size);
+		batch_size = 0;
+	}
+
+	return batch_size;
+}
+
+
+// Makes the diagnostics of the collected prediagnostics, moves their files, and returns the number
+// of failures. With the diagnostic workers running, waits for the queued prediagnostics instead:
+static int processBatch(int batch_size)
+{
+	if (diagnosticWorkersStarted())
+		return waitDiagnosticWorkers();
+
+	if (batch_size == 0)
+		return 0;
+
+	for (int i = 0; i < batch_size; ++i)
+		Batch_paths_array[i] = Batch_paths_src[i];
+
+	return processPrediagnosticFiles(Batch_paths_array, batch_size);
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+// Event driven fetching:
+
+
+#if defined __linux__
+
+
+// Event loop driven by inotify. Returns 1 if stopped by the user, and 0 if inotify is not
+// usable (or the source directory has been removed), in which case the polling loop takes over:
+static int inotifyEventLoop(void)
+{
+	int inotify_fd = inotify_init();
+
+	if (inotify_fd < 0)
+	{
+		printf("Unable to initialize inotify, polling the source directory instead.\n\n");
+		return 0;
+	}
+
+	// Files are fetched once their writer closed them, or once moved (e.g after an atomic rename) into the directory:
+	if (inotify_add_watch(inotify_fd, PREDIAGS_SRC_FOLDER, IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		printf("Unable to watch the directory '%s', polling it instead.\n\n", PREDIAGS_SRC_FOLDER);
+		close(inotify_fd);
+		return 0;
+	}
+
+	// Prediagnostics written before the watch was added. Those written during this scan are also notified:
+	// they are then found already moved, which processPrediagnosticFiles() does not count as a failure.
+	diagnosticFullProcess();
+
+	static char events_buffer[INOTIFY_BUFFER_SIZE] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+
+	double last_cleanup_time = get_time();
+	int stopped_by_user = 0, watch_removed = 0, stdin_open = 1;
+
+	set_mode(1); // call this with arg 0 to quit properly without input!
+
+	while (!stopped_by_user && !watch_removed)
+	{
+		// Waiting for a key, a new prediagnostic, or the next cleanup:
+
+		fd_set fs;
+		FD_ZERO(&fs);
+		FD_SET(inotify_fd, &fs);
+
+		if (stdin_open)
+			FD_SET(STDIN_FILENO, &fs);
+
+		struct timeval tv, *timeout = NULL;
+
+		if (ENABLE_CLEANUP)
+		{
+			double cooldown_left = CLEANUP_COOLDOWN - (get_time() - last_cleanup_time);
+
+			if (cooldown_left < 0.)
+				cooldown_left = 0.;
+
+			tv.tv_sec = cooldown_left;
+			tv.tv_usec = (cooldown_left - tv.tv_sec) * 1000000.;
+			timeout = &tv;
+		}
+
+		if (select(MAX(STDIN_FILENO, inotify_fd) + 1, &fs, NULL, NULL, timeout) < 0)
+			continue; // e.g interrupted by a signal.
+
+		if (FD_ISSET(STDIN_FILENO, &fs))
+		{
+			int read_char = getchar(); // keep this an int!
+
+			stopped_by_user = IS_QUIT_KEY(read_char);
+			stdin_open = read_char != EOF; // Not waiting for keys on a closed input anymore.
+		}
+
+		if (FD_ISSET(inotify_fd, &fs))
+		{
+			double time_start = get_time();
+
+			ssize_t length = read(inotify_fd, events_buffer, INOTIFY_BUFFER_SIZE);
+
+			int diags_number = 0, fails_number = 0, batch_size = 0, full_scan_needed = 0;
+
+			for (char *ptr = events_buffer; ptr < events_buffer + length; )
+			{
+				const struct inotify_event *event = (const struct inotify_event*) ptr;
+
+				if (event -> mask & IN_Q_OVERFLOW) // Some events were lost.
+					full_scan_needed = 1;
+
+				else if (event -> mask & IN_IGNORED) // The directory has been removed.
+					watch_removed = 1;
+
+				else if (event -> len > 0 && !(event -> mask & IN_ISDIR) && !isPartialPreDiagnosticBatchFilename(event -> name))
+				{
+					batch_size = addToBatch(event -> name, batch_size, &fails_number);
+
+					++diags_number;
+				}
+
+				ptr += sizeof(struct inotify_event) + event -> len;
+			}
+
+			fails_number += processBatch(batch_size); // Remaining prediagnostics.
+
+			double time_elapsed = get_time() - time_start;
+
+			if (VERBOSE_MODE >= 1 && diags_number > 0)
+			{
+				printf("Number of processed prediagnostics: %2d. Failures: %2d. (%.3f s)\n", diags_number, fails_number, time_elapsed);
+			}
+
+			if (full_scan_needed)
+				diagnosticFullProcess();
+		}
+
+		if (ENABLE_CLEANUP && get_time() - last_cleanup_time >= CLEANUP_COOLDOWN)
+		{
+			cleanupProcess();
+
+			last_cleanup_time = get_time();
+		}
+	}
+
+	set_mode(0);
+
+	close(inotify_fd);
+
+	if (watch_removed)
+	{
+		printf("The directory '%s' is not watched anymore, polling it instead.\n\n", PREDIAGS_SRC_FOLDER);
+		createFolder(PREDIAGS_SRC_FOLDER);
+	}
+
+	return stopped_by_user;
+}
+
+
+#else
+
+
+// inotify is Linux only:
+static int inotifyEventLoop(void)
+{
+	return 0;
+}
+
+
+#endif
+
+
 ///////////////////////////////////////////////////////////////////////////
 // Low level functions to handle user input, taken from rosettacode.org:
 
@@ -259,7 +493,7 @@ void demoLooping(void)
 
 		printf("Key: '%c' (%d)\n", read_char, read_char);
 
-		if (read_char == 'q' || read_char == 'Q' || read_char == ESC_KEY)
+		if (IS_QUIT_KEY(read_char))
 			return;
 	}
 }
@@ -6,8 +6,9 @@
 // Frameworks to be used:
 
 
-// Does what 'diagnosticFullProcess()' do, albeit periodically.
-// This process can be stopped by pressing either the 'q' key or ESC.
+// Does what 'diagnosticFullProcess()' do, albeit periodically. With USE_INOTIFY, prediagnostics
+// are instead processed as soon as their files are closed or moved into the source directory,
+// the polling being kept as a fallback. This process can be stopped by pressing either the 'q' key or ESC.
 void diagnosticEventLoop(void);
 
 
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <pthread.h>
 
 #include "learning_dataset.h"
 #include "parsing.h"
@@ -9,6 +10,21 @@ static MedicalData *BaseDataset;
 static int BaseDatasetLength;
 
 
+// Rows of the dataset generated by a thread:
+typedef struct
+{
+	Inputs *inputs;
+	uint64_t seed;
+	long start;
+	long end;
+} DatasetPart;
+
+
+// Generating the rows [start, end[ of the dataset. The first 'answers_size' x 'inputsPerIllness' rows are
+// made of each illness in turn, and the remaining rows are of the first illness in 'BaseDataset':
+static void* generateDatasetPart(void *arg);
+
+
 // Register a symptom in the given question. Returns 1 on success.
 // 'value' must be used according to the following pattern:
 // Symptom detected, no specific value attached to it -> 1.
@@ -32,27 +48,45 @@ int enterSymptom(Number *question, Symptom symptom, Number value)
 }
 
 
-// Generate a noisy value:
-Number generateValue(void)
+// Generate a noisy value, from a counter-based random number: the same seed and counter always give the same value.
+Number generateValue(uint64_t seed, uint64_t counter)
 {
-	float probability = uniform_random(0.f, 1.f);
+	// SplitMix64 finalizer, applied on the counter offset by the seed:
+
+	uint64_t z = seed * 0x9E3779B97F4A7C15ULL + counter * 0xBF58476D1CE4E5B9ULL;
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	z ^= z >> 31;
+
+	float probability = (z >> 40) * 0x1.0p-24f; // in [0, 1[
 
 	return probability < SYMPTOM_THESHOLD ? VALUE_ABSENT_SYMPTOM : 1.f;
 }
 
 
-// Adds a given quantity of the given illness into the learning dataset:
-void addIllnesses(Number **questions, Number **answers, const MedicalData *data, int dataQuantity)
+// Adds a given quantity of the given illness into the learning dataset. 'first_row' is the index of the first added
+// row in the whole dataset: each row values only depend on it and the seed, not on how the dataset is split.
+void addIllnesses(Number **questions, Number **answers, const MedicalData *data, int dataQuantity, long first_row,
+	uint64_t seed)
 {
+	Number values[MAX_SYMPTOM_PER_DATA];
+
 	for (int i = 0; i < dataQuantity; ++i)
 	{
+		const uint64_t counter = (uint64_t) (first_row + i) * MAX_SYMPTOM_PER_DATA;
+
+		// Branchless, thus vectorizable:
+		for (int symptomIndex = 0; symptomIndex < data -> symptomNumber; ++symptomIndex)
+			values[symptomIndex] = generateValue(seed, counter + symptomIndex);
+
 		for (int symptomIndex = 0; symptomIndex < data -> symptomNumber; ++symptomIndex)
 		{
 			const Symptom symptom = data -> symptomArray[symptomIndex];
 
 			if (symptom != no_symptom)
 			{
-				enterSymptom(questions[i], symptom, generateValue());
+				enterSymptom(questions[i], symptom, values[symptomIndex]);
 			}
 		}
 
@@ -61,39 +95,48 @@ void addIllnesses(Number **questions, Number **answers, const MedicalData *data,
 }
 
 
-// Creating a learning_dataset:
-Inputs* createDataset(int inputs_number)
+// Creating a learning dataset, whose rows are split between 'thread_number' threads.
+// The dataset only depends on the given seed, whatever the number of threads:
+Inputs* createDataset(int inputs_number, uint64_t seed, int thread_number)
 {
 	initDatasetAssets();
 
 	const int questions_size = getSymptomNumber();
 	const int answers_size = getIllnessNumber();
 
-	Number **questions = createMatrix(inputs_number, questions_size);
-	Number **answers = createMatrix(inputs_number, answers_size);
+	Inputs *inputs = createContiguousInputs(inputs_number, questions_size, answers_size);
 
-	Inputs *inputs = createInputs(inputs_number, questions_size, answers_size, questions, answers);
+	thread_number = MIN(MAX(thread_number, 1), MAX(inputs_number, 1));
 
-	const int inputsPerIllness = inputs_number / answers_size;
-	const int remainder = inputs_number % answers_size;
+	DatasetPart *parts = (DatasetPart*) calloc(thread_number, sizeof(DatasetPart));
+	pthread_t *threads = (pthread_t*) calloc(thread_number, sizeof(pthread_t));
 
-	for (int index = 0; index < inputs_number; ++index)
+	for (int t = 0; t < thread_number; ++t)
 	{
-		for (int symptom = 0; symptom < questions_size; ++symptom)
-			questions[index][symptom] = VALUE_ABSENT_SYMPTOM;
+		parts[t].inputs = inputs;
+		parts[t].seed = seed;
+		parts[t].start = (long) inputs_number * t / thread_number;
+		parts[t].end = (long) inputs_number * (t + 1) / thread_number;
 	}
 
-	int index = 0;
+	// The calling thread generates the first part:
 
-	for (int illnessIndex = 0; illnessIndex < answers_size; ++illnessIndex)
+	for (int t = 1; t < thread_number; ++t)
 	{
-		addIllnesses(questions + index, answers + index, BaseDataset + illnessIndex, inputsPerIllness);
-
-		index += inputsPerIllness;
+		if (pthread_create(threads + t, NULL, generateDatasetPart, parts + t) != 0)
+		{
+			printf("\nCould not create the dataset generation thread %d.\n\n", t);
+			exit(EXIT_FAILURE);
+		}
 	}
 
-	// In case remainder != 0. First illness in 'BaseDataset' added:
-	addIllnesses(questions + index, answers + index, BaseDataset, remainder);
+	generateDatasetPart(parts);
+
+	for (int t = 1; t < thread_number; ++t)
+		pthread_join(threads[t], NULL);
+
+	free(threads);
+	free(parts);
 
 	return inputs;
 }
@@ -150,3 +193,40 @@ void printBaseDataset(void)
 		}
 	}
 }
+
+
+// Generating the rows [start, end[ of the dataset. The first 'answers_size' x 'inputsPerIllness' rows are
+// made of each illness in turn, and the remaining rows are of the first illness in 'BaseDataset':
+static void* generateDatasetPart(void *arg)
+{
+	DatasetPart *part = (DatasetPart*) arg;
+
+	Inputs *inputs = part -> inputs;
+
+	const int inputsPerIllness = inputs -> InputNumber / inputs -> AnswersSize;
+	const long illnessRowsNumber = (long) inputsPerIllness * inputs -> AnswersSize;
+
+	for (long index = part -> start; index < part -> end; ++index)
+	{
+		for (int symptom = 0; symptom < inputs -> QuestionsSize; ++symptom)
+			inputs -> Questions[index][symptom] = VALUE_ABSENT_SYMPTOM;
+	}
+
+	long index = part -> start;
+
+	while (index < part -> end)
+	{
+		// Rows of the same illness, in this part:
+
+		const int illnessIndex = index < illnessRowsNumber ? index / inputsPerIllness : 0;
+		const long illnessEnd = index < illnessRowsNumber ? (illnessIndex + 1L) * inputsPerIllness : part -> end;
+		const long rowsNumber = MIN(illnessEnd, part -> end) - index;
+
+		addIllnesses(inputs -> Questions + index, inputs -> Answers + index, BaseDataset + illnessIndex, rowsNumber,
+			index, part -> seed);
+
+		index += rowsNumber;
+	}
+
+	return NULL;
+}
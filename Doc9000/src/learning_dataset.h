@@ -2,6 +2,8 @@
 #define LEARNING_DATASET_H
 
 
+#include <stdint.h>
+
 #include "medical_structs.h"
 
 
@@ -14,16 +16,19 @@
 int enterSymptom(Number *question, Symptom symptom, Number value);
 
 
-// Generate a noisy value:
-Number generateValue(void);
+// Generate a noisy value, from a counter-based random number: the same seed and counter always give the same value.
+Number generateValue(uint64_t seed, uint64_t counter);
 
 
-// Adds a given quantity of the given illness into the learning dataset:
-void addIllnesses(Number **questions, Number **answers, const MedicalData *data, int dataQuantity);
+// Adds a given quantity of the given illness into the learning dataset. 'first_row' is the index of the first added
+// row in the whole dataset: each row values only depend on it and the seed, not on how the dataset is split.
+void addIllnesses(Number **questions, Number **answers, const MedicalData *data, int dataQuantity, long first_row,
+	uint64_t seed);
 
 
-// Creating a demo of a learning_dataset:
-Inputs* createDataset(int inputs_number);
+// Creating a learning dataset, whose rows are split between 'thread_number' threads.
+// The dataset only depends on the given seed, whatever the number of threads:
+Inputs* createDataset(int inputs_number, uint64_t seed, int thread_number);
 
 
 // Fetch the json file to create the base dataset, assuming it hasn't been done already.
@@ -13,7 +13,7 @@ void learningPhase(void)
 
 	int learning_sampleNumber = 100000;
 
-	Inputs *learning_dataset = createDataset(learning_sampleNumber);
+	Inputs *learning_dataset = createDataset(learning_sampleNumber, LEARNING_DATASET_SEED, DATASET_THREAD_NUMBER);
 
 	printInputs(learning_dataset, INFOS);
 
@@ -38,6 +38,7 @@ void learningPhase(void)
 
 	params -> Method = MINI_BATCHES;
 	params -> BatchSize = max_batch_size;
+	params -> ThreadNumber = LEARNING_THREAD_NUMBER;
 	params -> EpochNumber = 5;
 	params -> LearningRate = 0.005;
 	params -> LearningRateMultiplier = 0.9;
@@ -51,13 +52,14 @@ void learningPhase(void)
 
 	int validation_sampleNumber = 10000;
 
-	Inputs *validation_dataset = createDataset(validation_sampleNumber);
+	Inputs *validation_dataset = createDataset(validation_sampleNumber, VALIDATION_DATASET_SEED, DATASET_THREAD_NUMBER);
 
 	validation(network, validation_dataset, MAX_CORRECT);
 
 	// Saving and loading:
 
 	saveNetwork(network, NEURAL_NET_DIR_PATH);
+	saveNetworkFile(network, NEURAL_NET_FILE_PATH);
 
 	// Freeing everything:
 
@@ -6,6 +6,7 @@
 #include "learning_dataset.h"
 #include "learning_phase.h"
 #include "api.h"
+#include "medrec_cache.h"
 #include "diagnostic_making.h"
 #include "event_loop.h"
 #include "demos.h"
@@ -59,6 +60,7 @@ void runtime(void)
 	// Disconnect from the database, and free static ressources:
 
 	disconnectFromDatabase();
+	freeMedicalRecordCache();
 	freeCriticityArray();
 	freeRecognitionRessources();
 
@@ -82,18 +84,33 @@ void unitTests(void)
 
 	failure_number += !testDiagnosticProduction();
 
+	failure_number += !testBatchedDiagnostics();
+
 	failure_number += !checkBackupsIntegrity();
 
 	failure_number += !testReadMedicalRecord(33); // several diagnostics on the local database.
 
 	failure_number += !testReadMedicalRecord(36); // no past diagnostic on the local database.
 
+	failure_number += !testMedicalRecordCache();
+
+	failure_number += !testDatasetGeneration();
+
+	failure_number += !testNameLookup();
+
+	failure_number += !testRequestArena();
+
+	failure_number += !testPreDiagnosticBatchFile();
+
+	failure_number += !testTruncatedPreDiagnosticFiles();
+
 	failure_number += !testWriteDiagnostic(1);
 
 	// Disconnect from the database, and free static ressources:
 
 	disconnectFromDatabase();
 
+	freeMedicalRecordCache();
 	freeCriticityArray();
 	freeStringsArrays();
 	freeDatasetAssets();
@@ -14,11 +14,21 @@ static const char* GenderString[] = {"male", "female"};
 
 // Allocates enough memory for a pre-diagnostic:
 PreDiagnostic* allocatePreDiagnostic(short symptom_number)
+{
+	return allocatePreDiagnosticInArena(NULL, symptom_number);
+}
+
+
+// Same as allocatePreDiagnostic(), in the given arena if not NULL. The prediagnostic is then not to be freed.
+// Its symptoms arrays follow it in the same block: confidences first, for their alignment.
+PreDiagnostic* allocatePreDiagnosticInArena(Arena *arena, short symptom_number)
 {
 	if (symptom_number < 0)
 		return NULL;
 
-	PreDiagnostic *prediag = (PreDiagnostic*) calloc(1, sizeof(PreDiagnostic));
+	const size_t size = sizeof(PreDiagnostic) + symptom_number * (sizeof(float) + sizeof(Symptom));
+
+	PreDiagnostic *prediag = (PreDiagnostic*) arenaAlloc(arena, size);
 
 	if (prediag == NULL)
 	{
@@ -36,15 +46,8 @@ PreDiagnostic* allocatePreDiagnostic(short symptom_number)
 
 	else
 	{
-		prediag -> declaredSymptoms = (Symptom*) calloc(symptom_number, sizeof(Symptom));
-		prediag -> declaredSymptomsConfidences = (float*) calloc(symptom_number, sizeof(float));
-
-		if (prediag -> declaredSymptoms == NULL || prediag -> declaredSymptomsConfidences == NULL)
-		{
-			printf("\nNot enough memory to create the prediagnostic' symptoms array.\n");
-			freePreDiagnostic(&prediag);
-			return NULL;
-		}
+		prediag -> declaredSymptomsConfidences = (float*) (prediag + 1);
+		prediag -> declaredSymptoms = (Symptom*) (prediag -> declaredSymptomsConfidences + symptom_number);
 	}
 
 	return prediag;
@@ -57,9 +60,7 @@ void freePreDiagnostic(PreDiagnostic **prediag)
 	if (prediag == NULL || *prediag == NULL)
 		return;
 
-	free((*prediag) -> declaredSymptomsConfidences);
-	free((*prediag) -> declaredSymptoms);
-	free(*prediag);
+	free(*prediag); // Along with its symptoms arrays.
 	*prediag = NULL;
 }
 
@@ -156,11 +157,19 @@ void printDiagnostic(const Diagnostic *diag)
 
 // Allocates enough memory for a medical record:
 MedicalRecord* allocateMedicalRecord(short diagnostic_number)
+{
+	return allocateMedicalRecordInArena(NULL, diagnostic_number);
+}
+
+
+// Same as allocateMedicalRecord(), in the given arena if not NULL. The medical record is then not to be freed.
+// Its diagnostics follow it in the same block.
+MedicalRecord* allocateMedicalRecordInArena(Arena *arena, short diagnostic_number)
 {
 	if (diagnostic_number < 0)
 		return NULL;
 
-	MedicalRecord *medrec = (MedicalRecord*) calloc(1, sizeof(MedicalRecord));
+	MedicalRecord *medrec = (MedicalRecord*) arenaAlloc(arena, sizeof(MedicalRecord) + diagnostic_number * sizeof(Diagnostic));
 
 	if (medrec == NULL)
 	{
@@ -169,21 +178,7 @@ MedicalRecord* allocateMedicalRecord(short diagnostic_number)
 	}
 
 	medrec -> diagnosticNumber = diagnostic_number;
-
-	if (diagnostic_number == 0)
-		medrec -> diagnosticArray = NULL;
-
-	else
-	{
-		medrec -> diagnosticArray = (Diagnostic*) calloc(diagnostic_number, sizeof(Diagnostic));
-
-		if (medrec -> diagnosticArray == NULL)
-		{
-			printf("\nNot enough memory to create a new diagnostic array.\n");
-			freeMedicalRecord(&medrec);
-			return NULL;
-		}
-	}
+	medrec -> diagnosticArray = diagnostic_number == 0 ? NULL : (Diagnostic*) (medrec + 1);
 
 	return medrec;
 }
@@ -195,8 +190,7 @@ void freeMedicalRecord(MedicalRecord **medrec)
 	if (medrec == NULL || *medrec == NULL)
 		return;
 
-	free((*medrec) -> diagnosticArray);
-	free(*medrec);
+	free(*medrec); // Along with its diagnostics.
 	*medrec = NULL;
 }
 
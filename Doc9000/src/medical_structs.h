@@ -3,6 +3,7 @@
 
 
 #include "doc_settings.h"
+#include "arena.h"
 
 
 ///////////////////////////////////////////////////////////////
@@ -63,6 +64,11 @@ typedef struct
 PreDiagnostic* allocatePreDiagnostic(short symptom_number);
 
 
+// Same as allocatePreDiagnostic(), in the given arena if not NULL. The prediagnostic is then not to be freed.
+// Its symptoms arrays follow it in the same block: confidences first, for their alignment.
+PreDiagnostic* allocatePreDiagnosticInArena(Arena *arena, short symptom_number);
+
+
 // Frees a pre-diagnostic passed by address, and sets said address to NULL.
 void freePreDiagnostic(PreDiagnostic **prediag);
 
@@ -93,6 +99,11 @@ void printDiagnostic(const Diagnostic *diag);
 MedicalRecord* allocateMedicalRecord(short diagnostic_number);
 
 
+// Same as allocateMedicalRecord(), in the given arena if not NULL. The medical record is then not to be freed.
+// Its diagnostics follow it in the same block.
+MedicalRecord* allocateMedicalRecordInArena(Arena *arena, short diagnostic_number);
+
+
 // Frees a medical record passed by address, and sets said address to NULL.
 void freeMedicalRecord(MedicalRecord **medrec);
 
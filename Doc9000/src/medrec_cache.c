@@ -0,0 +1,325 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "medrec_cache.h"
+
+
+#define NO_ENTRY -1
+
+// At least one element, for the arrays to be valid. Buckets number is a power of 2:
+#define CACHE_ARRAY_SIZE MAX(MEDREC_CACHE_SIZE, 1)
+#define CACHE_BUCKET_NUMBER 2048
+#define CACHE_BUCKET_MASK (CACHE_BUCKET_NUMBER - 1)
+
+
+typedef struct
+{
+	int id_socdet;
+	double insertion_time;
+	MedicalRecord *medrec; // NULL if the entry is unused.
+	int previous, next; // LRU list, from the most recently used entry.
+	int next_in_bucket;
+} CacheEntry;
+
+
+static CacheEntry Entries[CACHE_ARRAY_SIZE];
+static int Buckets[CACHE_BUCKET_NUMBER];
+static int LRU_head = NO_ENTRY, LRU_tail = NO_ENTRY;
+static int UsedEntries, CacheInitialized;
+static long HitNumber, MissNumber;
+
+// Bumped by each invalidation of a patient of the bucket, so that a record read from the database before
+// the invalidation is not cached afterwards. Patients sharing a bucket only make some insertions skipped:
+static unsigned int BucketGenerations[CACHE_BUCKET_NUMBER];
+
+static pthread_mutex_t CacheMutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+// Copies a medical record, and its diagnostics, in the given arena if not NULL:
+static MedicalRecord* copyMedicalRecord(const MedicalRecord *medrec, Arena *arena)
+{
+	MedicalRecord *copy = allocateMedicalRecordInArena(arena, medrec -> diagnosticNumber);
+
+	if (copy == NULL)
+		return NULL;
+
+	Diagnostic *diagnosticArray = copy -> diagnosticArray;
+
+	*copy = *medrec;
+	copy -> diagnosticArray = diagnosticArray;
+
+	for (int i = 0; i < medrec -> diagnosticNumber; ++i)
+		diagnosticArray[i] = medrec -> diagnosticArray[i];
+
+	return copy;
+}
+
+
+static inline int hashIdSocdet(int id_socdet)
+{
+	return ((unsigned int) id_socdet * 2654435761u) >> 16 & CACHE_BUCKET_MASK;
+}
+
+
+// Must be called with the mutex locked:
+static void initCache(void)
+{
+	for (int b = 0; b < CACHE_BUCKET_NUMBER; ++b)
+		Buckets[b] = NO_ENTRY;
+
+	CacheInitialized = 1;
+}
+
+
+// Must be called with the mutex locked. Returns the entry index, or NO_ENTRY:
+static int findEntry(int id_socdet)
+{
+	int e = Buckets[hashIdSocdet(id_socdet)];
+
+	while (e != NO_ENTRY && Entries[e].id_socdet != id_socdet)
+		e = Entries[e].next_in_bucket;
+
+	return e;
+}
+
+
+// Must be called with the mutex locked:
+static void unlinkFromLRU(int e)
+{
+	if (Entries[e].previous != NO_ENTRY)
+		Entries[Entries[e].previous].next = Entries[e].next;
+	else
+		LRU_head = Entries[e].next;
+
+	if (Entries[e].next != NO_ENTRY)
+		Entries[Entries[e].next].previous = Entries[e].previous;
+	else
+		LRU_tail = Entries[e].previous;
+}
+
+
+// Must be called with the mutex locked:
+static void pushFrontLRU(int e)
+{
+	Entries[e].previous = NO_ENTRY;
+	Entries[e].next = LRU_head;
+
+	if (LRU_head != NO_ENTRY)
+		Entries[LRU_head].previous = e;
+	else
+		LRU_tail = e;
+
+	LRU_head = e;
+}
+
+
+// Must be called with the mutex locked. The entry can then be reused:
+static void unlinkEntry(int e)
+{
+	int *link = Buckets + hashIdSocdet(Entries[e].id_socdet);
+
+	while (*link != e)
+		link = &Entries[*link].next_in_bucket;
+
+	*link = Entries[e].next_in_bucket;
+
+	unlinkFromLRU(e);
+
+	freeMedicalRecord(&Entries[e].medrec);
+}
+
+
+// Must be called with the mutex locked. Used entries are kept contiguous, by moving the last one in place of the deleted one:
+static void deleteEntry(int e)
+{
+	unlinkEntry(e);
+
+	const int last = --UsedEntries;
+
+	if (e == last)
+		return;
+
+	int *link = Buckets + hashIdSocdet(Entries[last].id_socdet);
+
+	while (*link != last)
+		link = &Entries[*link].next_in_bucket;
+
+	*link = e;
+
+	Entries[e] = Entries[last];
+	Entries[last].medrec = NULL;
+
+	if (Entries[e].previous != NO_ENTRY)
+		Entries[Entries[e].previous].next = e;
+	else
+		LRU_head = e;
+
+	if (Entries[e].next != NO_ENTRY)
+		Entries[Entries[e].next].previous = e;
+	else
+		LRU_tail = e;
+}
+
+
+// Returns a copy of the cached medical record of the given patient, or NULL if absent or expired.
+// This will require a freeMedicalRecord() call afterhand.
+MedicalRecord* getCachedMedicalRecord(int id_socdet)
+{
+	return getCachedMedicalRecordInArena(id_socdet, NULL);
+}
+
+
+// Same as getCachedMedicalRecord(), the copy being allocated in the given arena if not NULL.
+MedicalRecord* getCachedMedicalRecordInArena(int id_socdet, Arena *arena)
+{
+	if (MEDREC_CACHE_SIZE <= 0)
+		return NULL;
+
+	MedicalRecord *copy = NULL;
+
+	pthread_mutex_lock(&CacheMutex);
+
+	int e = CacheInitialized ? findEntry(id_socdet) : NO_ENTRY;
+
+	if (e != NO_ENTRY && get_time() - Entries[e].insertion_time > MEDREC_CACHE_TTL) // Expired.
+	{
+		deleteEntry(e);
+		e = NO_ENTRY;
+	}
+
+	if (e != NO_ENTRY)
+	{
+		unlinkFromLRU(e);
+		pushFrontLRU(e);
+
+		copy = copyMedicalRecord(Entries[e].medrec, arena);
+		++HitNumber;
+	}
+
+	else
+		++MissNumber;
+
+	pthread_mutex_unlock(&CacheMutex);
+
+	return copy;
+}
+
+
+// Returns the invalidation generation of the given patient. Read it before reading their medical record
+// from the database, and pass it to cacheMedicalRecord():
+unsigned int getMedicalRecordGeneration(int id_socdet)
+{
+	pthread_mutex_lock(&CacheMutex);
+
+	const unsigned int generation = BucketGenerations[hashIdSocdet(id_socdet)];
+
+	pthread_mutex_unlock(&CacheMutex);
+
+	return generation;
+}
+
+
+// Caches a copy of the given medical record, evicting the least recently used one if the cache is full.
+// Nothing is cached if the patient's record has been invalidated since 'generation' was read:
+void cacheMedicalRecord(int id_socdet, const MedicalRecord *medrec, unsigned int generation)
+{
+	if (MEDREC_CACHE_SIZE <= 0 || medrec == NULL)
+		return;
+
+	MedicalRecord *copy = copyMedicalRecord(medrec, NULL);
+
+	if (copy == NULL)
+		return;
+
+	pthread_mutex_lock(&CacheMutex);
+
+	if (BucketGenerations[hashIdSocdet(id_socdet)] != generation) // Possibly stale record.
+	{
+		pthread_mutex_unlock(&CacheMutex);
+		freeMedicalRecord(&copy);
+		return;
+	}
+
+	if (!CacheInitialized)
+		initCache();
+
+	int e = findEntry(id_socdet);
+
+	if (e != NO_ENTRY) // Already cached, e.g by another thread.
+		unlinkEntry(e);
+
+	else if (UsedEntries < MEDREC_CACHE_SIZE)
+		e = UsedEntries++;
+
+	else
+	{
+		e = LRU_tail;
+		unlinkEntry(e);
+	}
+
+	const int bucket = hashIdSocdet(id_socdet);
+
+	Entries[e].id_socdet = id_socdet;
+	Entries[e].insertion_time = get_time();
+	Entries[e].medrec = copy;
+	Entries[e].next_in_bucket = Buckets[bucket];
+	Buckets[bucket] = e;
+
+	pushFrontLRU(e);
+
+	pthread_mutex_unlock(&CacheMutex);
+}
+
+
+// Removes the given patient's medical record from the cache, e.g once a new diagnostic is written for them:
+void invalidateCachedMedicalRecord(int id_socdet)
+{
+	if (MEDREC_CACHE_SIZE <= 0)
+		return;
+
+	pthread_mutex_lock(&CacheMutex);
+
+	++BucketGenerations[hashIdSocdet(id_socdet)];
+
+	int e = CacheInitialized ? findEntry(id_socdet) : NO_ENTRY;
+
+	if (e != NO_ENTRY)
+		deleteEntry(e);
+
+	pthread_mutex_unlock(&CacheMutex);
+}
+
+
+// Prints the number of cache hits and misses:
+void printMedicalRecordCacheStats(void)
+{
+	pthread_mutex_lock(&CacheMutex);
+
+	const long total = HitNumber + MissNumber;
+
+	if (total > 0)
+	{
+		printf("Medical records cache: %ld hits, %ld misses (%.1f %% hits), %d cached.\n",
+			HitNumber, MissNumber, 100. * HitNumber / total, UsedEntries);
+	}
+
+	pthread_mutex_unlock(&CacheMutex);
+}
+
+
+// Empties the cache, and resets its counters:
+void freeMedicalRecordCache(void)
+{
+	pthread_mutex_lock(&CacheMutex);
+
+	for (int e = 0; e < UsedEntries; ++e)
+		freeMedicalRecord(&Entries[e].medrec);
+
+	UsedEntries = 0;
+	LRU_head = LRU_tail = NO_ENTRY;
+	HitNumber = MissNumber = 0;
+	CacheInitialized = 0;
+
+	pthread_mutex_unlock(&CacheMutex);
+}
@@ -0,0 +1,43 @@
+#ifndef MEDREC_CACHE_H
+#define MEDREC_CACHE_H
+
+
+#include "medical_structs.h"
+
+
+// Bounded LRU cache of medical records, keyed by 'id_socdet'. Entries older than 'MEDREC_CACHE_TTL'
+// seconds are reloaded. Thread safe. Medical records are copied in and out of the cache.
+
+
+// Returns a copy of the cached medical record of the given patient, or NULL if absent or expired.
+// This will require a freeMedicalRecord() call afterhand.
+MedicalRecord* getCachedMedicalRecord(int id_socdet);
+
+
+// Same as getCachedMedicalRecord(), the copy being allocated in the given arena if not NULL.
+MedicalRecord* getCachedMedicalRecordInArena(int id_socdet, Arena *arena);
+
+
+// Returns the invalidation generation of the given patient. Read it before reading their medical record
+// from the database, and pass it to cacheMedicalRecord():
+unsigned int getMedicalRecordGeneration(int id_socdet);
+
+
+// Caches a copy of the given medical record, evicting the least recently used one if the cache is full.
+// Nothing is cached if the patient's record has been invalidated since 'generation' was read:
+void cacheMedicalRecord(int id_socdet, const MedicalRecord *medrec, unsigned int generation);
+
+
+// Removes the given patient's medical record from the cache, e.g once a new diagnostic is written for them:
+void invalidateCachedMedicalRecord(int id_socdet);
+
+
+// Prints the number of cache hits and misses:
+void printMedicalRecordCacheStats(void);
+
+
+// Empties the cache, and resets its counters:
+void freeMedicalRecordCache(void);
+
+
+#endif
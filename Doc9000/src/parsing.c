@@ -18,6 +18,10 @@ float *CriticityArray;
 char **IllnessStringArray;
 char **SymptomStringArray;
 
+// Hash indexes of the above arrays, for getIllnessID() and getSymptomID():
+static StringIndex *IllnessNameIndex;
+static StringIndex *SymptomNameIndex;
+
 
 static int ParsingPass;
 
@@ -122,7 +126,7 @@ inline Illness getIllnessID(const char *string)
 
 	short illness_number = getIllnessNumber();
 
-	int index = getStringIndex(string, IllnessStringArray, illness_number);
+	int index = findStringIndex(IllnessNameIndex, string, illness_number);
 
 	if (index >= illness_number)
 	{
@@ -147,7 +151,7 @@ inline Symptom getSymptomID(const char *string)
 
 	short symptom_number = getSymptomNumber();
 
-	int index = getStringIndex(string, SymptomStringArray, symptom_number);
+	int index = findStringIndex(SymptomNameIndex, string, symptom_number);
 
 	if (index >= symptom_number)
 	{
@@ -168,6 +172,26 @@ inline const float* getCriticityArray(void)
 }
 
 
+// Builds the hash indexes of 'IllnessStringArray' and 'SymptomStringArray', once they are loaded:
+void buildNameIndexes(void)
+{
+	if (IllnessStringArray == NULL || SymptomStringArray == NULL)
+		return;
+
+	if (IllnessNameIndex == NULL)
+		IllnessNameIndex = createStringIndex(IllnessStringArray, IllnessNumber, IllnessNumber);
+
+	if (SymptomNameIndex == NULL)
+		SymptomNameIndex = createStringIndex(SymptomStringArray, SymptomNumber, SymptomNumber);
+
+	if (IllnessNameIndex == NULL || SymptomNameIndex == NULL)
+	{
+		printf("\nNot enough memory to create the names indexes.\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+
 ///////////////////////////////////////////////////////////////
 // Freeing:
 
@@ -175,8 +199,26 @@ inline const float* getCriticityArray(void)
 // Frees and resets to NULL.
 void freeCriticityArray(void)
 {
-	free(CriticityArray);
+	if (!inCompiledAssets(CriticityArray))
+		free(CriticityArray);
+
 	CriticityArray = NULL;
+
+	releaseCompiledAssets();
+}
+
+
+// Frees the names, or only their pointers if they are in the compiled assets:
+static void freeNames(char ***names, int names_number)
+{
+	if (*names != NULL && names_number > 0 && inCompiledAssets((*names)[0]))
+	{
+		free(*names);
+		*names = NULL;
+	}
+
+	else
+		freeCharMatrix(names, names_number);
 }
 
 
@@ -184,8 +226,12 @@ void freeCriticityArray(void)
 void freeStringsArrays(void)
 {
 	// Do not check 'IllnessNumber' and 'SymptomNumber' here, previous values must be used.
-	freeCharMatrix(&IllnessStringArray, IllnessNumber);
-	freeCharMatrix(&SymptomStringArray, SymptomNumber);
+	freeStringIndex(&IllnessNameIndex);
+	freeStringIndex(&SymptomNameIndex);
+	freeNames(&IllnessStringArray, IllnessNumber);
+	freeNames(&SymptomStringArray, SymptomNumber);
+
+	releaseCompiledAssets();
 }
 
 
@@ -214,6 +260,7 @@ void freeMedicalData(MedicalData **medData, int data_number)
 
 // Parse the base dataset, in order to generate the ilness and symptoms lists, along with the criticity file.
 // If called with a non-NULL medData, it will be filled with an array of medical data used for the learning phase.
+// The results are compiled into a single file, from which they are loaded instead while the base dataset is unchanged.
 ParsingStatus parseBaseDataset(MedicalData **medData)
 {
 	///////////////////////////////////////////////////////////////
@@ -224,6 +271,9 @@ ParsingStatus parseBaseDataset(MedicalData **medData)
 	if (medData == NULL && checkRessources() == RESSOURCES_EXIST)
 		return RESSOURCES_EXIST;
 
+	if (medData != NULL && loadCompiledAssets(medData) == LOADING_SUCCESSFUL)
+		return LOADING_SUCCESSFUL;
+
 	if (ParsingPass >= MAX_PARSING_PASSES) // protection against infinite loops in case of severe failure.
 	{
 		printf("\nMaximum parsing passes reached.\n");
@@ -247,7 +297,10 @@ ParsingStatus parseBaseDataset(MedicalData **medData)
 
 	float criticityArray[MAX_ILLNESS_NUMBER];
 
-	if (illnessArray == NULL || symptomArray == NULL)
+	// Index of the symptoms found so far, for finding the already known ones:
+	StringIndex *symptomIndex = createStringIndex(symptomArray, 0, MAX_SYMPTOM_NUMBER);
+
+	if (illnessArray == NULL || symptomArray == NULL || symptomIndex == NULL)
 	{
 		printf("\nNot enough memory to create strings arrays.\n");
 		fclose(src_file);
@@ -264,30 +317,25 @@ ParsingStatus parseBaseDataset(MedicalData **medData)
 	SymptomNumber = 0;
 
 	///////////////////////////////////////////////////////////////
-	// Medical data buffer:
+	// Medical data buffer, always filled for the compiled assets:
 
-	MedicalData *medDataBuffer = NULL;
+	MedicalData *medDataBuffer = (MedicalData*) calloc(MAX_ILLNESS_NUMBER, sizeof(MedicalData));
 
-	if (medData != NULL)
+	if (medDataBuffer == NULL)
 	{
-		medDataBuffer = (MedicalData*) calloc(MAX_ILLNESS_NUMBER, sizeof(MedicalData));
+		printf("\nNot enough memory to create 'medDataBuffer'.\n");
+		exit(EXIT_FAILURE);
+	}
 
-		if (medDataBuffer == NULL)
-		{
-			printf("\nNot enough memory to create 'medDataBuffer'.\n");
-			exit(EXIT_FAILURE);
-		}
+	for (int i = 0; i < MAX_ILLNESS_NUMBER; ++i)
+	{
+		medDataBuffer[i].symptomArray = (Symptom*) calloc(MAX_SYMPTOM_PER_DATA, sizeof(Symptom));
 
-		for (int i = 0; i < MAX_ILLNESS_NUMBER; ++i)
+		if (medDataBuffer[i].symptomArray == NULL)
 		{
-			medDataBuffer[i].symptomArray = (Symptom*) calloc(MAX_SYMPTOM_PER_DATA, sizeof(Symptom));
-
-			if (medDataBuffer[i].symptomArray == NULL)
-			{
-				printf("\nNot enough memory to create 'medDataBuffer[%d]'.\n", i);
-				freeMedicalData(&medDataBuffer, MAX_ILLNESS_NUMBER);
-				exit(EXIT_FAILURE);
-			}
+			printf("\nNot enough memory to create 'medDataBuffer[%d]'.\n", i);
+			freeMedicalData(&medDataBuffer, MAX_ILLNESS_NUMBER);
+			exit(EXIT_FAILURE);
 		}
 	}
 
@@ -297,9 +345,10 @@ ParsingStatus parseBaseDataset(MedicalData **medData)
 	int mode = 0, illness_rank = -1, symptom_rank = 0, symptom_data_rank = 0;
 
 	strcpy(symptomArray[symptom_rank], TO_STRING(no_symptom));
+	addStringToIndex(symptomIndex, symptom_rank);
 	++symptom_rank;
 
-	while (illness_rank < MAX_ILLNESS_NUMBER && symptom_rank < MAX_SYMPTOM_NUMBER)
+	while (illness_rank < MAX_ILLNESS_NUMBER - 1 && symptom_rank < MAX_SYMPTOM_NUMBER)
 	{
 		if (fgets(buffer, MAX_NAME_LENGTH, src_file) == NULL) // End of file.
 			break;
@@ -315,6 +364,11 @@ ParsingStatus parseBaseDataset(MedicalData **medData)
 		if (length >= MAX_NAME_LENGTH)
 		{
 			printf("Maximum name length may be too small!\n");
+			fclose(src_file);
+			freeStringIndex(&symptomIndex);
+			freeCharMatrix(&illnessArray, MAX_ILLNESS_NUMBER);
+			freeCharMatrix(&symptomArray, MAX_SYMPTOM_NUMBER);
+			freeMedicalData(&medDataBuffer, MAX_ILLNESS_NUMBER);
 			return PARSING_FAILED;
 		}
 
@@ -333,24 +387,22 @@ ParsingStatus parseBaseDataset(MedicalData **medData)
 				criticityArray[illness_rank] = boundCriticity(criticity);
 			}
 
-			if (medData != NULL)
-			{
-				medDataBuffer[illness_rank].illness = illness_rank;
-				symptom_data_rank = 0;
-			}
+			medDataBuffer[illness_rank].illness = illness_rank;
+			symptom_data_rank = 0;
 		}
 
 		else // symptoms
 		{
-			int symptom_pos = getStringIndex(buffer, symptomArray, symptom_rank);
+			int symptom_pos = findStringIndex(symptomIndex, buffer, symptom_rank);
 
 			if (symptom_pos == symptom_rank)
 			{
 				strcpy(symptomArray[symptom_rank], buffer);
+				addStringToIndex(symptomIndex, symptom_rank);
 				++symptom_rank;
 			}
 
-			if (medData != NULL)
+			if (illness_rank >= 0 && symptom_data_rank < MAX_SYMPTOM_PER_DATA) // No illness yet for a leading symptom.
 			{
 				++medDataBuffer[illness_rank].symptomNumber;
 				medDataBuffer[illness_rank].symptomArray[symptom_data_rank] = symptom_pos;
@@ -361,6 +413,8 @@ ParsingStatus parseBaseDataset(MedicalData **medData)
 
 	fclose(src_file);
 
+	freeStringIndex(&symptomIndex);
+
 	///////////////////////////////////////////////////////////////
 	// Filling, and freeing local buffers:
 
@@ -372,6 +426,9 @@ ParsingStatus parseBaseDataset(MedicalData **medData)
 	if (IllnessNumber >= MAX_ILLNESS_NUMBER || SymptomNumber >= MAX_SYMPTOM_NUMBER)
 	{
 		printf("Maximum number of illnesses or symptoms may be too small!\n");
+		freeCharMatrix(&illnessArray, MAX_ILLNESS_NUMBER);
+		freeCharMatrix(&symptomArray, MAX_SYMPTOM_NUMBER);
+		freeMedicalData(&medDataBuffer, MAX_ILLNESS_NUMBER);
 		return PARSING_FAILED;
 	}
 
@@ -403,6 +460,8 @@ ParsingStatus parseBaseDataset(MedicalData **medData)
 
 	freeCharMatrix(&symptomArray, MAX_SYMPTOM_NUMBER);
 
+	buildNameIndexes();
+
 	// Criticities:
 
 	for (int i = 0; i < IllnessNumber; ++i)
@@ -444,8 +503,6 @@ ParsingStatus parseBaseDataset(MedicalData **medData)
 				(*medData)[i].symptomArray[j] = medDataBuffer[i].symptomArray[j];
 			}
 		}
-
-		freeMedicalData(&medDataBuffer, MAX_ILLNESS_NUMBER);
 	}
 
 	printf("\nParsing done. Saving the results.\n");
@@ -453,5 +510,10 @@ ParsingStatus parseBaseDataset(MedicalData **medData)
 	if (saveParsingResults() != SAVING_SUCCESSFUL)
 		parsing_status = PARSING_FAILED;
 
+	if (saveCompiledAssets(medDataBuffer) != SAVING_SUCCESSFUL) // Not fatal: the base dataset is parsed again next time.
+		printf("\nCould not compile the assets of '%s'.\n", SRC_BASE_DATASET);
+
+	freeMedicalData(&medDataBuffer, MAX_ILLNESS_NUMBER);
+
 	return parsing_status;
 }
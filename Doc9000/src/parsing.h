@@ -48,6 +48,10 @@ Symptom getSymptomID(const char *string);
 const float* getCriticityArray(void);
 
 
+// Builds the hash indexes of 'IllnessStringArray' and 'SymptomStringArray', once they are loaded:
+void buildNameIndexes(void);
+
+
 ///////////////////////////////////////////////////////////////
 // Freeing:
 
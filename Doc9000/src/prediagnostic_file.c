@@ -1,14 +1,57 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "prediagnostic_file.h"
 #include "parsing.h"
 
 
-static const short Static_magic_number = MAGIC_NUMBER;
+#define PREDIAG_HEADER_SIZE 18 // Bytes before the symptoms, see prediagnostic_file.h
+#define PREDIAG_SYMPTOM_SIZE 4
+#define RECORD_SIZE_SIZE 4 // Size of a batch container record size.
+
+// Enough for reading at once any prediagnostic file of at most MAX_SYMPTOM_NUMBER symptoms, and detecting a bigger one:
+#define PREDIAG_READ_BUFFER_SIZE (PREDIAG_HEADER_SIZE + MAX_SYMPTOM_NUMBER * PREDIAG_SYMPTOM_SIZE + 1)
+
+
 static char Generated_filename[MAX_FILENAME_PATH_LENGTH];
+static int Generated_batch_count;
+
+
+// Little endian encoding and decoding, whatever the endianness of the machine:
+
+static inline void writeLE16(unsigned char *dest, uint16_t value);
+
+
+static inline void writeLE32(unsigned char *dest, uint32_t value);
+
+
+static inline void writeLE64(unsigned char *dest, uint64_t value);
+
+
+static inline uint16_t readLE16(const unsigned char *src);
+
+
+static inline uint32_t readLE32(const unsigned char *src);
+
+
+static inline uint64_t readLE64(const unsigned char *src);
+
+
+// Encodes a prediagnostic as in a prediagnostic file, 'no_symptom' being skipped, and writes it to the given file
+// with a single call, preceded by its size in bytes if 'with_size' is 1. Returns 1 on success, 0 else.
+static int writeEncodedPreDiagnostic(FILE *file, const PreDiagnostic *prediag, int with_size);
+
+
+// Decodes a prediagnostic of 'size' bytes, laid out as in a prediagnostic file. Returns NULL if invalid,
+// the size being checked against the symptoms number before any allocation.
+static PreDiagnostic* decodePreDiagnostic(const unsigned char *data, size_t size, Arena *arena);
 
 
 // Useful only for testing purpose. Do _not_ free the result, as it is static.
@@ -36,155 +79,497 @@ int writePreDiagnosticFile(const PreDiagnostic *prediag)
 		return 0;
 	}
 
-	short convertedPatientConfidenceLevel = CONVERSION_COEFF * prediag -> patientConfidenceLevel;
+	int success = writeEncodedPreDiagnostic(file, prediag, 0);
 
-	fwrite(&Static_magic_number, sizeof(short), 1, file);
-	fwrite(&(prediag -> timestamp), sizeof(unsigned long), 1, file);
-	fwrite(&(prediag -> id_socdet), sizeof(int), 1, file);
-	fwrite(&convertedPatientConfidenceLevel, sizeof(short), 1, file);
-	fwrite(&(prediag -> symptomNumber), sizeof(short), 1, file);
+	success = fclose(file) == 0 && success;
 
-	for (int i = 0; i < prediag -> symptomNumber; ++i)
-	{
-		if (prediag -> declaredSymptoms[i] != no_symptom)
-		{
-			short convertedDeclaredSymptomsConfidences = CONVERSION_COEFF * prediag -> declaredSymptomsConfidences[i];
+	if (!success)
+		printf("\nCould not write to: '%s'.\n", Generated_filename);
 
-			fwrite(prediag -> declaredSymptoms + i, sizeof(Symptom), 1, file);
-			fwrite(&convertedDeclaredSymptomsConfidences, sizeof(short), 1, file);
-		}
-	}
+	return success;
+}
 
-	fclose(file);
 
-	return 1;
+// Reads a prediagnostic file, and returns a new prediagnostic on success, and NULL on failure.
+// The file is read at once, and rejected if its size does not match its symptoms number.
+// This will require a freePreDiagnostic() call afterhand.
+PreDiagnostic* readPreDiagnosticFile(const char *filename)
+{
+	return readPreDiagnosticFileInArena(filename, NULL);
 }
 
 
-// Reads a prediagnostic file, and returns a new prediagnostic on success,
-// and NULL on failure. This will require a freePreDiagnostic() call afterhand.
-PreDiagnostic* readPreDiagnosticFile(const char *filename)
+// Same as readPreDiagnosticFile(), the prediagnostic being allocated in the given arena if not NULL.
+// It must not be freed then: it lives until the arena is reset.
+PreDiagnostic* readPreDiagnosticFileInArena(const char *filename, Arena *arena)
 {
 	if (CHECK_PREDIAG_FILENAMES && !prediagFilenameCheck(filename))
 		return NULL;
 
-	FILE *file = fopen(filename, "rb");
+	int fd = open(filename, O_RDONLY);
 
-	if (file == NULL)
+	if (fd < 0)
 	{
 		printf("\nCould not open file: '%s'.\n", filename);
 		return NULL;
 	}
 
-	short magic_number;
-	unsigned long timestamp;
-	int id_socdet;
-	short toConvertPatientConfidenceLevel;
-	short symptomNumber;
+	// Read at once, then decoded from the buffer:
 
-	if (fread(&magic_number, sizeof(short), 1, file) != 1)
+	unsigned char buffer[PREDIAG_READ_BUFFER_SIZE];
+
+	const ssize_t size = read(fd, buffer, PREDIAG_READ_BUFFER_SIZE);
+
+	PreDiagnostic *prediag = NULL;
+
+	if (size >= 0 && size < PREDIAG_READ_BUFFER_SIZE)
+		prediag = decodePreDiagnostic(buffer, size, arena);
+
+	else if (size == PREDIAG_READ_BUFFER_SIZE) // Bigger file, which is mapped instead.
 	{
-		printf("\nCould not read 'magic_number'.\n");
-		goto failure;
+		struct stat st;
+
+		void *mapping = fstat(fd, &st) == 0 ? mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+
+		if (mapping != MAP_FAILED)
+		{
+			prediag = decodePreDiagnostic((const unsigned char*) mapping, st.st_size, arena);
+			munmap(mapping, st.st_size);
+		}
 	}
 
-	if (magic_number != Static_magic_number)
+	close(fd);
+
+	if (prediag == NULL)
+		printf("\nInvalid or truncated prediagnostic file: '%s'.\n", filename);
+
+	return prediag;
+}
+
+
+// Checks the filenames of the prediagnostics files, which must be located in 'PREDIAGS_SRC_FOLDER'.
+int prediagFilenameCheck(const char *filename)
+{
+	if (!filename)
+		return 0;
+
+	char full_path_format[] = PREDIAGS_SRC_FOLDER PREDIAGS_FILENAME_FORMAT;
+
+	const int start_check_length = 8, end_check_length = 21;
+	const int len = strlen(filename);
+	const int end_filename = MIN(len, end_check_length);
+
+	int start_res = strncmp(full_path_format, filename, start_check_length + sizeof(PREDIAGS_SRC_FOLDER) - 1) == 0;
+	int end_res = strcmp(full_path_format + sizeof(full_path_format) - 1 - end_check_length, filename + len - end_filename) == 0;
+
+	if (VERBOSE_MODE >= 2 && !(start_res && end_res))
+		printf("Incorrect prediagnostic filename: '%s'.\n", filename);
+
+	return start_res && end_res;
+}
+
+
+// Creates a new batch container in 'PREDIAGS_SRC_FOLDER', with a generated filename. Returns NULL on failure.
+PreDiagnosticBatchWriter* createPreDiagnosticBatchWriter(void)
+{
+	char filename[MAX_FILENAME_PATH_LENGTH];
+
+	snprintf(filename, MAX_FILENAME_PATH_LENGTH, "%s"PREDIAGS_BATCH_FILENAME_FORMAT,
+		PREDIAGS_SRC_FOLDER, (int) getpid(), (long) time(NULL), Generated_batch_count++);
+
+	PreDiagnosticBatchWriter *writer = createPreDiagnosticBatchWriterAt(filename);
+
+	if (writer != NULL)
+		writer -> generated = 1;
+
+	return writer;
+}
+
+
+// Creates a new batch container with the given filename, in any folder. Returns NULL on failure.
+PreDiagnosticBatchWriter* createPreDiagnosticBatchWriterAt(const char *filename)
+{
+	PreDiagnosticBatchWriter *writer = (PreDiagnosticBatchWriter*) calloc(1, sizeof(PreDiagnosticBatchWriter));
+
+	if (writer == NULL)
 	{
-		printf("\nWrong endianness or unsupported file.\n");
-		goto failure;
+		printf("\nNot enough memory to create a batch container.\n");
+		return NULL;
 	}
 
-	if (fread(&timestamp, sizeof(unsigned long), 1, file) != 1)
+	snprintf(writer -> filename, MAX_FILENAME_PATH_LENGTH, "%s", filename);
+
+	snprintf(writer -> partial_filename, sizeof(writer -> partial_filename), "%s"BATCH_PARTIAL_SUFFIX, writer -> filename);
+
+	writer -> file = fopen(writer -> partial_filename, "wb");
+
+	if (writer -> file == NULL)
 	{
-		printf("Could not read 'timestamp'.\n");
-		goto failure;
+		printf("\nCould not write to: '%s'.\n", writer -> partial_filename);
+		free(writer);
+		return NULL;
 	}
 
-	if (fread(&id_socdet, sizeof(int), 1, file) != 1)
+	unsigned char header[BATCH_HEADER_SIZE];
+
+	writeLE16(header, BATCH_MAGIC_NUMBER);
+	writeLE16(header + 2, BATCH_FORMAT_VERSION);
+
+	if (fwrite(header, 1, BATCH_HEADER_SIZE, writer -> file) != BATCH_HEADER_SIZE)
 	{
-		printf("Could not read 'id_socdet'.\n");
-		goto failure;
+		printf("\nCould not write to: '%s'.\n", writer -> partial_filename);
+		fclose(writer -> file);
+		remove(writer -> partial_filename);
+		free(writer);
+		return NULL;
 	}
 
-	if (fread(&toConvertPatientConfidenceLevel, sizeof(short), 1, file) != 1)
+	return writer;
+}
+
+
+// Appends a prediagnostic to the given container. Returns 1 on success, 0 else.
+int appendPreDiagnosticToBatch(PreDiagnosticBatchWriter *writer, const PreDiagnostic *prediag)
+{
+	if (writer == NULL || prediag == NULL)
+		return 0;
+
+	if (!writeEncodedPreDiagnostic(writer -> file, prediag, 1))
 	{
-		printf("Could not read 'toConvertPatientConfidenceLevel'.\n");
-		goto failure;
+		printf("\nCould not append a prediagnostic to: '%s'.\n", writer -> partial_filename);
+		return 0;
 	}
 
-	if (fread(&symptomNumber, sizeof(short), 1, file) != 1)
+	++(writer -> recordNumber);
+
+	return 1;
+}
+
+
+// Appends the record of a mapped container starting at 'record_offset' (its 'offset' before the record is read) to
+// the given container, without decoding it: invalid and truncated records are copied as is. Returns 1 on success, 0 else.
+int copyBatchRecord(PreDiagnosticBatchWriter *writer, const PreDiagnosticBatchFile *batch, size_t record_offset)
+{
+	if (writer == NULL || batch == NULL || record_offset >= batch -> size)
+		return 0;
+
+	const size_t left = batch -> size - record_offset;
+
+	const uint32_t record_size = left >= RECORD_SIZE_SIZE ? readLE32(batch -> mapping + record_offset) : 0;
+
+	const size_t copy_size = left < RECORD_SIZE_SIZE || record_size > left - RECORD_SIZE_SIZE ?
+		left : RECORD_SIZE_SIZE + record_size; // Truncated record: the rest of the container.
+
+	if (fwrite(batch -> mapping + record_offset, 1, copy_size, writer -> file) != copy_size)
 	{
-		printf("Could not read 'symptomNumber'.\n");
-		goto failure;
+		printf("\nCould not append a prediagnostic to: '%s'.\n", writer -> partial_filename);
+		return 0;
 	}
 
-	symptomNumber = MAX(0, symptomNumber); // to be sure.
+	++(writer -> recordNumber);
 
-	PreDiagnostic *prediag = allocatePreDiagnostic(symptomNumber);
+	return 1;
+}
 
-	if (prediag == NULL)
+
+// Closes the container passed by address, renames it to its final filename (then stored in 'Generated_filename'
+// if it has been generated), and sets it to NULL. Returns 1 on success, 0 else.
+int closePreDiagnosticBatchWriter(PreDiagnosticBatchWriter **writer)
+{
+	if (writer == NULL || *writer == NULL)
+		return 0;
+
+	int success = fclose((*writer) -> file) == 0;
+
+	// Atomic rename, for the container not to be read before being complete:
+	success = success && rename((*writer) -> partial_filename, (*writer) -> filename) == 0;
+
+	if (!success)
+		printf("\nCould not close the batch container: '%s'.\n", (*writer) -> filename);
+	else if ((*writer) -> generated)
+		snprintf(Generated_filename, MAX_FILENAME_PATH_LENGTH, "%s", (*writer) -> filename);
+
+	free(*writer);
+	*writer = NULL;
+
+	return success;
+}
+
+
+// Returns 1 if the given filename is the one of a batch container, 0 else. Its folder is not checked.
+int isPreDiagnosticBatchFilename(const char *filename)
+{
+	if (!filename)
+		return 0;
+
+	const char *name = strrchr(filename, '/');
+	name = name != NULL ? name + 1 : filename;
+
+	const char suffix[] = "_BehaviorAnalysis.bin";
+	const int len = strlen(name), suffix_len = sizeof(suffix) - 1;
+
+	return strncmp(name, "Batch_", 6) == 0 && len > suffix_len && strcmp(name + len - suffix_len, suffix) == 0;
+}
+
+
+// Returns 1 if the given filename is the one of a batch container still being written, 0 else.
+int isPartialPreDiagnosticBatchFilename(const char *filename)
+{
+	if (!filename)
+		return 0;
+
+	const int len = strlen(filename), suffix_len = sizeof(BATCH_PARTIAL_SUFFIX) - 1;
+
+	return len > suffix_len && strcmp(filename + len - suffix_len, BATCH_PARTIAL_SUFFIX) == 0;
+}
+
+
+// Maps a batch container, whose records can then be read with readNextPreDiagnostic(). Returns NULL on failure.
+PreDiagnosticBatchFile* openPreDiagnosticBatchFile(const char *filename)
+{
+	if (CHECK_PREDIAG_FILENAMES && (!isPreDiagnosticBatchFilename(filename)
+		|| strncmp(filename, PREDIAGS_SRC_FOLDER, sizeof(PREDIAGS_SRC_FOLDER) - 1) != 0))
 	{
-		printf("Failure: prediagnostic not filled.\n");
-		goto failure;
+		if (VERBOSE_MODE >= 2)
+			printf("Incorrect batch container filename: '%s'.\n", filename);
+		return NULL;
 	}
 
-	prediag -> timestamp = timestamp;
-	prediag -> id_socdet = id_socdet;
-	prediag -> patientConfidenceLevel = (float) toConvertPatientConfidenceLevel / CONVERSION_COEFF;
-	prediag -> symptomNumber = symptomNumber;
+	int fd = open(filename, O_RDONLY);
 
-	const short total_symptom_number = getSymptomNumber();
+	if (fd < 0)
+	{
+		printf("\nCould not open file: '%s'.\n", filename);
+		return NULL;
+	}
 
-	for (int i = 0; i < symptomNumber; ++i)
+	struct stat st;
+
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t) BATCH_HEADER_SIZE)
 	{
-		if (fread(prediag -> declaredSymptoms + i, sizeof(Symptom), 1, file) != 1)
-		{
-			printf("Could not read 'declaredSymptoms[%d]'.\n", i);
-			freePreDiagnostic(&prediag);
-			goto failure;
-		}
+		printf("\nCould not read the header of: '%s'.\n", filename);
+		close(fd);
+		return NULL;
+	}
 
-		if (prediag -> declaredSymptoms[i] < 0 || prediag -> declaredSymptoms[i] >= total_symptom_number) // to be sure.
-			prediag -> declaredSymptoms[i] = no_symptom;
+	void *mapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
 
-		short toConvertDeclaredSymptomsConfidences;
+	close(fd); // The mapping stays valid.
 
-		if (fread(&toConvertDeclaredSymptomsConfidences, sizeof(short), 1, file) != 1)
-		{
-			printf("Could not read 'declaredSymptomsConfidences[%d]'.\n", i);
-			freePreDiagnostic(&prediag);
-			goto failure;
-		}
+	if (mapping == MAP_FAILED)
+	{
+		printf("\nCould not map file: '%s'.\n", filename);
+		return NULL;
+	}
+
+	const unsigned char *header = (const unsigned char*) mapping;
 
-		prediag -> declaredSymptomsConfidences[i] = (float) toConvertDeclaredSymptomsConfidences / CONVERSION_COEFF;
+	if (readLE16(header) != BATCH_MAGIC_NUMBER || readLE16(header + 2) != BATCH_FORMAT_VERSION)
+	{
+		printf("\nWrong endianness or unsupported batch container: '%s'.\n", filename);
+		munmap(mapping, st.st_size);
+		return NULL;
 	}
 
-	fclose(file);
-	return prediag;
+	PreDiagnosticBatchFile *batch = (PreDiagnosticBatchFile*) calloc(1, sizeof(PreDiagnosticBatchFile));
 
-	failure:
-		fclose(file);
+	if (batch == NULL)
+	{
+		printf("\nNot enough memory to read a batch container.\n");
+		munmap(mapping, st.st_size);
 		return NULL;
+	}
+
+	batch -> mapping = (const unsigned char*) mapping;
+	batch -> size = st.st_size;
+	batch -> offset = BATCH_HEADER_SIZE;
+
+	return batch;
 }
 
 
-// Checks the filenames of the prediagnostics files, which must be located in 'PREDIAGS_SRC_FOLDER'.
-int prediagFilenameCheck(const char *filename)
+// Reads the next record of the given container into '*prediag', allocated in the given arena if not NULL
+// (to be freed with freePreDiagnostic() else). '*prediag' is set to NULL if the record is invalid.
+// Returns 1 if a record has been read, and 0 once all of them have been, or if the last one is truncated.
+int readNextPreDiagnostic(PreDiagnosticBatchFile *batch, PreDiagnostic **prediag, Arena *arena)
 {
-	if (!filename)
+	*prediag = NULL;
+
+	if (batch == NULL || batch -> offset == batch -> size)
 		return 0;
 
-	char full_path_format[] = PREDIAGS_SRC_FOLDER PREDIAGS_FILENAME_FORMAT;
+	const size_t left = batch -> size - batch -> offset;
 
-	const int start_check_length = 8, end_check_length = 21;
-	const int len = strlen(filename);
-	const int end_filename = MIN(len, end_check_length);
+	const uint32_t record_size = left >= RECORD_SIZE_SIZE ? readLE32(batch -> mapping + batch -> offset) : 0;
 
-	int start_res = strncmp(full_path_format, filename, start_check_length + sizeof(PREDIAGS_SRC_FOLDER) - 1) == 0;
-	int end_res = strcmp(full_path_format + sizeof(full_path_format) - 1 - end_check_length, filename + len - end_filename) == 0;
+	if (left < RECORD_SIZE_SIZE || record_size > left - RECORD_SIZE_SIZE)
+	{
+		printf("\nTruncated record %d in a batch container.\n", batch -> recordIndex);
+		batch -> truncated = 1;
+		batch -> offset = batch -> size;
+		return 0;
+	}
 
-	if (VERBOSE_MODE >= 2 && !(start_res && end_res))
-		printf("Incorrect prediagnostic filename: '%s'.\n", filename);
+	*prediag = decodePreDiagnostic(batch -> mapping + batch -> offset + RECORD_SIZE_SIZE, record_size, arena);
 
-	return start_res && end_res;
+	if (*prediag == NULL)
+		printf("\nInvalid record %d in a batch container.\n", batch -> recordIndex);
+
+	batch -> offset += RECORD_SIZE_SIZE + record_size;
+	++(batch -> recordIndex);
+
+	return 1;
+}
+
+
+// Unmaps the container passed by address, and sets it to NULL.
+void closePreDiagnosticBatchFile(PreDiagnosticBatchFile **batch)
+{
+	if (batch == NULL || *batch == NULL)
+		return;
+
+	munmap((void*) (*batch) -> mapping, (*batch) -> size);
+	free(*batch);
+	*batch = NULL;
+}
+
+
+static inline void writeLE16(unsigned char *dest, uint16_t value)
+{
+	dest[0] = value;
+	dest[1] = value >> 8;
+}
+
+
+static inline void writeLE32(unsigned char *dest, uint32_t value)
+{
+	writeLE16(dest, value);
+	writeLE16(dest + 2, value >> 16);
+}
+
+
+static inline void writeLE64(unsigned char *dest, uint64_t value)
+{
+	writeLE32(dest, value);
+	writeLE32(dest + 4, value >> 32);
+}
+
+
+static inline uint16_t readLE16(const unsigned char *src)
+{
+	return src[0] | (uint16_t) src[1] << 8;
+}
+
+
+static inline uint32_t readLE32(const unsigned char *src)
+{
+	return readLE16(src) | (uint32_t) readLE16(src + 2) << 16;
+}
+
+
+static inline uint64_t readLE64(const unsigned char *src)
+{
+	return readLE32(src) | (uint64_t) readLE32(src + 4) << 32;
+}
+
+
+// Encodes a prediagnostic as in a prediagnostic file, 'no_symptom' being skipped, and writes it to the given file
+// with a single call, preceded by its size in bytes if 'with_size' is 1. Returns 1 on success, 0 else.
+static int writeEncodedPreDiagnostic(FILE *file, const PreDiagnostic *prediag, int with_size)
+{
+	short symptomNumber = 0;
+
+	for (int i = 0; i < prediag -> symptomNumber; ++i)
+		symptomNumber += prediag -> declaredSymptoms[i] != no_symptom;
+
+	const size_t size = PREDIAG_HEADER_SIZE + symptomNumber * PREDIAG_SYMPTOM_SIZE;
+
+	unsigned char stack_buffer[RECORD_SIZE_SIZE + PREDIAG_READ_BUFFER_SIZE];
+
+	unsigned char *buffer = RECORD_SIZE_SIZE + size <= sizeof(stack_buffer) ? stack_buffer :
+		(unsigned char*) malloc(RECORD_SIZE_SIZE + size);
+
+	if (buffer == NULL)
+	{
+		printf("\nNot enough memory to encode a prediagnostic.\n");
+		return 0;
+	}
+
+	unsigned char *dest = buffer;
+
+	if (with_size)
+	{
+		writeLE32(dest, size);
+		dest += RECORD_SIZE_SIZE;
+	}
+
+	short convertedPatientConfidenceLevel = CONVERSION_COEFF * prediag -> patientConfidenceLevel;
+
+	writeLE16(dest, MAGIC_NUMBER);
+	writeLE64(dest + 2, prediag -> timestamp);
+	writeLE32(dest + 10, prediag -> id_socdet);
+	writeLE16(dest + 14, convertedPatientConfidenceLevel);
+	writeLE16(dest + 16, symptomNumber);
+	dest += PREDIAG_HEADER_SIZE;
+
+	for (int i = 0; i < prediag -> symptomNumber; ++i)
+	{
+		if (prediag -> declaredSymptoms[i] != no_symptom)
+		{
+			short convertedDeclaredSymptomsConfidences = CONVERSION_COEFF * prediag -> declaredSymptomsConfidences[i];
+
+			writeLE16(dest, prediag -> declaredSymptoms[i]);
+			writeLE16(dest + 2, convertedDeclaredSymptomsConfidences);
+			dest += PREDIAG_SYMPTOM_SIZE;
+		}
+	}
+
+	const size_t length = dest - buffer;
+
+	const int success = fwrite(buffer, 1, length, file) == length;
+
+	if (buffer != stack_buffer)
+		free(buffer);
+
+	return success;
+}
+
+
+// Decodes a prediagnostic of 'size' bytes, laid out as in a prediagnostic file. Returns NULL if invalid,
+// the size being checked against the symptoms number before any allocation.
+static PreDiagnostic* decodePreDiagnostic(const unsigned char *data, size_t size, Arena *arena)
+{
+	if (size < PREDIAG_HEADER_SIZE)
+		return NULL;
+
+	const short magic_number = readLE16(data);
+	const unsigned long timestamp = readLE64(data + 2);
+	const int id_socdet = (int32_t) readLE32(data + 10);
+	const short toConvertPatientConfidenceLevel = readLE16(data + 14);
+	const short symptomNumber = readLE16(data + 16);
+
+	if (magic_number != MAGIC_NUMBER || symptomNumber < 0 || size != PREDIAG_HEADER_SIZE + symptomNumber * PREDIAG_SYMPTOM_SIZE)
+		return NULL;
+
+	data += PREDIAG_HEADER_SIZE;
+
+	PreDiagnostic *prediag = allocatePreDiagnosticInArena(arena, symptomNumber);
+
+	prediag -> timestamp = timestamp;
+	prediag -> id_socdet = id_socdet;
+	prediag -> patientConfidenceLevel = (float) toConvertPatientConfidenceLevel / CONVERSION_COEFF;
+
+	const short total_symptom_number = getSymptomNumber();
+
+	for (int i = 0; i < symptomNumber; ++i, data += PREDIAG_SYMPTOM_SIZE)
+	{
+		prediag -> declaredSymptoms[i] = readLE16(data);
+
+		if (prediag -> declaredSymptoms[i] < 0 || prediag -> declaredSymptoms[i] >= total_symptom_number) // to be sure.
+			prediag -> declaredSymptoms[i] = no_symptom;
+
+		prediag -> declaredSymptomsConfidences[i] = (float) (short) readLE16(data + 2) / CONVERSION_COEFF;
+	}
+
+	return prediag;
 }
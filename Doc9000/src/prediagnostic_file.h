@@ -2,6 +2,8 @@
 #define PREDIAGNOSTIC_FILE_H
 
 
+#include <stdio.h>
+
 #include "medical_structs.h"
 
 
@@ -9,7 +11,7 @@
 // Filename: 'DIAG_FOLDER'/Patient_'id_socdet'_'timestamp'_BehaviorAnalysis.bin,
 // where 'timestamp' is the number of seconds passed since January 1, 1970.
 // File size: 4 * symptomNumber + 18 bytes. 'symptomNumber' is written inside the file, see below.
-// File content, in the following order:
+// File content, in the following order, every value being little endian:
 // - magic_number: short (2 bytes). See below for its fixed value. This is useful to test endianness and proper reading.
 // - timestamp: unsigned long (8 bytes)
 // - id_socdet: int (4 bytes)
@@ -27,6 +29,48 @@
 // Will not truncate values in practice, since only rounded values will be saved in the first place.
 
 
+// PreDiagnostic batch container, holding many prediagnostics in a single file, thus sparing the file system
+// operations made for each prediagnostic file (open, filename check, rename, and unlink at cleanup):
+// Filename: 'DIAG_FOLDER'/Batch_'pid'_'timestamp'_'count'_BehaviorAnalysis.bin, see PREDIAGS_BATCH_FILENAME_FORMAT.
+// File content, in the following order, every value being little endian:
+// - batch_magic_number: short (2 bytes), BATCH_MAGIC_NUMBER.
+// - version: short (2 bytes), BATCH_FORMAT_VERSION.
+// - Any number of records, appended one after the other:
+// 	- record_size: int (4 bytes). Size in bytes of the following prediagnostic.
+// 	- A prediagnostic, with the same content as a prediagnostic file (starting with MAGIC_NUMBER).
+// The container is written under its filename followed by BATCH_PARTIAL_SUFFIX, which is ignored by the event loop,
+// and renamed once closed: it is then processed at once, and must not be appended to anymore.
+
+
+#define BATCH_MAGIC_NUMBER 101 // Same constraint as MAGIC_NUMBER, and different from it.
+#define BATCH_FORMAT_VERSION 1
+#define BATCH_HEADER_SIZE (2 * sizeof(short))
+
+#define BATCH_PARTIAL_SUFFIX ".part"
+
+
+// Container being written by an emitter:
+typedef struct
+{
+	FILE *file;
+	int recordNumber;
+	int generated; // 1 if its filename has been generated, 0 if given.
+	char filename[MAX_FILENAME_PATH_LENGTH]; // Final filename.
+	char partial_filename[MAX_FILENAME_PATH_LENGTH + sizeof(BATCH_PARTIAL_SUFFIX)]; // Filename while being written.
+} PreDiagnosticBatchWriter;
+
+
+// Mapped container being read:
+typedef struct
+{
+	const unsigned char *mapping;
+	size_t size;
+	size_t offset; // Of the next record.
+	int recordIndex;
+	int truncated; // 1 if the last record is incomplete.
+} PreDiagnosticBatchFile;
+
+
 // Useful only for testing purpose. Do _not_ free the result, as it is static.
 const char* lastGeneratedPreDiagnosticFilename(void);
 
@@ -36,13 +80,63 @@ const char* lastGeneratedPreDiagnosticFilename(void);
 int writePreDiagnosticFile(const PreDiagnostic *prediag);
 
 
-// Reads a prediagnostic file, and returns a new prediagnostic on success,
-// and NULL on failure. This will require a freePreDiagnostic() call afterhand.
+// Reads a prediagnostic file, and returns a new prediagnostic on success, and NULL on failure.
+// The file is read at once, and rejected if its size does not match its symptoms number.
+// This will require a freePreDiagnostic() call afterhand.
 PreDiagnostic* readPreDiagnosticFile(const char *filename);
 
 
+// Same as readPreDiagnosticFile(), the prediagnostic being allocated in the given arena if not NULL.
+// It must not be freed then: it lives until the arena is reset.
+PreDiagnostic* readPreDiagnosticFileInArena(const char *filename, Arena *arena);
+
+
 // Checks the filenames of the prediagnostics files, which must be located in 'PREDIAGS_SRC_FOLDER'.
 int prediagFilenameCheck(const char *filename);
 
 
+// Creates a new batch container in 'PREDIAGS_SRC_FOLDER', with a generated filename. Returns NULL on failure.
+PreDiagnosticBatchWriter* createPreDiagnosticBatchWriter(void);
+
+
+// Creates a new batch container with the given filename, in any folder. Returns NULL on failure.
+PreDiagnosticBatchWriter* createPreDiagnosticBatchWriterAt(const char *filename);
+
+
+// Appends a prediagnostic to the given container. Returns 1 on success, 0 else.
+int appendPreDiagnosticToBatch(PreDiagnosticBatchWriter *writer, const PreDiagnostic *prediag);
+
+
+// Appends the record of a mapped container starting at 'record_offset' (its 'offset' before the record is read) to
+// the given container, without decoding it: invalid and truncated records are copied as is. Returns 1 on success, 0 else.
+int copyBatchRecord(PreDiagnosticBatchWriter *writer, const PreDiagnosticBatchFile *batch, size_t record_offset);
+
+
+// Closes the container passed by address, renames it to its final filename (then stored in 'Generated_filename'
+// if it has been generated), and sets it to NULL. Returns 1 on success, 0 else.
+int closePreDiagnosticBatchWriter(PreDiagnosticBatchWriter **writer);
+
+
+// Returns 1 if the given filename is the one of a batch container, 0 else. Its folder is not checked.
+int isPreDiagnosticBatchFilename(const char *filename);
+
+
+// Returns 1 if the given filename is the one of a batch container still being written, 0 else.
+int isPartialPreDiagnosticBatchFilename(const char *filename);
+
+
+// Maps a batch container, whose records can then be read with readNextPreDiagnostic(). Returns NULL on failure.
+PreDiagnosticBatchFile* openPreDiagnosticBatchFile(const char *filename);
+
+
+// Reads the next record of the given container into '*prediag', allocated in the given arena if not NULL
+// (to be freed with freePreDiagnostic() else). '*prediag' is set to NULL if the record is invalid.
+// Returns 1 if a record has been read, and 0 once all of them have been, or if the last one is truncated.
+int readNextPreDiagnostic(PreDiagnosticBatchFile *batch, PreDiagnostic **prediag, Arena *arena);
+
+
+// Unmaps the container passed by address, and sets it to NULL.
+void closePreDiagnosticBatchFile(PreDiagnosticBatchFile **batch);
+
+
 #endif
@@ -16,7 +16,8 @@ float getBMI_index(short weight, short height)
 int getAge(const char *birthday)
 {
 	time_t t = time(NULL);
-	struct tm tm = *localtime(&t);
+	struct tm tm;
+	localtime_r(&t, &tm); // Thread safe.
 
 	// printf("Date: %d-%02d-%02d\n", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
 
@@ -6,6 +6,10 @@
 #include "doc_settings.h"
 
 
+// FNV-1a hash of a string:
+static inline uint32_t stringHash(const char *string);
+
+
 // Reads an entire text file, and returns it as a string:
 char* readFileContent(char *filename)
 {
@@ -83,6 +87,21 @@ void freeCharMatrix(char ***matrix, int rows)
 }
 
 
+// FNV-1a 64 bits hash of the given data:
+uint64_t dataHash(const unsigned char *data, size_t len)
+{
+	uint64_t hash = 14695981039346656037ULL;
+
+	for (size_t i = 0; i < len; ++i)
+	{
+		hash ^= data[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+
 // Returns the index of a string in the given array if it exists, or 'bound' otherwise.
 // 'bound' needs to not be greater than the array length.
 int getStringIndex(const char *string, char* const *string_array, int bound)
@@ -94,3 +113,115 @@ int getStringIndex(const char *string, char* const *string_array, int bound)
 
 	return i;
 }
+
+
+// Creates an index of the 'string_number' first strings of the given array, which can then grow with
+// addStringToIndex() up to 'max_string_number' strings. Returns NULL if there is not enough memory.
+StringIndex* createStringIndex(char* const *string_array, int string_number, int max_string_number)
+{
+	StringIndex *index = (StringIndex*) calloc(1, sizeof(StringIndex));
+
+	if (index == NULL)
+	{
+		printf("\nNot enough memory to create a strings index.\n");
+		return NULL;
+	}
+
+	// Load factor of at most 1/2, so that the probe sequences stay short:
+
+	index -> Capacity = 1;
+
+	while (index -> Capacity < 2 * max_string_number)
+		index -> Capacity *= 2;
+
+	index -> Slots = (int*) malloc(index -> Capacity * sizeof(int));
+	index -> Hashes = (uint32_t*) calloc(index -> Capacity, sizeof(uint32_t));
+	index -> StringArray = string_array;
+
+	if (index -> Slots == NULL || index -> Hashes == NULL)
+	{
+		printf("\nNot enough memory to create a strings index.\n");
+		freeStringIndex(&index);
+		return NULL;
+	}
+
+	memset(index -> Slots, -1, index -> Capacity * sizeof(int));
+
+	for (int i = 0; i < string_number; ++i)
+		addStringToIndex(index, i);
+
+	return index;
+}
+
+
+// Free the index pointed by the given adress, and set it to NULL:
+void freeStringIndex(StringIndex **index)
+{
+	if (index == NULL || *index == NULL)
+		return;
+
+	free((*index) -> Slots);
+	free((*index) -> Hashes);
+	free(*index);
+	*index = NULL;
+}
+
+
+// Adds the string at the given position of the indexed array. If an equal string is already indexed, the first one is kept:
+void addStringToIndex(StringIndex *index, int position)
+{
+	const char *string = index -> StringArray[position];
+	const uint32_t hash = stringHash(string);
+
+	int slot = hash & (index -> Capacity - 1);
+
+	while (index -> Slots[slot] != -1) // Linear probing. The capacity bounds the load factor, thus an empty slot exists.
+	{
+		if (index -> Hashes[slot] == hash && strcmp(string, index -> StringArray[index -> Slots[slot]]) == 0)
+			return;
+
+		slot = (slot + 1) & (index -> Capacity - 1);
+	}
+
+	index -> Slots[slot] = position;
+	index -> Hashes[slot] = hash;
+}
+
+
+// Same as getStringIndex(), with the given index. Returns 'bound' if the string is not indexed, or if 'index' is NULL:
+int findStringIndex(const StringIndex *index, const char *string, int bound)
+{
+	if (index == NULL)
+		return bound;
+
+	const uint32_t hash = stringHash(string);
+
+	int slot = hash & (index -> Capacity - 1);
+
+	while (index -> Slots[slot] != -1)
+	{
+		const int position = index -> Slots[slot];
+
+		if (index -> Hashes[slot] == hash && strcmp(string, index -> StringArray[position]) == 0)
+			return position < bound ? position : bound;
+
+		slot = (slot + 1) & (index -> Capacity - 1);
+	}
+
+	return bound;
+}
+
+
+// FNV-1a hash of a string:
+static inline uint32_t stringHash(const char *string)
+{
+	uint32_t hash = 2166136261u;
+
+	for (; *string != '\0'; ++string)
+	{
+		hash ^= (unsigned char) *string;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
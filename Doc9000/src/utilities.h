@@ -2,6 +2,21 @@
 #define UTILITIES_H
 
 
+#include <stdint.h>
+#include <stddef.h>
+
+
+// Open addressing hash index of a strings array, for finding a string index in constant time.
+// The strings are not copied: the indexed ones must not be modified nor freed while the index is used.
+typedef struct
+{
+	int Capacity;			// Power of 2, at least twice the maximum strings number.
+	int *Slots;				// Index of a string in the array, or -1 for an empty slot.
+	uint32_t *Hashes;		// Hash of the string of each slot, compared before the strings themselves.
+	char* const *StringArray;
+} StringIndex;
+
+
 // Reads an entire text file, and returns it as a string:
 char* readFileContent(char *filename);
 
@@ -13,9 +28,30 @@ char** createCharMatrix(int rows, int cols);
 void freeCharMatrix(char ***matrix, int rows);
 
 
+// FNV-1a 64 bits hash of the given data:
+uint64_t dataHash(const unsigned char *data, size_t len);
+
+
 // Returns the index of a string in the given array if it exists, or 'bound' otherwise.
 // 'bound' needs to not be greater than the array length.
 int getStringIndex(const char *string, char* const *string_array, int bound);
 
 
+// Creates an index of the 'string_number' first strings of the given array, which can then grow with
+// addStringToIndex() up to 'max_string_number' strings. Returns NULL if there is not enough memory.
+StringIndex* createStringIndex(char* const *string_array, int string_number, int max_string_number);
+
+
+// Free the index pointed by the given adress, and set it to NULL:
+void freeStringIndex(StringIndex **index);
+
+
+// Adds the string at the given position of the indexed array. If an equal string is already indexed, the first one is kept:
+void addStringToIndex(StringIndex *index, int position);
+
+
+// Same as getStringIndex(), with the given index. Returns 'bound' if the string is not indexed, or if 'index' is NULL:
+int findStringIndex(const StringIndex *index, const char *string, int bound);
+
+
 #endif
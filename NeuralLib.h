@@ -91,6 +91,8 @@ typedef enum {ACTIVATION_APPLY(ACTIVATION_ID)} Activation;
 
 
 // Answers = NULL if the inputs are not for learning.
+// Inputs created by createContiguousInputs() have their rows stored in single blocks, the questions having a stride
+// of QuestionsSize + 1 whose last column is filled with 1: batches of consecutive questions are then propagated in place.
 typedef struct
 {
 	const int InputNumber;
@@ -98,12 +100,24 @@ typedef struct
 	const int AnswersSize;
 	Number **Questions;		// InputNumber x QuestionsSize
 	Number **Answers;		// InputNumber x AnswersSize
+	Number *QuestionsData;	// NULL, or InputNumber x (QuestionsSize + 1), the 'Questions' rows pointing into it.
+	Number *AnswersData;	// NULL, or InputNumber x AnswersSize, the 'Answers' rows pointing into it.
 } Inputs;
 
 
 Inputs* createInputs(int InputNumber, int QuestionsSize, int AnswersSize, Number** Questions, Number** Answers);
 
 
+// Creates inputs whose questions and answers are each stored in a single block, initialized to 0.
+// Answers are only allocated if AnswersSize > 0. The rows can still be shuffled, those inputs being then gathered by batch.
+Inputs* createContiguousInputs(int InputNumber, int QuestionsSize, int AnswersSize);
+
+
+// Returns 1 if the questions rows [batch_index, batch_index + batch_size[ follow each other in the contiguous storage,
+// and can thus be used in place as a strided matrix of leading dimension QuestionsSize + 1. Returns 0 otherwise.
+int contiguousBatch(const Inputs *inputs, int batch_index, int batch_size);
+
+
 // Frees the given Inputs passed by address, and sets it to NULL.
 void freeInputs(Inputs **inputs);
 
@@ -114,6 +128,10 @@ void printInputs(const Inputs *inputs, PrintOption opt);
 int saveInputs(const Inputs *inputs, const char *foldername);
 
 
+// Reads the sizes of the inputs saved in the given folder by saveInputs(). Exits on failure.
+void loadInputsInfos(const char *foldername, int *input_number, int *questions_size, int *answers_size);
+
+
 Inputs* loadInputs(const char *foldername);
 
 
@@ -130,6 +148,79 @@ void normalize(Inputs *inputs, Number* const* mean_stddev_matrix);
 void shuffleInputs(Inputs *inputs);
 
 
+//////////////////////////////////////////////////////////
+// input_stream.h
+//////////////////////////////////////////////////////////
+
+
+// Inputs saved by saveInputs(), read by chunks of 'ChunkSize' rows instead of being loaded at once.
+// Two chunks are kept in memory: while one is being learned, the next one is read by a background thread.
+typedef struct InputStream InputStream;
+
+
+// Opens the inputs saved in the given folder, to be read by chunks of 'ChunkSize' rows. Returns NULL on failure.
+InputStream* openInputStream(const char *foldername, int ChunkSize);
+
+
+// Stops the reading thread, frees the given InputStream passed by address, and sets it to NULL.
+void closeInputStream(InputStream **stream);
+
+
+int inputStream_inputNumber(const InputStream *stream);
+
+
+int inputStream_questionsSize(const InputStream *stream);
+
+
+int inputStream_answersSize(const InputStream *stream);
+
+
+int inputStream_chunkSize(const InputStream *stream);
+
+
+// Starts a new pass over the inputs. If 'shuffle' is non 0, the chunks are read in a random order,
+// and the rows of each chunk are shuffled: this is a shuffling within a window of 'ChunkSize' rows.
+void rewindInputStream(InputStream *stream, int shuffle);
+
+
+// Returns the next chunk of the current pass, as contiguous inputs, or NULL at the end of the pass.
+// The returned chunk is valid until the next call, while the following chunk is being read.
+Inputs* nextInputChunk(InputStream *stream);
+
+
+//////////////////////////////////////////////////////////
+// half_precision.h
+//////////////////////////////////////////////////////////
+
+
+#include <stdint.h>
+
+
+// 16 bits floating point formats, used for storing copies of the nets during a mixed precision learning:
+// BFLOAT16 -> 8 bits exponent, 7 bits mantissa: same range as float, less precision.
+// FLOAT16 -> 5 bits exponent, 10 bits mantissa (IEEE 754 half): more precision, range limited to 65504.
+typedef enum {FULL_PRECISION, BFLOAT16, FLOAT16} Precision;
+
+
+typedef uint16_t Half;
+
+
+// Get the name of a Precision:
+const char* getPrecisionString(Precision format);
+
+
+// Converts 'len' Numbers to the given 16 bits format, rounding to the nearest even:
+void toHalf(Precision format, Half *dest, const Number *src, long len);
+
+
+// Converts 'len' values of the given 16 bits format to Numbers, exactly:
+void fromHalf(Precision format, Number *dest, const Half *src, long len);
+
+
+// Returns the name of the instruction set used by the conversions:
+const char* half_simdName(void);
+
+
 //////////////////////////////////////////////////////////
 // neural_network.h
 //////////////////////////////////////////////////////////
@@ -143,18 +234,33 @@ typedef struct
 
 	Number *Input;		// Pointer to the previous output if not the first layer.
 	Number *Net;		// (InputSize + 1) * NeuronsNumber (last row: biases, other rows: weights)
+	Half *HalfNet;		// NULL, or a copy of 'Net' in the 'HalfFormat' 16 bits format, used by the products of
+	Precision HalfFormat;	// a mixed precision learning.
 	Number *Sum;		// MaxBatchSize * NeuronsNumber
 	Number *GradSum;	// MaxBatchSize * NeuronsNumber
 	Number *Output;		// MaxBatchSize * (NeuronsNumber + 1)
 } NeuronLayer;
 
 
+// Batches whose first layer input has at most this rate of non zero elements are propagated and learned from the
+// lists of said elements, the first layer cost then being proportional to their number. 0 disables it:
+#define SPARSE_INPUT_DENSITY 0.2
+
+
 typedef struct
 {
 	int HasLearned;
 	const int LayersNumber;
 	const int MaxBatchSize; // The greater MaxBatchSize is, the faster the computations may be.
 	NeuronLayer *Layers;	// size: LayersNumber
+	void *Mapping;			// Non NULL if the nets point into a mapped network file.
+	long int MappingSize;
+
+	// Non zero elements of the current batch first layer input, bias column included, if 'SparseBatch' is 1:
+	int SparseBatch;
+	int *SparseRowStart;	// MaxBatchSize + 1, the elements of the question b being at [SparseRowStart[b], SparseRowStart[b + 1]).
+	int *SparseIndices;		// MaxBatchSize * (InputSize + 1)
+	Number *SparseValues;	// MaxBatchSize * (InputSize + 1)
 } NeuralNetwork;
 
 
@@ -166,6 +272,15 @@ NeuralNetwork* createNetwork(int InputSize, int LayersNumber, int *NeuronsNumber
 void freeNetwork(NeuralNetwork **network);
 
 
+// Creates a network sharing the nets of the given one, but owning its own computation buffers.
+// Useful for running several propagations of the same network in parallel. Free it with freeNetworkReplica().
+NeuralNetwork* createNetworkReplica(const NeuralNetwork *network, int MaxBatchSize);
+
+
+// Frees the given replica passed by address, but not the shared nets, and sets it to NULL.
+void freeNetworkReplica(NeuralNetwork **replica);
+
+
 int network_inputSize(const NeuralNetwork *network);
 
 
@@ -184,6 +299,17 @@ int saveNetwork(const NeuralNetwork *network, const char *foldername);
 NeuralNetwork* loadNetwork(const char *foldername, int MaxBatchSize);
 
 
+// Saving a neural network in a single binary file: a header (Number size, endianness, layers sizes and activations,
+// checksum) followed by the nets, each aligned on 'NETWORK_FILE_ALIGNMENT' bytes. Returns 1 on success, 0 else.
+int saveNetworkFile(const NeuralNetwork *network, const char *filename);
+
+
+// Loading a neural network saved by saveNetworkFile(), without copying its nets: they point straight into
+// a private mapping of the file. The network can still learn, modified pages being copied on write.
+// Returns NULL on failure.
+NeuralNetwork* mapNetworkFile(const char *filename, int MaxBatchSize);
+
+
 //////////////////////////////////////////////////////////
 // recognition.h
 //////////////////////////////////////////////////////////
@@ -223,6 +349,7 @@ typedef enum {NO_SHUFFLE, SHUFFLE} ShuffleMode;
 
 // Tips:
 // ON_LINE is slower than MINI_BATCHES, which performs best when BatchSize >= 16.
+// With ThreadNumber > 1, each thread gets BatchSize / ThreadNumber inputs: bigger batches are then needed.
 // AUTOMATIC_NORMALIZED works better when Init = UNIFORM.
 
 
@@ -238,8 +365,12 @@ typedef struct
 	RecognitionMode RecogEstimates; // ALL_CORRECT by default. This can be changed for better estimates.
 
 	int PrintEstimates;
+	int Profile; // If not 0, the time spent in each learning phase is printed after each epoch. 0 by default.
 	int EpochNumber;
 	int BatchSize;
+	int ThreadNumber; // Each batch is split between this many threads, whose gradients are then summed. 1 by default.
+	Precision ProductsPrecision; // FULL_PRECISION by default. Else the products read 16 bits copies of the nets,
+		// refreshed after each update of the full precision nets. Halves the memory read for the nets.
 	Number BatchSizeMultiplier; // Multiply the batch size by this value after each epoch.
 	Number InitRange; // If Init = BY_RANGE, weights are randomly chosen between -InitRange and InitRange.
 	Number LearningRate;
@@ -268,6 +399,11 @@ void freeParameters(LearningParameters **params);
 void learn(NeuralNetwork *network, Inputs *inputs, LearningParameters *params);
 
 
+// Make the neural network learn the inputs read from the given stream, while using the given parameters.
+// The batches being taken within the stream chunks, their size is bounded by the chunk size:
+void learnStream(NeuralNetwork *network, InputStream *stream, LearningParameters *params);
+
+
 // Compare the network answers to the correct ones, and print the validation level.
 void validation(NeuralNetwork *network, Inputs *inputs, RecognitionMode recog);
 
@@ -276,6 +412,90 @@ void validation(NeuralNetwork *network, Inputs *inputs, RecognitionMode recog);
 void prediction(NeuralNetwork *network, Inputs *inputs);
 
 
+//////////////////////////////////////////////////////////
+// quantization.h
+//////////////////////////////////////////////////////////
+
+
+#include <stdint.h>
+
+
+// Int8 copy of a learned network, for inference only. Weights are quantized per output neuron (i.e per channel),
+// with a float scale each. Activations are quantized per row, dynamically: each layer input is stored as unsigned
+// bytes q + 128, so that the dot products can use the u8 x s8 instructions (see quantization.c), the offset being
+// removed with the sums of the weights. Results and activations are computed back in 'Number'.
+
+// The products are computed by blocks of QUANT_ROWS_GROUP rows x QUANT_NEURONS_GROUP neurons, QUANT_INPUTS_GROUP
+// inputs at a time. Sizes are padded accordingly:
+#define QUANT_ROWS_GROUP 8
+#define QUANT_NEURONS_GROUP 16
+#define QUANT_INPUTS_GROUP 4
+
+
+typedef struct
+{
+	const int InputSize;
+	const int NeuronsNumber;
+	const int PaddedInputSize;		// Multiple of QUANT_INPUTS_GROUP.
+	const int PaddedNeuronsNumber;	// Multiple of QUANT_NEURONS_GROUP.
+	Activation Fun;
+
+	int8_t *Weights;		// PaddedInputSize * PaddedNeuronsNumber, 0 padded. Interleaved: for each group of
+							// QUANT_INPUTS_GROUP inputs, the weights of each neuron are consecutive.
+	float *Scales;			// PaddedNeuronsNumber, weights scale of each neuron.
+	int32_t *WeightsSums;	// PaddedNeuronsNumber, for removing the offset of the unsigned inputs.
+	Number *Biases;			// NeuronsNumber
+
+	uint8_t *Input;			// PaddedBatchSize * PaddedInputSize
+	float *InputScales;		// PaddedBatchSize
+	Number *Sum;			// MaxBatchSize * NeuronsNumber
+	Number *Output;			// MaxBatchSize * (NeuronsNumber + 1), like 'NeuronLayer'.
+} QuantizedLayer;
+
+
+typedef struct
+{
+	const int LayersNumber;
+	const int MaxBatchSize;
+	const int PaddedBatchSize;	// Multiple of QUANT_ROWS_GROUP.
+	QuantizedLayer *Layers;	// size: LayersNumber
+} QuantizedNetwork;
+
+
+// Creates the int8 copy of the given network. The latter is not needed afterwards:
+QuantizedNetwork* quantizeNetwork(const NeuralNetwork *network, int MaxBatchSize);
+
+
+// Frees the given quantized network passed by address, and sets it to NULL.
+void freeQuantizedNetwork(QuantizedNetwork **qnet);
+
+
+// Creates a quantized network sharing the weights of the given one, but owning its own computation buffers.
+// Useful for running several propagations of the same network in parallel. Free it with freeQuantizedReplica().
+QuantizedNetwork* createQuantizedReplica(const QuantizedNetwork *qnet, int MaxBatchSize);
+
+
+// Frees the given replica passed by address, but not the shared weights, and sets it to NULL.
+void freeQuantizedReplica(QuantizedNetwork **replica);
+
+
+// Returns the size in bytes of the quantized weights, scales and biases:
+long int quantizedNetworkSize(const QuantizedNetwork *qnet);
+
+
+// Returns the name of the instruction set used by the int8 dot products:
+const char* quantization_simdName(void);
+
+
+// Write the quantized network answers in the given inputs, like prediction():
+void quantizedPrediction(QuantizedNetwork *qnet, Inputs *inputs);
+
+
+// Compares the answers of the network and its quantized copy on the given questions. Prints the rates of questions
+// whose most probable class, and whose 'top_k' most probable classes are the same. Returns the latter rate.
+Number quantizedAgreement(NeuralNetwork *network, QuantizedNetwork *qnet, const Inputs *inputs, int top_k);
+
+
 //////////////////////////////////////////////////////////
 // matrix.h
 //////////////////////////////////////////////////////////
@@ -364,6 +584,54 @@ void recenter(Number *dest, const Number *src, int width, int height);
 //////////////////////////////////////////////////////////
 
 
+#include <stdint.h>
+
+
+// State of a xoshiro256** generator. Each thread must use its own state, e.g split from another one:
+typedef struct
+{
+	uint64_t s[4];
+} RandomState;
+
+
+// Seeds the given state. The same seed always gives the same sequence:
+void seedRandomState(RandomState *state, uint64_t seed);
+
+
+// Returns the next 64 random bits of the given state:
+uint64_t nextRandom(RandomState *state);
+
+
+// Advances the given state by 2^128 numbers, which is equivalent to as many calls to nextRandom().
+void jumpRandomState(RandomState *state);
+
+
+// Creates in 'stream' a new independent sequence, starting where 'state' is, then jumps 'state' past it.
+// Useful for giving its own stream to each thread.
+void splitRandomState(RandomState *state, RandomState *stream);
+
+
+// Returns an unbiased random integer in [0, bound[, bound > 0:
+int random_below(RandomState *state, int bound);
+
+
+// Fills the given vector with random numbers in [min, max[:
+void uniformRandomFill(RandomState *state, Number *vector, int len, Number min, Number max);
+
+
+// Fills the given vector with random numbers following the distribution N(mean, std_dev²):
+void gaussianRandomFill(RandomState *state, Number *vector, int len, Number mean, Number std_dev);
+
+
+// State used by the functions below, one per thread. Threads which did not call setRandomSeed()
+// are seeded with 1, 2, 3... in the order they first use it, the main thread being usually the first one:
+RandomState* defaultRandomState(void);
+
+
+// Seeds the default state of the calling thread:
+void setRandomSeed(uint64_t seed);
+
+
 // Returns a random number in [min, max[.
 Number uniform_random(Number min, Number max);
 
@@ -377,6 +645,26 @@ Number uniform_random(Number min, Number max);
 double get_time(void);
 
 
+// Monotonic clock, finer than get_time(), for timing short calls. Thread safe.
+double get_monotonic_time(void);
+
+
+// Statistics of the durations of repeated calls, in seconds:
+typedef struct
+{
+	int Repeats;
+	double Min;
+	double Median;
+	double P99;
+	double Mean;
+} TimingStats;
+
+
+// Calls 'fun(arg)' 'warmups' times untimed, then times 'repeats' calls of it with a monotonic clock,
+// and returns the statistics of their durations. 'repeats' must be at least 1:
+TimingStats timeRepeated(void (*fun)(void*), void *arg, int warmups, int repeats);
+
+
 //////////////////////////////////////////////////////////
 // endian.h
 //////////////////////////////////////////////////////////
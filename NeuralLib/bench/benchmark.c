@@ -0,0 +1,572 @@
+// NeuralLib benchmark suite, built and run by 'make bench'. Measures the GEMM GFLOP/s for every 'TransposeOptions' case,
+// the activations and optimizers throughputs, the propagation latency at several batch sizes, in full precision and
+// with an int8 copy of the network, and the learning throughput of a network shaped like Doc9000's one. The median and 99th percentile of each measure are printed,
+// and written as JSON for comparing builds.
+
+// Usage: ./benchmark_NeuralLib [-r repeats] [-w warmups] [-o results.json]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "settings.h"
+#include "matrix.h"
+#include "high_perf.h"
+#include "gemm.h"
+#include "activation.h"
+#include "optimizers.h"
+#include "neural_network.h"
+#include "learning.h"
+#include "quantization.h"
+#include "random.h"
+#include "benchmarking.h"
+
+
+#define DEFAULT_REPEATS 30
+#define DEFAULT_WARMUPS 3
+#define MAX_RESULTS 128
+#define BENCH_SEED 12345
+
+// Learning passes are long, thus repeated less:
+#define LEARNING_REPEATS_DIVISOR 5
+
+
+typedef struct
+{
+	char Group[32];
+	char Name[64];
+	TimingStats Stats;
+	double Throughput; // Computed from the median.
+	const char *Unit;
+} BenchResult;
+
+
+static BenchResult Results[MAX_RESULTS];
+static int ResultsNumber = 0;
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Prototypes of static functions:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+// Stores and prints a result, whose throughput is 'work' units per second at the median time:
+static void addResult(const char *group, const char *name, TimingStats stats, double work, const char *unit);
+
+
+static void writeJSON(const char *path, int repeats, int warmups);
+
+
+// The learning functions print their progress, which is not wanted here. Returns the saved stdout:
+static int silenceStdout(void);
+
+
+static void restoreStdout(int saved_stdout);
+
+
+// Sparse binary questions, with a few symptoms per class, like Doc9000 prediagnostics:
+static Inputs* createSymptomInputs(int input_number, int input_size, int answer_size);
+
+
+static void benchGEMM(int warmups, int repeats);
+
+
+static void benchActivations(int warmups, int repeats);
+
+
+static void benchOptimizers(int warmups, int repeats);
+
+
+static void benchPropagation(int warmups, int repeats);
+
+
+static void benchLearning(int warmups, int repeats);
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Main:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+int main(int argc, char **argv)
+{
+	int repeats = DEFAULT_REPEATS, warmups = DEFAULT_WARMUPS;
+	const char *json_path = NULL;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+			repeats = atoi(argv[++i]);
+
+		else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+			warmups = atoi(argv[++i]);
+
+		else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			json_path = argv[++i];
+
+		else
+		{
+			printf("Usage: %s [-r repeats] [-w warmups] [-o results.json]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (repeats < 1 || warmups < 0)
+	{
+		printf("\nInvalid repeats or warmups number.\n\n");
+		return EXIT_FAILURE;
+	}
+
+	setRandomSeed(BENCH_SEED);
+
+	printf("\nNeuralLib benchmarks: %d repeats, %d warmups, kernels: %s\n\n", repeats, warmups, gemm_simdName());
+
+	printf("%-12s %-34s %12s %12s %14s\n", "group", "name", "median (ms)", "p99 (ms)", "throughput");
+
+	benchGEMM(warmups, repeats);
+	benchActivations(warmups, repeats);
+	benchOptimizers(warmups, repeats);
+	benchPropagation(warmups, repeats);
+	benchLearning(warmups, repeats);
+
+	if (json_path != NULL)
+		writeJSON(json_path, repeats, warmups);
+
+	return EXIT_SUCCESS;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Results:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+// Stores and prints a result, whose throughput is 'work' units per second at the median time:
+static void addResult(const char *group, const char *name, TimingStats stats, double work, const char *unit)
+{
+	if (ResultsNumber == MAX_RESULTS)
+	{
+		printf("\nToo many results, increase 'MAX_RESULTS'.\n\n");
+		exit(EXIT_FAILURE);
+	}
+
+	BenchResult *result = Results + ResultsNumber++;
+
+	snprintf(result -> Group, sizeof(result -> Group), "%s", group);
+	snprintf(result -> Name, sizeof(result -> Name), "%s", name);
+	result -> Stats = stats;
+	result -> Throughput = stats.Median > 0 ? work / stats.Median : 0;
+	result -> Unit = unit;
+
+	printf("%-12s %-34s %12.4f %12.4f %9.2f %s\n", group, name, 1000. * stats.Median, 1000. * stats.P99,
+		result -> Throughput, unit);
+}
+
+
+static void writeJSON(const char *path, int repeats, int warmups)
+{
+	FILE *file = fopen(path, "w");
+
+	if (file == NULL)
+	{
+		printf("\nCould not write the results to '%s'.\n\n", path);
+		exit(EXIT_FAILURE);
+	}
+
+	fprintf(file, "{\n");
+	fprintf(file, "\t\"simd\": \"%s\",\n", gemm_simdName());
+	fprintf(file, "\t\"number_size\": %d,\n", (int) sizeof(Number));
+	fprintf(file, "\t\"repeats\": %d,\n", repeats);
+	fprintf(file, "\t\"warmups\": %d,\n", warmups);
+	fprintf(file, "\t\"results\": [\n");
+
+	for (int i = 0; i < ResultsNumber; ++i)
+	{
+		const BenchResult *result = Results + i;
+
+		fprintf(file, "\t\t{\"group\": \"%s\", \"name\": \"%s\", \"repeats\": %d, \"min_s\": %.9f, \"median_s\": %.9f, "
+			"\"p99_s\": %.9f, \"mean_s\": %.9f, \"throughput\": %.6g, \"unit\": \"%s\"}%s\n", result -> Group,
+			result -> Name, result -> Stats.Repeats, result -> Stats.Min, result -> Stats.Median, result -> Stats.P99,
+			result -> Stats.Mean, result -> Throughput, result -> Unit, i + 1 < ResultsNumber ? "," : "");
+	}
+
+	fprintf(file, "\t]\n}\n");
+
+	fclose(file);
+
+	printf("\nResults written to '%s'.\n\n", path);
+}
+
+
+// The learning functions print their progress, which is not wanted here. Returns the saved stdout:
+static int silenceStdout(void)
+{
+	fflush(stdout);
+
+	int saved_stdout = dup(STDOUT_FILENO);
+	int null_file = open("/dev/null", O_WRONLY);
+
+	if (saved_stdout < 0 || null_file < 0)
+	{
+		printf("\nCould not silence the standard output.\n\n");
+		exit(EXIT_FAILURE);
+	}
+
+	dup2(null_file, STDOUT_FILENO);
+	close(null_file);
+
+	return saved_stdout;
+}
+
+
+static void restoreStdout(int saved_stdout)
+{
+	fflush(stdout);
+
+	dup2(saved_stdout, STDOUT_FILENO);
+	close(saved_stdout);
+}
+
+
+// Sparse binary questions, with a few symptoms per class, like Doc9000 prediagnostics:
+static Inputs* createSymptomInputs(int input_number, int input_size, int answer_size)
+{
+	Inputs *inputs = createContiguousInputs(input_number, input_size, answer_size);
+
+	for (int i = 0; i < input_number; ++i)
+	{
+		const int answer = i % answer_size;
+
+		for (int k = 0; k < 5; ++k)
+		{
+			if (uniform_random(0, 1) < 0.8)
+				inputs -> Questions[i][(answer * 3 + k * 7) % input_size] = 1;
+		}
+
+		inputs -> Questions[i][random_below(defaultRandomState(), input_size)] = 1;
+		inputs -> Answers[i][answer] = 1;
+	}
+
+	return inputs;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// GEMM:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+typedef struct
+{
+	TransposeOptions optA, optB;
+	const Number *A, *B;
+	Number *C;
+	int M, N, K;
+} GEMMArgs;
+
+
+static void runGEMM(void *arg)
+{
+	GEMMArgs *args = (GEMMArgs*) arg;
+
+	matrix_multiply(args -> optA, args -> optB, args -> A, args -> B, args -> C, args -> M, args -> N, args -> K);
+}
+
+
+// Sizes of the learning products of Doc9000's network: M x N x K, i.e op(A) is M x K and op(B) is K x N:
+static void benchGEMM(int warmups, int repeats)
+{
+	const TransposeOptions options[4][2] = {{NoTrans, NoTrans}, {NoTrans, Trans}, {Trans, NoTrans}, {Trans, Trans}};
+	const char *options_names[] = {"NN", "NT", "TN", "TT"};
+	const int sizes[][3] = {{1, 256, 389}, {64, 256, 389}, {64, 150, 257}, {389, 256, 64}, {256, 256, 256}};
+
+	for (int s = 0; s < ARRAY_LENGTH(sizes); ++s)
+	{
+		const int M = sizes[s][0], N = sizes[s][1], K = sizes[s][2];
+
+		Number *A = createVector(M * K);
+		Number *B = createVector(K * N);
+		Number *C = createVector(M * N);
+
+		randomFillVector_uniform(A, M * K, 1);
+		randomFillVector_uniform(B, K * N, 1);
+
+		for (int o = 0; o < 4; ++o)
+		{
+			GEMMArgs args = {options[o][0], options[o][1], A, B, C, M, N, K};
+
+			char name[64];
+			snprintf(name, sizeof(name), "%s %dx%dx%d", options_names[o], M, N, K);
+
+			addResult("gemm", name, timeRepeated(runGEMM, &args, warmups, repeats), 2e-9 * M * N * K, "GFLOP/s");
+		}
+
+		freeVector(&A);
+		freeVector(&B);
+		freeVector(&C);
+	}
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Activations:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+typedef struct
+{
+	Activation fun;
+	Number *sum, *output, *grad;
+	int rows, cols;
+} ActivationArgs;
+
+
+static void runActivation(void *arg)
+{
+	ActivationArgs *args = (ActivationArgs*) arg;
+
+	activationBlock(args -> fun, args -> output, args -> cols + 1, args -> sum, args -> rows, args -> cols);
+}
+
+
+static void runDerivative(void *arg)
+{
+	ActivationArgs *args = (ActivationArgs*) arg;
+
+	der_activationMultiply(args -> fun, args -> grad, args -> sum, args -> rows * args -> cols);
+}
+
+
+// A batch of 64 rows of the first hidden layer:
+static void benchActivations(int warmups, int repeats)
+{
+	const int rows = 64, cols = 256;
+
+	Number *sum = createVector(rows * cols);
+	Number *output = createVector(rows * (cols + 1));
+	Number *grad = createVector(rows * cols);
+
+	randomFillVector_uniform(sum, rows * cols, 5);
+	randomFillVector_uniform(grad, rows * cols, 1);
+
+	for (int f = 0; f < getActivationNumber(); ++f)
+	{
+		ActivationArgs args = {f, sum, output, grad, rows, cols};
+
+		char name[64];
+
+		snprintf(name, sizeof(name), "%s", getActivationString(f));
+		addResult("activation", name, timeRepeated(runActivation, &args, warmups, repeats), 1e-6 * rows * cols, "Melem/s");
+
+		if (f == Softmax) // Its derivative is not applied on its own.
+			continue;
+
+		snprintf(name, sizeof(name), "%s derivative", getActivationString(f));
+		addResult("activation", name, timeRepeated(runDerivative, &args, warmups, repeats), 1e-6 * rows * cols, "Melem/s");
+	}
+
+	freeVector(&sum);
+	freeVector(&output);
+	freeVector(&grad);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Optimizers:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+typedef struct
+{
+	int optimizer; // 'Optimizer' value.
+	Number *net, *grad, *M, *V;
+	long len;
+} OptimizerArgs;
+
+
+static void runOptimizer(void *arg)
+{
+	OptimizerArgs *args = (OptimizerArgs*) arg;
+
+	switch (args -> optimizer)
+	{
+		case NO_OPT:
+			sgdStep(args -> net, args -> grad, args -> len, 0.9999, 1e-4);
+			break;
+
+		case MOMENTUM:
+			momentumStep(args -> net, args -> grad, args -> M, args -> len, 0.9999, 1e-4, 0.5);
+			break;
+
+		case RMSprop:
+			rmspropStep(args -> net, args -> grad, args -> V, args -> len, 0.9999, 1e-4, 0.9);
+			break;
+
+		default:
+			adamStep(args -> net, args -> grad, args -> M, args -> V, args -> len, 0.9999, 1e-4, 0.9, 0.999);
+			break;
+	}
+}
+
+
+// A step on the first layer nets of Doc9000's network, with a weight decay. The throughput counts the bytes
+// read and written by the step:
+static void benchOptimizers(int warmups, int repeats)
+{
+	const long len = 389 * 256;
+
+	const char *names[] = {"SGD", "Momentum", "RMSprop", "Adam"};
+	const int arrays_moved[] = {3, 5, 5, 7}; // Read and written arrays.
+
+	Number *net = createVector(len);
+	Number *grad = createVector(len);
+	Number *M = createVector(len);
+	Number *V = createVector(len);
+
+	randomFillVector_uniform(net, len, 1);
+	randomFillVector_uniform(grad, len, 1e-3);
+
+	for (int opt = NO_OPT; opt <= ADAM; ++opt)
+	{
+		OptimizerArgs args = {opt, net, grad, M, V, len};
+
+		addResult("optimizer", names[opt], timeRepeated(runOptimizer, &args, warmups, repeats),
+			1e-9 * arrays_moved[opt] * len * sizeof(Number), "GB/s");
+	}
+
+	freeVector(&net);
+	freeVector(&grad);
+	freeVector(&M);
+	freeVector(&V);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Propagation and learning, with Doc9000's network:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+#define DOC_INPUT_SIZE 388
+#define DOC_ANSWER_SIZE 136
+
+
+static NeuralNetwork* createDocNetwork(int max_batch_size)
+{
+	int NeuronsNumberArray[] = {256, 150, DOC_ANSWER_SIZE};
+	Activation funArray[] = {ReLu, ReLu, Softmax};
+
+	const int layers_number = ARRAYS_COMPARE_LENGTH(NeuronsNumberArray, funArray);
+
+	NeuralNetwork *network = createNetwork(DOC_INPUT_SIZE, layers_number, NeuronsNumberArray, funArray, max_batch_size);
+
+	for (int l = 0; l < layers_number; ++l)
+	{
+		const int netLength = (network -> Layers[l].InputSize + 1) * network -> Layers[l].NeuronsNumber;
+		randomFillVector_gaussian(network -> Layers[l].Net, netLength, 0.05);
+	}
+
+	network -> HasLearned = 1; // Else prediction() warns.
+
+	return network;
+}
+
+
+typedef struct
+{
+	NeuralNetwork *network;
+	QuantizedNetwork *qnet;
+	Inputs *inputs;
+	LearningParameters *params;
+} NetworkArgs;
+
+
+static void runPrediction(void *arg)
+{
+	NetworkArgs *args = (NetworkArgs*) arg;
+
+	prediction(args -> network, args -> inputs);
+}
+
+
+static void runQuantizedPrediction(void *arg)
+{
+	NetworkArgs *args = (NetworkArgs*) arg;
+
+	quantizedPrediction(args -> qnet, args -> inputs);
+}
+
+
+static void runLearning(void *arg)
+{
+	NetworkArgs *args = (NetworkArgs*) arg;
+
+	learn(args -> network, args -> inputs, args -> params);
+}
+
+
+// A single propagation of a batch of each size, by the network and its int8 copy:
+static void benchPropagation(int warmups, int repeats)
+{
+	const int batch_sizes[] = {1, 16, 64, 256};
+
+	for (int s = 0; s < ARRAY_LENGTH(batch_sizes); ++s)
+	{
+		const int batch_size = batch_sizes[s];
+
+		NeuralNetwork *network = createDocNetwork(batch_size);
+		QuantizedNetwork *qnet = quantizeNetwork(network, batch_size);
+		Inputs *inputs = createSymptomInputs(batch_size, DOC_INPUT_SIZE, DOC_ANSWER_SIZE);
+
+		NetworkArgs args = {network, qnet, inputs, NULL};
+
+		char name[64];
+		snprintf(name, sizeof(name), "batch %d", batch_size);
+
+		addResult("propagation", name, timeRepeated(runPrediction, &args, warmups, repeats), batch_size, "samples/s");
+
+		snprintf(name, sizeof(name), "int8 batch %d", batch_size);
+
+		addResult("propagation", name, timeRepeated(runQuantizedPrediction, &args, warmups, repeats), batch_size, "samples/s");
+
+		freeQuantizedNetwork(&qnet);
+		freeInputs(&inputs);
+		freeNetwork(&network);
+	}
+}
+
+
+// One epoch of learningPhase(), on fewer samples:
+static void benchLearning(int warmups, int repeats)
+{
+	const int samples_number = 8192, batch_size = 64;
+
+	NeuralNetwork *network = createDocNetwork(batch_size);
+	Inputs *inputs = createSymptomInputs(samples_number, DOC_INPUT_SIZE, DOC_ANSWER_SIZE);
+
+	LearningParameters *params = initLearningParameters();
+
+	params -> Method = MINI_BATCHES;
+	params -> BatchSize = batch_size;
+	params -> EpochNumber = 1;
+	params -> LearningRate = 0.005;
+	params -> PrintEstimates = 0;
+
+	NetworkArgs args = {network, NULL, inputs, params};
+
+	const int learning_repeats = (repeats + LEARNING_REPEATS_DIVISOR - 1) / LEARNING_REPEATS_DIVISOR;
+	const int learning_warmups = warmups > 0 ? 1 : 0;
+
+	const int saved_stdout = silenceStdout();
+
+	TimingStats stats = timeRepeated(runLearning, &args, learning_warmups, learning_repeats);
+
+	restoreStdout(saved_stdout);
+
+	addResult("learning", "doc network, batch 64", stats, samples_number, "samples/s");
+
+	freeParameters(&params);
+	freeInputs(&inputs);
+	freeNetwork(&network);
+}
@@ -4,6 +4,7 @@
 #include <string.h>
 
 #include "activation.h"
+#include "simd.h"
 
 
 static const Number LRELU_COEFF = 0.01;
@@ -164,20 +165,162 @@ Number der_activation(Activation fun, Number x)
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////
+// Vectorized kernels:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+// Defines a kernel applying 'EXPR' on each vector of a row, with X = src vector and D = dest vector.
+// The last elements are processed through padded buffers, for the results not to depend on the position.
+#define ROW_KERNEL(NAME, EXPR)												\
+static void NAME(Number *dest, const Number *src, int len)					\
+{																			\
+	int i = 0;																\
+																			\
+	for (; i <= len - VEC_SIZE; i += VEC_SIZE)								\
+	{																		\
+		Vec X = vec_load(src + i), D = vec_load(dest + i);					\
+		vec_store(dest + i, EXPR);											\
+	}																		\
+																			\
+	if (i < len)															\
+	{																		\
+		Number src_buffer[VEC_SIZE] = {0}, dest_buffer[VEC_SIZE] = {0};		\
+		memcpy(src_buffer, src + i, (len - i) * sizeof(Number));			\
+		memcpy(dest_buffer, dest + i, (len - i) * sizeof(Number));			\
+																			\
+		Vec X = vec_load(src_buffer), D = vec_load(dest_buffer);			\
+		vec_store(dest_buffer, EXPR);										\
+		memcpy(dest + i, dest_buffer, (len - i) * sizeof(Number));			\
+	}																		\
+}
+
+
+#define ONE vec_set1(1)
+#define ZERO vec_zero()
+
+// tanh(x) = 1 - 2 / (exp(2x) + 1):
+#define VEC_TANH(X) vec_sub(ONE, vec_div(vec_set1(2), vec_add(vec_exp(vec_add(X, X)), ONE)))
+
+#define VEC_SIGMOID(X) vec_div(ONE, vec_add(ONE, vec_exp(vec_sub(ZERO, X))))
+
+
+// Activations:
+
+ROW_KERNEL(row_Id, ((void) D, X))
+ROW_KERNEL(row_Heaviside, ((void) D, vec_select_pos(vec_sub(ZERO, X), ZERO, ONE))) // 1 if x > 0, else 0.
+ROW_KERNEL(row_Sigmoid, ((void) D, VEC_SIGMOID(X)))
+ROW_KERNEL(row_Tanh, ((void) D, VEC_TANH(X)))
+ROW_KERNEL(row_ReLu, ((void) D, vec_max(X, ZERO)))
+ROW_KERNEL(row_LReLu, ((void) D, vec_max(X, vec_mul(vec_set1(LRELU_COEFF), X)))) // Since 0 < LRELU_COEFF < 1.
+ROW_KERNEL(row_ELu, ((void) D, vec_select_pos(X, X, vec_mul(vec_set1(ELU_COEFF), vec_sub(vec_exp(X), ONE)))))
+ROW_KERNEL(row_SELu, ((void) D, vec_select_pos(X, vec_mul(vec_set1(SELU_COEFF_POS), X),
+	vec_mul(vec_set1(SELU_COEFF_NEG), vec_sub(vec_exp(X), ONE)))))
+ROW_KERNEL(row_exp, ((void) D, vec_exp(X)))
+
+
+// Derivatives, multiplied to dest:
+
+// sigmoid'(x) = y * (1 - y), with y = sigmoid(x):
+static inline Vec vec_der_sigmoid(Vec X)
+{
+	const Vec Y = VEC_SIGMOID(X);
+	return vec_mul(Y, vec_sub(ONE, Y));
+}
+
+
+// tanh'(x) = 1 - z^2, with z = tanh(x):
+static inline Vec vec_der_tanh(Vec X)
+{
+	const Vec Z = VEC_TANH(X);
+	return vec_sub(ONE, vec_mul(Z, Z));
+}
+
+
+ROW_KERNEL(der_row_Sigmoid, vec_mul(D, vec_der_sigmoid(X)))
+ROW_KERNEL(der_row_Tanh, vec_mul(D, vec_der_tanh(X)))
+ROW_KERNEL(der_row_ReLu, vec_select_pos(X, D, ZERO))
+ROW_KERNEL(der_row_LReLu, vec_select_pos(X, D, vec_mul(vec_set1(LRELU_COEFF), D)))
+ROW_KERNEL(der_row_ELu, vec_select_pos(X, D, vec_mul(D, vec_mul(vec_set1(ELU_COEFF), vec_exp(X)))))
+ROW_KERNEL(der_row_SELu, vec_mul(D, vec_select_pos(X, vec_set1(SELU_COEFF_POS), vec_mul(vec_set1(SELU_COEFF_NEG), vec_exp(X)))))
+
+
+typedef void (*RowKernel)(Number *dest, const Number *src, int len);
+
+
 void softmax(Number *dest, const Number *src, int len)
 {
+	row_exp(dest, src, len);
+
 	Number sum = 0;
 
 	for (int i = 0; i < len; ++i)
-	{
-		Number x = number_exp(src[i]);
-		sum += x;
-		dest[i] = x;
-	}
-	
+		sum += dest[i];
+
 	// Total sum has been computed, now dividing by it:
+
+	Number inv_sum = 1. / (sum + EPSILON);
+
 	for (int i = 0; i < len; ++i)
-		dest[i] /= (sum + EPSILON);
+		dest[i] *= inv_sum;
+}
+
+
+// Vectorized activation of a 'rows' x 'cols' block: the function is chosen once for the whole block.
+// Rows of 'dest' are 'dest_stride' long (e.g to skip the biases column), those of 'src' are 'cols' long.
+// Softmax is applied on each row.
+void activationBlock(Activation fun, Number *dest, int dest_stride, const Number *src, int rows, int cols)
+{
+	RowKernel kernel;
+
+	switch (fun)
+	{
+		case Id: kernel = row_Id; break;
+		case Heaviside: kernel = row_Heaviside; break;
+		case Sigmoid: kernel = row_Sigmoid; break;
+		case Tanh: kernel = row_Tanh; break;
+		case ReLu: kernel = row_ReLu; break;
+		case LReLu: kernel = row_LReLu; break;
+		case ELu: kernel = row_ELu; break;
+		case SELu: kernel = row_SELu; break;
+		case Softmax: kernel = softmax; break;
+
+		default:
+			printf("\nUnsupported activation for a block: %d\n\n", fun);
+			exit(EXIT_FAILURE);
+	}
+
+	if (dest_stride == cols && fun != Softmax) // Contiguous block.
+	{
+		kernel(dest, src, rows * cols);
+		return;
+	}
+
+	for (int r = 0; r < rows; ++r)
+		kernel(dest + r * dest_stride, src + r * cols, cols);
+}
+
+
+// Vectorized grad[i] *= der_activation(fun, src[i]) for the 'len' elements, without softmax:
+void der_activationMultiply(Activation fun, Number *grad, const Number *src, int len)
+{
+	switch (fun)
+	{
+		case Id:
+		case Heaviside:
+		case Softmax: // Not supported, like der_activation().
+			break;
+
+		case Sigmoid: der_row_Sigmoid(grad, src, len); break;
+		case Tanh: der_row_Tanh(grad, src, len); break;
+		case ReLu: der_row_ReLu(grad, src, len); break;
+		case LReLu: der_row_LReLu(grad, src, len); break;
+		case ELu: der_row_ELu(grad, src, len); break;
+		case SELu: der_row_SELu(grad, src, len); break;
+
+		default:
+			break;
+	}
 }
 
 
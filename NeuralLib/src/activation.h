@@ -49,6 +49,16 @@ Number der_activation(Activation fun, Number x);
 void softmax(Number *dest, const Number *src, int len);
 
 
+// Vectorized activation of a 'rows' x 'cols' block: the function is chosen once for the whole block.
+// Rows of 'dest' are 'dest_stride' long (e.g to skip the biases column), those of 'src' are 'cols' long.
+// Softmax is applied on each row.
+void activationBlock(Activation fun, Number *dest, int dest_stride, const Number *src, int rows, int cols);
+
+
+// Vectorized grad[i] *= der_activation(fun, src[i]) for the 'len' elements, without softmax:
+void der_activationMultiply(Activation fun, Number *grad, const Number *src, int len);
+
+
 // Updating the last layer's GradSum for the softmax activation with quadratic loss:
 void updateGradSumSoftmaxQuadLoss(Number *output_error, const Number *answer, const Number *good_answer, int len);
 
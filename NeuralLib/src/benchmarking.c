@@ -1,5 +1,7 @@
 #include "benchmarking.h"
 
+#include <stdio.h>
+#include <stdlib.h>
 #include <time.h>
 
 
@@ -21,3 +23,72 @@ double get_time(void)
 	return (double) GetTickCount() / 1000.;
 }
 #endif
+
+
+// Monotonic clock, finer than get_time(), for timing short calls. Thread safe.
+double get_monotonic_time(void)
+{
+#ifndef _WIN32
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + (double) ts.tv_nsec / 1000000000.;
+#else
+	return get_time();
+#endif
+}
+
+
+static int compare_doubles(const void *a, const void *b)
+{
+	const double x = *(const double*) a, y = *(const double*) b;
+	return (x > y) - (x < y);
+}
+
+
+// Calls 'fun(arg)' 'warmups' times untimed, then times 'repeats' calls of it with a monotonic clock,
+// and returns the statistics of their durations. 'repeats' must be at least 1:
+TimingStats timeRepeated(void (*fun)(void*), void *arg, int warmups, int repeats)
+{
+	if (repeats < 1)
+	{
+		printf("\nAt least 1 timed repetition is needed.\n\n");
+		exit(EXIT_FAILURE);
+	}
+
+	double *durations = (double*) calloc(repeats, sizeof(double));
+
+	if (durations == NULL)
+	{
+		printf("\nNot enough memory for the timings.\n\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for (int w = 0; w < warmups; ++w)
+		fun(arg);
+
+	double sum = 0;
+
+	for (int r = 0; r < repeats; ++r)
+	{
+		const double start = get_monotonic_time();
+
+		fun(arg);
+
+		durations[r] = get_monotonic_time() - start;
+		sum += durations[r];
+	}
+
+	qsort(durations, repeats, sizeof(double), compare_doubles);
+
+	TimingStats stats;
+
+	stats.Repeats = repeats;
+	stats.Min = durations[0];
+	stats.Median = repeats % 2 == 1 ? durations[repeats / 2] : (durations[repeats / 2 - 1] + durations[repeats / 2]) / 2;
+	stats.P99 = durations[(99 * repeats + 99) / 100 - 1]; // Nearest rank: ceil(0.99 * repeats) - 1.
+	stats.Mean = sum / repeats;
+
+	free(durations);
+
+	return stats;
+}
@@ -6,4 +6,24 @@
 double get_time(void);
 
 
+// Monotonic clock, finer than get_time(), for timing short calls. Thread safe.
+double get_monotonic_time(void);
+
+
+// Statistics of the durations of repeated calls, in seconds:
+typedef struct
+{
+	int Repeats;
+	double Min;
+	double Median;
+	double P99;
+	double Mean;
+} TimingStats;
+
+
+// Calls 'fun(arg)' 'warmups' times untimed, then times 'repeats' calls of it with a monotonic clock,
+// and returns the statistics of their durations. 'repeats' must be at least 1:
+TimingStats timeRepeated(void (*fun)(void*), void *arg, int warmups, int repeats);
+
+
 #endif
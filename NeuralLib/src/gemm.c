@@ -0,0 +1,615 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gemm.h"
+#include "simd.h"
+
+
+// Width of the micro-kernel, in Numbers: two SIMD vectors.
+#define GEMM_NR (2 * VEC_SIZE)
+
+// Rounds 'x' up to a multiple of 'step':
+#define ROUND_UP(x, step) ((((x) + (step) - 1) / (step)) * (step))
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Packing:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+// Element (i, k) of op(A), where A has 'lda' columns as stored in memory:
+#define OP_A(optA, A, lda, i, k) \
+	((optA) == NoTrans ? (A)[(i) * (lda) + (k)] : (A)[(k) * (lda) + (i)])
+
+
+// Packs op(A)[i0 : i0 + mc, p0 : p0 + kc] in panels of 'GEMM_MR' rows, stored k by k. Incomplete panels are zero padded:
+static void packA(TransposeOptions optA, const Number *A, int lda, int i0, int p0, int mc, int kc, Number *buffer)
+{
+	for (int ip = 0; ip < mc; ip += GEMM_MR)
+	{
+		const int mr = MIN(GEMM_MR, mc - ip);
+
+		if (optA == NoTrans)
+		{
+			for (int r = 0; r < mr; ++r)
+			{
+				const Number *row = A + (i0 + ip + r) * lda + p0;
+
+				for (int k = 0; k < kc; ++k)
+					buffer[k * GEMM_MR + r] = row[k];
+			}
+		}
+
+		else // Trans: the panel's rows are contiguous in memory.
+		{
+			for (int k = 0; k < kc; ++k)
+			{
+				const Number *col = A + (p0 + k) * lda + i0 + ip;
+
+				for (int r = 0; r < mr; ++r)
+					buffer[k * GEMM_MR + r] = col[r];
+			}
+		}
+
+		for (int r = mr; r < GEMM_MR; ++r)
+		{
+			for (int k = 0; k < kc; ++k)
+				buffer[k * GEMM_MR + r] = 0;
+		}
+
+		buffer += GEMM_MR * kc;
+	}
+}
+
+
+// Packs op(B)[p0 : p0 + kc, j0 : j0 + nc] in panels of 'GEMM_NR' columns, stored k by k. Incomplete panels are zero padded:
+static void packB(TransposeOptions optB, const Number *B, int ldb, int p0, int j0, int kc, int nc, Number *buffer)
+{
+	for (int jp = 0; jp < nc; jp += GEMM_NR)
+	{
+		const int nr = MIN(GEMM_NR, nc - jp);
+
+		if (optB == NoTrans)
+		{
+			for (int k = 0; k < kc; ++k)
+			{
+				const Number *row = B + (p0 + k) * ldb + j0 + jp;
+				Number *dest = buffer + k * GEMM_NR;
+
+				for (int c = 0; c < nr; ++c)
+					dest[c] = row[c];
+
+				for (int c = nr; c < GEMM_NR; ++c)
+					dest[c] = 0;
+			}
+		}
+
+		else // Trans
+		{
+			for (int c = 0; c < nr; ++c)
+			{
+				const Number *col = B + (j0 + jp + c) * ldb + p0;
+
+				for (int k = 0; k < kc; ++k)
+					buffer[k * GEMM_NR + c] = col[k];
+			}
+
+			for (int c = nr; c < GEMM_NR; ++c)
+			{
+				for (int k = 0; k < kc; ++k)
+					buffer[k * GEMM_NR + c] = 0;
+			}
+		}
+
+		buffer += GEMM_NR * kc;
+	}
+}
+
+
+// Same as packB(), B being stored in the given 16 bits format:
+static void packB_half(TransposeOptions optB, const Half *B, Precision formatB, int ldb, int p0, int j0, int kc, int nc,
+	Number *buffer)
+{
+	Number col_buffer[GEMM_KC];
+
+	for (int jp = 0; jp < nc; jp += GEMM_NR)
+	{
+		const int nr = MIN(GEMM_NR, nc - jp);
+
+		if (optB == NoTrans)
+		{
+			for (int k = 0; k < kc; ++k)
+			{
+				Number *dest = buffer + k * GEMM_NR;
+
+				fromHalf(formatB, dest, B + (p0 + k) * ldb + j0 + jp, nr);
+
+				for (int c = nr; c < GEMM_NR; ++c)
+					dest[c] = 0;
+			}
+		}
+
+		else // Trans
+		{
+			for (int c = 0; c < nr; ++c)
+			{
+				fromHalf(formatB, col_buffer, B + (j0 + jp + c) * ldb + p0, kc);
+
+				for (int k = 0; k < kc; ++k)
+					buffer[k * GEMM_NR + c] = col_buffer[k];
+			}
+
+			for (int c = nr; c < GEMM_NR; ++c)
+			{
+				for (int k = 0; k < kc; ++k)
+					buffer[k * GEMM_NR + c] = 0;
+			}
+		}
+
+		buffer += GEMM_NR * kc;
+	}
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Micro-kernel:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+// Rank 1 update of the two accumulators of row 'i':
+#define KERNEL_ROW(i)										\
+{															\
+	const Vec a_##i = vec_set1(a[i]);						\
+	c_##i##_0 = vec_fma(a_##i, b_0, c_##i##_0);				\
+	c_##i##_1 = vec_fma(a_##i, b_1, c_##i##_1);				\
+}
+
+// dest[i] += accumulators of row 'i':
+#define ADD_ROW(dest, ld, i)														\
+{																					\
+	vec_store(dest + (i) * (ld), vec_add(vec_load(dest + (i) * (ld)), c_##i##_0));					\
+	vec_store(dest + (i) * (ld) + VEC_SIZE, vec_add(vec_load(dest + (i) * (ld) + VEC_SIZE), c_##i##_1));	\
+}
+
+// dest[i] = accumulators of row 'i':
+#define STORE_ROW(dest, ld, i)							\
+{														\
+	vec_store(dest + (i) * (ld), c_##i##_0);			\
+	vec_store(dest + (i) * (ld) + VEC_SIZE, c_##i##_1);	\
+}
+
+
+// C[0 : mr, 0 : nr] += A_panel * B_panel, the panels being packed over 'kc':
+static void micro_kernel(int kc, const Number *restrict a, const Number *restrict b, Number *C, int ldc, int mr, int nr)
+{
+	#if GEMM_MR != 6
+		#error "The micro-kernel is unrolled for GEMM_MR = 6."
+	#endif
+
+	Vec c_0_0 = vec_zero(), c_0_1 = vec_zero();
+	Vec c_1_0 = vec_zero(), c_1_1 = vec_zero();
+	Vec c_2_0 = vec_zero(), c_2_1 = vec_zero();
+	Vec c_3_0 = vec_zero(), c_3_1 = vec_zero();
+	Vec c_4_0 = vec_zero(), c_4_1 = vec_zero();
+	Vec c_5_0 = vec_zero(), c_5_1 = vec_zero();
+
+	for (int k = 0; k < kc; ++k)
+	{
+		const Vec b_0 = vec_load(b);
+		const Vec b_1 = vec_load(b + VEC_SIZE);
+
+		KERNEL_ROW(0)
+		KERNEL_ROW(1)
+		KERNEL_ROW(2)
+		KERNEL_ROW(3)
+		KERNEL_ROW(4)
+		KERNEL_ROW(5)
+
+		a += GEMM_MR;
+		b += GEMM_NR;
+	}
+
+	if (mr == GEMM_MR && nr == GEMM_NR)
+	{
+		ADD_ROW(C, ldc, 0)
+		ADD_ROW(C, ldc, 1)
+		ADD_ROW(C, ldc, 2)
+		ADD_ROW(C, ldc, 3)
+		ADD_ROW(C, ldc, 4)
+		ADD_ROW(C, ldc, 5)
+	}
+
+	else // Edge of C: going through a buffer.
+	{
+		Number buffer[GEMM_MR * GEMM_NR];
+
+		STORE_ROW(buffer, GEMM_NR, 0)
+		STORE_ROW(buffer, GEMM_NR, 1)
+		STORE_ROW(buffer, GEMM_NR, 2)
+		STORE_ROW(buffer, GEMM_NR, 3)
+		STORE_ROW(buffer, GEMM_NR, 4)
+		STORE_ROW(buffer, GEMM_NR, 5)
+
+		for (int i = 0; i < mr; ++i)
+		{
+			for (int j = 0; j < nr; ++j)
+				C[i * ldc + j] += buffer[i * GEMM_NR + j];
+		}
+	}
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Products with few rows (e.g prediction of a single question), where packing isn't worth it:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+// X[0 : len] += alpha * Y[0 : len]
+static inline void vec_axpy(Number *restrict X, const Number *restrict Y, int len, Number alpha)
+{
+	const Vec alpha_vec = vec_set1(alpha);
+
+	int j = 0;
+
+	for (; j + VEC_SIZE <= len; j += VEC_SIZE)
+		vec_store(X + j, vec_fma(alpha_vec, vec_load(Y + j), vec_load(X + j)));
+
+	for (; j < len; ++j)
+		X[j] += alpha * Y[j];
+}
+
+
+// Returns X[0 : len] . Y[0 : len]
+static inline Number vec_dot(const Number *X, const Number *Y, int len)
+{
+	Vec sum_0 = vec_zero(), sum_1 = vec_zero();
+
+	int k = 0;
+
+	for (; k + 2 * VEC_SIZE <= len; k += 2 * VEC_SIZE)
+	{
+		sum_0 = vec_fma(vec_load(X + k), vec_load(Y + k), sum_0);
+		sum_1 = vec_fma(vec_load(X + k + VEC_SIZE), vec_load(Y + k + VEC_SIZE), sum_1);
+	}
+
+	Number lanes[VEC_SIZE];
+	vec_store(lanes, vec_add(sum_0, sum_1));
+
+	Number sum = 0;
+
+	for (int l = 0; l < VEC_SIZE; ++l)
+		sum += lanes[l];
+
+	for (; k < len; ++k)
+		sum += X[k] * Y[k];
+
+	return sum;
+}
+
+
+// C <- op(A) * op(B), C being already reset:
+static void small_matrix_multiply(TransposeOptions optA, TransposeOptions optB, const Number *A, const Number *B, Number *C,
+	int rows_op_A, int cols_op_B, int cols_op_A)
+{
+	const int lda = optA == NoTrans ? cols_op_A : rows_op_A;
+
+	if (optB == NoTrans)
+	{
+		for (int i = 0; i < rows_op_A; ++i)
+		{
+			for (int k = 0; k < cols_op_A; ++k)
+				vec_axpy(C + i * cols_op_B, B + k * cols_op_B, cols_op_B, OP_A(optA, A, lda, i, k));
+		}
+
+		return;
+	}
+
+	// optB == Trans, rows of op(A) are needed contiguous:
+
+	Number *row_buffer = NULL;
+
+	if (optA == Trans && (row_buffer = (Number*) malloc(cols_op_A * sizeof(Number))) == NULL)
+	{
+		printf("\nNot enough memory for a matrix product.\n\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for (int i = 0; i < rows_op_A; ++i)
+	{
+		const Number *row = A + i * cols_op_A;
+
+		if (optA == Trans)
+		{
+			for (int k = 0; k < cols_op_A; ++k)
+				row_buffer[k] = A[k * lda + i];
+
+			row = row_buffer;
+		}
+
+		for (int j = 0; j < cols_op_B; ++j)
+			C[i * cols_op_B + j] = vec_dot(row, B + j * cols_op_A, cols_op_A);
+	}
+
+	free(row_buffer);
+}
+
+
+// Same as small_matrix_multiply(), B being stored in the given 16 bits format. Each row of B is converted once:
+static void small_matrix_multiply_half(TransposeOptions optA, TransposeOptions optB, const Number *A, const Half *B,
+	Precision formatB, Number *C, int rows_op_A, int cols_op_B, int cols_op_A)
+{
+	const int lda = optA == NoTrans ? cols_op_A : rows_op_A;
+	const int ldb = optB == NoTrans ? cols_op_B : cols_op_A;
+
+	Number *row_B = (Number*) malloc(ldb * sizeof(Number));
+	Number *row_A = (Number*) malloc(cols_op_A * sizeof(Number));
+
+	if (row_B == NULL || row_A == NULL)
+	{
+		printf("\nNot enough memory for a matrix product.\n\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (optB == NoTrans)
+	{
+		for (int k = 0; k < cols_op_A; ++k)
+		{
+			fromHalf(formatB, row_B, B + k * ldb, cols_op_B);
+
+			for (int i = 0; i < rows_op_A; ++i)
+				vec_axpy(C + i * cols_op_B, row_B, cols_op_B, OP_A(optA, A, lda, i, k));
+		}
+	}
+
+	else // Trans
+	{
+		for (int j = 0; j < cols_op_B; ++j)
+		{
+			fromHalf(formatB, row_B, B + j * ldb, cols_op_A);
+
+			for (int i = 0; i < rows_op_A; ++i)
+			{
+				const Number *row = A + i * cols_op_A;
+
+				if (optA == Trans)
+				{
+					for (int k = 0; k < cols_op_A; ++k)
+						row_A[k] = A[k * lda + i];
+
+					row = row_A;
+				}
+
+				C[i * cols_op_B + j] = vec_dot(row, row_B, cols_op_A);
+			}
+		}
+	}
+
+	free(row_A);
+	free(row_B);
+}
+
+
+// C <- op(A) * op(B), B being either 'B' or 'B_half' stored in the given 16 bits format:
+static void blockedProduct(TransposeOptions optA, TransposeOptions optB, const Number *A, const Number *B, const Half *B_half,
+	Precision formatB, Number *C, int rows_op_A, int cols_op_B, int cols_op_A)
+{
+	const int M = rows_op_A, N = cols_op_B, K = cols_op_A;
+
+	if (M <= 0 || N <= 0)
+		return;
+
+	memset(C, 0, M * N * sizeof(Number));
+
+	if (K <= 0)
+		return;
+
+	if (M < GEMM_MR)
+	{
+		if (B_half != NULL)
+			small_matrix_multiply_half(optA, optB, A, B_half, formatB, C, M, N, K);
+		else
+			small_matrix_multiply(optA, optB, A, B, C, M, N, K);
+
+		return;
+	}
+
+	const int lda = optA == NoTrans ? K : M;
+	const int ldb = optB == NoTrans ? N : K;
+
+	const int kc_max = MIN(GEMM_KC, K);
+	const int nc_max = MIN(GEMM_NC, ROUND_UP(N, GEMM_NR));
+	const int mc_max = MIN(GEMM_MC, ROUND_UP(M, GEMM_MR));
+
+	Number *packedA = (Number*) malloc(mc_max * kc_max * sizeof(Number));
+	Number *packedB = (Number*) malloc(kc_max * ROUND_UP(nc_max, GEMM_NR) * sizeof(Number));
+
+	if (packedA == NULL || packedB == NULL)
+	{
+		printf("\nNot enough memory for a matrix product.\n\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for (int jc = 0; jc < N; jc += GEMM_NC)
+	{
+		const int nc = MIN(GEMM_NC, N - jc);
+
+		for (int pc = 0; pc < K; pc += GEMM_KC)
+		{
+			const int kc = MIN(GEMM_KC, K - pc);
+
+			if (B_half != NULL)
+				packB_half(optB, B_half, formatB, ldb, pc, jc, kc, nc, packedB);
+			else
+				packB(optB, B, ldb, pc, jc, kc, nc, packedB);
+
+			for (int ic = 0; ic < M; ic += GEMM_MC)
+			{
+				const int mc = MIN(GEMM_MC, M - ic);
+
+				packA(optA, A, lda, ic, pc, mc, kc, packedA);
+
+				for (int jr = 0; jr < nc; jr += GEMM_NR)
+				{
+					const int nr = MIN(GEMM_NR, nc - jr);
+					const Number *panelB = packedB + jr * kc;
+
+					for (int ir = 0; ir < mc; ir += GEMM_MR)
+					{
+						const int mr = MIN(GEMM_MR, mc - ir);
+
+						micro_kernel(kc, packedA + ir * kc, panelB, C + (ic + ir) * N + jc + jr, N, mr, nr);
+					}
+				}
+			}
+		}
+	}
+
+	free(packedA);
+	free(packedB);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Sparse products, whose cost is proportional to the number of non zero elements of A:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+// C[0 : cols_B] <- sum of values[e] * B[indices[e]][0 : cols_B], for e in [start, end). The columns are processed
+// by groups of 4 vectors, kept in registers while the rows of B are accumulated:
+static void sparse_row_product(const int *indices, const Number *values, int start, int end, const Number *B,
+	Number *C, int cols_B)
+{
+	int j = 0;
+
+	for (; j + 8 * VEC_SIZE <= cols_B; j += 8 * VEC_SIZE)
+	{
+		Vec c_0 = vec_zero(), c_1 = vec_zero(), c_2 = vec_zero(), c_3 = vec_zero();
+		Vec c_4 = vec_zero(), c_5 = vec_zero(), c_6 = vec_zero(), c_7 = vec_zero();
+
+		for (int e = start; e < end; ++e)
+		{
+			const Vec v = vec_set1(values[e]);
+			const Number *b = B + (long) indices[e] * cols_B + j;
+
+			c_0 = vec_fma(v, vec_load(b), c_0);
+			c_1 = vec_fma(v, vec_load(b + VEC_SIZE), c_1);
+			c_2 = vec_fma(v, vec_load(b + 2 * VEC_SIZE), c_2);
+			c_3 = vec_fma(v, vec_load(b + 3 * VEC_SIZE), c_3);
+			c_4 = vec_fma(v, vec_load(b + 4 * VEC_SIZE), c_4);
+			c_5 = vec_fma(v, vec_load(b + 5 * VEC_SIZE), c_5);
+			c_6 = vec_fma(v, vec_load(b + 6 * VEC_SIZE), c_6);
+			c_7 = vec_fma(v, vec_load(b + 7 * VEC_SIZE), c_7);
+		}
+
+		vec_store(C + j, c_0);
+		vec_store(C + j + VEC_SIZE, c_1);
+		vec_store(C + j + 2 * VEC_SIZE, c_2);
+		vec_store(C + j + 3 * VEC_SIZE, c_3);
+		vec_store(C + j + 4 * VEC_SIZE, c_4);
+		vec_store(C + j + 5 * VEC_SIZE, c_5);
+		vec_store(C + j + 6 * VEC_SIZE, c_6);
+		vec_store(C + j + 7 * VEC_SIZE, c_7);
+	}
+
+	for (; j + VEC_SIZE <= cols_B; j += VEC_SIZE)
+	{
+		Vec c = vec_zero();
+
+		for (int e = start; e < end; ++e)
+			c = vec_fma(vec_set1(values[e]), vec_load(B + (long) indices[e] * cols_B + j), c);
+
+		vec_store(C + j, c);
+	}
+
+	for (; j < cols_B; ++j)
+	{
+		Number c = 0;
+
+		for (int e = start; e < end; ++e)
+			c += values[e] * B[(long) indices[e] * cols_B + j];
+
+		C[j] = c;
+	}
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Public functions:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+// C <- op(A) * op(B), with the same arguments as naive_matrix_multiply():
+void blocked_matrix_multiply(TransposeOptions optA, TransposeOptions optB, const Number *A, const Number *B, Number *C,
+	int rows_op_A, int cols_op_B, int cols_op_A)
+{
+	blockedProduct(optA, optB, A, B, NULL, FULL_PRECISION, C, rows_op_A, cols_op_B, cols_op_A);
+}
+
+
+// C <- op(A) * op(B), B being stored in the given 16 bits format. It is converted while being packed,
+// which halves the memory read for B, e.g the nets during a mixed precision learning:
+void blocked_matrix_multiply_half(TransposeOptions optA, TransposeOptions optB, const Number *A, const Half *B,
+	Precision formatB, Number *C, int rows_op_A, int cols_op_B, int cols_op_A)
+{
+	blockedProduct(optA, optB, A, NULL, B, formatB, C, rows_op_A, cols_op_B, cols_op_A);
+}
+
+
+// C <- A * B, A being a sparse rows_A x cols_A matrix given by its non zero elements: those of the row i are
+// (indices[e], values[e]) for e in [row_start[i], row_start[i + 1]). B is cols_A x cols_B, C is rows_A x cols_B:
+void sparse_matrix_multiply(const int *row_start, const int *indices, const Number *values, const Number *B, Number *C,
+	int rows_A, int cols_B)
+{
+	for (int i = 0; i < rows_A; ++i)
+		sparse_row_product(indices, values, row_start[i], row_start[i + 1], B, C + (long) i * cols_B, cols_B);
+}
+
+
+// C <- tr(A) * B, A being a sparse rows_A x cols_A matrix given as above. B is rows_A x cols_B, C is cols_A x cols_B.
+// Only the rows of C matching non zero columns of A are accumulated, the others are reset. 'col_start' (cols_A + 1),
+// 'col_rows' and 'col_values' (row_start[rows_A] each) are scratch buffers, for A to be grouped by column:
+void sparse_transposed_multiply(const int *row_start, const int *indices, const Number *values, const Number *B, Number *C,
+	int rows_A, int cols_A, int cols_B, int *col_start, int *col_rows, Number *col_values)
+{
+	// Transposing A, i.e grouping its non zero elements by column, for each row of C to be written once:
+
+	const int nonzero_number = row_start[rows_A];
+
+	memset(col_start, 0, (cols_A + 1) * sizeof(int));
+
+	for (int e = 0; e < nonzero_number; ++e)
+		++col_start[indices[e] + 1];
+
+	for (int k = 0; k < cols_A; ++k)
+		col_start[k + 1] += col_start[k];
+
+	for (int i = 0; i < rows_A; ++i)
+	{
+		for (int e = row_start[i]; e < row_start[i + 1]; ++e)
+		{
+			const int pos = col_start[indices[e]]++;
+
+			col_rows[pos] = i;
+			col_values[pos] = values[e];
+		}
+	}
+
+	// 'col_start' now holds the ends of the columns, i.e the starts of the next ones:
+
+	int start = 0;
+
+	for (int k = 0; k < cols_A; ++k)
+	{
+		sparse_row_product(col_rows, col_values, start, col_start[k], B, C + (long) k * cols_B, cols_B);
+
+		start = col_start[k];
+	}
+}
+
+
+// Returns the name of the instruction set used by the micro-kernel:
+const char* gemm_simdName(void)
+{
+	return SIMD_NAME;
+}
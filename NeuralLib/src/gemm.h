@@ -0,0 +1,51 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+
+#include "settings.h"
+#include "matrix.h"
+#include "half_precision.h"
+
+
+// Built-in matrix product, used when no high performance library is available.
+// Cache-blocked: op(A) and op(B) are packed in panels of 'GEMM_MR' rows / 'GEMM_NR' columns,
+// which are then multiplied by a SIMD micro-kernel (see simd.h for the supported instruction sets).
+// Every 'TransposeOptions' case is handled by the packing routines.
+
+
+// Blocking parameters. 'GEMM_MC' must be a multiple of 'GEMM_MR':
+#define GEMM_MR 6
+#define GEMM_MC 72
+#define GEMM_KC 256
+#define GEMM_NC 4096
+
+
+// C <- op(A) * op(B), with the same arguments as naive_matrix_multiply():
+void blocked_matrix_multiply(TransposeOptions optA, TransposeOptions optB, const Number *A, const Number *B, Number *C,
+	int rows_op_A, int cols_op_B, int cols_op_A);
+
+
+// C <- op(A) * op(B), B being stored in the given 16 bits format. It is converted while being packed,
+// which halves the memory read for B, e.g the nets during a mixed precision learning:
+void blocked_matrix_multiply_half(TransposeOptions optA, TransposeOptions optB, const Number *A, const Half *B,
+	Precision formatB, Number *C, int rows_op_A, int cols_op_B, int cols_op_A);
+
+
+// C <- A * B, A being a sparse rows_A x cols_A matrix given by its non zero elements: those of the row i are
+// (indices[e], values[e]) for e in [row_start[i], row_start[i + 1]). B is cols_A x cols_B, C is rows_A x cols_B:
+void sparse_matrix_multiply(const int *row_start, const int *indices, const Number *values, const Number *B, Number *C,
+	int rows_A, int cols_B);
+
+
+// C <- tr(A) * B, A being a sparse rows_A x cols_A matrix given as above. B is rows_A x cols_B, C is cols_A x cols_B.
+// Only the rows of C matching non zero columns of A are accumulated, the others are reset. 'col_start' (cols_A + 1),
+// 'col_rows' and 'col_values' (row_start[rows_A] each) are scratch buffers, for A to be grouped by column:
+void sparse_transposed_multiply(const int *row_start, const int *indices, const Number *values, const Number *B, Number *C,
+	int rows_A, int cols_A, int cols_B, int *col_start, int *col_rows, Number *col_values);
+
+
+// Returns the name of the instruction set used by the micro-kernel:
+const char* gemm_simdName(void);
+
+
+#endif
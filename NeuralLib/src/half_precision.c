@@ -0,0 +1,344 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "half_precision.h"
+
+
+// Compile time selection of the vectorized conversions, for float Numbers only:
+// AVX-512: 16 values at once, bfloat16 rounding being done by AVX512-BF16 when present, with integer operations otherwise.
+// AVX2 + F16C: 8 values at once.
+#if defined _FLOAT && defined __AVX512F__
+
+	#include <immintrin.h>
+
+	#define HALF_VEC_SIZE 16
+
+	#if defined __AVX512BF16__
+		#define HALF_SIMD_NAME "AVX512-BF16"
+	#else
+		#define HALF_SIMD_NAME "AVX-512"
+	#endif
+
+#elif defined _FLOAT && defined __AVX2__ && defined __F16C__
+
+	#include <immintrin.h>
+
+	#define HALF_VEC_SIZE 8
+	#define HALF_SIMD_NAME "AVX2-F16C"
+
+#else
+
+	#define HALF_VEC_SIZE 0 // Scalar conversions only.
+	#define HALF_SIMD_NAME "none"
+#endif
+
+
+static const char* PrecisionNames[] = {"full precision", "bfloat16", "float16"};
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Prototypes of static functions:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+static inline uint32_t floatBits(float x);
+
+
+static inline float bitsFloat(uint32_t bits);
+
+
+static inline Half floatToBfloat16(float x);
+
+
+static inline float bfloat16ToFloat(Half h);
+
+
+static inline Half floatToFloat16(float x);
+
+
+static inline float float16ToFloat(Half h);
+
+
+#if HALF_VEC_SIZE > 0
+
+// Vectorized conversions of 'HALF_VEC_SIZE' values:
+
+static inline void toBfloat16Vec(Half *dest, const float *src);
+
+
+static inline void fromBfloat16Vec(float *dest, const Half *src);
+
+
+static inline void toFloat16Vec(Half *dest, const float *src);
+
+
+static inline void fromFloat16Vec(float *dest, const Half *src);
+
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Conversions:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+// Get the name of a Precision:
+const char* getPrecisionString(Precision format)
+{
+	if (format < FULL_PRECISION || format > FLOAT16)
+		return "unknown precision";
+
+	return PrecisionNames[format];
+}
+
+
+// Converts 'len' Numbers to the given 16 bits format, rounding to the nearest even:
+void toHalf(Precision format, Half *dest, const Number *src, long len)
+{
+	long i = 0;
+
+	if (format == BFLOAT16)
+	{
+	#if HALF_VEC_SIZE > 0
+		for (; i + HALF_VEC_SIZE <= len; i += HALF_VEC_SIZE)
+			toBfloat16Vec(dest + i, src + i);
+	#endif
+
+		for (; i < len; ++i)
+			dest[i] = floatToBfloat16(src[i]);
+	}
+
+	else if (format == FLOAT16)
+	{
+	#if HALF_VEC_SIZE > 0
+		for (; i + HALF_VEC_SIZE <= len; i += HALF_VEC_SIZE)
+			toFloat16Vec(dest + i, src + i);
+	#endif
+
+		for (; i < len; ++i)
+			dest[i] = floatToFloat16(src[i]);
+	}
+
+	else
+	{
+		printf("\nCannot convert to %s.\n\n", getPrecisionString(format));
+		exit(EXIT_FAILURE);
+	}
+}
+
+
+// Converts 'len' values of the given 16 bits format to Numbers, exactly:
+void fromHalf(Precision format, Number *dest, const Half *src, long len)
+{
+	long i = 0;
+
+	if (format == BFLOAT16)
+	{
+	#if HALF_VEC_SIZE > 0
+		for (; i + HALF_VEC_SIZE <= len; i += HALF_VEC_SIZE)
+			fromBfloat16Vec(dest + i, src + i);
+	#endif
+
+		for (; i < len; ++i)
+			dest[i] = bfloat16ToFloat(src[i]);
+	}
+
+	else if (format == FLOAT16)
+	{
+	#if HALF_VEC_SIZE > 0
+		for (; i + HALF_VEC_SIZE <= len; i += HALF_VEC_SIZE)
+			fromFloat16Vec(dest + i, src + i);
+	#endif
+
+		for (; i < len; ++i)
+			dest[i] = float16ToFloat(src[i]);
+	}
+
+	else
+	{
+		printf("\nCannot convert from %s.\n\n", getPrecisionString(format));
+		exit(EXIT_FAILURE);
+	}
+}
+
+
+// Returns the name of the instruction set used by the conversions:
+const char* half_simdName(void)
+{
+	return HALF_SIMD_NAME;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Static functions:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+static inline uint32_t floatBits(float x)
+{
+	uint32_t bits;
+	memcpy(&bits, &x, sizeof(float));
+	return bits;
+}
+
+
+static inline float bitsFloat(uint32_t bits)
+{
+	float x;
+	memcpy(&x, &bits, sizeof(float));
+	return x;
+}
+
+
+static inline Half floatToBfloat16(float x)
+{
+	uint32_t bits = floatBits(x);
+
+	if (isnan(x))
+		return (bits >> 16) | 0x40; // Keeping a quiet NaN.
+
+	bits += 0x7FFF + ((bits >> 16) & 1); // Rounding to the nearest even.
+
+	return bits >> 16;
+}
+
+
+static inline float bfloat16ToFloat(Half h)
+{
+	return bitsFloat((uint32_t) h << 16);
+}
+
+
+static inline Half floatToFloat16(float x)
+{
+	const uint32_t bits = floatBits(x);
+	const uint32_t sign = (bits >> 16) & 0x8000, abs_bits = bits & 0x7FFFFFFF;
+
+	if (abs_bits >= 0x7F800000) // Infinity or NaN.
+		return sign | 0x7C00 | (abs_bits > 0x7F800000 ? 0x200 : 0);
+
+	if (abs_bits >= 0x477FF000) // Rounded to infinity, i.e >= 65520.
+		return sign | 0x7C00;
+
+	if (abs_bits < 0x38800000) // Subnormal or 0, i.e < 2^-14: multiples of 2^-24.
+		return sign | (Half) lrintf(bitsFloat(abs_bits) * 16777216.f);
+
+	// Normal: exponent rebiased from 127 to 15, mantissa rounded from 23 to 10 bits, to the nearest even:
+
+	uint32_t rebiased = abs_bits - 0x38000000;
+
+	rebiased += 0x0FFF + ((rebiased >> 13) & 1);
+
+	return sign | (rebiased >> 13);
+}
+
+
+static inline float float16ToFloat(Half h)
+{
+	const uint32_t sign = (uint32_t) (h & 0x8000) << 16, exponent = (h >> 10) & 0x1F, mantissa = h & 0x3FF;
+
+	if (exponent == 0) // Subnormal or 0.
+		return bitsFloat(sign | floatBits(mantissa * (1.f / 16777216.f)));
+
+	if (exponent == 31) // Infinity or NaN.
+		return bitsFloat(sign | 0x7F800000 | (mantissa << 13));
+
+	return bitsFloat(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+
+#if HALF_VEC_SIZE == 16
+
+
+static inline void toBfloat16Vec(Half *dest, const float *src)
+{
+	const __m512 X = _mm512_loadu_ps(src);
+
+#if defined __AVX512BF16__
+
+	_mm256_storeu_si256((__m256i*) dest, (__m256i) _mm512_cvtneps_pbh(X));
+
+#else
+
+	const __m512i bits = _mm512_castps_si512(X);
+	const __m512i lsb = _mm512_and_si512(_mm512_srli_epi32(bits, 16), _mm512_set1_epi32(1));
+
+	__m512i rounded = _mm512_srli_epi32(_mm512_add_epi32(bits, _mm512_add_epi32(lsb, _mm512_set1_epi32(0x7FFF))), 16);
+
+	const __mmask16 nan_mask = _mm512_cmp_ps_mask(X, X, _CMP_UNORD_Q);
+
+	rounded = _mm512_mask_or_epi32(rounded, nan_mask, _mm512_srli_epi32(bits, 16), _mm512_set1_epi32(0x40));
+
+	_mm256_storeu_si256((__m256i*) dest, _mm512_cvtepi32_epi16(rounded));
+#endif
+}
+
+
+static inline void fromBfloat16Vec(float *dest, const Half *src)
+{
+	const __m512i bits = _mm512_slli_epi32(_mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*) src)), 16);
+
+	_mm512_storeu_ps(dest, _mm512_castsi512_ps(bits));
+}
+
+
+static inline void toFloat16Vec(Half *dest, const float *src)
+{
+	_mm256_storeu_si256((__m256i*) dest, _mm512_cvtps_ph(_mm512_loadu_ps(src), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+}
+
+
+static inline void fromFloat16Vec(float *dest, const Half *src)
+{
+	_mm512_storeu_ps(dest, _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i*) src)));
+}
+
+
+#elif HALF_VEC_SIZE == 8
+
+
+static inline void toBfloat16Vec(Half *dest, const float *src)
+{
+	const __m256 X = _mm256_loadu_ps(src);
+
+	const __m256i bits = _mm256_castps_si256(X);
+	const __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+
+	__m256i rounded = _mm256_srli_epi32(_mm256_add_epi32(bits, _mm256_add_epi32(lsb, _mm256_set1_epi32(0x7FFF))), 16);
+
+	const __m256i nan_mask = _mm256_castps_si256(_mm256_cmp_ps(X, X, _CMP_UNORD_Q));
+	const __m256i nan_value = _mm256_or_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(0x40));
+
+	rounded = _mm256_blendv_epi8(rounded, nan_value, nan_mask);
+
+	// Packing the 8 int32 (all < 2^16) into 8 uint16:
+
+	const __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(rounded), _mm256_extracti128_si256(rounded, 1));
+
+	_mm_storeu_si128((__m128i*) dest, packed);
+}
+
+
+static inline void fromBfloat16Vec(float *dest, const Half *src)
+{
+	const __m256i bits = _mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) src)), 16);
+
+	_mm256_storeu_ps(dest, _mm256_castsi256_ps(bits));
+}
+
+
+static inline void toFloat16Vec(Half *dest, const float *src)
+{
+	_mm_storeu_si128((__m128i*) dest, _mm256_cvtps_ph(_mm256_loadu_ps(src), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+}
+
+
+static inline void fromFloat16Vec(float *dest, const Half *src)
+{
+	_mm256_storeu_ps(dest, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*) src)));
+}
+
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef HALF_PRECISION_H
+#define HALF_PRECISION_H
+
+
+#include <stdint.h>
+
+#include "settings.h"
+
+
+// 16 bits floating point formats, used for storing copies of the nets during a mixed precision learning:
+// BFLOAT16 -> 8 bits exponent, 7 bits mantissa: same range as float, less precision.
+// FLOAT16 -> 5 bits exponent, 10 bits mantissa (IEEE 754 half): more precision, range limited to 65504.
+typedef enum {FULL_PRECISION, BFLOAT16, FLOAT16} Precision;
+
+
+typedef uint16_t Half;
+
+
+// Get the name of a Precision:
+const char* getPrecisionString(Precision format);
+
+
+// Converts 'len' Numbers to the given 16 bits format, rounding to the nearest even:
+void toHalf(Precision format, Half *dest, const Number *src, long len);
+
+
+// Converts 'len' values of the given 16 bits format to Numbers, exactly:
+void fromHalf(Precision format, Number *dest, const Half *src, long len);
+
+
+// Returns the name of the instruction set used by the conversions:
+const char* half_simdName(void);
+
+
+#endif
@@ -10,6 +10,9 @@
 
 // matrix_multiply(optA, optB, A, B, C, rows_op_A, cols_op_B, cols_op_A): C <- op(A) * op(B)
 
+// matrix_multiply_half(optA, optB, A, B, formatB, C, rows_op_A, cols_op_B, cols_op_A): same, B being stored
+// in a 16 bits format. The built-in product is used in both cases, converting B while packing it.
+
 
 #ifndef HIGH_PERF_H
 #define HIGH_PERF_H
@@ -22,6 +25,7 @@
 
 
 #include "settings.h" // For 'Number' definition.
+#include "gemm.h"
 
 
 #if defined CBLAS
@@ -106,9 +110,13 @@
 	}
 
 
-#else // Naive implementations:
+	#define matrix_multiply_half(optA, optB, A, B, formatB, C, rows_op_A, cols_op_B, cols_op_A) \
+		blocked_matrix_multiply_half(optA, optB, A, B, formatB, C, rows_op_A, cols_op_B, cols_op_A)
+
 
-	#pragma message "No high performance library is being used, expect slow learning."
+#else // Built-in implementations:
+
+	#pragma message "No high performance library is being used, using the built-in blocked matrix product."
 
 	#define copy(dest, src, len) \
 		copyVector(dest, src, len)
@@ -120,7 +128,10 @@
 		naive_addScal(X, Y, len, alpha)
 
 	#define matrix_multiply(optA, optB, A, B, C, rows_op_A, cols_op_B, cols_op_A) \
-		naive_matrix_multiply(optA, optB, A, B, C, rows_op_A, cols_op_B, cols_op_A)
+		blocked_matrix_multiply(optA, optB, A, B, C, rows_op_A, cols_op_B, cols_op_A)
+
+	#define matrix_multiply_half(optA, optB, A, B, formatB, C, rows_op_A, cols_op_B, cols_op_A) \
+		blocked_matrix_multiply_half(optA, optB, A, B, formatB, C, rows_op_A, cols_op_B, cols_op_A)
 #endif
 
 
@@ -0,0 +1,393 @@
+#define _XOPEN_SOURCE 500 // for pread
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// May be Unix dependant. Used for reading the inputs files by chunks:
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "input_stream.h"
+#include "saving.h"
+#include "random.h"
+
+
+struct InputStream
+{
+	int InputNumber;
+	int QuestionsSize;
+	int AnswersSize;
+	int ChunkSize;
+	int ChunkNumber;
+
+	int questions_fd;
+	int answers_fd;
+
+	Inputs *buffers[2];		// The chunk at the position p of a pass is read in buffers[p % 2].
+	int *chunk_order;		// size: ChunkNumber, chunks read during the current pass.
+	int next_position;		// Position in 'chunk_order' of the next chunk to be returned.
+	int shuffle;
+
+	// Reading thread:
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	int requested;			// Position being read, or -1 if the thread is idle.
+	int ready;				// Last position read, or -1.
+	int failed;
+	int stop;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Prototypes of static functions:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+// Returns 1 if the given file holds exactly 'rows' x 'cols' Numbers, 0 otherwise:
+static int checkFileSize(int fd, int rows, int cols);
+
+
+// Asks the reading thread to read the chunk at the given position of the pass. The thread must be idle:
+static void requestChunk(InputStream *stream, int position);
+
+
+// Loop of the reading thread, waiting for chunks to read:
+static void* readingLoop(void *arg);
+
+
+// Reads the given chunk in the given buffer. Returns 1 on success, 0 otherwise:
+static int readChunk(InputStream *stream, int chunk, Inputs *buffer);
+
+
+// Reads exactly 'len' bytes at the given offset. Returns 1 on success, 0 otherwise:
+static int readFully(int fd, void *dest, size_t len, off_t offset);
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Input stream:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+// Opens the inputs saved in the given folder, to be read by chunks of 'ChunkSize' rows. Returns NULL on failure.
+InputStream* openInputStream(const char *foldername, int ChunkSize)
+{
+	int input_number, questions_size, answers_size;
+
+	loadInputsInfos(foldername, &input_number, &questions_size, &answers_size);
+
+	if (input_number <= 0 || answers_size <= 0)
+	{
+		printf("\nNothing to stream from '%s'.\n\n", foldername);
+		return NULL;
+	}
+
+	char questions_filename[MAX_PATH_LENGTH], answers_filename[MAX_PATH_LENGTH];
+
+	sprintf(questions_filename, "%s/questions.bin", foldername);
+	sprintf(answers_filename, "%s/answers.bin", foldername);
+
+	int questions_fd = open(questions_filename, O_RDONLY);
+	int answers_fd = open(answers_filename, O_RDONLY);
+
+	if (questions_fd == -1 || answers_fd == -1 || !checkFileSize(questions_fd, input_number, questions_size) ||
+		!checkFileSize(answers_fd, input_number, answers_size))
+	{
+		printf("\nCannot stream the inputs from '%s': missing or truncated files.\n\n", foldername);
+
+		if (questions_fd != -1)
+			close(questions_fd);
+
+		if (answers_fd != -1)
+			close(answers_fd);
+
+		return NULL;
+	}
+
+	InputStream *stream = (InputStream*) calloc(1, sizeof(InputStream));
+
+	stream -> InputNumber = input_number;
+	stream -> QuestionsSize = questions_size;
+	stream -> AnswersSize = answers_size;
+	stream -> ChunkSize = MIN(MAX(ChunkSize, 1), input_number);
+	stream -> ChunkNumber = (input_number + stream -> ChunkSize - 1) / stream -> ChunkSize;
+
+	stream -> questions_fd = questions_fd;
+	stream -> answers_fd = answers_fd;
+
+	for (int i = 0; i < 2; ++i)
+		stream -> buffers[i] = createContiguousInputs(stream -> ChunkSize, questions_size, answers_size);
+
+	stream -> chunk_order = (int*) calloc(stream -> ChunkNumber, sizeof(int));
+
+	for (int c = 0; c < stream -> ChunkNumber; ++c)
+		stream -> chunk_order[c] = c;
+
+	stream -> next_position = stream -> ChunkNumber; // No pass started.
+	stream -> requested = -1;
+	stream -> ready = -1;
+
+	pthread_mutex_init(&(stream -> mutex), NULL);
+	pthread_cond_init(&(stream -> cond), NULL);
+
+	if (pthread_create(&(stream -> thread), NULL, readingLoop, stream) != 0)
+	{
+		printf("\nCould not create the inputs reading thread.\n\n");
+		exit(EXIT_FAILURE);
+	}
+
+	return stream;
+}
+
+
+// Stops the reading thread, frees the given InputStream passed by address, and sets it to NULL.
+void closeInputStream(InputStream **stream)
+{
+	if (stream == NULL || *stream == NULL)
+		return;
+
+	pthread_mutex_lock(&((*stream) -> mutex));
+
+	(*stream) -> stop = 1;
+
+	pthread_cond_broadcast(&((*stream) -> cond));
+	pthread_mutex_unlock(&((*stream) -> mutex));
+
+	pthread_join((*stream) -> thread, NULL);
+
+	pthread_mutex_destroy(&((*stream) -> mutex));
+	pthread_cond_destroy(&((*stream) -> cond));
+
+	close((*stream) -> questions_fd);
+	close((*stream) -> answers_fd);
+
+	for (int i = 0; i < 2; ++i)
+		freeInputs((*stream) -> buffers + i);
+
+	free((*stream) -> chunk_order);
+	free(*stream);
+	*stream = NULL;
+}
+
+
+int inputStream_inputNumber(const InputStream *stream)
+{
+	return stream -> InputNumber;
+}
+
+
+int inputStream_questionsSize(const InputStream *stream)
+{
+	return stream -> QuestionsSize;
+}
+
+
+int inputStream_answersSize(const InputStream *stream)
+{
+	return stream -> AnswersSize;
+}
+
+
+int inputStream_chunkSize(const InputStream *stream)
+{
+	return stream -> ChunkSize;
+}
+
+
+// Starts a new pass over the inputs. If 'shuffle' is non 0, the chunks are read in a random order,
+// and the rows of each chunk are shuffled: this is a shuffling within a window of 'ChunkSize' rows.
+void rewindInputStream(InputStream *stream, int shuffle)
+{
+	if (stream == NULL)
+		return;
+
+	pthread_mutex_lock(&(stream -> mutex));
+
+	while (stream -> requested != -1) // Waiting for a read of the previous pass, if any.
+		pthread_cond_wait(&(stream -> cond), &(stream -> mutex));
+
+	stream -> ready = -1;
+
+	pthread_mutex_unlock(&(stream -> mutex));
+
+	if (shuffle)
+	{
+		RandomState *state = defaultRandomState();
+
+		for (int i = stream -> ChunkNumber - 1; i >= 1; --i)
+		{
+			int j = random_below(state, i + 1);
+
+			int temp = stream -> chunk_order[i];
+			stream -> chunk_order[i] = stream -> chunk_order[j];
+			stream -> chunk_order[j] = temp;
+		}
+	}
+
+	stream -> next_position = 0;
+	stream -> shuffle = shuffle;
+
+	requestChunk(stream, 0);
+}
+
+
+// Returns the next chunk of the current pass, as contiguous inputs, or NULL at the end of the pass.
+// The returned chunk is valid until the next call, while the following chunk is being read.
+Inputs* nextInputChunk(InputStream *stream)
+{
+	if (stream == NULL || stream -> next_position >= stream -> ChunkNumber)
+		return NULL;
+
+	const int position = stream -> next_position;
+
+	pthread_mutex_lock(&(stream -> mutex));
+
+	while (stream -> ready != position)
+		pthread_cond_wait(&(stream -> cond), &(stream -> mutex));
+
+	const int failed = stream -> failed;
+
+	pthread_mutex_unlock(&(stream -> mutex));
+
+	if (failed)
+	{
+		printf("\nFailed to read a chunk of the streamed inputs.\n\n");
+		exit(EXIT_FAILURE);
+	}
+
+	// The previous chunk buffer is not used anymore, the next chunk is read into it while this one is learned:
+
+	if (position + 1 < stream -> ChunkNumber)
+		requestChunk(stream, position + 1);
+
+	++(stream -> next_position);
+
+	Inputs *chunk = stream -> buffers[position % 2];
+
+	if (stream -> shuffle)
+		shuffleInputs(chunk);
+
+	return chunk;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Static functions:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+// Returns 1 if the given file holds exactly 'rows' x 'cols' Numbers, 0 otherwise:
+static int checkFileSize(int fd, int rows, int cols)
+{
+	struct stat file_stat;
+
+	return fstat(fd, &file_stat) == 0 && file_stat.st_size == (off_t) sizeof(Number) * rows * cols;
+}
+
+
+// Asks the reading thread to read the chunk at the given position of the pass. The thread must be idle:
+static void requestChunk(InputStream *stream, int position)
+{
+	pthread_mutex_lock(&(stream -> mutex));
+
+	stream -> requested = position;
+
+	pthread_cond_broadcast(&(stream -> cond));
+	pthread_mutex_unlock(&(stream -> mutex));
+}
+
+
+// Loop of the reading thread, waiting for chunks to read:
+static void* readingLoop(void *arg)
+{
+	InputStream *stream = (InputStream*) arg;
+
+	while (1)
+	{
+		pthread_mutex_lock(&(stream -> mutex));
+
+		while (stream -> requested == -1 && !stream -> stop)
+			pthread_cond_wait(&(stream -> cond), &(stream -> mutex));
+
+		if (stream -> stop)
+		{
+			pthread_mutex_unlock(&(stream -> mutex));
+			return NULL;
+		}
+
+		const int position = stream -> requested;
+
+		pthread_mutex_unlock(&(stream -> mutex));
+
+		int success = readChunk(stream, stream -> chunk_order[position], stream -> buffers[position % 2]);
+
+		pthread_mutex_lock(&(stream -> mutex));
+
+		stream -> failed |= !success;
+		stream -> ready = position;
+		stream -> requested = -1;
+
+		pthread_cond_broadcast(&(stream -> cond));
+		pthread_mutex_unlock(&(stream -> mutex));
+	}
+}
+
+
+// Reads the given chunk in the given buffer. Returns 1 on success, 0 otherwise:
+static int readChunk(InputStream *stream, int chunk, Inputs *buffer)
+{
+	const int first_row = chunk * stream -> ChunkSize;
+	const int rows = MIN(stream -> ChunkSize, stream -> InputNumber - first_row);
+	const int questions_size = stream -> QuestionsSize, stride = questions_size + 1;
+
+	*(int*) &(buffer -> InputNumber) = rows;
+
+	// The questions are read packed, then spread from the last row to the first one, to make room for the bias column:
+
+	if (!readFully(stream -> questions_fd, buffer -> QuestionsData, sizeof(Number) * rows * questions_size,
+		(off_t) sizeof(Number) * first_row * questions_size))
+		return 0;
+
+	for (int i = rows - 1; i >= 0; --i)
+	{
+		Number *row = buffer -> QuestionsData + (long) i * stride;
+
+		memmove(row, buffer -> QuestionsData + (long) i * questions_size, sizeof(Number) * questions_size);
+		row[questions_size] = 1;
+
+		buffer -> Questions[i] = row; // The rows may have been shuffled during the previous use of this buffer.
+	}
+
+	if (!readFully(stream -> answers_fd, buffer -> AnswersData, sizeof(Number) * rows * stream -> AnswersSize,
+		(off_t) sizeof(Number) * first_row * stream -> AnswersSize))
+		return 0;
+
+	for (int i = 0; i < rows; ++i)
+		buffer -> Answers[i] = buffer -> AnswersData + (long) i * stream -> AnswersSize;
+
+	return 1;
+}
+
+
+// Reads exactly 'len' bytes at the given offset. Returns 1 on success, 0 otherwise:
+static int readFully(int fd, void *dest, size_t len, off_t offset)
+{
+	char *buffer = (char*) dest;
+
+	while (len > 0)
+	{
+		ssize_t bytes_read = pread(fd, buffer, len, offset);
+
+		if (bytes_read <= 0)
+			return 0;
+
+		buffer += bytes_read;
+		offset += bytes_read;
+		len -= bytes_read;
+	}
+
+	return 1;
+}
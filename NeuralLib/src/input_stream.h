@@ -0,0 +1,44 @@
+#ifndef INPUT_STREAM_H
+#define INPUT_STREAM_H
+
+
+#include "settings.h"
+#include "inputs.h"
+
+
+// Inputs saved by saveInputs(), read by chunks of 'ChunkSize' rows instead of being loaded at once.
+// Two chunks are kept in memory: while one is being learned, the next one is read by a background thread.
+typedef struct InputStream InputStream;
+
+
+// Opens the inputs saved in the given folder, to be read by chunks of 'ChunkSize' rows. Returns NULL on failure.
+InputStream* openInputStream(const char *foldername, int ChunkSize);
+
+
+// Stops the reading thread, frees the given InputStream passed by address, and sets it to NULL.
+void closeInputStream(InputStream **stream);
+
+
+int inputStream_inputNumber(const InputStream *stream);
+
+
+int inputStream_questionsSize(const InputStream *stream);
+
+
+int inputStream_answersSize(const InputStream *stream);
+
+
+int inputStream_chunkSize(const InputStream *stream);
+
+
+// Starts a new pass over the inputs. If 'shuffle' is non 0, the chunks are read in a random order,
+// and the rows of each chunk are shuffled: this is a shuffling within a window of 'ChunkSize' rows.
+void rewindInputStream(InputStream *stream, int shuffle);
+
+
+// Returns the next chunk of the current pass, as contiguous inputs, or NULL at the end of the pass.
+// The returned chunk is valid until the next call, while the following chunk is being read.
+Inputs* nextInputChunk(InputStream *stream);
+
+
+#endif
@@ -6,6 +6,7 @@
 #include "inputs.h"
 #include "matrix.h"
 #include "saving.h"
+#include "random.h"
 
 
 Inputs* createInputs(int InputNumber, int QuestionsSize, int AnswersSize, Number** Questions, Number** Answers)
@@ -22,15 +23,89 @@ Inputs* createInputs(int InputNumber, int QuestionsSize, int AnswersSize, Number
 }
 
 
+// Creates inputs whose questions and answers are each stored in a single block, initialized to 0.
+// Answers are only allocated if AnswersSize > 0. The rows can still be shuffled, those inputs being then gathered by batch.
+Inputs* createContiguousInputs(int InputNumber, int QuestionsSize, int AnswersSize)
+{
+	Inputs *inputs = createInputs(InputNumber, QuestionsSize, AnswersSize, NULL, NULL);
+
+	const int stride = QuestionsSize + 1; // Last column: 1, used for the biases.
+
+	inputs -> QuestionsData = createVector((long) InputNumber * stride);
+	inputs -> Questions = (Number**) calloc(InputNumber, sizeof(Number*));
+
+	if (inputs -> QuestionsData == NULL || inputs -> Questions == NULL)
+	{
+		printf("\nImpossible to allocate enough memory for contiguous inputs.\n\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for (int i = 0; i < InputNumber; ++i)
+	{
+		inputs -> Questions[i] = inputs -> QuestionsData + (long) i * stride;
+		inputs -> Questions[i][QuestionsSize] = 1;
+	}
+
+	if (AnswersSize > 0)
+	{
+		inputs -> AnswersData = createVector((long) InputNumber * AnswersSize);
+		inputs -> Answers = (Number**) calloc(InputNumber, sizeof(Number*));
+
+		if (inputs -> AnswersData == NULL || inputs -> Answers == NULL)
+		{
+			printf("\nImpossible to allocate enough memory for contiguous inputs.\n\n");
+			exit(EXIT_FAILURE);
+		}
+
+		for (int i = 0; i < InputNumber; ++i)
+			inputs -> Answers[i] = inputs -> AnswersData + (long) i * AnswersSize;
+	}
+
+	return inputs;
+}
+
+
+// Returns 1 if the questions rows [batch_index, batch_index + batch_size[ follow each other in the contiguous storage,
+// and can thus be used in place as a strided matrix of leading dimension QuestionsSize + 1. Returns 0 otherwise.
+int contiguousBatch(const Inputs *inputs, int batch_index, int batch_size)
+{
+	if (inputs == NULL || inputs -> QuestionsData == NULL)
+		return 0;
+
+	const int stride = inputs -> QuestionsSize + 1;
+
+	Number **batch_questions = inputs -> Questions + batch_index;
+
+	for (int b = 1; b < batch_size; ++b)
+	{
+		if (batch_questions[b] != batch_questions[0] + (long) b * stride)
+			return 0;
+	}
+
+	return 1;
+}
+
+
 // Frees the given Inputs passed by address, and sets it to NULL.
 void freeInputs(Inputs **inputs)
 {
 	if (inputs == NULL || *inputs == NULL)
 		return;
 
-	freeMatrix(&((*inputs) -> Questions), (*inputs) -> InputNumber);
+	if ((*inputs) -> QuestionsData != NULL)
+	{
+		free((*inputs) -> QuestionsData);
+		free((*inputs) -> Questions);
+	}
+	else
+		freeMatrix(&((*inputs) -> Questions), (*inputs) -> InputNumber);
 
-	if ((*inputs) -> Answers != NULL)
+	if ((*inputs) -> AnswersData != NULL)
+	{
+		free((*inputs) -> AnswersData);
+		free((*inputs) -> Answers);
+	}
+	else if ((*inputs) -> Answers != NULL) // Answers may have been allocated row by row by prediction().
 		freeMatrix(&((*inputs) -> Answers), (*inputs) -> InputNumber);
 
 	free(*inputs);
@@ -118,7 +193,8 @@ int saveInputs(const Inputs *inputs, const char *foldername)
 }
 
 
-Inputs* loadInputs(const char *foldername)
+// Reads the sizes of the inputs saved in the given folder by saveInputs(). Exits on failure.
+void loadInputsInfos(const char *foldername, int *input_number, int *questions_size, int *answers_size)
 {
 	if (foldername == NULL)
 	{
@@ -140,7 +216,7 @@ Inputs* loadInputs(const char *foldername)
 
 	skip(infos_file, "Inputs.\nSize of Number: ");
 
-	int size_of_number, input_number, questions_size, answers_size;
+	int size_of_number;
 
 	if (fscanf(infos_file, "%d", &size_of_number) != 1 || size_of_number != sizeof(Number))
 	{
@@ -150,24 +226,30 @@ Inputs* loadInputs(const char *foldername)
 
 	skip(infos_file, " bytes\nInput number: ");
 
-	if (fscanf(infos_file, "%d", &input_number) != 1)
+	if (fscanf(infos_file, "%d", input_number) != 1)
 		exitFileError(infos_file, "Input number couldn't be retrieved from", infos_filename);
 
 	skip(infos_file, "\nQuestions size: ");
 
-	if (fscanf(infos_file, "%d", &questions_size) != 1)
+	if (fscanf(infos_file, "%d", questions_size) != 1)
 		exitFileError(infos_file, "Questions size couldn't be retrieved from", infos_filename);
 
 	skip(infos_file, "\nAnswers size: ");
 
-	if (fscanf(infos_file, "%d", &answers_size) != 1)
+	if (fscanf(infos_file, "%d", answers_size) != 1)
 		exitFileError(infos_file, "Answers size couldn't be retrieved from", infos_filename);
 
 	fclose(infos_file);
+}
 
-	Number **questions = createMatrix(input_number, questions_size);
 
-	Inputs *inputs = createInputs(input_number, questions_size, answers_size, questions, NULL);
+Inputs* loadInputs(const char *foldername)
+{
+	int input_number, questions_size, answers_size;
+
+	loadInputsInfos(foldername, &input_number, &questions_size, &answers_size);
+
+	Inputs *inputs = createContiguousInputs(input_number, questions_size, answers_size);
 
 	// Loading those inputs' questions:
 
@@ -183,8 +265,6 @@ Inputs* loadInputs(const char *foldername)
 		char answers_filename[MAX_PATH_LENGTH];
 		sprintf(answers_filename, "%s/answers.bin", foldername);
 
-		inputs -> Answers = createMatrix(input_number, answers_size);
-
 		load_toMatrix(inputs -> Answers, input_number, answers_size, answers_filename);
 	}
 
@@ -277,14 +357,13 @@ void shuffleInputs(Inputs *inputs)
 	Number **Answers = inputs -> Answers;
 	Number *temp;
 
-	if (len - 1 > RAND_MAX)
-		printf("\nNumber of inputs is greater than RAND_MAX!\n\n");
+	RandomState *state = defaultRandomState();
 
 	// N.B: questions and answers receive the same shuffling!
 
 	for (int i = len - 1; i >= 1; --i)
 	{
-		int j = rand() % (i + 1); // 0 ≤ j ≤ i. Biased, but negligeable.
+		int j = random_below(state, i + 1); // 0 ≤ j ≤ i.
 
 		temp = Questions[i];
 
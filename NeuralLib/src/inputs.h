@@ -6,6 +6,8 @@
 
 
 // Answers = NULL if the inputs are not for learning.
+// Inputs created by createContiguousInputs() have their rows stored in single blocks, the questions having a stride
+// of QuestionsSize + 1 whose last column is filled with 1: batches of consecutive questions are then propagated in place.
 typedef struct
 {
 	const int InputNumber;
@@ -13,12 +15,24 @@ typedef struct
 	const int AnswersSize;
 	Number **Questions;		// InputNumber x QuestionsSize
 	Number **Answers;		// InputNumber x AnswersSize
+	Number *QuestionsData;	// NULL, or InputNumber x (QuestionsSize + 1), the 'Questions' rows pointing into it.
+	Number *AnswersData;	// NULL, or InputNumber x AnswersSize, the 'Answers' rows pointing into it.
 } Inputs;
 
 
 Inputs* createInputs(int InputNumber, int QuestionsSize, int AnswersSize, Number** Questions, Number** Answers);
 
 
+// Creates inputs whose questions and answers are each stored in a single block, initialized to 0.
+// Answers are only allocated if AnswersSize > 0. The rows can still be shuffled, those inputs being then gathered by batch.
+Inputs* createContiguousInputs(int InputNumber, int QuestionsSize, int AnswersSize);
+
+
+// Returns 1 if the questions rows [batch_index, batch_index + batch_size[ follow each other in the contiguous storage,
+// and can thus be used in place as a strided matrix of leading dimension QuestionsSize + 1. Returns 0 otherwise.
+int contiguousBatch(const Inputs *inputs, int batch_index, int batch_size);
+
+
 // Frees the given Inputs passed by address, and sets it to NULL.
 void freeInputs(Inputs **inputs);
 
@@ -29,6 +43,10 @@ void printInputs(const Inputs *inputs, PrintOption opt);
 int saveInputs(const Inputs *inputs, const char *foldername);
 
 
+// Reads the sizes of the inputs saved in the given folder by saveInputs(). Exits on failure.
+void loadInputsInfos(const char *foldername, int *input_number, int *questions_size, int *answers_size);
+
+
 Inputs* loadInputs(const char *foldername);
 
 
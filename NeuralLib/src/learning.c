@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <pthread.h>
 
 #include "learning.h"
 #include "matrix.h"
@@ -8,11 +9,64 @@
 #include "random.h"
 #include "benchmarking.h"
 #include "high_perf.h"
+#include "optimizers.h"
+#include "learning_profile.h"
 
 
 static int Warning_softmax = 1; // Used to only print the warning once.
 
 
+///////////////////////////////////////////////////////////////////////////////////////
+// Data-parallel learning structures:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+// Each batch is split between 'ThreadNumber' workers. The calling thread is the worker 0, and uses the
+// learned network and 'grad_buffer' directly. Other workers use network replicas sharing the same nets,
+// and their own gradient buffers, which are then summed into 'grad_buffer' before updating the network.
+
+
+typedef enum {COMPUTE_GRADIENTS, REDUCE_GRADIENTS, STOP_WORKERS} WorkerTask;
+
+
+typedef struct LearningPool LearningPool;
+
+
+typedef struct
+{
+	LearningPool *pool;
+	int index;
+	NeuralNetwork *network;		// Replica of the learned network, or the latter for the worker 0.
+	Number **grad_buffer;		// Gradients of this worker's part of the batch.
+	int batch_offset;
+	int batch_size;				// May be 0 if the batch is smaller than the number of threads.
+	int sum;					// Learning level estimate on this worker's part of the batch.
+} LearningWorker;
+
+
+struct LearningPool
+{
+	int ThreadNumber;
+	LearningWorker *workers;	// size: ThreadNumber
+	pthread_t *threads;			// size: ThreadNumber - 1, the calling thread being the worker 0.
+
+	pthread_mutex_t mutex;
+	pthread_cond_t start_cond;
+	pthread_cond_t done_cond;
+	int generation;				// Incremented for each new task.
+	int pending;				// Number of threads which haven't finished the current task.
+	WorkerTask task;
+
+	// Current batch:
+	Number **batch_questions;
+	Number **batch_good_answers;
+	int batch_contiguous;		// 1 if the batch questions can be used in place.
+	int batch_sparse;			// 1 if the batch questions may be gathered as sparse, see sparseInputs().
+	LearningParameters *params;
+	LearningProfile *profile;	// NULL if the learning is not profiled. Only the worker 0 measures its phases.
+};
+
+
 ///////////////////////////////////////////////////////////////////////////////////////
 // Prototypes of static functions:
 ///////////////////////////////////////////////////////////////////////////////////////
@@ -32,26 +86,99 @@ static Number** createNetworkBuffer(NeuralNetwork *network);
 static void freeNetworkBuffer(NeuralNetwork *network, Number **buffer);
 
 
-// Propagating the questions from the batch forward, and returning the network's answers:
-static Number* propagation(NeuralNetwork *network, Number **batch_questions, int batch_size);
+// Returns the first layer input of the given batch. Questions which are consecutive rows of contiguous inputs are used
+// in place, as they already have the bias column of 1. Otherwise they are gathered in the first layer own 'Input'.
+// If 'sparse' is 1, returns NULL for a sparse batch, whose first layer input is then given by the network sparse lists:
+static const Number* batchInput(NeuralNetwork *network, Number **batch_questions, int batch_size, int contiguous,
+	int sparse);
+
+
+// Fills the network sparse lists with the non zero elements of the given batch, bias column included.
+// Returns 0, the lists being then unused, if the batch has more than 'SPARSE_INPUT_DENSITY' non zero elements:
+static int gatherSparseInput(NeuralNetwork *network, Number **batch_questions, int batch_size);
+
+
+// C <- op(A) * op(Net), reading the 16 bits copy of the layer nets during a mixed precision learning:
+static void netProduct(const NeuronLayer *layer, TransposeOptions optA, TransposeOptions optNet, const Number *A, Number *C,
+	int rows_op_A, int cols_op_B, int cols_op_A);
+
+
+// Returns the number of first operand elements read by the products of the given layer, i.e half their floating point
+// operations per neuron. Only the non zero elements are read for the first layer of a sparse batch:
+static inline double layerProductElements(const NeuralNetwork *network, int layer_index, int batch_size);
+
+
+// Propagating the batch first layer input forward, and returning the network's answers.
+// The phases are measured in 'profile', if not NULL:
+static Number* propagation(NeuralNetwork *network, const Number *batch_input, int batch_size, LearningProfile *profile);
 
 
 // Backpropagation: recursively update each 'GradSum'.
 // A propagation pass is necessary before doing the backpropagation:
-static void backpropagation(NeuralNetwork *network, Number **batch_good_answers, LearningParameters *params, int batch_size);
+static void backpropagation(NeuralNetwork *network, Number **batch_good_answers, LearningParameters *params, int batch_size,
+	LearningProfile *profile);
+
 
+// Update 'grad_buffer' for the whole batch, whose first layer input is 'batch_input':
+static void updateGradBufferBatch(NeuralNetwork *network, const Number *batch_input, Number **grad_buffer, int batch_size,
+	LearningProfile *profile);
 
-// Update 'grad_buffer' for the whole batch:
-static void updateGradBufferBatch(NeuralNetwork *network, Number **grad_buffer, int batch_size);
 
+// Checking the inputs sizes and the learning settings, and initializing the nets if this is the first learning.
+// At most 'chunk_size' inputs are available at once. Returns 1 if the learning can start, 0 otherwise:
+static int initLearning(NeuralNetwork *network, LearningParameters *params, int questions_size, int answers_size,
+	int input_number, int chunk_size);
 
-static void gradientDescent(NeuralNetwork *network, Inputs *inputs, LearningParameters *params);
+
+// Creates the 16 bits copies of the nets, for a mixed precision learning:
+static void createHalfNets(NeuralNetwork *network, Precision format);
+
+
+// Frees the 16 bits copies of the nets, the products reading the full precision nets again:
+static void freeHalfNets(NeuralNetwork *network);
+
+
+// Learning either the given inputs, or the ones read from the given stream if 'inputs' is NULL:
+static void gradientDescent(NeuralNetwork *network, Inputs *inputs, InputStream *stream, LearningParameters *params);
+
+
+// Learning all the batches of the given inputs once, 'sparse' being the value of sparseInputs() on them.
+// Returns the learning level estimate sum:
+static int learnBatches(NeuralNetwork *network, Inputs *inputs, int sparse, LearningParameters *params, Number **grad_buffer,
+	Number **M_buffer, Number **V_buffer, LearningPool *pool, LearningProfile *profile, int *step_number);
 
 
 static void updateNetwork(NeuralNetwork *network, Number **grad_buffer, Number **M_buffer,	Number **V_buffer,
 	LearningParameters *params, int step_number);
 
 
+// Starting 'params -> ThreadNumber' - 1 worker threads, sharing the batches with the calling thread:
+static LearningPool* createLearningPool(NeuralNetwork *network, Number **grad_buffer, LearningParameters *params,
+	LearningProfile *profile, int batch_size_bound);
+
+
+// Stopping the worker threads, and setting free the pool. The learned network and 'grad_buffer' are left untouched:
+static void freeLearningPool(LearningPool **pool);
+
+
+// Giving a task to every worker, and waiting for all of them to finish it:
+static void runLearningTask(LearningPool *pool, WorkerTask task);
+
+
+// Loop of the worker threads, waiting for new tasks:
+static void* learningWorkerLoop(void *arg);
+
+
+// Doing the given task on this worker's part of the batch, or of the gradients:
+static void doLearningTask(LearningWorker *worker, WorkerTask task);
+
+
+// Parallel equivalent of propagation() + backpropagation() + updateGradBufferBatch() on the whole batch.
+// The gradients are written in the 'grad_buffer' given to createLearningPool(). Returns the learning level estimate sum:
+static int parallelGradients(LearningPool *pool, Number **batch_questions, Number **batch_good_answers, int batch_size,
+	int contiguous, int sparse);
+
+
 ///////////////////////////////////////////////////////////////////////////////////////
 // Learning framework:
 ///////////////////////////////////////////////////////////////////////////////////////
@@ -72,8 +199,11 @@ LearningParameters* initLearningParameters(void)
 	params -> RecogEstimates = ALL_CORRECT;
 
 	params -> PrintEstimates = 1;
+	params -> Profile = 0;
 	params -> EpochNumber = 1;
 	params -> BatchSize = 32;
+	params -> ThreadNumber = 1;
+	params -> ProductsPrecision = FULL_PRECISION;
 	params -> BatchSizeMultiplier = 1.;
 	params -> InitRange = 0.01;
 	params -> LearningRate = 0.01;
@@ -118,13 +248,58 @@ void learn(NeuralNetwork *network, Inputs *inputs, LearningParameters *params)
 		return;
 	}
 
+	if (!initLearning(network, params, inputs -> QuestionsSize, inputs -> AnswersSize, inputs -> InputNumber,
+		inputs -> InputNumber))
+		return;
+
+	gradientDescent(network, inputs, NULL, params);
+
+	network -> HasLearned = 1;
+
+	double time_2 = get_time();
+
+	printf("\n\n-> Learning done (%d epochs). Time elapsed: %.2f s\n\n", params -> EpochNumber, time_2 - time_1);
+}
+
+
+// Make the neural network learn the inputs read from the given stream, while using the given parameters.
+// The batches being taken within the stream chunks, their size is bounded by the chunk size:
+void learnStream(NeuralNetwork *network, InputStream *stream, LearningParameters *params)
+{
+	double time_1 = get_time();
+
+	if (network == NULL || stream == NULL || params == NULL)
+	{
+		printf("\nInvalid arguments passed to the learnStream function.\n\n");
+		return;
+	}
+
+	if (!initLearning(network, params, inputStream_questionsSize(stream), inputStream_answersSize(stream),
+		inputStream_inputNumber(stream), inputStream_chunkSize(stream)))
+		return;
+
+	gradientDescent(network, NULL, stream, params);
+
+	network -> HasLearned = 1;
+
+	double time_2 = get_time();
+
+	printf("\n\n-> Learning done (%d epochs). Time elapsed: %.2f s\n\n", params -> EpochNumber, time_2 - time_1);
+}
+
+
+// Checking the inputs sizes and the learning settings, and initializing the nets if this is the first learning.
+// At most 'chunk_size' inputs are available at once. Returns 1 if the learning can start, 0 otherwise:
+static int initLearning(NeuralNetwork *network, LearningParameters *params, int questions_size, int answers_size,
+	int input_number, int chunk_size)
+{
 	const int net_input_size = network_inputSize(network), net_output_size = network_outputSize(network);
 
-	if (net_input_size != inputs -> QuestionsSize || net_output_size != inputs -> AnswersSize)
+	if (net_input_size != questions_size || net_output_size != answers_size)
 	{
 		printf("\nImcompatible sizes between network and inputs! Questions size: %d vs %d, answers size: %d vs %d.\n\n",
-			net_input_size, inputs -> QuestionsSize, net_output_size, inputs -> AnswersSize);
-		return;
+			net_input_size, questions_size, net_output_size, answers_size);
+		return 0;
 	}
 
 	// Batch size management:
@@ -133,9 +308,9 @@ void learn(NeuralNetwork *network, Inputs *inputs, LearningParameters *params)
 		params -> BatchSize = 1;
 
 	else if (params -> Method == FULL_BATCH)
-		params -> BatchSize = inputs -> InputNumber;
+		params -> BatchSize = input_number;
 
-	int batch_size_bound = MIN(network -> MaxBatchSize, inputs -> InputNumber);
+	int batch_size_bound = MIN(network -> MaxBatchSize, chunk_size);
 
 	if (params -> BatchSize > batch_size_bound)
 	{
@@ -143,6 +318,15 @@ void learn(NeuralNetwork *network, Inputs *inputs, LearningParameters *params)
 		params -> BatchSize = batch_size_bound;
 	}
 
+	if (params -> ThreadNumber < 1)
+		params -> ThreadNumber = 1;
+
+	if (params -> ThreadNumber > batch_size_bound)
+	{
+		printf("\nLearning threads number changed to 'batch_size_bound': %d.\n\n", batch_size_bound);
+		params -> ThreadNumber = batch_size_bound;
+	}
+
 	// Making sure the settings are coherent enough:
 
 	NeuronLayer *layer = network_outputLayer(network);
@@ -153,10 +337,20 @@ void learn(NeuralNetwork *network, Inputs *inputs, LearningParameters *params)
 		printf("\nOutput of dimension 1: activation changed to 'Sigmoid'.\n");
 	}
 
+	if (params -> ProductsPrecision < FULL_PRECISION || params -> ProductsPrecision > FLOAT16)
+	{
+		printf("\nUnknown products precision, changed to 'FULL_PRECISION'.\n");
+		params -> ProductsPrecision = FULL_PRECISION;
+	}
+
+	if (params -> ProductsPrecision != FULL_PRECISION)
+		printf("\nRemark: mixed precision learning, the products using %s copies of the nets.\n",
+			getPrecisionString(params -> ProductsPrecision));
+
 	if (params -> Shuffle == SHUFFLE)
 		printf("\nRemark: the inputs will be shuffled during the learning phase.\nThis can be turned off via 'params -> Shuffle'.\n");
 
-	printf("\n-> Starting to learn the %d given inputs:\n", inputs -> InputNumber);
+	printf("\n-> Starting to learn the %d given inputs:\n", input_number);
 
 	if (network -> HasLearned == 0) // First learning.
 	{
@@ -189,13 +383,7 @@ void learn(NeuralNetwork *network, Inputs *inputs, LearningParameters *params)
 		}
 	}
 
-	gradientDescent(network, inputs, params);
-
-	network -> HasLearned = 1;
-
-	double time_2 = get_time();
-
-	printf("\n\n-> Learning done (%d epochs). Time elapsed: %.2f s\n\n", params -> EpochNumber, time_2 - time_1);
+	return 1;
 }
 
 
@@ -217,6 +405,31 @@ inline void prediction(NeuralNetwork *network, Inputs *inputs)
 }
 
 
+// Returns 1 if the given questions, bias column included, have at most 'SPARSE_INPUT_DENSITY' non zero elements,
+// i.e if their batches are worth being gathered as lists of said elements. Stops reading them once found too dense:
+int sparseInputs(const Inputs *inputs)
+{
+	const long max_elements = SPARSE_INPUT_DENSITY * inputs -> InputNumber * (inputs -> QuestionsSize + 1);
+
+	long e = 0;
+
+	for (int i = 0; i < inputs -> InputNumber; ++i)
+	{
+		const Number *question = inputs -> Questions[i];
+
+		for (int k = 0; k < inputs -> QuestionsSize; ++k)
+			e += question[k] != 0;
+
+		++e; // Bias column.
+
+		if (e > max_elements)
+			return 0;
+	}
+
+	return 1;
+}
+
+
 // Predict the answers of the given inputs, and do the following depending on the value of 'type':
 // VALIDATION -> compare the network answers to the correct ones, and print the validation level.
 // PREDICTION -> write the network answers in the given inputs.
@@ -273,12 +486,17 @@ static void recognitionFramework(NeuralNetwork *network, Inputs *inputs, RecogTy
 	int current_batch_size = remainder == 0 ? batch_size_bound : remainder;
 	int batch_index = 0, sum = 0;
 
+	const int sparse = sparseInputs(inputs);
+
 	while (batch_index < inputs -> InputNumber)
 	{
 		Number **batch_questions = inputs -> Questions + batch_index;
 		Number **batch_goodOrToFill_answers = inputs -> Answers + batch_index;
 
-		Number *batch_answers = propagation(network, batch_questions, current_batch_size);
+		const Number *batch_input = batchInput(network, batch_questions, current_batch_size,
+			contiguousBatch(inputs, batch_index, current_batch_size), sparse);
+
+		Number *batch_answers = propagation(network, batch_input, current_batch_size, NULL);
 
 		for (int b = 0; b < current_batch_size; ++b)
 		{
@@ -337,40 +555,126 @@ static inline void freeNetworkBuffer(NeuralNetwork *network, Number **buffer)
 ///////////////////////////////////////////////////////////////////////////////////////
 
 
-// Propagating the questions from the batch forward, and returning the network's answers:
-static Number* propagation(NeuralNetwork *network, Number **batch_questions, int batch_size)
+// Returns the first layer input of the given batch. Questions which are consecutive rows of contiguous inputs are used
+// in place, as they already have the bias column of 1. Otherwise they are gathered in the first layer own 'Input'.
+// If 'sparse' is 1, returns NULL for a sparse batch, whose first layer input is then given by the network sparse lists:
+static const Number* batchInput(NeuralNetwork *network, Number **batch_questions, int batch_size, int contiguous,
+	int sparse)
 {
-	NeuronLayer *layer = network -> Layers;
+	network -> SparseBatch = sparse && gatherSparseInput(network, batch_questions, batch_size);
+
+	if (network -> SparseBatch)
+		return NULL;
+
+	if (contiguous)
+		return batch_questions[0];
 
-	// Copying the questions from the batch to the first network's Input:
+	NeuronLayer *layer = network -> Layers;
 
 	for (int b = 0; b < batch_size; ++b)
 		copy(layer -> Input + b * (layer -> InputSize + 1), batch_questions[b], layer -> InputSize);
 
+	return layer -> Input;
+}
+
+
+// Fills the network sparse lists with the non zero elements of the given batch, bias column included.
+// Returns 0, the lists being then unused, if the batch has more than 'SPARSE_INPUT_DENSITY' non zero elements:
+static int gatherSparseInput(NeuralNetwork *network, Number **batch_questions, int batch_size)
+{
+	const int input_size = network_inputSize(network);
+	const long max_elements = SPARSE_INPUT_DENSITY * batch_size * (input_size + 1);
+
+	int *indices = network -> SparseIndices;
+	Number *values = network -> SparseValues;
+
+	int e = 0;
+
+	for (int b = 0; b < batch_size; ++b)
+	{
+		network -> SparseRowStart[b] = e;
+
+		const Number *question = batch_questions[b];
+
+		// Branchless: each element is written, but only kept if non zero.
+
+		for (int k = 0; k < input_size; ++k)
+		{
+			indices[e] = k;
+			values[e] = question[k];
+			e += question[k] != 0;
+		}
+
+		indices[e] = input_size; // Bias column.
+		values[e] = 1;
+		++e;
+
+		if (e > max_elements) // Too dense, the remaining questions are not read.
+			return 0;
+	}
+
+	network -> SparseRowStart[batch_size] = e;
+
+	return 1;
+}
+
+
+// C <- op(A) * op(Net), reading the 16 bits copy of the layer nets during a mixed precision learning:
+static void netProduct(const NeuronLayer *layer, TransposeOptions optA, TransposeOptions optNet, const Number *A, Number *C,
+	int rows_op_A, int cols_op_B, int cols_op_A)
+{
+	if (layer -> HalfNet != NULL)
+		matrix_multiply_half(optA, optNet, A, layer -> HalfNet, layer -> HalfFormat, C, rows_op_A, cols_op_B, cols_op_A);
+
+	else
+		matrix_multiply(optA, optNet, A, layer -> Net, C, rows_op_A, cols_op_B, cols_op_A);
+}
+
+
+// Returns the number of first operand elements read by the products of the given layer, i.e half their floating point
+// operations per neuron. Only the non zero elements are read for the first layer of a sparse batch:
+static inline double layerProductElements(const NeuralNetwork *network, int layer_index, int batch_size)
+{
+	if (layer_index == 0 && network -> SparseBatch)
+		return network -> SparseRowStart[batch_size];
+
+	return (double) batch_size * (network -> Layers[layer_index].InputSize + 1);
+}
+
+
+// Propagating the batch first layer input forward, and returning the network's answers.
+// The phases are measured in 'profile', if not NULL:
+static Number* propagation(NeuralNetwork *network, const Number *batch_input, int batch_size, LearningProfile *profile)
+{
+	NeuronLayer *layer = network -> Layers;
+
 	// Propagating the questions through each layers:
 
 	for (int l = 0; l < network -> LayersNumber; ++l)
 	{
-		// For each layer: Sum = Input * Net
+		const Number *input = l == 0 ? batch_input : layer -> Input;
 
-		matrix_multiply(NoTrans, NoTrans, layer -> Input, layer -> Net, layer -> Sum,
-			batch_size, layer -> NeuronsNumber, layer -> InputSize + 1);
+		// For each layer: Sum = Input * Net. For a sparse batch, the first layer only reads the rows of
+		// the nets matching its non zero elements (the full precision nets, even in mixed precision):
 
-		// Activation:
+		double start = profileStart(profile);
 
-		for (int b = 0; b < batch_size; ++b)
-		{
-			int gradsum_pos = b * layer -> NeuronsNumber;
-			int output_pos = gradsum_pos + b; // = b * (layer -> NeuronsNumber + 1)
+		if (l == 0 && network -> SparseBatch)
+			sparse_matrix_multiply(network -> SparseRowStart, network -> SparseIndices, network -> SparseValues,
+				layer -> Net, layer -> Sum, batch_size, layer -> NeuronsNumber);
 
-			if (layer -> Fun == Softmax)
-				softmax(layer -> Output + output_pos, layer -> Sum + gradsum_pos, layer -> NeuronsNumber);
-			else
-			{
-				for (int j = 0; j < layer -> NeuronsNumber; ++j)
-					layer -> Output[output_pos + j] = activation(layer -> Fun, layer -> Sum[gradsum_pos + j]);
-			}
-		}
+		else
+			netProduct(layer, NoTrans, NoTrans, input, layer -> Sum, batch_size, layer -> NeuronsNumber, layer -> InputSize + 1);
+
+		profileStop(profile, PROF_FORWARD_PRODUCT, l, start, 2. * layerProductElements(network, l, batch_size) * layer -> NeuronsNumber);
+
+		// Activation, on the whole batch. N.B: the biases are already added by the product, through the Input last column of 1:
+
+		start = profileStart(profile);
+
+		activationBlock(layer -> Fun, layer -> Output, layer -> NeuronsNumber + 1, layer -> Sum, batch_size, layer -> NeuronsNumber);
+
+		profileStop(profile, PROF_ACTIVATION, l, start, 0);
 
 		++layer;
 	}
@@ -383,73 +687,89 @@ static Number* propagation(NeuralNetwork *network, Number **batch_questions, int
 
 // Backpropagation: recursively update each 'GradSum'.
 // A propagation pass is necessary before doing the backpropagation:
-static void backpropagation(NeuralNetwork *network, Number **batch_good_answers, LearningParameters *params, int batch_size)
+static void backpropagation(NeuralNetwork *network, Number **batch_good_answers, LearningParameters *params, int batch_size,
+	LearningProfile *profile)
 {
 	NeuronLayer *layer = network_outputLayer(network);
 
 	// Output layer:
 
+	double start = profileStart(profile);
+
 	for (int b = 0; b < batch_size; ++b)
 	{
 		int gradsum_pos = b * layer -> NeuronsNumber;
 		int output_pos = gradsum_pos + b; // = b * (layer -> NeuronsNumber + 1)
 
-		if (params -> LossFun == QUADRATIC)
-		{
-			if (layer -> Fun == Softmax)
-				updateGradSumSoftmaxQuadLoss(layer -> GradSum + gradsum_pos, layer -> Output + output_pos,
-					batch_good_answers[b], layer -> NeuronsNumber);
-			else
-			{
-				for (int j = 0; j < layer -> NeuronsNumber; ++j)
-					layer -> GradSum[gradsum_pos + j] = der_activation(layer -> Fun, layer -> Sum[output_pos + j]) *
-						(layer -> Output[output_pos + j] - batch_good_answers[b][j]);
-			}
-		}
+		if (params -> LossFun == QUADRATIC && layer -> Fun == Softmax)
+			updateGradSumSoftmaxQuadLoss(layer -> GradSum + gradsum_pos, layer -> Output + output_pos,
+				batch_good_answers[b], layer -> NeuronsNumber);
 
-		else // CROSS_ENTROPY
+		else // CROSS_ENTROPY, or QUADRATIC whose activation derivative is applied below.
 		{
 			for (int j = 0; j < layer -> NeuronsNumber; ++j)
 				layer -> GradSum[gradsum_pos + j] = layer -> Output[output_pos + j] - batch_good_answers[b][j];
 		}
 	}
 
+	if (params -> LossFun == QUADRATIC && layer -> Fun != Softmax)
+		der_activationMultiply(layer -> Fun, layer -> GradSum, layer -> Sum, batch_size * layer -> NeuronsNumber);
+
+	profileStop(profile, PROF_OUTPUT_ERROR, 0, start, 0);
+
 	// Hidden layers:
 
-	for (int l = 0; l < network -> LayersNumber - 1; ++l)
+	for (int l = network -> LayersNumber - 2; l >= 0; --l)
 	{
 		NeuronLayer *next_layer = layer;
 		--layer;
 
 		// For each hidden layer: GradSum = next GradSum * tr(next Net)
 
-		matrix_multiply(NoTrans, Trans, next_layer -> GradSum, next_layer -> Net, layer -> GradSum,
+		start = profileStart(profile);
+
+		netProduct(next_layer, NoTrans, Trans, next_layer -> GradSum, layer -> GradSum,
 			batch_size, layer -> NeuronsNumber, next_layer -> NeuronsNumber);
 
-		// Multiplying by the activation derivative (softmax not supported here):
+		profileStop(profile, PROF_BACKWARD_PRODUCT, l + 1, start,
+			2. * batch_size * layer -> NeuronsNumber * next_layer -> NeuronsNumber);
 
-		for (int b = 0; b < batch_size; ++b)
-		{
-			int gradsum_pos = b * layer -> NeuronsNumber;
+		// Multiplying by the activation derivative, on the whole batch (softmax not supported here):
 
-			for (int j = 0; j < layer -> NeuronsNumber; ++j)
-				layer -> GradSum[gradsum_pos + j] *= der_activation(layer -> Fun, layer -> Sum[gradsum_pos + j]);
-		}
+		start = profileStart(profile);
+
+		der_activationMultiply(layer -> Fun, layer -> GradSum, layer -> Sum, batch_size * layer -> NeuronsNumber);
+
+		profileStop(profile, PROF_ACTIVATION_DERIVATIVE, l, start, 0);
 	}
 }
 
 
-// Update 'grad_buffer' for the whole batch:
-static void updateGradBufferBatch(NeuralNetwork *network, Number **grad_buffer, int batch_size)
+// Update 'grad_buffer' for the whole batch, whose first layer input is 'batch_input':
+static void updateGradBufferBatch(NeuralNetwork *network, const Number *batch_input, Number **grad_buffer, int batch_size,
+	LearningProfile *profile)
 {
 	NeuronLayer *layer = network -> Layers;
 
 	for (int l = 0; l < network -> LayersNumber; ++l)
 	{
-		// For each layer: grad_buffer[l] = tr(Input) * GradSum
+		const Number *input = l == 0 ? batch_input : layer -> Input;
+
+		const double start = profileStart(profile);
+
+		// For each layer: grad_buffer[l] = tr(Input) * GradSum. For a sparse batch, only the first layer gradient
+		// rows matching its non zero elements are accumulated:
 
-		matrix_multiply(Trans, NoTrans, layer -> Input, layer -> GradSum, grad_buffer[l],
-			layer -> InputSize + 1, layer -> NeuronsNumber, batch_size);
+		if (l == 0 && network -> SparseBatch)
+			sparse_transposed_multiply(network -> SparseRowStart, network -> SparseIndices, network -> SparseValues,
+				layer -> GradSum, grad_buffer[l], batch_size, layer -> InputSize + 1, layer -> NeuronsNumber,
+				network -> SparseColStart, network -> SparseColRows, network -> SparseColValues);
+
+		else
+			matrix_multiply(Trans, NoTrans, input, layer -> GradSum, grad_buffer[l],
+				layer -> InputSize + 1, layer -> NeuronsNumber, batch_size);
+
+		profileStop(profile, PROF_GRADIENT_PRODUCT, l, start, 2. * layerProductElements(network, l, batch_size) * layer -> NeuronsNumber);
 
 		++layer;
 	}
@@ -461,7 +781,47 @@ static void updateGradBufferBatch(NeuralNetwork *network, Number **grad_buffer,
 ///////////////////////////////////////////////////////////////////////////////////////
 
 
-static void gradientDescent(NeuralNetwork *network, Inputs *inputs, LearningParameters *params)
+// Creates the 16 bits copies of the nets, for a mixed precision learning:
+static void createHalfNets(NeuralNetwork *network, Precision format)
+{
+	for (int l = 0; l < network -> LayersNumber; ++l)
+	{
+		NeuronLayer *layer = network -> Layers + l;
+
+		const int netLength = (layer -> InputSize + 1) * layer -> NeuronsNumber;
+
+		layer -> HalfNet = (Half*) malloc(netLength * sizeof(Half));
+
+		if (layer -> HalfNet == NULL)
+		{
+			printf("\nNot enough memory for the 16 bits copies of the nets.\n\n");
+			exit(EXIT_FAILURE);
+		}
+
+		layer -> HalfFormat = format;
+
+		toHalf(format, layer -> HalfNet, layer -> Net, netLength);
+	}
+}
+
+
+// Frees the 16 bits copies of the nets, the products reading the full precision nets again:
+static void freeHalfNets(NeuralNetwork *network)
+{
+	for (int l = 0; l < network -> LayersNumber; ++l)
+	{
+		NeuronLayer *layer = network -> Layers + l;
+
+		free(layer -> HalfNet);
+
+		layer -> HalfNet = NULL;
+		layer -> HalfFormat = FULL_PRECISION;
+	}
+}
+
+
+// Learning either the given inputs, or the ones read from the given stream if 'inputs' is NULL:
+static void gradientDescent(NeuralNetwork *network, Inputs *inputs, InputStream *stream, LearningParameters *params)
 {
 	// Buffers initialization:
 
@@ -495,53 +855,78 @@ static void gradientDescent(NeuralNetwork *network, Inputs *inputs, LearningPara
 			break;
 	}
 
-	int batch_size_bound = MIN(network -> MaxBatchSize, inputs -> InputNumber);
+	const int input_number = inputs != NULL ? inputs -> InputNumber : inputStream_inputNumber(stream);
+	const int chunk_size = inputs != NULL ? inputs -> InputNumber : inputStream_chunkSize(stream);
+
+	int batch_size_bound = MIN(network -> MaxBatchSize, chunk_size);
 	int step_number = 0; // Number of batches done since the beginning.
 
+	const int sparse = inputs != NULL && sparseInputs(inputs); // Checked for each chunk of a stream.
+
+	if (params -> ProductsPrecision != FULL_PRECISION)
+		createHalfNets(network, params -> ProductsPrecision); // Before creating the replicas, which share them.
+
+	LearningProfile *profile = params -> Profile ? createLearningProfile(network -> LayersNumber) : NULL;
+
+	LearningPool *pool = NULL;
+
+	if (params -> ThreadNumber > 1)
+		pool = createLearningPool(network, grad_buffer, params, profile, batch_size_bound);
+
 	// Learning begins:
 
 	for (int epoch = 0; epoch < params -> EpochNumber; ++epoch)
 	{
-		if (params -> Shuffle == SHUFFLE)
-			shuffleInputs(inputs);
+		int sum = 0;
 
-		int current_remainder = (inputs -> InputNumber) % (params -> BatchSize); // here since BatchSize may be changed with epochs.
-		int current_batch_size = current_remainder == 0 ? params -> BatchSize : current_remainder;
-		int batch_index = 0, sum = 0;
+		if (profile != NULL)
+			resetLearningProfile(profile);
 
-		while (batch_index < inputs -> InputNumber)
+		if (inputs != NULL)
 		{
-			Number **batch_questions = inputs -> Questions + batch_index;
-			Number **batch_good_answers = inputs -> Answers + batch_index;
+			if (params -> Shuffle == SHUFFLE)
+			{
+				const double start = profileStart(profile);
 
-			Number *batch_answers = propagation(network, batch_questions, current_batch_size);
+				shuffleInputs(inputs);
 
-			if (params -> PrintEstimates)
-			{
-				for (int b = 0; b < current_batch_size; ++b)
-					sum += recog_method(batch_good_answers[b], batch_answers + b * (inputs -> AnswersSize + 1),
-						inputs -> AnswersSize, params -> RecogEstimates, VALIDATION);
+				profileStop(profile, PROF_SHUFFLE, 0, start, 0);
 			}
 
-			backpropagation(network, batch_good_answers, params, current_batch_size);
+			sum = learnBatches(network, inputs, sparse, params, grad_buffer, M_buffer, V_buffer, pool, profile, &step_number);
+		}
 
-			updateGradBufferBatch(network, grad_buffer, current_batch_size);
+		else // The next chunk is read while the current one is learned.
+		{
+			double start = profileStart(profile);
 
-			++step_number;
+			rewindInputStream(stream, params -> Shuffle == SHUFFLE);
 
-			updateNetwork(network, grad_buffer, M_buffer, V_buffer, params, step_number);
+			Inputs *chunk;
 
-			batch_index += current_batch_size;
-			current_batch_size = params -> BatchSize; // only 'params -> BatchSize' after the first pass.
+			while ((chunk = nextInputChunk(stream)) != NULL)
+			{
+				profileStop(profile, PROF_STREAM_WAIT, 0, start, 0);
+
+				sum += learnBatches(network, chunk, sparseInputs(chunk), params, grad_buffer, M_buffer, V_buffer, pool, profile,
+					&step_number);
+
+				start = profileStart(profile);
+			}
+
+			profileStop(profile, PROF_STREAM_WAIT, 0, start, 0);
 		}
 
 		if (params -> PrintEstimates)
 		{
-			float learning_level = 100. * sum / inputs -> InputNumber;
+			float learning_level = 100. * sum / input_number;
 
 			printf("\nEpoch °%d, learning level estimate: %.2f %%\n", epoch + 1, learning_level);
 		}
 
+		if (profile != NULL)
+			printLearningProfile(profile, epoch + 1);
+
 		// Multiply the learning rate by an user given value:
 		params -> LearningRate *= params -> LearningRateMultiplier;
 
@@ -550,99 +935,154 @@ static void gradientDescent(NeuralNetwork *network, Inputs *inputs, LearningPara
 		params -> BatchSize = MAX(params -> BatchSize, 1); // so that batch size != 0.
 	}
 
+	freeLearningPool(&pool);
+
+	freeLearningProfile(&profile);
+
+	freeHalfNets(network);
+
 	freeNetworkBuffer(network, grad_buffer);
 	freeNetworkBuffer(network, M_buffer);
 	freeNetworkBuffer(network, V_buffer);
 }
 
 
-static void updateNetwork(NeuralNetwork *network, Number **grad_buffer, Number **M_buffer, Number **V_buffer,
-	LearningParameters *params, int step_number)
+// Learning all the batches of the given inputs once, 'sparse' being the value of sparseInputs() on them.
+// Returns the learning level estimate sum:
+static int learnBatches(NeuralNetwork *network, Inputs *inputs, int sparse, LearningParameters *params, Number **grad_buffer,
+	Number **M_buffer, Number **V_buffer, LearningPool *pool, LearningProfile *profile, int *step_number)
 {
-	NeuronLayer *layer = network -> Layers;
+	int current_remainder = (inputs -> InputNumber) % (params -> BatchSize); // here since BatchSize may be changed with epochs.
+	int current_batch_size = current_remainder == 0 ? params -> BatchSize : current_remainder;
+	int batch_index = 0, sum = 0;
 
-	for (int l = 0; l < network -> LayersNumber; ++l)
+	while (batch_index < inputs -> InputNumber)
 	{
-		// Regularization:
+		Number **batch_questions = inputs -> Questions + batch_index;
+		Number **batch_good_answers = inputs -> Answers + batch_index;
 
-		if (params -> Reg == L2)
+		int contiguous = contiguousBatch(inputs, batch_index, current_batch_size);
+
+		if (pool != NULL)
+			sum += parallelGradients(pool, batch_questions, batch_good_answers, current_batch_size, contiguous, sparse);
+
+		else
 		{
-			int weigthsLength = layer -> InputSize * layer -> NeuronsNumber;
+			double start = profileStart(profile);
+
+			const Number *batch_input = batchInput(network, batch_questions, current_batch_size, contiguous, sparse);
+
+			profileStop(profile, PROF_BATCH_INPUT, 0, start, 0);
+
+			Number *batch_answers = propagation(network, batch_input, current_batch_size, profile);
+
+			if (params -> PrintEstimates)
+			{
+				start = profileStart(profile);
+
+				for (int b = 0; b < current_batch_size; ++b)
+					sum += recog_method(batch_good_answers[b], batch_answers + b * (inputs -> AnswersSize + 1),
+						inputs -> AnswersSize, params -> RecogEstimates, VALIDATION);
+
+				profileStop(profile, PROF_ESTIMATES, 0, start, 0);
+			}
+
+			backpropagation(network, batch_good_answers, params, current_batch_size, profile);
 
-			scal(layer -> Net, weigthsLength, 1 - params -> L2regCoeff);
+			updateGradBufferBatch(network, batch_input, grad_buffer, current_batch_size, profile);
 		}
 
+		++(*step_number);
+
+		const double start = profileStart(profile);
+
+		updateNetwork(network, grad_buffer, M_buffer, V_buffer, params, *step_number);
+
+		profileStop(profile, PROF_OPTIMIZER, 0, start, 0);
+
+		batch_index += current_batch_size;
+		current_batch_size = params -> BatchSize; // only 'params -> BatchSize' after the first pass.
+	}
+
+	if (profile != NULL)
+		profile -> Samples += inputs -> InputNumber;
+
+	return sum;
+}
+
+
+static void updateNetwork(NeuralNetwork *network, Number **grad_buffer, Number **M_buffer, Number **V_buffer,
+	LearningParameters *params, int step_number)
+{
+	NeuronLayer *layer = network -> Layers;
+
+	for (int l = 0; l < network -> LayersNumber; ++l)
+	{
+		// The weights are followed by the biases row, which is not regularized:
+
+		const int weightsLength = layer -> InputSize * layer -> NeuronsNumber;
+		const int netLength = weightsLength + layer -> NeuronsNumber;
 
-		// Optimizer:
+		const Number decay = params -> Reg == L2 ? 1 - params -> L2regCoeff : 1;
 
-		int netLength = (layer -> InputSize + 1) * layer -> NeuronsNumber;
+		// Optimizer, applying the regularization, the moments update and the step in a single pass:
 
 		switch (params -> Optim)
 		{
 			case NO_OPT:
 
-				// For all layers: Net -= eta * grad_buffer[l]
+				// Net -= eta * grad_buffer[l]
 
-				addScal(layer -> Net, grad_buffer[l], netLength, - params -> LearningRate);
+				sgdStep(layer -> Net, grad_buffer[l], weightsLength, decay, params -> LearningRate);
+
+				sgdStep(layer -> Net + weightsLength, grad_buffer[l] + weightsLength, layer -> NeuronsNumber, 1,
+					params -> LearningRate);
 
 				break;
 
 
 			case MOMENTUM:
 
-				// M_buffer[l] = params -> MomentumRate * M_buffer[l] + params -> LearningRate * grad_buffer[l]:
-
-				scal(M_buffer[l], netLength, params -> MomentumRate);
-
-				addScal(M_buffer[l], grad_buffer[l], netLength, params -> LearningRate);
+				// M_buffer[l] = params -> MomentumRate * M_buffer[l] + params -> LearningRate * grad_buffer[l]
+				// layer -> Net -= M_buffer[l]
 
-				// layer -> Net -= M_buffer[l]:
+				momentumStep(layer -> Net, grad_buffer[l], M_buffer[l], weightsLength, decay,
+					params -> LearningRate, params -> MomentumRate);
 
-				addScal(layer -> Net, M_buffer[l], netLength, -1.);
+				momentumStep(layer -> Net + weightsLength, grad_buffer[l] + weightsLength, M_buffer[l] + weightsLength,
+					layer -> NeuronsNumber, 1, params -> LearningRate, params -> MomentumRate);
 
 				break;
 
 
 			case RMSprop:
 
-				;Number RMScoeff_conj = 1 - params -> RMScoeff;
-
 				// V_buffer[l] = params -> RMScoeff * V_buffer[l] + RMScoeff_conj * grad_buffer[l] * grad_buffer[l]
 				// layer -> Net -= params -> LearningRate * grad_buffer[l] / (number_sqrt(V_buffer[l]) + EPSILON)
 
-				// Naive:
-
-				for (int i = 0; i < netLength; ++i)
-				{
-					V_buffer[l][i] = params -> RMScoeff * V_buffer[l][i] + RMScoeff_conj * grad_buffer[l][i] * grad_buffer[l][i];
+				rmspropStep(layer -> Net, grad_buffer[l], V_buffer[l], weightsLength, decay,
+					params -> LearningRate, params -> RMScoeff);
 
-					layer -> Net[i] -= params -> LearningRate * grad_buffer[l][i] / (number_sqrt(V_buffer[l][i]) + EPSILON);
-				}
+				rmspropStep(layer -> Net + weightsLength, grad_buffer[l] + weightsLength, V_buffer[l] + weightsLength,
+					layer -> NeuronsNumber, 1, params -> LearningRate, params -> RMScoeff);
 
 				break;
 
 
 			case ADAM:
 
-				;Number AdamBetaM_conj = 1 - params -> AdamBetaM, AdamBetaV_conj = 1 - params -> AdamBetaV;
-
-				Number scalar = params -> LearningRate * number_sqrt(1 - number_pow(params -> AdamBetaV, step_number)) /
+				;Number scalar = params -> LearningRate * number_sqrt(1 - number_pow(params -> AdamBetaV, step_number)) /
 					(1 - number_pow(params -> AdamBetaM, step_number));
 
 				// M_buffer[l] = params -> AdamBetaM * M_buffer[l] + AdamBetaM_conj * grad_buffer[l]
-				// V_buffer[l] = params -> AdamBetaM * V_buffer[l] + AdamBetaM_conj * grad_buffer[l] * grad_buffer[l]
+				// V_buffer[l] = params -> AdamBetaV * V_buffer[l] + AdamBetaV_conj * grad_buffer[l] * grad_buffer[l]
 				// layer -> Net -= scalar * M_buffer[l] / (number_sqrt(V_buffer[l]) + EPSILON)
 
-				// Naive:
+				adamStep(layer -> Net, grad_buffer[l], M_buffer[l], V_buffer[l], weightsLength, decay,
+					scalar, params -> AdamBetaM, params -> AdamBetaV);
 
-				for (int i = 0; i < netLength; ++i)
-				{
-					M_buffer[l][i] = params -> AdamBetaM * M_buffer[l][i] + AdamBetaM_conj * grad_buffer[l][i];
-
-					V_buffer[l][i] = params -> AdamBetaV * V_buffer[l][i] + AdamBetaV_conj * grad_buffer[l][i] * grad_buffer[l][i];
-
-					layer -> Net[i] -= scalar * M_buffer[l][i] / (number_sqrt(V_buffer[l][i]) + EPSILON);
-				}
+				adamStep(layer -> Net + weightsLength, grad_buffer[l] + weightsLength, M_buffer[l] + weightsLength,
+					V_buffer[l] + weightsLength, layer -> NeuronsNumber, 1, scalar, params -> AdamBetaM, params -> AdamBetaV);
 
 				break;
 
@@ -651,6 +1091,272 @@ static void updateNetwork(NeuralNetwork *network, Number **grad_buffer, Number *
 				break;
 		}
 
+		// Mixed precision: the next products use the updated nets.
+
+		if (layer -> HalfNet != NULL)
+			toHalf(layer -> HalfFormat, layer -> HalfNet, layer -> Net, netLength);
+
 		++layer;
 	}
 }
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Data-parallel learning:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+// Starting 'params -> ThreadNumber' - 1 worker threads, sharing the batches with the calling thread:
+static LearningPool* createLearningPool(NeuralNetwork *network, Number **grad_buffer, LearningParameters *params,
+	LearningProfile *profile, int batch_size_bound)
+{
+	LearningPool *pool = (LearningPool*) calloc(1, sizeof(LearningPool));
+
+	pool -> ThreadNumber = params -> ThreadNumber;
+	pool -> params = params;
+	pool -> profile = profile;
+
+	pool -> workers = (LearningWorker*) calloc(pool -> ThreadNumber, sizeof(LearningWorker));
+	pool -> threads = (pthread_t*) calloc(pool -> ThreadNumber - 1, sizeof(pthread_t));
+
+	pthread_mutex_init(&(pool -> mutex), NULL);
+	pthread_cond_init(&(pool -> start_cond), NULL);
+	pthread_cond_init(&(pool -> done_cond), NULL);
+
+	// Max batch size of each worker, the batches being split as evenly as possible:
+	int worker_batch_size_bound = (batch_size_bound + pool -> ThreadNumber - 1) / pool -> ThreadNumber;
+
+	for (int w = 0; w < pool -> ThreadNumber; ++w)
+	{
+		LearningWorker *worker = pool -> workers + w;
+
+		worker -> pool = pool;
+		worker -> index = w;
+
+		if (w == 0)
+		{
+			worker -> network = network;
+			worker -> grad_buffer = grad_buffer;
+		}
+		else
+		{
+			worker -> network = createNetworkReplica(network, worker_batch_size_bound);
+			worker -> grad_buffer = createNetworkBuffer(network);
+		}
+	}
+
+	for (int t = 0; t < pool -> ThreadNumber - 1; ++t)
+	{
+		if (pthread_create(pool -> threads + t, NULL, learningWorkerLoop, pool -> workers + t + 1) != 0)
+		{
+			printf("\nCould not create the learning thread %d.\n\n", t + 1);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	return pool;
+}
+
+
+// Stopping the worker threads, and setting free the pool. The learned network and 'grad_buffer' are left untouched:
+static void freeLearningPool(LearningPool **pool)
+{
+	if (pool == NULL || *pool == NULL)
+		return;
+
+	runLearningTask(*pool, STOP_WORKERS);
+
+	for (int w = 1; w < (*pool) -> ThreadNumber; ++w)
+	{
+		LearningWorker *worker = (*pool) -> workers + w;
+
+		freeNetworkBuffer(worker -> network, worker -> grad_buffer);
+		freeNetworkReplica(&(worker -> network));
+	}
+
+	pthread_mutex_destroy(&((*pool) -> mutex));
+	pthread_cond_destroy(&((*pool) -> start_cond));
+	pthread_cond_destroy(&((*pool) -> done_cond));
+
+	free((*pool) -> workers);
+	free((*pool) -> threads);
+	free(*pool);
+	*pool = NULL;
+}
+
+
+// Giving a task to every worker, and waiting for all of them to finish it:
+static void runLearningTask(LearningPool *pool, WorkerTask task)
+{
+	pthread_mutex_lock(&(pool -> mutex));
+
+	pool -> task = task;
+	pool -> pending = pool -> ThreadNumber - 1;
+	++(pool -> generation);
+
+	pthread_cond_broadcast(&(pool -> start_cond));
+	pthread_mutex_unlock(&(pool -> mutex));
+
+	if (task == STOP_WORKERS)
+	{
+		for (int t = 0; t < pool -> ThreadNumber - 1; ++t)
+			pthread_join(pool -> threads[t], NULL);
+
+		return;
+	}
+
+	doLearningTask(pool -> workers, task); // The calling thread being the worker 0.
+
+	pthread_mutex_lock(&(pool -> mutex));
+
+	while (pool -> pending > 0)
+		pthread_cond_wait(&(pool -> done_cond), &(pool -> mutex));
+
+	pthread_mutex_unlock(&(pool -> mutex));
+}
+
+
+// Loop of the worker threads, waiting for new tasks:
+static void* learningWorkerLoop(void *arg)
+{
+	LearningWorker *worker = (LearningWorker*) arg;
+	LearningPool *pool = worker -> pool;
+
+	int generation = 0;
+
+	while (1)
+	{
+		pthread_mutex_lock(&(pool -> mutex));
+
+		while (pool -> generation == generation)
+			pthread_cond_wait(&(pool -> start_cond), &(pool -> mutex));
+
+		generation = pool -> generation;
+		WorkerTask task = pool -> task;
+
+		pthread_mutex_unlock(&(pool -> mutex));
+
+		if (task == STOP_WORKERS)
+			return NULL;
+
+		doLearningTask(worker, task);
+
+		pthread_mutex_lock(&(pool -> mutex));
+
+		if (--(pool -> pending) == 0)
+			pthread_cond_signal(&(pool -> done_cond));
+
+		pthread_mutex_unlock(&(pool -> mutex));
+	}
+}
+
+
+// Doing the given task on this worker's part of the batch, or of the gradients:
+static void doLearningTask(LearningWorker *worker, WorkerTask task)
+{
+	LearningPool *pool = worker -> pool;
+	NeuralNetwork *network = worker -> network;
+
+	LearningProfile *profile = worker -> index == 0 ? pool -> profile : NULL; // Measured on the calling thread only.
+
+	if (task == COMPUTE_GRADIENTS)
+	{
+		worker -> sum = 0;
+
+		if (worker -> batch_size == 0)
+			return;
+
+		Number **batch_questions = pool -> batch_questions + worker -> batch_offset;
+		Number **batch_good_answers = pool -> batch_good_answers + worker -> batch_offset;
+
+		double start = profileStart(profile);
+
+		const Number *batch_input = batchInput(network, batch_questions, worker -> batch_size, pool -> batch_contiguous,
+			pool -> batch_sparse);
+
+		profileStop(profile, PROF_BATCH_INPUT, 0, start, 0);
+
+		Number *batch_answers = propagation(network, batch_input, worker -> batch_size, profile);
+
+		if (pool -> params -> PrintEstimates)
+		{
+			const int answers_size = network_outputSize(network);
+
+			start = profileStart(profile);
+
+			for (int b = 0; b < worker -> batch_size; ++b)
+				worker -> sum += recog_method(batch_good_answers[b], batch_answers + b * (answers_size + 1),
+					answers_size, pool -> params -> RecogEstimates, VALIDATION);
+
+			profileStop(profile, PROF_ESTIMATES, 0, start, 0);
+		}
+
+		backpropagation(network, batch_good_answers, pool -> params, worker -> batch_size, profile);
+
+		updateGradBufferBatch(network, batch_input, worker -> grad_buffer, worker -> batch_size, profile);
+	}
+
+	else if (task == REDUCE_GRADIENTS)
+	{
+		// Each worker sums a slice of every layer gradients, into the worker 0 buffer:
+
+		Number **grad_buffer = pool -> workers[0].grad_buffer;
+
+		NeuronLayer *layer = network -> Layers;
+
+		for (int l = 0; l < network -> LayersNumber; ++l)
+		{
+			int netLength = (layer -> InputSize + 1) * layer -> NeuronsNumber;
+			int start = (long) netLength * worker -> index / pool -> ThreadNumber;
+			int end = (long) netLength * (worker -> index + 1) / pool -> ThreadNumber;
+
+			for (int w = 1; w < pool -> ThreadNumber; ++w)
+			{
+				if (pool -> workers[w].batch_size > 0)
+					addScal(grad_buffer[l] + start, pool -> workers[w].grad_buffer[l] + start, end - start, 1.);
+			}
+
+			++layer;
+		}
+	}
+}
+
+
+// Parallel equivalent of propagation() + backpropagation() + updateGradBufferBatch() on the whole batch.
+// The gradients are written in the 'grad_buffer' given to createLearningPool(). Returns the learning level estimate sum:
+static int parallelGradients(LearningPool *pool, Number **batch_questions, Number **batch_good_answers, int batch_size,
+	int contiguous, int sparse)
+{
+	pool -> batch_questions = batch_questions;
+	pool -> batch_good_answers = batch_good_answers;
+	pool -> batch_contiguous = contiguous;
+	pool -> batch_sparse = sparse;
+
+	// Splitting the batch. The first workers get one more input if needed, thus the worker 0 is never idle:
+
+	int quotient = batch_size / pool -> ThreadNumber, remainder = batch_size % pool -> ThreadNumber;
+	int batch_offset = 0;
+
+	for (int w = 0; w < pool -> ThreadNumber; ++w)
+	{
+		pool -> workers[w].batch_offset = batch_offset;
+		pool -> workers[w].batch_size = quotient + (w < remainder);
+
+		batch_offset += pool -> workers[w].batch_size;
+	}
+
+	runLearningTask(pool, COMPUTE_GRADIENTS);
+
+	const double start = profileStart(pool -> profile);
+
+	runLearningTask(pool, REDUCE_GRADIENTS);
+
+	profileStop(pool -> profile, PROF_GRADIENTS_REDUCTION, 0, start, 0);
+
+	int sum = 0;
+
+	for (int w = 0; w < pool -> ThreadNumber; ++w)
+		sum += pool -> workers[w].sum;
+
+	return sum;
+}
@@ -5,7 +5,9 @@
 #include "settings.h"
 #include "neural_network.h"
 #include "inputs.h"
+#include "input_stream.h"
 #include "recognition.h"
+#include "half_precision.h"
 
 
 typedef enum {ON_LINE, MINI_BATCHES, FULL_BATCH} BatchMethod;
@@ -18,6 +20,7 @@ typedef enum {NO_SHUFFLE, SHUFFLE} ShuffleMode;
 
 // Tips:
 // ON_LINE is slower than MINI_BATCHES, which performs best when BatchSize >= 16.
+// With ThreadNumber > 1, each thread gets BatchSize / ThreadNumber inputs: bigger batches are then needed.
 // AUTOMATIC_NORMALIZED works better when Init = UNIFORM.
 
 
@@ -33,8 +36,12 @@ typedef struct
 	RecognitionMode RecogEstimates; // ALL_CORRECT by default. This can be changed for better estimates.
 
 	int PrintEstimates;
+	int Profile; // If not 0, the time spent in each learning phase is printed after each epoch. 0 by default.
 	int EpochNumber;
 	int BatchSize;
+	int ThreadNumber; // Each batch is split between this many threads, whose gradients are then summed. 1 by default.
+	Precision ProductsPrecision; // FULL_PRECISION by default. Else the products read 16 bits copies of the nets,
+		// refreshed after each update of the full precision nets. Halves the memory read for the nets.
 	Number BatchSizeMultiplier; // Multiply the batch size by this value after each epoch.
 	Number InitRange; // If Init = BY_RANGE, weights are randomly chosen between -InitRange and InitRange.
 	Number LearningRate;
@@ -67,6 +74,11 @@ void freeParameters(LearningParameters **params);
 void learn(NeuralNetwork *network, Inputs *inputs, LearningParameters *params);
 
 
+// Make the neural network learn the inputs read from the given stream, while using the given parameters.
+// The batches being taken within the stream chunks, their size is bounded by the chunk size:
+void learnStream(NeuralNetwork *network, InputStream *stream, LearningParameters *params);
+
+
 ///////////////////////////////////////////////////////////////////////////////////////
 // Recognition:
 ///////////////////////////////////////////////////////////////////////////////////////
@@ -80,4 +92,9 @@ void validation(NeuralNetwork *network, Inputs *inputs, RecognitionMode recog);
 void prediction(NeuralNetwork *network, Inputs *inputs);
 
 
+// Returns 1 if the given questions, bias column included, have at most 'SPARSE_INPUT_DENSITY' non zero elements,
+// i.e if their batches are worth being gathered as lists of said elements. Stops reading them once found too dense:
+int sparseInputs(const Inputs *inputs);
+
+
 #endif
@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "learning_profile.h"
+
+
+static const char* PhasesNames[] =
+{
+	"shuffle",
+	"stream wait",
+	"batch input",
+	"forward product",
+	"activation",
+	"output error",
+	"backward product",
+	"activation derivative",
+	"gradient product",
+	"gradients reduction",
+	"optimizer",
+	"estimates"
+};
+
+
+// Creates a profile, reset:
+LearningProfile* createLearningProfile(int LayersNumber)
+{
+	LearningProfile *profile = (LearningProfile*) calloc(1, sizeof(LearningProfile));
+
+	if (profile == NULL)
+	{
+		printf("\nNot enough memory for the learning profile.\n\n");
+		exit(EXIT_FAILURE);
+	}
+
+	profile -> LayersNumber = LayersNumber;
+	profile -> Times = (double*) calloc(PROF_PHASES_NUMBER * LayersNumber, sizeof(double));
+	profile -> Flops = (double*) calloc(PROF_PHASES_NUMBER * LayersNumber, sizeof(double));
+
+	if (profile -> Times == NULL || profile -> Flops == NULL)
+	{
+		printf("\nNot enough memory for the learning profile.\n\n");
+		exit(EXIT_FAILURE);
+	}
+
+	resetLearningProfile(profile);
+
+	return profile;
+}
+
+
+// Frees the given profile passed by address, and sets it to NULL.
+void freeLearningProfile(LearningProfile **profile)
+{
+	if (profile == NULL || *profile == NULL)
+		return;
+
+	free((*profile) -> Times);
+	free((*profile) -> Flops);
+	free(*profile);
+	*profile = NULL;
+}
+
+
+// Resets the measures, and starts a new epoch:
+void resetLearningProfile(LearningProfile *profile)
+{
+	memset(profile -> Times, 0, PROF_PHASES_NUMBER * profile -> LayersNumber * sizeof(double));
+	memset(profile -> Flops, 0, PROF_PHASES_NUMBER * profile -> LayersNumber * sizeof(double));
+
+	profile -> Samples = 0;
+	profile -> Start = get_monotonic_time();
+}
+
+
+// Prints the time spent in each phase since the last reset, and the throughputs:
+void printLearningProfile(const LearningProfile *profile, int epoch)
+{
+	const double epoch_time = get_monotonic_time() - profile -> Start;
+
+	printf("\nEpoch °%d profile: %ld samples in %.3f s -> %.0f samples/s\n\n", epoch, profile -> Samples, epoch_time,
+		epoch_time > 0 ? profile -> Samples / epoch_time : 0);
+
+	double measured_time = 0;
+
+	for (int phase = 0; phase < PROF_PHASES_NUMBER; ++phase)
+	{
+		for (int l = 0; l < profile -> LayersNumber; ++l)
+		{
+			const int index = phase * profile -> LayersNumber + l;
+			const double time = profile -> Times[index], flops = profile -> Flops[index];
+
+			if (time == 0)
+				continue;
+
+			measured_time += time;
+
+			char name[64];
+
+			if (phase >= PROF_FORWARD_PRODUCT && phase <= PROF_GRADIENT_PRODUCT && phase != PROF_OUTPUT_ERROR)
+				snprintf(name, sizeof(name), "layer %d %s", l + 1, PhasesNames[phase]);
+			else
+				snprintf(name, sizeof(name), "%s", PhasesNames[phase]);
+
+			printf("   %-32s %8.4f s  %5.1f %%", name, time, 100. * time / epoch_time);
+
+			if (flops > 0)
+				printf("  %7.2f GFLOP/s", 1e-9 * flops / time);
+
+			printf("\n");
+		}
+	}
+
+	printf("   %-32s %8.4f s  %5.1f %%\n", "other", epoch_time - measured_time,
+		100. * (epoch_time - measured_time) / epoch_time);
+}
@@ -0,0 +1,78 @@
+#ifndef LEARNING_PROFILE_H
+#define LEARNING_PROFILE_H
+
+
+#include "settings.h"
+#include "benchmarking.h"
+
+
+// Time spent in each phase of a learning, enabled with 'params -> Profile'. Phases done for each layer are
+// measured per layer, and the products also count their floating point operations.
+// With several threads, the phases done on the batches parts are measured on the calling thread only.
+
+
+typedef enum
+{
+	PROF_SHUFFLE,
+	PROF_STREAM_WAIT,
+	PROF_BATCH_INPUT,
+	PROF_FORWARD_PRODUCT,
+	PROF_ACTIVATION,
+	PROF_OUTPUT_ERROR,
+	PROF_BACKWARD_PRODUCT,
+	PROF_ACTIVATION_DERIVATIVE,
+	PROF_GRADIENT_PRODUCT,
+	PROF_GRADIENTS_REDUCTION,
+	PROF_OPTIMIZER,
+	PROF_ESTIMATES,
+	PROF_PHASES_NUMBER
+} ProfilePhase;
+
+
+typedef struct
+{
+	int LayersNumber;
+	double *Times;	// PROF_PHASES_NUMBER * LayersNumber, in seconds. Phases not done per layer use the layer 0.
+	double *Flops;	// Same layout, for the products.
+	long Samples;	// Number of samples learned.
+	double Start;	// Start of the current epoch.
+} LearningProfile;
+
+
+// Creates a profile, reset:
+LearningProfile* createLearningProfile(int LayersNumber);
+
+
+// Frees the given profile passed by address, and sets it to NULL.
+void freeLearningProfile(LearningProfile **profile);
+
+
+// Resets the measures, and starts a new epoch:
+void resetLearningProfile(LearningProfile *profile);
+
+
+// Prints the time spent in each phase since the last reset, and the throughputs:
+void printLearningProfile(const LearningProfile *profile, int epoch);
+
+
+// Returns the start time of a phase, or 0 if 'profile' is NULL, i.e the profiling is disabled:
+static inline double profileStart(const LearningProfile *profile)
+{
+	return profile != NULL ? get_monotonic_time() : 0;
+}
+
+
+// Adds the time elapsed since 'start' to the given phase, and the given floating point operations:
+static inline void profileStop(LearningProfile *profile, ProfilePhase phase, int layer, double start, double flops)
+{
+	if (profile == NULL)
+		return;
+
+	const int index = phase * profile -> LayersNumber + layer;
+
+	profile -> Times[index] += get_monotonic_time() - start;
+	profile -> Flops[index] += flops;
+}
+
+
+#endif
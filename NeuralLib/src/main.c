@@ -1,14 +1,15 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h> // for srand().
+#include <time.h> // for seeding the RNG.
 
 #include "settings.h"
 #include "testing.h"
+#include "random.h"
 
 
 int main(void)
 {
-	srand(time(NULL)); // Initialization of the pseudo-random number generator.
+	setRandomSeed(time(NULL)); // Initialization of the pseudo-random number generator.
 
 	// Normalization of some inputs:
 	// test_normalize();
@@ -18,10 +19,54 @@ int main(void)
 	// test_Box_Muller();
 
 
+	// Random states check:
+	// test_random_state();
+
+
 	// Shuffle demo:
 	// test_shuffle();
 
 
+	// Built-in matrix product check:
+	// test_matrix_multiply();
+
+
+	// Activation kernels check:
+	// test_activations();
+
+
+	// Single file network saving and mapping:
+	// test_network_file();
+
+
+	// Contiguous inputs check:
+	// test_contiguous_inputs();
+
+
+	// Streamed inputs check:
+	// test_input_stream();
+
+
+	// Int8 quantized inference check:
+	// test_quantization();
+
+
+	// Sparse products check:
+	// test_sparse_products();
+
+
+	// Fused optimizer kernels check:
+	// test_optimizers();
+
+
+	// Mixed precision learning check:
+	// test_mixed_precision();
+
+
+	// Learning profile check:
+	// test_learning_profile();
+
+
 	// 1 layer neural network for the logical gate 'AND':
 	test_AND();
 
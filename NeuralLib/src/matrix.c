@@ -134,8 +134,7 @@ void randomFillVector_uniform(Number *vector, int len, Number bound)
 	if (vector == NULL)
 		return;
 
-	for (int i = 0; i < len; ++i)
-		vector[i] = uniform_random(-bound, bound);
+	uniformRandomFill(defaultRandomState(), vector, len, -bound, bound);
 }
 
 
@@ -154,17 +153,7 @@ void randomFillVector_gaussian(Number *vector, int len, Number std_dev)
 	if (vector == NULL)
 		return;
 
-	for (int i = 0; i < len - 1; i += 2)
-		gaussian_random(vector + i, vector + i + 1, 0, std_dev);
-
-	if (len % 2 == 0)
-		gaussian_random(vector + len - 2, vector + len - 1, 0, std_dev);
-
-	else
-	{
-		Number buffer;
-		gaussian_random(vector + len - 1, &buffer, 0, std_dev); // 'buffer' needed.
-	}
+	gaussianRandomFill(defaultRandomState(), vector, len, 0, std_dev);
 }
 
 
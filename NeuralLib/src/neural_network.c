@@ -1,12 +1,52 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+
+// May be Unix dependant. Used for mapping network files:
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
 #include "neural_network.h"
 #include "matrix.h"
 #include "saving.h"
 
 
+// Single file format:
+
+#define NETWORK_FILE_MAGIC "NeurLib" // 8 bytes, with the '\0'.
+#define NETWORK_FILE_VERSION 1
+#define NETWORK_FILE_ENDIANNESS 0x01020304u // Read differently on a machine of another endianness.
+#define NETWORK_FILE_ALIGNMENT 64 // Cache line size, enough for any SIMD load.
+#define ACTIVATION_NAME_LENGTH 16
+
+
+typedef struct
+{
+	char Magic[8];
+	uint32_t Version;
+	uint32_t Endianness;
+	uint32_t NumberSize;
+	uint32_t InputSize;
+	uint32_t LayersNumber;
+	uint32_t Padding;
+	uint64_t FileSize;
+	uint64_t Checksum; // FNV-1a hash of everything following the header.
+} NetworkFileHeader;
+
+
+// One per layer, following the header:
+typedef struct
+{
+	uint32_t NeuronsNumber;
+	char Activation[ACTIVATION_NAME_LENGTH];
+	uint32_t Padding;
+	uint64_t NetOffset; // From the start of the file.
+} NetworkFileLayer;
+
+
 static const char* LearningStateAnswer[] = {"no", "yes"};
 
 
@@ -19,6 +59,8 @@ static void initLayer(NeuronLayer *layer, int InputSize, int NeuronsNumber, Acti
 
 	layer -> Input = NULL; // Pointer to the previous output if not the first layer.
 	layer -> Net = createVector((InputSize + 1) * NeuronsNumber);
+	layer -> HalfNet = NULL;
+	layer -> HalfFormat = FULL_PRECISION;
 	layer -> Sum = createVector(MaxBatchSize * NeuronsNumber);
 	layer -> GradSum = createVector(MaxBatchSize * NeuronsNumber);
 	layer -> Output = createVector(MaxBatchSize * (NeuronsNumber + 1));
@@ -54,6 +96,20 @@ NeuralNetwork* createNetwork(int InputSize, int LayersNumber, int *NeuronsNumber
 	for (int b = 0; b < MaxBatchSize; ++b) // MaxBatchSize needed, for validation/prediction optimizations!
 		layer -> Input[b * (layer -> InputSize + 1) + layer -> InputSize] = 1;
 
+	// Lists of the non zero elements of sparse batches. Denser batches are not gathered, but the elements
+	// of their last read question may be written past said density, one question at most:
+
+	const long sparse_capacity = (long) (SPARSE_INPUT_DENSITY * MaxBatchSize * (InputSize + 1)) + InputSize + 1;
+
+	network -> SparseBatch = 0;
+	network -> SparseRowStart = (int*) calloc(MaxBatchSize + 1, sizeof(int));
+	network -> SparseIndices = (int*) calloc(sparse_capacity, sizeof(int));
+	network -> SparseValues = createVector(sparse_capacity);
+
+	network -> SparseColStart = (int*) calloc(InputSize + 2, sizeof(int));
+	network -> SparseColRows = (int*) calloc(sparse_capacity, sizeof(int));
+	network -> SparseColValues = createVector(sparse_capacity);
+
 	// Initializing the other layers:
 
 	for (int l = 1; l < LayersNumber; ++l)
@@ -79,10 +135,19 @@ void freeNetwork(NeuralNetwork **network)
 
 	free(layer -> Input); // freeing the first input.
 
+	free((*network) -> SparseRowStart);
+	free((*network) -> SparseIndices);
+	free((*network) -> SparseValues);
+	free((*network) -> SparseColStart);
+	free((*network) -> SparseColRows);
+	free((*network) -> SparseColValues);
+
 	for (int l = 0; l < (*network) -> LayersNumber; ++l)
 	{
 		// Useless to free from memory 'layer -> Input' has it is only pointing to addresses.
-		free(layer -> Net);
+		if ((*network) -> Mapping == NULL) // Else the nets belong to the mapping.
+			free(layer -> Net);
+
 		free(layer -> Sum);
 		free(layer -> GradSum);
 		free(layer -> Output);
@@ -90,12 +155,69 @@ void freeNetwork(NeuralNetwork **network)
 		++layer;
 	}
 
+	if ((*network) -> Mapping != NULL)
+		munmap((*network) -> Mapping, (*network) -> MappingSize);
+
 	free((*network) -> Layers);
 	free(*network);
 	*network = NULL;
 }
 
 
+// Creates a network sharing the nets of the given one, but owning its own computation buffers.
+// Useful for running several propagations of the same network in parallel. Free it with freeNetworkReplica().
+NeuralNetwork* createNetworkReplica(const NeuralNetwork *network, int MaxBatchSize)
+{
+	if (network == NULL)
+	{
+		printf("\nCannot replicate a NULL network.\n\n");
+		exit(EXIT_FAILURE);
+	}
+
+	int *NeuronsNumberArray = (int*) calloc(network -> LayersNumber, sizeof(int));
+	Activation *funArray = (Activation*) calloc(network -> LayersNumber, sizeof(Activation));
+
+	for (int l = 0; l < network -> LayersNumber; ++l)
+	{
+		NeuronsNumberArray[l] = network -> Layers[l].NeuronsNumber;
+		funArray[l] = network -> Layers[l].Fun;
+	}
+
+	NeuralNetwork *replica = createNetwork(network_inputSize(network), network -> LayersNumber,
+		NeuronsNumberArray, funArray, MaxBatchSize);
+
+	free(NeuronsNumberArray);
+	free(funArray);
+
+	replica -> HasLearned = network -> HasLearned;
+
+	// Sharing the nets:
+
+	for (int l = 0; l < network -> LayersNumber; ++l)
+	{
+		free(replica -> Layers[l].Net);
+		replica -> Layers[l].Net = network -> Layers[l].Net;
+		replica -> Layers[l].HalfNet = network -> Layers[l].HalfNet;
+		replica -> Layers[l].HalfFormat = network -> Layers[l].HalfFormat;
+	}
+
+	return replica;
+}
+
+
+// Frees the given replica passed by address, but not the shared nets, and sets it to NULL.
+void freeNetworkReplica(NeuralNetwork **replica)
+{
+	if (replica == NULL || *replica == NULL)
+		return;
+
+	for (int l = 0; l < (*replica) -> LayersNumber; ++l)
+		(*replica) -> Layers[l].Net = NULL; // Not owned.
+
+	freeNetwork(replica);
+}
+
+
 int network_inputSize(const NeuralNetwork *network)
 {
 	if (network == NULL)
@@ -339,3 +461,270 @@ NeuralNetwork* loadNetwork(const char *foldername, int MaxBatchSize)
 
 	return network;
 }
+
+
+static inline uint64_t alignOffset(uint64_t offset)
+{
+	return (offset + NETWORK_FILE_ALIGNMENT - 1) / NETWORK_FILE_ALIGNMENT * NETWORK_FILE_ALIGNMENT;
+}
+
+
+// FNV-1a 64 bits hash:
+static uint64_t checksum(const unsigned char *data, uint64_t len)
+{
+	uint64_t hash = 14695981039346656037ULL;
+
+	for (uint64_t i = 0; i < len; ++i)
+	{
+		hash ^= data[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+
+// Saving a neural network in a single binary file: a header (Number size, endianness, layers sizes and activations,
+// checksum) followed by the nets, each aligned on 64 bytes. Returns 1 on success, 0 else.
+int saveNetworkFile(const NeuralNetwork *network, const char *filename)
+{
+	if (network == NULL)
+	{
+		printf("\nCannot save a NULL network.\n\n");
+		return 0;
+	}
+
+	if (filename == NULL)
+	{
+		printf("\nNULL filename.\n\n");
+		return 0;
+	}
+
+	if (network -> HasLearned != 1)
+	{
+		printf("\nNo learning has been done, there is nothing so save.\n\n");
+		return 0;
+	}
+
+	const int layers_number = network -> LayersNumber;
+
+	// Placing the nets:
+
+	uint64_t offset = alignOffset(sizeof(NetworkFileHeader) + layers_number * sizeof(NetworkFileLayer));
+
+	uint64_t *net_offsets = (uint64_t*) calloc(layers_number, sizeof(uint64_t));
+
+	for (int l = 0; l < layers_number; ++l)
+	{
+		const NeuronLayer *layer = network -> Layers + l;
+
+		net_offsets[l] = offset;
+		offset = alignOffset(offset + sizeof(Number) * (layer -> InputSize + 1) * layer -> NeuronsNumber);
+	}
+
+	const uint64_t file_size = offset;
+
+	// Filling the whole file in memory, padding included:
+
+	unsigned char *buffer = (unsigned char*) calloc(file_size, 1);
+
+	if (buffer == NULL)
+	{
+		printf("\nNot enough memory to save the network in '%s'.\n\n", filename);
+		free(net_offsets);
+		return 0;
+	}
+
+	NetworkFileLayer *file_layers = (NetworkFileLayer*) (buffer + sizeof(NetworkFileHeader));
+
+	for (int l = 0; l < layers_number; ++l)
+	{
+		const NeuronLayer *layer = network -> Layers + l;
+
+		file_layers[l].NeuronsNumber = layer -> NeuronsNumber;
+		file_layers[l].NetOffset = net_offsets[l];
+		snprintf(file_layers[l].Activation, ACTIVATION_NAME_LENGTH, "%s", getActivationString(layer -> Fun));
+
+		memcpy(buffer + net_offsets[l], layer -> Net, sizeof(Number) * (layer -> InputSize + 1) * layer -> NeuronsNumber);
+	}
+
+	NetworkFileHeader header =
+	{
+		.Magic = NETWORK_FILE_MAGIC,
+		.Version = NETWORK_FILE_VERSION,
+		.Endianness = NETWORK_FILE_ENDIANNESS,
+		.NumberSize = sizeof(Number),
+		.InputSize = network_inputSize(network),
+		.LayersNumber = layers_number,
+		.FileSize = file_size,
+		.Checksum = checksum(buffer + sizeof(NetworkFileHeader), file_size - sizeof(NetworkFileHeader))
+	};
+
+	memcpy(buffer, &header, sizeof(NetworkFileHeader));
+
+	free(net_offsets);
+
+	// Writing a temporary file first, then renaming it: programs having mapped the previous file are not affected.
+
+	char tmp_filename[MAX_PATH_LENGTH];
+	snprintf(tmp_filename, MAX_PATH_LENGTH, "%s.tmp", filename);
+
+	FILE *file = fopen(tmp_filename, "wb");
+
+	if (file == NULL)
+	{
+		printf("\nCannot create the file '%s'.\n\n", tmp_filename);
+		free(buffer);
+		return 0;
+	}
+
+	const int write_success = fwrite(buffer, 1, file_size, file) == file_size;
+
+	free(buffer);
+
+	if (fclose(file) != 0 || !write_success || !moveFile(filename, tmp_filename))
+	{
+		printf("\nCannot write the file '%s'.\n\n", filename);
+		return 0;
+	}
+
+	printf("\nThe given neural network has been successfully saved in '%s'.\n\n", filename);
+
+	return 1;
+}
+
+
+// Returns NULL if the given mapped network file is valid, or the reason why it is not:
+static const char* checkNetworkFile(const unsigned char *mapping, uint64_t mapping_size)
+{
+	const NetworkFileHeader *header = (const NetworkFileHeader*) mapping;
+
+	if (mapping_size < sizeof(NetworkFileHeader) || memcmp(header -> Magic, NETWORK_FILE_MAGIC, 8) != 0)
+		return "not a network file";
+
+	if (header -> Endianness != NETWORK_FILE_ENDIANNESS)
+		return "saved on a machine of different endianness";
+
+	if (header -> Version != NETWORK_FILE_VERSION)
+		return "unsupported version";
+
+	if (header -> NumberSize != sizeof(Number))
+		return "incompatible 'Number' size";
+
+	if (header -> FileSize != mapping_size)
+		return "truncated file";
+
+	if (header -> LayersNumber == 0 || header -> InputSize == 0 ||
+		sizeof(NetworkFileHeader) + header -> LayersNumber * sizeof(NetworkFileLayer) > mapping_size)
+	{
+		return "invalid layers";
+	}
+
+	const NetworkFileLayer *file_layers = (const NetworkFileLayer*) (mapping + sizeof(NetworkFileHeader));
+
+	uint64_t input_size = header -> InputSize;
+
+	for (uint32_t l = 0; l < header -> LayersNumber; ++l)
+	{
+		const uint64_t net_size = sizeof(Number) * (input_size + 1) * file_layers[l].NeuronsNumber;
+
+		if (file_layers[l].NeuronsNumber == 0 || file_layers[l].NetOffset % NETWORK_FILE_ALIGNMENT != 0 ||
+			file_layers[l].NetOffset + net_size > mapping_size ||
+			memchr(file_layers[l].Activation, '\0', ACTIVATION_NAME_LENGTH) == NULL)
+		{
+			return "invalid layers";
+		}
+
+		input_size = file_layers[l].NeuronsNumber;
+	}
+
+	if (checksum(mapping + sizeof(NetworkFileHeader), mapping_size - sizeof(NetworkFileHeader)) != header -> Checksum)
+		return "wrong checksum";
+
+	return NULL;
+}
+
+
+// Loading a neural network saved by saveNetworkFile(), without copying its nets: they point straight into
+// a private mapping of the file. The network can still learn, modified pages being copied on write.
+// Returns NULL on failure.
+NeuralNetwork* mapNetworkFile(const char *filename, int MaxBatchSize)
+{
+	if (filename == NULL)
+	{
+		printf("\nNULL filename.\n\n");
+		return NULL;
+	}
+
+	int fd = open(filename, O_RDONLY);
+
+	if (fd < 0)
+	{
+		printf("\nCannot find the file '%s'.\n\n", filename);
+		return NULL;
+	}
+
+	struct stat st;
+
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		printf("\nCannot read the file '%s'.\n\n", filename);
+		close(fd);
+		return NULL;
+	}
+
+	void *mapping = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+	close(fd); // The mapping stays valid.
+
+	if (mapping == MAP_FAILED)
+	{
+		printf("\nCannot map the file '%s'.\n\n", filename);
+		return NULL;
+	}
+
+	const char *error = checkNetworkFile((const unsigned char*) mapping, st.st_size);
+
+	if (error != NULL)
+	{
+		printf("\nCannot load the network file '%s': %s.\n\n", filename, error);
+		munmap(mapping, st.st_size);
+		return NULL;
+	}
+
+	const NetworkFileHeader *header = (const NetworkFileHeader*) mapping;
+	const NetworkFileLayer *file_layers = (const NetworkFileLayer*) ((char*) mapping + sizeof(NetworkFileHeader));
+
+	const int layers_number = header -> LayersNumber;
+
+	int *NeuronsNumberArray = (int*) calloc(layers_number, sizeof(int));
+	Activation *funArray = (Activation*) calloc(layers_number, sizeof(Activation));
+
+	for (int l = 0; l < layers_number; ++l)
+	{
+		NeuronsNumberArray[l] = file_layers[l].NeuronsNumber;
+		funArray[l] = getActivation(file_layers[l].Activation);
+	}
+
+	NeuralNetwork *network = createNetwork(header -> InputSize, layers_number, NeuronsNumberArray, funArray, MaxBatchSize);
+
+	free(NeuronsNumberArray);
+	free(funArray);
+
+	network -> HasLearned = 1; // The network would not have been saved if it had not learned a thing.
+
+	// Pointing the nets into the mapping:
+
+	for (int l = 0; l < layers_number; ++l)
+	{
+		free(network -> Layers[l].Net);
+		network -> Layers[l].Net = (Number*) ((char*) mapping + file_layers[l].NetOffset);
+	}
+
+	network -> Mapping = mapping;
+	network -> MappingSize = st.st_size;
+
+	printf("\nThe given neural network has been successfully mapped from '%s'.\n\n", filename);
+
+	return network;
+}
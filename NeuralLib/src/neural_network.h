@@ -4,6 +4,7 @@
 
 #include "settings.h"
 #include "activation.h"
+#include "half_precision.h"
 
 
 typedef struct
@@ -14,18 +15,38 @@ typedef struct
 
 	Number *Input;		// Pointer to the previous output if not the first layer.
 	Number *Net;		// (InputSize + 1) * NeuronsNumber (last row: biases, other rows: weights)
+	Half *HalfNet;		// NULL, or a copy of 'Net' in the 'HalfFormat' 16 bits format, used by the products of
+	Precision HalfFormat;	// a mixed precision learning.
 	Number *Sum;		// MaxBatchSize * NeuronsNumber
 	Number *GradSum;	// MaxBatchSize * NeuronsNumber
 	Number *Output;		// MaxBatchSize * (NeuronsNumber + 1)
 } NeuronLayer;
 
 
+// Batches whose first layer input has at most this rate of non zero elements are propagated and learned from the
+// lists of said elements, the first layer cost then being proportional to their number. 0 disables it:
+#define SPARSE_INPUT_DENSITY 0.2
+
+
 typedef struct
 {
 	int HasLearned;
 	const int LayersNumber;
 	const int MaxBatchSize; // The greater MaxBatchSize is, the faster the computations may be.
 	NeuronLayer *Layers;	// size: LayersNumber
+	void *Mapping;			// Non NULL if the nets point into a mapped network file.
+	long int MappingSize;
+
+	// Non zero elements of the current batch first layer input, bias column included, if 'SparseBatch' is 1:
+	int SparseBatch;
+	int *SparseRowStart;	// MaxBatchSize + 1, the elements of the question b being at [SparseRowStart[b], SparseRowStart[b + 1]).
+	int *SparseIndices;		// SPARSE_INPUT_DENSITY * MaxBatchSize * (InputSize + 1) + InputSize + 1
+	Number *SparseValues;	// Same size.
+
+	// Scratch buffers of the first layer gradient product, grouping said elements by column:
+	int *SparseColStart;		// InputSize + 2
+	int *SparseColRows;			// Same size as 'SparseIndices'.
+	Number *SparseColValues;	// Same size as 'SparseIndices'.
 } NeuralNetwork;
 
 
@@ -37,6 +58,15 @@ NeuralNetwork* createNetwork(int InputSize, int LayersNumber, int *NeuronsNumber
 void freeNetwork(NeuralNetwork **network);
 
 
+// Creates a network sharing the nets of the given one, but owning its own computation buffers.
+// Useful for running several propagations of the same network in parallel. Free it with freeNetworkReplica().
+NeuralNetwork* createNetworkReplica(const NeuralNetwork *network, int MaxBatchSize);
+
+
+// Frees the given replica passed by address, but not the shared nets, and sets it to NULL.
+void freeNetworkReplica(NeuralNetwork **replica);
+
+
 int network_inputSize(const NeuralNetwork *network);
 
 
@@ -58,4 +88,15 @@ int saveNetwork(const NeuralNetwork *network, const char *foldername);
 NeuralNetwork* loadNetwork(const char *foldername, int MaxBatchSize);
 
 
+// Saving a neural network in a single binary file: a header (Number size, endianness, layers sizes and activations,
+// checksum) followed by the nets, each aligned on 'NETWORK_FILE_ALIGNMENT' bytes. Returns 1 on success, 0 else.
+int saveNetworkFile(const NeuralNetwork *network, const char *filename);
+
+
+// Loading a neural network saved by saveNetworkFile(), without copying its nets: they point straight into
+// a private mapping of the file. The network can still learn, modified pages being copied on write.
+// Returns NULL on failure.
+NeuralNetwork* mapNetworkFile(const char *filename, int MaxBatchSize);
+
+
 #endif
@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "optimizers.h"
+#include "simd.h"
+
+
+// The last 'len % VEC_SIZE' elements are updated by the scalar versions of the kernels.
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Kernels:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+// net = decay * net - rate * grad
+void sgdStep(Number *net, const Number *grad, long len, Number decay, Number rate)
+{
+	const Vec Decay = vec_set1(decay), MinusRate = vec_set1(-rate);
+
+	long i = 0;
+
+	for (; i + VEC_SIZE <= len; i += VEC_SIZE)
+		vec_store(net + i, vec_fma(MinusRate, vec_load(grad + i), vec_mul(Decay, vec_load(net + i))));
+
+	for (; i < len; ++i)
+		net[i] = decay * net[i] - rate * grad[i];
+}
+
+
+// M = momentum * M + rate * grad
+// net = decay * net - M
+void momentumStep(Number *net, const Number *grad, Number *M, long len, Number decay, Number rate, Number momentum)
+{
+	const Vec Decay = vec_set1(decay), Rate = vec_set1(rate), Momentum = vec_set1(momentum);
+
+	long i = 0;
+
+	for (; i + VEC_SIZE <= len; i += VEC_SIZE)
+	{
+		const Vec m = vec_fma(Momentum, vec_load(M + i), vec_mul(Rate, vec_load(grad + i)));
+
+		vec_store(M + i, m);
+		vec_store(net + i, vec_sub(vec_mul(Decay, vec_load(net + i)), m));
+	}
+
+	for (; i < len; ++i)
+	{
+		M[i] = momentum * M[i] + rate * grad[i];
+		net[i] = decay * net[i] - M[i];
+	}
+}
+
+
+// V = coeff * V + (1 - coeff) * grad^2
+// net = decay * net - rate * grad / (sqrt(V) + EPSILON)
+void rmspropStep(Number *net, const Number *grad, Number *V, long len, Number decay, Number rate, Number coeff)
+{
+	const Number coeff_conj = 1 - coeff;
+
+	const Vec Decay = vec_set1(decay), MinusRate = vec_set1(-rate), Coeff = vec_set1(coeff),
+		CoeffConj = vec_set1(coeff_conj), Eps = vec_set1(EPSILON);
+
+	long i = 0;
+
+	for (; i + VEC_SIZE <= len; i += VEC_SIZE)
+	{
+		const Vec g = vec_load(grad + i);
+		const Vec v = vec_fma(Coeff, vec_load(V + i), vec_mul(CoeffConj, vec_mul(g, g)));
+
+		vec_store(V + i, v);
+		vec_store(net + i, vec_fma(MinusRate, vec_div(g, vec_add(vec_sqrt(v), Eps)), vec_mul(Decay, vec_load(net + i))));
+	}
+
+	for (; i < len; ++i)
+	{
+		V[i] = coeff * V[i] + coeff_conj * grad[i] * grad[i];
+		net[i] = decay * net[i] - rate * grad[i] / (number_sqrt(V[i]) + EPSILON);
+	}
+}
+
+
+// M = betaM * M + (1 - betaM) * grad
+// V = betaV * V + (1 - betaV) * grad^2
+// net = decay * net - rate * M / (sqrt(V) + EPSILON), 'rate' including the bias corrections.
+void adamStep(Number *net, const Number *grad, Number *M, Number *V, long len, Number decay, Number rate,
+	Number betaM, Number betaV)
+{
+	const Number betaM_conj = 1 - betaM, betaV_conj = 1 - betaV;
+
+	const Vec Decay = vec_set1(decay), MinusRate = vec_set1(-rate), BetaM = vec_set1(betaM), BetaV = vec_set1(betaV),
+		BetaMConj = vec_set1(betaM_conj), BetaVConj = vec_set1(betaV_conj), Eps = vec_set1(EPSILON);
+
+	long i = 0;
+
+	for (; i + VEC_SIZE <= len; i += VEC_SIZE)
+	{
+		const Vec g = vec_load(grad + i);
+		const Vec m = vec_fma(BetaM, vec_load(M + i), vec_mul(BetaMConj, g));
+		const Vec v = vec_fma(BetaV, vec_load(V + i), vec_mul(BetaVConj, vec_mul(g, g)));
+
+		vec_store(M + i, m);
+		vec_store(V + i, v);
+		vec_store(net + i, vec_fma(MinusRate, vec_div(m, vec_add(vec_sqrt(v), Eps)), vec_mul(Decay, vec_load(net + i))));
+	}
+
+	for (; i < len; ++i)
+	{
+		M[i] = betaM * M[i] + betaM_conj * grad[i];
+		V[i] = betaV * V[i] + betaV_conj * grad[i] * grad[i];
+		net[i] = decay * net[i] - rate * M[i] / (number_sqrt(V[i]) + EPSILON);
+	}
+}
+
+
+// Returns the name of the instruction set used by the kernels:
+const char* optimizers_simdName(void)
+{
+	return SIMD_NAME;
+}
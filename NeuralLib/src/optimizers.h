@@ -0,0 +1,38 @@
+#ifndef OPTIMIZERS_H
+#define OPTIMIZERS_H
+
+
+#include "settings.h"
+
+
+// Fused update kernels of the optimizers: each one applies the weight decay, the moments update and the step
+// in a single pass over its buffers, vectorized with the instruction set of simd.h.
+// 'decay' multiplies the nets before the step: 1 - L2regCoeff for the weights, 1 for the biases.
+
+
+// net = decay * net - rate * grad
+void sgdStep(Number *net, const Number *grad, long len, Number decay, Number rate);
+
+
+// M = momentum * M + rate * grad
+// net = decay * net - M
+void momentumStep(Number *net, const Number *grad, Number *M, long len, Number decay, Number rate, Number momentum);
+
+
+// V = coeff * V + (1 - coeff) * grad^2
+// net = decay * net - rate * grad / (sqrt(V) + EPSILON)
+void rmspropStep(Number *net, const Number *grad, Number *V, long len, Number decay, Number rate, Number coeff);
+
+
+// M = betaM * M + (1 - betaM) * grad
+// V = betaV * V + (1 - betaV) * grad^2
+// net = decay * net - rate * M / (sqrt(V) + EPSILON), 'rate' including the bias corrections.
+void adamStep(Number *net, const Number *grad, Number *M, Number *V, long len, Number decay, Number rate,
+	Number betaM, Number betaV);
+
+
+// Returns the name of the instruction set used by the kernels:
+const char* optimizers_simdName(void);
+
+
+#endif
@@ -0,0 +1,965 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "quantization.h"
+#include "matrix.h"
+#include "learning.h"
+#include "recognition.h"
+#include "simd.h"
+
+
+// Compile time selection of the int8 products, from the compiler flags (e.g '-march=native'):
+// AVX512-VNNI: u8 x s8 products of 4 consecutive inputs summed in int32 by a single instruction (vpdpbusd),
+// for 16 neurons at once: thanks to the interleaved weights, no horizontal sum is needed.
+// AVX2: bytes widened to int16, then multiplied and summed pairwise in int32 (vpmaddwd). pmaddubsw is not used,
+// for its int16 saturation would be reached by 255 x 127 x 2.
+#if defined __AVX512F__ && defined __AVX512VNNI__
+	#include <immintrin.h>
+	#define QUANT_SIMD_NAME "AVX512-VNNI"
+#elif defined __AVX2__
+	#include <immintrin.h>
+	#define QUANT_SIMD_NAME "AVX2"
+#else
+	#define QUANT_SIMD_NAME "None"
+#endif
+
+
+// Offset of the unsigned quantized inputs:
+#define QUANT_INPUT_OFFSET 128
+
+#define QUANT_MAX 127
+
+// Number of question elements tested at once while gathering the non zero ones, for skipping the null groups:
+#define QUANT_SCAN_GROUP 8
+
+// Number of groups of QUANT_NEURONS_GROUP neurons whose sparse products are computed at once, each with its
+// accumulator(s) kept in registers: AVX-512 has 32 of them, AVX2 16.
+#if defined __AVX512F__ && defined __AVX512VNNI__
+	#define QUANT_SPARSE_GROUPS 16
+#else
+	#define QUANT_SPARSE_GROUPS 4
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Prototypes of static functions:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+// Allocates the computation buffers of a quantized network, whose layers sizes are already set:
+static void allocQuantizedBuffers(QuantizedNetwork *qnet);
+
+
+// Frees the computation buffers of a quantized network:
+static void freeQuantizedBuffers(QuantizedNetwork *qnet);
+
+
+// Quantizes a row of 'len' Numbers in unsigned bytes, q + QUANT_INPUT_OFFSET with q = round(x / scale) in
+// [-QUANT_MAX, QUANT_MAX]. The padding up to 'padded_len' is set to the offset, i.e 0. Returns the scale.
+static float quantizeRow(uint8_t *dest, const Number *src, int len, int padded_len);
+
+
+// Int32 products of QUANT_ROWS_GROUP rows of quantized inputs with QUANT_NEURONS_GROUP neurons of interleaved weights,
+// each row of 'results' being QUANT_NEURONS_GROUP long:
+static void productsBlock(int32_t *results, const uint8_t *input, const int8_t *weights, int padded_input_size,
+	int padded_neurons_number);
+
+
+// sum[j] = (input + offset) . w[j] - offset * sum(w[j]), scaled back, for the 'len' neurons starting at 'j0':
+static inline void scaleResults(Number *sum_row, const int32_t *result_row, const QuantizedLayer *qlayer, int b, int j0,
+	int len);
+
+
+// Same as scaleResults(), for the products of sparse questions, which have no offset:
+static inline void scaleSparseResults(Number *restrict sum_row, const int32_t *restrict result_row,
+	const QuantizedLayer *qlayer, int b, int j0, int len);
+
+
+// Fills the network sparse lists with the non zero elements of the given questions, quantized like quantizeRow() does,
+// their scales being written in the first layer 'InputScales'. Returns 0, the lists being then unused, if the
+// questions have more than 'SPARSE_INPUT_DENSITY' non zero elements, bias column included:
+static int gatherSparseQuestions(QuantizedNetwork *qnet, Number *const *batch_questions, int batch_size);
+
+
+// Int32 products of the sparse elements [start, end) with 'groups' (at most QUANT_SPARSE_GROUPS) groups of
+// QUANT_NEURONS_GROUP neurons of interleaved weights, whose stride between groups of inputs is 'weights_stride',
+// 'results' being 'groups * QUANT_NEURONS_GROUP' long:
+static inline void sparseProductsGroups(int32_t *results, const int *indices, const int8_t *values, int start, int end,
+	const int8_t *weights, int weights_stride, int groups);
+
+
+// First layer sums of the questions gathered by gatherSparseQuestions(), which only read the weights of their
+// non zero elements:
+static void sparseProducts(QuantizedNetwork *qnet, int batch_size);
+
+
+// Sums of the given layer, whose input, i.e the questions or the previous output, is quantized then multiplied by blocks:
+static void denseProducts(QuantizedNetwork *qnet, int layer_index, Number *const *batch_questions, int batch_size);
+
+
+// Propagation of the 'batch_size' first questions, returns the output of the last layer. 'sparse' is the value
+// of sparseInputs() on the questions:
+static const Number* quantizedPropagation(QuantizedNetwork *qnet, Number *const *batch_questions, int batch_size,
+	int sparse);
+
+
+// Returns 1 if the 'top_k' most probable classes of both answers are the same, regardless of their order:
+static int sameGreaterValues(int *buffer_1, int *buffer_2, int top_k, const Number *answer_1, const Number *answer_2,
+	int len);
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Quantized network:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+// Creates the int8 copy of the given network. The latter is not needed afterwards:
+QuantizedNetwork* quantizeNetwork(const NeuralNetwork *network, int MaxBatchSize)
+{
+	if (network == NULL)
+	{
+		printf("\nCannot quantize a NULL network.\n\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (MaxBatchSize <= 0)
+	{
+		printf("\nMaxBatchSize must be positive.\n\n");
+		exit(EXIT_FAILURE);
+	}
+
+	QuantizedNetwork *qnet = (QuantizedNetwork*) calloc(1, sizeof(QuantizedNetwork));
+
+	*(int*) &(qnet -> LayersNumber) = network -> LayersNumber;
+	*(int*) &(qnet -> MaxBatchSize) = MaxBatchSize;
+	*(int*) &(qnet -> PaddedBatchSize) = (MaxBatchSize + QUANT_ROWS_GROUP - 1) / QUANT_ROWS_GROUP * QUANT_ROWS_GROUP;
+
+	qnet -> Layers = (QuantizedLayer*) calloc(network -> LayersNumber, sizeof(QuantizedLayer));
+
+	for (int l = 0; l < network -> LayersNumber; ++l)
+	{
+		const NeuronLayer *layer = network -> Layers + l;
+		QuantizedLayer *qlayer = qnet -> Layers + l;
+
+		const int input_size = layer -> InputSize, neurons_number = layer -> NeuronsNumber;
+		const int padded_input_size = (input_size + QUANT_INPUTS_GROUP - 1) / QUANT_INPUTS_GROUP * QUANT_INPUTS_GROUP;
+		const int padded_neurons_number = (neurons_number + QUANT_NEURONS_GROUP - 1) / QUANT_NEURONS_GROUP * QUANT_NEURONS_GROUP;
+
+		*(int*) &(qlayer -> InputSize) = input_size;
+		*(int*) &(qlayer -> NeuronsNumber) = neurons_number;
+		*(int*) &(qlayer -> PaddedInputSize) = padded_input_size;
+		*(int*) &(qlayer -> PaddedNeuronsNumber) = padded_neurons_number;
+		qlayer -> Fun = layer -> Fun;
+
+		qlayer -> Weights = (int8_t*) calloc((long) padded_input_size * padded_neurons_number, sizeof(int8_t));
+		qlayer -> Scales = (float*) calloc(padded_neurons_number, sizeof(float));
+		qlayer -> WeightsSums = (int32_t*) calloc(padded_neurons_number, sizeof(int32_t));
+		qlayer -> Biases = createVector(neurons_number);
+
+		// The nets store one column per neuron, whose weights are interleaved by groups of QUANT_INPUTS_GROUP:
+
+		for (int j = 0; j < neurons_number; ++j)
+		{
+			Number max_abs = 0;
+
+			for (int i = 0; i < input_size; ++i)
+				max_abs = number_max(max_abs, number_abs(layer -> Net[i * neurons_number + j]));
+
+			const float scale = max_abs > 0 ? max_abs / QUANT_MAX : 1.f;
+
+			int32_t sum = 0;
+
+			for (int i = 0; i < input_size; ++i)
+			{
+				const long index = ((long) (i / QUANT_INPUTS_GROUP) * padded_neurons_number + j) * QUANT_INPUTS_GROUP
+					+ i % QUANT_INPUTS_GROUP;
+
+				qlayer -> Weights[index] = (int8_t) lrintf(layer -> Net[i * neurons_number + j] / scale);
+				sum += qlayer -> Weights[index];
+			}
+
+			qlayer -> Scales[j] = scale;
+			qlayer -> WeightsSums[j] = sum;
+			qlayer -> Biases[j] = layer -> Net[input_size * neurons_number + j];
+		}
+	}
+
+	allocQuantizedBuffers(qnet);
+
+	return qnet;
+}
+
+
+// Frees the given quantized network passed by address, and sets it to NULL.
+void freeQuantizedNetwork(QuantizedNetwork **qnet)
+{
+	if (qnet == NULL || *qnet == NULL)
+		return;
+
+	for (int l = 0; l < (*qnet) -> LayersNumber; ++l)
+	{
+		QuantizedLayer *qlayer = (*qnet) -> Layers + l;
+
+		free(qlayer -> Weights);
+		free(qlayer -> Scales);
+		free(qlayer -> WeightsSums);
+		freeVector(&(qlayer -> Biases));
+	}
+
+	freeQuantizedBuffers(*qnet);
+
+	free((*qnet) -> Layers);
+	free(*qnet);
+	*qnet = NULL;
+}
+
+
+// Creates a quantized network sharing the weights of the given one, but owning its own computation buffers.
+// Useful for running several propagations of the same network in parallel. Free it with freeQuantizedReplica().
+QuantizedNetwork* createQuantizedReplica(const QuantizedNetwork *qnet, int MaxBatchSize)
+{
+	if (qnet == NULL)
+	{
+		printf("\nCannot replicate a NULL quantized network.\n\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (MaxBatchSize <= 0)
+	{
+		printf("\nMaxBatchSize must be positive.\n\n");
+		exit(EXIT_FAILURE);
+	}
+
+	QuantizedNetwork *replica = (QuantizedNetwork*) calloc(1, sizeof(QuantizedNetwork));
+
+	*(int*) &(replica -> LayersNumber) = qnet -> LayersNumber;
+	*(int*) &(replica -> MaxBatchSize) = MaxBatchSize;
+	*(int*) &(replica -> PaddedBatchSize) = (MaxBatchSize + QUANT_ROWS_GROUP - 1) / QUANT_ROWS_GROUP * QUANT_ROWS_GROUP;
+
+	replica -> Layers = (QuantizedLayer*) calloc(qnet -> LayersNumber, sizeof(QuantizedLayer));
+
+	memcpy(replica -> Layers, qnet -> Layers, qnet -> LayersNumber * sizeof(QuantizedLayer)); // Sharing the weights.
+
+	allocQuantizedBuffers(replica);
+
+	return replica;
+}
+
+
+// Frees the given replica passed by address, but not the shared weights, and sets it to NULL.
+void freeQuantizedReplica(QuantizedNetwork **replica)
+{
+	if (replica == NULL || *replica == NULL)
+		return;
+
+	freeQuantizedBuffers(*replica);
+
+	free((*replica) -> Layers);
+	free(*replica);
+	*replica = NULL;
+}
+
+
+// Returns the size in bytes of the quantized weights, scales and biases:
+long int quantizedNetworkSize(const QuantizedNetwork *qnet)
+{
+	if (qnet == NULL)
+		return 0;
+
+	long int size = 0;
+
+	for (int l = 0; l < qnet -> LayersNumber; ++l)
+	{
+		const QuantizedLayer *qlayer = qnet -> Layers + l;
+
+		size += (long) qlayer -> PaddedNeuronsNumber * (qlayer -> PaddedInputSize * sizeof(int8_t) + sizeof(float) + sizeof(int32_t));
+		size += qlayer -> NeuronsNumber * sizeof(Number);
+	}
+
+	return size;
+}
+
+
+// Returns the name of the instruction set used by the int8 dot products:
+const char* quantization_simdName(void)
+{
+	return QUANT_SIMD_NAME;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Recognition:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+// Write the quantized network answers in the given inputs, like prediction():
+void quantizedPrediction(QuantizedNetwork *qnet, Inputs *inputs)
+{
+	if (qnet == NULL || inputs == NULL || inputs -> InputNumber <= 0 || inputs -> Questions == NULL)
+	{
+		printf("\nNothing to recognize.\n\n");
+		return;
+	}
+
+	const QuantizedLayer *output_layer = qnet -> Layers + qnet -> LayersNumber - 1;
+
+	if (qnet -> Layers[0].InputSize != inputs -> QuestionsSize || output_layer -> NeuronsNumber != inputs -> AnswersSize)
+	{
+		printf("\nImcompatible sizes between network and inputs! Questions size: %d vs %d, answers size: %d vs %d.\n\n",
+			qnet -> Layers[0].InputSize, inputs -> QuestionsSize, output_layer -> NeuronsNumber, inputs -> AnswersSize);
+		return;
+	}
+
+	if (inputs -> Answers == NULL)
+		inputs -> Answers = createMatrix(inputs -> InputNumber, inputs -> AnswersSize);
+
+	const int sparse = sparseInputs(inputs);
+
+	for (int batch_index = 0; batch_index < inputs -> InputNumber; batch_index += qnet -> MaxBatchSize)
+	{
+		const int batch_size = MIN(qnet -> MaxBatchSize, inputs -> InputNumber - batch_index);
+
+		const Number *batch_answers = quantizedPropagation(qnet, inputs -> Questions + batch_index, batch_size, sparse);
+
+		for (int b = 0; b < batch_size; ++b)
+			copyVector(inputs -> Answers[batch_index + b], batch_answers + b * (inputs -> AnswersSize + 1), inputs -> AnswersSize);
+	}
+}
+
+
+// Compares the answers of the network and its quantized copy on the given questions. Prints the rates of questions
+// whose most probable class, and whose 'top_k' most probable classes are the same. Returns the latter rate.
+Number quantizedAgreement(NeuralNetwork *network, QuantizedNetwork *qnet, const Inputs *inputs, int top_k)
+{
+	if (network == NULL || qnet == NULL || inputs == NULL || inputs -> InputNumber <= 0)
+	{
+		printf("\nNothing to compare.\n\n");
+		return 0;
+	}
+
+	top_k = MIN(MAX(top_k, 1), inputs -> AnswersSize);
+
+	// Both answers are predicted on inputs sharing the given questions:
+
+	Inputs reference = {inputs -> InputNumber, inputs -> QuestionsSize, inputs -> AnswersSize,
+		inputs -> Questions, NULL, inputs -> QuestionsData, NULL};
+
+	Inputs quantized = reference;
+
+	prediction(network, &reference);
+	quantizedPrediction(qnet, &quantized);
+
+	if (reference.Answers == NULL || quantized.Answers == NULL)
+	{
+		freeMatrix(&(reference.Answers), inputs -> InputNumber);
+		freeMatrix(&(quantized.Answers), inputs -> InputNumber);
+		return 0;
+	}
+
+	int *buffer_1 = (int*) calloc(top_k, sizeof(int));
+	int *buffer_2 = (int*) calloc(top_k, sizeof(int));
+
+	int top_1_count = 0, top_k_count = 0;
+
+	for (int i = 0; i < inputs -> InputNumber; ++i)
+	{
+		top_1_count += sameGreaterValues(buffer_1, buffer_2, 1, reference.Answers[i], quantized.Answers[i], inputs -> AnswersSize);
+		top_k_count += sameGreaterValues(buffer_1, buffer_2, top_k, reference.Answers[i], quantized.Answers[i], inputs -> AnswersSize);
+	}
+
+	free(buffer_1);
+	free(buffer_2);
+
+	freeMatrix(&(reference.Answers), inputs -> InputNumber);
+	freeMatrix(&(quantized.Answers), inputs -> InputNumber);
+
+	const Number top_1_rate = (Number) top_1_count / inputs -> InputNumber;
+	const Number top_k_rate = (Number) top_k_count / inputs -> InputNumber;
+
+	printf("\nInt8 vs full precision agreement on %d questions: top-1: %.2f %%, top-%d: %.2f %%\n",
+		inputs -> InputNumber, 100. * top_1_rate, top_k, 100. * top_k_rate);
+
+	return top_k_rate;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Static functions:
+///////////////////////////////////////////////////////////////////////////////////////
+
+
+// Allocates the computation buffers of a quantized network, whose layers sizes are already set:
+static void allocQuantizedBuffers(QuantizedNetwork *qnet)
+{
+	for (int l = 0; l < qnet -> LayersNumber; ++l)
+	{
+		QuantizedLayer *qlayer = qnet -> Layers + l;
+
+		qlayer -> Input = (uint8_t*) calloc((long) qnet -> PaddedBatchSize * qlayer -> PaddedInputSize, sizeof(uint8_t));
+		qlayer -> InputScales = (float*) calloc(qnet -> PaddedBatchSize, sizeof(float));
+		qlayer -> Sum = createVector(qnet -> MaxBatchSize * qlayer -> NeuronsNumber);
+		qlayer -> Output = createVector(qnet -> MaxBatchSize * (qlayer -> NeuronsNumber + 1));
+
+		if (qlayer -> Input == NULL || qlayer -> InputScales == NULL)
+		{
+			printf("\nNot enough memory to create the quantized network buffers.\n\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	// Denser questions are not gathered, but the elements of the last read one may be written past said density:
+
+	const int input_size = qnet -> Layers[0].InputSize;
+	const long sparse_capacity = (long) (SPARSE_INPUT_DENSITY * qnet -> MaxBatchSize * (input_size + 1)) + input_size;
+
+	qnet -> SparseRowStart = (int*) calloc(qnet -> MaxBatchSize + 1, sizeof(int));
+	qnet -> SparseIndices = (int*) calloc(sparse_capacity, sizeof(int));
+	qnet -> SparseValues = (int8_t*) calloc(sparse_capacity, sizeof(int8_t));
+
+	if (qnet -> SparseRowStart == NULL || qnet -> SparseIndices == NULL || qnet -> SparseValues == NULL)
+	{
+		printf("\nNot enough memory to create the quantized network buffers.\n\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+
+// Frees the computation buffers of a quantized network:
+static void freeQuantizedBuffers(QuantizedNetwork *qnet)
+{
+	for (int l = 0; l < qnet -> LayersNumber; ++l)
+	{
+		QuantizedLayer *qlayer = qnet -> Layers + l;
+
+		free(qlayer -> Input);
+		free(qlayer -> InputScales);
+		freeVector(&(qlayer -> Sum));
+		freeVector(&(qlayer -> Output));
+
+		qlayer -> Input = NULL;
+		qlayer -> InputScales = NULL;
+	}
+
+	free(qnet -> SparseRowStart);
+	free(qnet -> SparseIndices);
+	free(qnet -> SparseValues);
+
+	qnet -> SparseRowStart = NULL;
+	qnet -> SparseIndices = NULL;
+	qnet -> SparseValues = NULL;
+}
+
+
+// Quantizes a row of 'len' Numbers in unsigned bytes, q + QUANT_INPUT_OFFSET with q = round(x / scale) in
+// [-QUANT_MAX, QUANT_MAX]. The padding up to 'padded_len' is set to the offset, i.e 0. Returns the scale.
+static float quantizeRow(uint8_t *dest, const Number *src, int len, int padded_len)
+{
+	Number buffer[VEC_SIZE];
+
+	Vec Max_abs = vec_zero();
+
+	int i = 0;
+
+	for (; i + VEC_SIZE <= len; i += VEC_SIZE)
+	{
+		Vec X = vec_load(src + i);
+		Max_abs = vec_max(Max_abs, vec_max(X, vec_sub(vec_zero(), X)));
+	}
+
+	vec_store(buffer, Max_abs);
+
+	Number max_abs = 0;
+
+	for (int v = 0; v < VEC_SIZE; ++v)
+		max_abs = number_max(max_abs, buffer[v]);
+
+	for (; i < len; ++i)
+		max_abs = number_max(max_abs, number_abs(src[i]));
+
+	const float scale = max_abs > 0 ? max_abs / QUANT_MAX : 1.f;
+
+	// x / scale + offset + 0.5 is in [0.5, 255.5]: truncating it rounds to the nearest integer.
+
+	const float inv_scale = 1.f / scale;
+
+	const Vec Inv_scale = vec_set1(inv_scale), Offset = vec_set1(QUANT_INPUT_OFFSET + 0.5f);
+
+	for (i = 0; i + VEC_SIZE <= len; i += VEC_SIZE)
+	{
+	#if defined __AVX512F__ && defined _FLOAT // Truncated and narrowed to bytes in registers.
+		const __m512i X = _mm512_cvttps_epi32(vec_fma(vec_load(src + i), Inv_scale, Offset));
+		_mm_storeu_si128((__m128i*) (dest + i), _mm512_cvtepi32_epi8(X));
+	#else
+		vec_store(buffer, vec_fma(vec_load(src + i), Inv_scale, Offset));
+
+		for (int v = 0; v < VEC_SIZE; ++v)
+			dest[i + v] = (uint8_t) (int) buffer[v];
+	#endif
+	}
+
+	for (; i < len; ++i)
+		dest[i] = (uint8_t) (int) (src[i] * inv_scale + (QUANT_INPUT_OFFSET + 0.5f));
+
+	memset(dest + len, QUANT_INPUT_OFFSET, padded_len - len);
+
+	return scale;
+}
+
+
+// Int32 products of QUANT_ROWS_GROUP rows of quantized inputs with QUANT_NEURONS_GROUP neurons of interleaved weights,
+// each row of 'results' being QUANT_NEURONS_GROUP long:
+static void productsBlock(int32_t *results, const uint8_t *input, const int8_t *weights, int padded_input_size,
+	int padded_neurons_number)
+{
+#if QUANT_ROWS_GROUP != 8 || QUANT_NEURONS_GROUP != 16 || QUANT_INPUTS_GROUP != 4
+	#error "The int8 products are written for blocks of 8 rows x 16 neurons, 4 inputs at a time."
+#endif
+
+	const int weights_stride = padded_neurons_number * QUANT_INPUTS_GROUP;
+
+#if defined __AVX512F__ && defined __AVX512VNNI__
+
+	// 8 independent accumulators, for hiding the latency of vpdpbusd:
+
+	__m512i acc0 = _mm512_setzero_si512(), acc1 = _mm512_setzero_si512();
+	__m512i acc2 = _mm512_setzero_si512(), acc3 = _mm512_setzero_si512();
+	__m512i acc4 = _mm512_setzero_si512(), acc5 = _mm512_setzero_si512();
+	__m512i acc6 = _mm512_setzero_si512(), acc7 = _mm512_setzero_si512();
+
+	for (int k = 0; k < padded_input_size; k += QUANT_INPUTS_GROUP, weights += weights_stride)
+	{
+		const __m512i w = _mm512_loadu_si512(weights);
+
+		// 4 inputs of each row, broadcast to each neuron:
+		#define ROW_PRODUCTS(r, acc)																	\
+			int32_t x##r;																				\
+			memcpy(&x##r, input + r * padded_input_size + k, sizeof(int32_t));							\
+			acc = _mm512_dpbusd_epi32(acc, _mm512_set1_epi32(x##r), w);
+
+		ROW_PRODUCTS(0, acc0)
+		ROW_PRODUCTS(1, acc1)
+		ROW_PRODUCTS(2, acc2)
+		ROW_PRODUCTS(3, acc3)
+		ROW_PRODUCTS(4, acc4)
+		ROW_PRODUCTS(5, acc5)
+		ROW_PRODUCTS(6, acc6)
+		ROW_PRODUCTS(7, acc7)
+
+		#undef ROW_PRODUCTS
+	}
+
+	_mm512_storeu_si512(results, acc0);
+	_mm512_storeu_si512(results + 16, acc1);
+	_mm512_storeu_si512(results + 32, acc2);
+	_mm512_storeu_si512(results + 48, acc3);
+	_mm512_storeu_si512(results + 64, acc4);
+	_mm512_storeu_si512(results + 80, acc5);
+	_mm512_storeu_si512(results + 96, acc6);
+	_mm512_storeu_si512(results + 112, acc7);
+
+#elif defined __AVX2__
+
+	// Widened weights are shared by 2 rows at a time, 16 registers being available:
+
+	for (int r = 0; r < QUANT_ROWS_GROUP; r += 2)
+	{
+		// Each accumulator holds 4 neurons, 2 int32 each: [n0, n0, n1, n1 | n2, n2, n3, n3].
+
+		__m256i acc[2][4];
+
+		for (int i = 0; i < 2; ++i)
+			acc[i][0] = acc[i][1] = acc[i][2] = acc[i][3] = _mm256_setzero_si256();
+
+		const uint8_t *input_row = input + r * padded_input_size;
+		const int8_t *w = weights;
+
+		for (int k = 0; k < padded_input_size; k += QUANT_INPUTS_GROUP, w += weights_stride)
+		{
+			const __m256i w0 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*) w));
+			const __m256i w1 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*) (w + 16)));
+			const __m256i w2 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*) (w + 32)));
+			const __m256i w3 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*) (w + 48)));
+
+			for (int i = 0; i < 2; ++i)
+			{
+				int32_t x_packed;
+				memcpy(&x_packed, input_row + i * padded_input_size + k, sizeof(int32_t));
+
+				const __m256i x = _mm256_cvtepu8_epi16(_mm_set1_epi32(x_packed));
+
+				acc[i][0] = _mm256_add_epi32(acc[i][0], _mm256_madd_epi16(x, w0));
+				acc[i][1] = _mm256_add_epi32(acc[i][1], _mm256_madd_epi16(x, w1));
+				acc[i][2] = _mm256_add_epi32(acc[i][2], _mm256_madd_epi16(x, w2));
+				acc[i][3] = _mm256_add_epi32(acc[i][3], _mm256_madd_epi16(x, w3));
+			}
+		}
+
+		// Pairwise sums give [n0, n1, n4, n5 | n2, n3, n6, n7], put back in order:
+
+		for (int i = 0; i < 2; ++i)
+		{
+			const __m256i sum01 = _mm256_permute4x64_epi64(_mm256_hadd_epi32(acc[i][0], acc[i][1]), 0xD8);
+			const __m256i sum23 = _mm256_permute4x64_epi64(_mm256_hadd_epi32(acc[i][2], acc[i][3]), 0xD8);
+
+			_mm256_storeu_si256((__m256i*) (results + QUANT_NEURONS_GROUP * (r + i)), sum01);
+			_mm256_storeu_si256((__m256i*) (results + QUANT_NEURONS_GROUP * (r + i) + 8), sum23);
+		}
+	}
+
+#else
+
+	for (int r = 0; r < QUANT_ROWS_GROUP; ++r)
+	{
+		const uint8_t *input_row = input + r * padded_input_size;
+
+		int32_t acc[QUANT_NEURONS_GROUP] = {0};
+
+		const int8_t *w = weights;
+
+		for (int k = 0; k < padded_input_size; k += QUANT_INPUTS_GROUP, w += weights_stride)
+		{
+			const int32_t x0 = input_row[k], x1 = input_row[k + 1], x2 = input_row[k + 2], x3 = input_row[k + 3];
+
+			for (int j = 0; j < QUANT_NEURONS_GROUP; ++j)
+				acc[j] += x0 * w[4 * j] + x1 * w[4 * j + 1] + x2 * w[4 * j + 2] + x3 * w[4 * j + 3];
+		}
+
+		memcpy(results + QUANT_NEURONS_GROUP * r, acc, sizeof(acc));
+	}
+
+#endif
+}
+
+
+// sum[j] = (input + offset) . w[j] - offset * sum(w[j]), scaled back, for the 'len' neurons starting at 'j0':
+static inline void scaleResults(Number *sum_row, const int32_t *result_row, const QuantizedLayer *qlayer, int b, int j0,
+	int len)
+{
+	const float input_scale = qlayer -> InputScales[b];
+
+	for (int j = 0; j < len; ++j)
+	{
+		const int32_t dot = result_row[j] - QUANT_INPUT_OFFSET * qlayer -> WeightsSums[j0 + j];
+
+		sum_row[j] = dot * (input_scale * qlayer -> Scales[j0 + j]) + qlayer -> Biases[j0 + j];
+	}
+}
+
+
+// Same as scaleResults(), for the products of sparse questions, which have no offset:
+static inline void scaleSparseResults(Number *restrict sum_row, const int32_t *restrict result_row,
+	const QuantizedLayer *qlayer, int b, int j0, int len)
+{
+	const float input_scale = qlayer -> InputScales[b];
+
+	const float *restrict scales = qlayer -> Scales + j0;
+	const Number *restrict biases = qlayer -> Biases + j0;
+
+	for (int j = 0; j < len; ++j)
+		sum_row[j] = result_row[j] * (input_scale * scales[j]) + biases[j];
+}
+
+
+// Fills the network sparse lists with the non zero elements of the given questions, quantized like quantizeRow() does,
+// their scales being written in the first layer 'InputScales'. Returns 0, the lists being then unused, if the
+// questions have more than 'SPARSE_INPUT_DENSITY' non zero elements, bias column included:
+static int gatherSparseQuestions(QuantizedNetwork *qnet, Number *const *batch_questions, int batch_size)
+{
+	QuantizedLayer *qlayer = qnet -> Layers;
+
+	const int input_size = qlayer -> InputSize;
+	const long max_elements = SPARSE_INPUT_DENSITY * batch_size * (input_size + 1);
+
+	int *indices = qnet -> SparseIndices;
+	int8_t *values = qnet -> SparseValues;
+
+	int e = 0;
+
+	for (int b = 0; b < batch_size; ++b)
+	{
+		const int row_start = e;
+
+		qnet -> SparseRowStart[b] = row_start;
+
+		const Number *question = batch_questions[b];
+
+		int k = 0;
+
+		for (; k + QUANT_SCAN_GROUP <= input_size; k += QUANT_SCAN_GROUP)
+		{
+			int nonzero = 0;
+
+			for (int v = 0; v < QUANT_SCAN_GROUP; ++v)
+				nonzero |= question[k + v] != 0;
+
+			if (!nonzero)
+				continue;
+
+			for (int v = 0; v < QUANT_SCAN_GROUP; ++v)
+			{
+				if (question[k + v] != 0)
+					indices[e++] = k + v;
+			}
+		}
+
+		for (; k < input_size; ++k)
+		{
+			if (question[k] != 0)
+				indices[e++] = k;
+		}
+
+		if (e + b + 1 > max_elements) // Too dense, the remaining questions are not read.
+			return 0;
+
+		Number max_abs = 0;
+
+		for (int i = row_start; i < e; ++i)
+			max_abs = number_max(max_abs, number_abs(question[indices[i]]));
+
+		const float scale = max_abs > 0 ? max_abs / QUANT_MAX : 1.f;
+		const float inv_scale = 1.f / scale;
+
+		// Same rounding as quantizeRow(), for the products to be those of the dense questions:
+
+		for (int i = row_start; i < e; ++i)
+			values[i] = (int8_t) ((int) (question[indices[i]] * inv_scale + (QUANT_INPUT_OFFSET + 0.5f)) - QUANT_INPUT_OFFSET);
+
+		qlayer -> InputScales[b] = scale;
+	}
+
+	qnet -> SparseRowStart[batch_size] = e;
+
+	return 1;
+}
+
+
+// Int32 products of the sparse elements [start, end) with 'groups' (at most QUANT_SPARSE_GROUPS) groups of
+// QUANT_NEURONS_GROUP neurons of interleaved weights, whose stride between groups of inputs is 'weights_stride',
+// 'results' being 'groups * QUANT_NEURONS_GROUP' long:
+static inline void sparseProductsGroups(int32_t *results, const int *indices, const int8_t *values, int start, int end,
+	const int8_t *weights, int weights_stride, int groups)
+{
+#if defined __AVX512F__ && defined __AVX512VNNI__ || defined __AVX2__
+
+	// The weight of an input is the byte 'index % QUANT_INPUTS_GROUP' of each neuron int32 lane: shifted to the top byte
+	// then back, it is sign extended. Its int16 halves are then multiplied by the value and 0, and summed:
+
+	#define SPARSE_WEIGHTS(e) (weights + (long) (indices[e] / QUANT_INPUTS_GROUP) * weights_stride)
+	#define SPARSE_SHIFT(e) _mm_cvtsi32_si128(24 - 8 * (indices[e] % QUANT_INPUTS_GROUP))
+	#define SPARSE_VALUE(e) ((uint16_t) values[e])
+
+#endif
+
+#if defined __AVX512F__ && defined __AVX512VNNI__
+
+	// One accumulator per group, for hiding the latency of vpdpwssd:
+
+	__m512i acc[QUANT_SPARSE_GROUPS];
+
+	for (int g = 0; g < groups; ++g)
+		acc[g] = _mm512_setzero_si512();
+
+	for (int e = start; e < end; ++e)
+	{
+		const int8_t *w = SPARSE_WEIGHTS(e);
+		const __m128i shift = SPARSE_SHIFT(e);
+		const __m512i x = _mm512_set1_epi32(SPARSE_VALUE(e));
+
+		for (int g = 0; g < groups; ++g)
+		{
+			const __m512i w_g = _mm512_srai_epi32(_mm512_sll_epi32(_mm512_loadu_si512(w + 64 * g), shift), 24);
+
+			acc[g] = _mm512_dpwssd_epi32(acc[g], w_g, x);
+		}
+	}
+
+	for (int g = 0; g < groups; ++g)
+		_mm512_storeu_si512(results + QUANT_NEURONS_GROUP * g, acc[g]);
+
+#elif defined __AVX2__
+
+	__m256i acc[2 * QUANT_SPARSE_GROUPS];
+
+	for (int g = 0; g < 2 * groups; ++g)
+		acc[g] = _mm256_setzero_si256();
+
+	for (int e = start; e < end; ++e)
+	{
+		const int8_t *w = SPARSE_WEIGHTS(e);
+		const __m128i shift = SPARSE_SHIFT(e);
+		const __m256i x = _mm256_set1_epi32(SPARSE_VALUE(e));
+
+		for (int g = 0; g < 2 * groups; ++g)
+		{
+			const __m256i w_g = _mm256_srai_epi32(_mm256_sll_epi32(_mm256_loadu_si256((const __m256i*) (w + 32 * g)), shift), 24);
+
+			acc[g] = _mm256_add_epi32(acc[g], _mm256_madd_epi16(w_g, x));
+		}
+	}
+
+	for (int g = 0; g < 2 * groups; ++g)
+		_mm256_storeu_si256((__m256i*) (results + 8 * g), acc[g]);
+
+#else
+
+	int32_t acc[QUANT_SPARSE_GROUPS * QUANT_NEURONS_GROUP] = {0};
+
+	for (int e = start; e < end; ++e)
+	{
+		const int32_t x = values[e];
+		const int8_t *w = weights + (long) (indices[e] / QUANT_INPUTS_GROUP) * weights_stride + indices[e] % QUANT_INPUTS_GROUP;
+
+		for (int j = 0; j < groups * QUANT_NEURONS_GROUP; ++j)
+			acc[j] += x * w[QUANT_INPUTS_GROUP * j];
+	}
+
+	memcpy(results, acc, groups * QUANT_NEURONS_GROUP * sizeof(int32_t));
+
+#endif
+
+#undef SPARSE_WEIGHTS
+#undef SPARSE_SHIFT
+#undef SPARSE_VALUE
+}
+
+
+// First layer sums of the questions gathered by gatherSparseQuestions(), which only read the weights of their
+// non zero elements:
+static void sparseProducts(QuantizedNetwork *qnet, int batch_size)
+{
+	QuantizedLayer *qlayer = qnet -> Layers;
+
+	const int neurons_number = qlayer -> NeuronsNumber, padded_neurons_number = qlayer -> PaddedNeuronsNumber;
+
+	for (int b = 0; b < batch_size; ++b)
+	{
+		const int start = qnet -> SparseRowStart[b], end = qnet -> SparseRowStart[b + 1];
+
+		for (int j1 = 0; j1 < neurons_number; j1 += QUANT_SPARSE_GROUPS * QUANT_NEURONS_GROUP)
+		{
+			int32_t results[QUANT_SPARSE_GROUPS * QUANT_NEURONS_GROUP];
+
+			const int groups = MIN(QUANT_SPARSE_GROUPS, (padded_neurons_number - j1) / QUANT_NEURONS_GROUP);
+
+			const int8_t *weights = qlayer -> Weights + j1 * QUANT_INPUTS_GROUP;
+			const int weights_stride = padded_neurons_number * QUANT_INPUTS_GROUP;
+
+			if (groups == QUANT_SPARSE_GROUPS) // Constant number, for the accumulators to be kept in registers.
+				sparseProductsGroups(results, qnet -> SparseIndices, qnet -> SparseValues, start, end, weights,
+					weights_stride, QUANT_SPARSE_GROUPS);
+			else
+				sparseProductsGroups(results, qnet -> SparseIndices, qnet -> SparseValues, start, end, weights,
+					weights_stride, groups);
+
+			for (int j0 = j1; j0 < MIN(j1 + groups * QUANT_NEURONS_GROUP, neurons_number); j0 += QUANT_NEURONS_GROUP)
+			{
+				const int group_size = MIN(QUANT_NEURONS_GROUP, neurons_number - j0);
+
+				Number *sum_row = qlayer -> Sum + b * neurons_number + j0;
+				const int32_t *result_row = results + (j0 - j1);
+
+				if (group_size == QUANT_NEURONS_GROUP) // Constant length, for the loop to be vectorized.
+					scaleSparseResults(sum_row, result_row, qlayer, b, j0, QUANT_NEURONS_GROUP);
+				else
+					scaleSparseResults(sum_row, result_row, qlayer, b, j0, group_size);
+			}
+		}
+	}
+}
+
+
+// Sums of the given layer, whose input, i.e the questions or the previous output, is quantized then multiplied by blocks:
+static void denseProducts(QuantizedNetwork *qnet, int layer_index, Number *const *batch_questions, int batch_size)
+{
+	int32_t results[QUANT_ROWS_GROUP * QUANT_NEURONS_GROUP];
+
+	QuantizedLayer *qlayer = qnet -> Layers + layer_index;
+
+	const int input_size = qlayer -> InputSize, neurons_number = qlayer -> NeuronsNumber;
+	const int padded_input_size = qlayer -> PaddedInputSize, padded_neurons_number = qlayer -> PaddedNeuronsNumber;
+
+	// Quantizing the input. Rows past 'batch_size' are left as they are:
+
+	for (int b = 0; b < batch_size; ++b)
+	{
+		const Number *input_row = layer_index == 0 ? batch_questions[b] : (qlayer - 1) -> Output + b * (input_size + 1);
+
+		qlayer -> InputScales[b] = quantizeRow(qlayer -> Input + (long) b * padded_input_size, input_row,
+			input_size, padded_input_size);
+	}
+
+	// Products by blocks of rows and neurons:
+
+	for (int b0 = 0; b0 < batch_size; b0 += QUANT_ROWS_GROUP)
+	{
+		const int rows_end = MIN(b0 + QUANT_ROWS_GROUP, batch_size);
+
+		for (int j0 = 0; j0 < neurons_number; j0 += QUANT_NEURONS_GROUP)
+		{
+			productsBlock(results, qlayer -> Input + (long) b0 * padded_input_size,
+				qlayer -> Weights + j0 * QUANT_INPUTS_GROUP, padded_input_size, padded_neurons_number);
+
+			const int group_size = MIN(QUANT_NEURONS_GROUP, neurons_number - j0);
+
+			for (int b = b0; b < rows_end; ++b)
+			{
+				const int32_t *result_row = results + (b - b0) * QUANT_NEURONS_GROUP;
+
+				Number *sum_row = qlayer -> Sum + b * neurons_number + j0;
+
+				if (group_size == QUANT_NEURONS_GROUP) // Constant length, for the loop to be vectorized.
+					scaleResults(sum_row, result_row, qlayer, b, j0, QUANT_NEURONS_GROUP);
+				else
+					scaleResults(sum_row, result_row, qlayer, b, j0, group_size);
+			}
+		}
+	}
+}
+
+
+// Propagation of the 'batch_size' first questions, returns the output of the last layer. 'sparse' is the value
+// of sparseInputs() on the questions:
+static const Number* quantizedPropagation(QuantizedNetwork *qnet, Number *const *batch_questions, int batch_size,
+	int sparse)
+{
+	for (int l = 0; l < qnet -> LayersNumber; ++l)
+	{
+		QuantizedLayer *qlayer = qnet -> Layers + l;
+
+		// The first layer of sparse questions only reads the weights of their non zero elements:
+
+		if (l == 0 && sparse && gatherSparseQuestions(qnet, batch_questions, batch_size))
+			sparseProducts(qnet, batch_size);
+		else
+			denseProducts(qnet, l, batch_questions, batch_size);
+
+		activationBlock(qlayer -> Fun, qlayer -> Output, qlayer -> NeuronsNumber + 1, qlayer -> Sum, batch_size,
+			qlayer -> NeuronsNumber);
+	}
+
+	return qnet -> Layers[qnet -> LayersNumber - 1].Output;
+}
+
+
+// Returns 1 if the 'top_k' most probable classes of both answers are the same, regardless of their order:
+static int sameGreaterValues(int *buffer_1, int *buffer_2, int top_k, const Number *answer_1, const Number *answer_2,
+	int len)
+{
+	findGreaterValuesIndex(buffer_1, top_k, answer_1, len);
+	findGreaterValuesIndex(buffer_2, top_k, answer_2, len);
+
+	for (int i = 0; i < top_k; ++i)
+	{
+		int found = 0;
+
+		for (int j = 0; j < top_k && !found; ++j)
+			found = buffer_1[i] == buffer_2[j];
+
+		if (!found)
+			return 0;
+	}
+
+	return 1;
+}
@@ -0,0 +1,93 @@
+#ifndef QUANTIZATION_H
+#define QUANTIZATION_H
+
+
+#include <stdint.h>
+
+#include "settings.h"
+#include "neural_network.h"
+#include "inputs.h"
+
+
+// Int8 copy of a learned network, for inference only. Weights are quantized per output neuron (i.e per channel),
+// with a float scale each. Activations are quantized per row, dynamically: each layer input is stored as unsigned
+// bytes q + 128, so that the dot products can use the u8 x s8 instructions (see quantization.c), the offset being
+// removed with the sums of the weights. Results and activations are computed back in 'Number'.
+
+// The products are computed by blocks of QUANT_ROWS_GROUP rows x QUANT_NEURONS_GROUP neurons, QUANT_INPUTS_GROUP
+// inputs at a time. Sizes are padded accordingly:
+#define QUANT_ROWS_GROUP 8
+#define QUANT_NEURONS_GROUP 16
+#define QUANT_INPUTS_GROUP 4
+
+
+typedef struct
+{
+	const int InputSize;
+	const int NeuronsNumber;
+	const int PaddedInputSize;		// Multiple of QUANT_INPUTS_GROUP.
+	const int PaddedNeuronsNumber;	// Multiple of QUANT_NEURONS_GROUP.
+	Activation Fun;
+
+	int8_t *Weights;		// PaddedInputSize * PaddedNeuronsNumber, 0 padded. Interleaved: for each group of
+							// QUANT_INPUTS_GROUP inputs, the weights of each neuron are consecutive.
+	float *Scales;			// PaddedNeuronsNumber, weights scale of each neuron.
+	int32_t *WeightsSums;	// PaddedNeuronsNumber, for removing the offset of the unsigned inputs.
+	Number *Biases;			// NeuronsNumber
+
+	uint8_t *Input;			// PaddedBatchSize * PaddedInputSize
+	float *InputScales;		// PaddedBatchSize
+	Number *Sum;			// MaxBatchSize * NeuronsNumber
+	Number *Output;			// MaxBatchSize * (NeuronsNumber + 1), like 'NeuronLayer'.
+} QuantizedLayer;
+
+
+typedef struct
+{
+	const int LayersNumber;
+	const int MaxBatchSize;
+	const int PaddedBatchSize;	// Multiple of QUANT_ROWS_GROUP.
+	QuantizedLayer *Layers;	// size: LayersNumber
+
+	// Non zero elements of the current batch questions, quantized like the first layer 'Input', if they are sparse:
+	int *SparseRowStart;	// MaxBatchSize + 1, the elements of the question b being at [SparseRowStart[b], SparseRowStart[b + 1]).
+	int *SparseIndices;		// MaxBatchSize * InputSize of the first layer.
+	int8_t *SparseValues;	// MaxBatchSize * InputSize of the first layer.
+} QuantizedNetwork;
+
+
+// Creates the int8 copy of the given network. The latter is not needed afterwards:
+QuantizedNetwork* quantizeNetwork(const NeuralNetwork *network, int MaxBatchSize);
+
+
+// Frees the given quantized network passed by address, and sets it to NULL.
+void freeQuantizedNetwork(QuantizedNetwork **qnet);
+
+
+// Creates a quantized network sharing the weights of the given one, but owning its own computation buffers.
+// Useful for running several propagations of the same network in parallel. Free it with freeQuantizedReplica().
+QuantizedNetwork* createQuantizedReplica(const QuantizedNetwork *qnet, int MaxBatchSize);
+
+
+// Frees the given replica passed by address, but not the shared weights, and sets it to NULL.
+void freeQuantizedReplica(QuantizedNetwork **replica);
+
+
+// Returns the size in bytes of the quantized weights, scales and biases:
+long int quantizedNetworkSize(const QuantizedNetwork *qnet);
+
+
+// Returns the name of the instruction set used by the int8 dot products:
+const char* quantization_simdName(void);
+
+
+// Write the quantized network answers in the given inputs, like prediction():
+void quantizedPrediction(QuantizedNetwork *qnet, Inputs *inputs);
+
+
+// Compares the answers of the network and its quantized copy on the given questions. Prints the rates of questions
+// whose most probable class, and whose 'top_k' most probable classes are the same. Returns the latter rate.
+Number quantizedAgreement(NeuralNetwork *network, QuantizedNetwork *qnet, const Inputs *inputs, int top_k);
+
+
+#endif
@@ -5,32 +5,200 @@
 #include "random.h"
 
 
-static const double two_pi = 2.0 * 3.14159265358979323846;
-// static const double sqrt_2 = 1.41421356237309504880;
+static __thread RandomState DefaultState;
+static __thread int DefaultStateSeeded = 0;
+static int DefaultSeedsNumber = 0; // Number of threads whose default state has been seeded automatically.
+
+
+// Generators, from 'xoshiro256**' by David Blackman and Sebastiano Vigna:
+
+
+// SplitMix64, used for expanding a seed into a xoshiro256** state:
+static inline uint64_t splitMix64(uint64_t *x)
+{
+	uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+	return z ^ (z >> 31);
+}
+
+
+static inline uint64_t rotl(uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+
+// Uniform double in [0, 1[, from the 53 upper bits:
+static inline double toUnitInterval(uint64_t x)
+{
+	return (x >> 11) * 0x1.0p-53;
+}
+
+
+// Seeds the given state. The same seed always gives the same sequence:
+void seedRandomState(RandomState *state, uint64_t seed)
+{
+	for (int i = 0; i < 4; ++i)
+		state -> s[i] = splitMix64(&seed); // Never all 0.
+}
+
+
+// Returns the next 64 random bits of the given state:
+inline uint64_t nextRandom(RandomState *state)
+{
+	uint64_t *s = state -> s;
+
+	const uint64_t result = rotl(s[1] * 5, 7) * 9;
+	const uint64_t t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+
+	s[2] ^= t;
+	s[3] = rotl(s[3], 45);
+
+	return result;
+}
+
+
+// Advances the given state by 2^128 numbers, which is equivalent to as many calls to nextRandom().
+void jumpRandomState(RandomState *state)
+{
+	static const uint64_t jump[] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+
+	uint64_t s[4] = {0, 0, 0, 0};
+
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int b = 0; b < 64; ++b)
+		{
+			if (jump[i] & (1ULL << b))
+			{
+				for (int j = 0; j < 4; ++j)
+					s[j] ^= state -> s[j];
+			}
+
+			nextRandom(state);
+		}
+	}
+
+	for (int j = 0; j < 4; ++j)
+		state -> s[j] = s[j];
+}
+
+
+// Creates in 'stream' a new independent sequence, starting where 'state' is, then jumps 'state' past it.
+// Useful for giving its own stream to each thread.
+void splitRandomState(RandomState *state, RandomState *stream)
+{
+	*stream = *state;
+
+	jumpRandomState(state);
+}
+
+
+// Returns an unbiased random integer in [0, bound[, bound > 0:
+int random_below(RandomState *state, int bound)
+{
+	// Lemire's method: multiplication instead of a modulo, rejecting the few values which would bias the result.
+
+	uint64_t product = (nextRandom(state) >> 32) * (uint64_t) bound;
+	uint32_t low = (uint32_t) product;
+
+	if (low < (uint32_t) bound)
+	{
+		const uint32_t threshold = -(uint32_t) bound % (uint32_t) bound;
+
+		while (low < threshold)
+		{
+			product = (nextRandom(state) >> 32) * (uint64_t) bound;
+			low = (uint32_t) product;
+		}
+	}
+
+	return product >> 32;
+}
+
+
+// Fills the given vector with random numbers in [min, max[:
+void uniformRandomFill(RandomState *state, Number *vector, int len, Number min, Number max)
+{
+	const double range = max - min;
+
+	for (int i = 0; i < len; ++i)
+		vector[i] = min + (Number) (toUnitInterval(nextRandom(state)) * range);
+}
+
+
+// Fills the given vector with random numbers following the distribution N(mean, std_dev²):
+void gaussianRandomFill(RandomState *state, Number *vector, int len, Number mean, Number std_dev)
+{
+	// Marsaglia polar method, a Box–Muller transform without trigonometric functions. Two numbers at a time:
+
+	for (int i = 0; i < len; i += 2)
+	{
+		double u, v, square_norm;
+
+		do // Uniform point in the unit disk, but its center. Accepted with a probability of pi / 4.
+		{
+			u = 2. * toUnitInterval(nextRandom(state)) - 1.;
+			v = 2. * toUnitInterval(nextRandom(state)) - 1.;
+
+			square_norm = u * u + v * v;
+		}
+		while (square_norm >= 1. || square_norm == 0.);
+
+		double factor = std_dev * sqrt(-2. * log(square_norm) / square_norm);
+
+		vector[i] = mean + (Number) (u * factor);
+
+		if (i + 1 < len)
+			vector[i + 1] = mean + (Number) (v * factor);
+	}
+}
+
+
+// State used by the functions below, one per thread. Threads which did not call setRandomSeed()
+// are seeded with 1, 2, 3... in the order they first use it, the main thread being usually the first one:
+RandomState* defaultRandomState(void)
+{
+	if (!DefaultStateSeeded)
+		setRandomSeed(__sync_add_and_fetch(&DefaultSeedsNumber, 1));
+
+	return &DefaultState;
+}
+
+
+// Seeds the default state of the calling thread:
+void setRandomSeed(uint64_t seed)
+{
+	seedRandomState(&DefaultState, seed);
+
+	DefaultStateSeeded = 1;
+}
 
 
 // Returns a random number in [min, max[.
-inline Number uniform_random(Number min, Number max)
+Number uniform_random(Number min, Number max)
 {
-	return (Number) rand() / RAND_MAX * (max - min) + min;
+	return (Number) (toUnitInterval(nextRandom(defaultRandomState())) * (max - min)) + min;
 }
 
 
 // Box–Muller transform, generate two 'Number' following the distribution N(0,1):
 void Box_Muller(Number *x1, Number *x2)
 {
-	double u1;
-	double u2 = (double) rand() / RAND_MAX; // ~ U[0, 1]
-
-	do
-		u1 = (double) rand() / RAND_MAX; // ~ U]0, 1], needs to be > 0 !!!
-	while (u1 == 0);
+	Number pair[2];
 
-	double rho = sqrt(-2. * log(u1));
-	double theta = two_pi * u2;
+	gaussianRandomFill(defaultRandomState(), pair, 2, 0, 1);
 
-	*x1 = (Number) rho * cos(theta);
-	*x2 = (Number) rho * sin(theta);
+	*x1 = pair[0];
+	*x2 = pair[1];
 }
 
 
@@ -50,12 +218,11 @@ void gaussian_random(Number *x1, Number *x2, Number mean, Number std_dev)
 // Fisher–Yates shuffle:
 void shuffle(void* *array, int len)
 {
-	if (len - 1 > RAND_MAX)
-		printf("\nArray length is greater than RAND_MAX!\n\n");
+	RandomState *state = defaultRandomState();
 
 	for (int i = len - 1; i >= 1; --i)
 	{
-		int j = rand() % (i + 1); // 0 ≤ j ≤ i. Biased, but negligeable.
+		int j = random_below(state, i + 1); // 0 ≤ j ≤ i.
 
 		void* temp = array[i];
 
@@ -2,9 +2,56 @@
 #define RANDOM_H
 
 
+#include <stdint.h>
+
 #include "settings.h"
 
 
+// State of a xoshiro256** generator. Each thread must use its own state, e.g split from another one:
+typedef struct
+{
+	uint64_t s[4];
+} RandomState;
+
+
+// Seeds the given state. The same seed always gives the same sequence:
+void seedRandomState(RandomState *state, uint64_t seed);
+
+
+// Returns the next 64 random bits of the given state:
+uint64_t nextRandom(RandomState *state);
+
+
+// Advances the given state by 2^128 numbers, which is equivalent to as many calls to nextRandom().
+void jumpRandomState(RandomState *state);
+
+
+// Creates in 'stream' a new independent sequence, starting where 'state' is, then jumps 'state' past it.
+// Useful for giving its own stream to each thread.
+void splitRandomState(RandomState *state, RandomState *stream);
+
+
+// Returns an unbiased random integer in [0, bound[, bound > 0:
+int random_below(RandomState *state, int bound);
+
+
+// Fills the given vector with random numbers in [min, max[:
+void uniformRandomFill(RandomState *state, Number *vector, int len, Number min, Number max);
+
+
+// Fills the given vector with random numbers following the distribution N(mean, std_dev²):
+void gaussianRandomFill(RandomState *state, Number *vector, int len, Number mean, Number std_dev);
+
+
+// State used by the functions below, one per thread. Threads which did not call setRandomSeed()
+// are seeded with 1, 2, 3... in the order they first use it, the main thread being usually the first one:
+RandomState* defaultRandomState(void);
+
+
+// Seeds the default state of the calling thread:
+void setRandomSeed(uint64_t seed);
+
+
 // Returns a random number in [min, max[.
 Number uniform_random(Number min, Number max);
 
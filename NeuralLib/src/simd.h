@@ -0,0 +1,278 @@
+// Compile time selection of the widest SIMD instruction set enabled by the compiler flags
+// (e.g '-march=native'), for the built-in kernels used when no high performance library is present.
+
+// Types and operations defined, for 'Number' vectors of 'VEC_SIZE' elements:
+
+// Vec: vector type.
+
+// vec_load(ptr), vec_store(ptr, X): unaligned loading/storing of 'VEC_SIZE' Numbers.
+
+// vec_set1(x), vec_zero(): broadcasting.
+
+// vec_fma(A, B, C): A * B + C
+
+// vec_add(A, B), vec_sub(A, B), vec_mul(A, B), vec_div(A, B), vec_max(A, B), vec_min(A, B), vec_sqrt(A)
+
+// vec_select_pos(X, A, B): X >= 0 ? A : B, for each element.
+
+// vec_exp(X): exponential, with a relative error close to the 'Number' precision.
+
+// Internal: vec_round(A) to the nearest integer, vec_scale_pow2(A, N) = A * 2^N.
+
+
+#ifndef SIMD_H
+#define SIMD_H
+
+
+#include <math.h>
+
+#include "settings.h" // For 'Number' definition.
+
+
+#if defined __AVX512F__
+
+	#include <immintrin.h>
+
+	#define SIMD_NAME "AVX-512"
+
+	#if defined _FLOAT
+
+		#define VEC_SIZE 16
+		typedef __m512 Vec;
+
+		#define vec_load(ptr) _mm512_loadu_ps(ptr)
+		#define vec_store(ptr, X) _mm512_storeu_ps(ptr, X)
+		#define vec_set1(x) _mm512_set1_ps(x)
+		#define vec_zero() _mm512_setzero_ps()
+		#define vec_fma(A, B, C) _mm512_fmadd_ps(A, B, C)
+		#define vec_add(A, B) _mm512_add_ps(A, B)
+		#define vec_sub(A, B) _mm512_sub_ps(A, B)
+		#define vec_mul(A, B) _mm512_mul_ps(A, B)
+		#define vec_div(A, B) _mm512_div_ps(A, B)
+		#define vec_max(A, B) _mm512_max_ps(A, B)
+		#define vec_min(A, B) _mm512_min_ps(A, B)
+		#define vec_sqrt(A) _mm512_sqrt_ps(A)
+		#define vec_select_pos(X, A, B) _mm512_mask_blend_ps(_mm512_cmp_ps_mask(X, _mm512_setzero_ps(), _CMP_GE_OQ), B, A)
+		#define vec_round(A) _mm512_roundscale_ps(A, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+		#define vec_scale_pow2(A, N) _mm512_scalef_ps(A, N) // A * 2^N, N being a vector of integer values.
+
+	#elif defined _DOUBLE
+
+		#define VEC_SIZE 8
+		typedef __m512d Vec;
+
+		#define vec_load(ptr) _mm512_loadu_pd(ptr)
+		#define vec_store(ptr, X) _mm512_storeu_pd(ptr, X)
+		#define vec_set1(x) _mm512_set1_pd(x)
+		#define vec_zero() _mm512_setzero_pd()
+		#define vec_fma(A, B, C) _mm512_fmadd_pd(A, B, C)
+		#define vec_add(A, B) _mm512_add_pd(A, B)
+		#define vec_sub(A, B) _mm512_sub_pd(A, B)
+		#define vec_mul(A, B) _mm512_mul_pd(A, B)
+		#define vec_div(A, B) _mm512_div_pd(A, B)
+		#define vec_max(A, B) _mm512_max_pd(A, B)
+		#define vec_min(A, B) _mm512_min_pd(A, B)
+		#define vec_sqrt(A) _mm512_sqrt_pd(A)
+		#define vec_select_pos(X, A, B) _mm512_mask_blend_pd(_mm512_cmp_pd_mask(X, _mm512_setzero_pd(), _CMP_GE_OQ), B, A)
+		#define vec_round(A) _mm512_roundscale_pd(A, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+		#define vec_scale_pow2(A, N) _mm512_scalef_pd(A, N)
+	#endif
+
+
+#elif defined __AVX__
+
+	#include <immintrin.h>
+
+	#if defined __FMA__
+		#define SIMD_NAME "AVX2/FMA"
+		#define _vec_fma_ps(A, B, C) _mm256_fmadd_ps(A, B, C)
+		#define _vec_fma_pd(A, B, C) _mm256_fmadd_pd(A, B, C)
+	#else
+		#define SIMD_NAME "AVX"
+		#define _vec_fma_ps(A, B, C) _mm256_add_ps(_mm256_mul_ps(A, B), C)
+		#define _vec_fma_pd(A, B, C) _mm256_add_pd(_mm256_mul_pd(A, B), C)
+	#endif
+
+	#if defined _FLOAT
+
+		#define VEC_SIZE 8
+		typedef __m256 Vec;
+
+		#define vec_load(ptr) _mm256_loadu_ps(ptr)
+		#define vec_store(ptr, X) _mm256_storeu_ps(ptr, X)
+		#define vec_set1(x) _mm256_set1_ps(x)
+		#define vec_zero() _mm256_setzero_ps()
+		#define vec_fma(A, B, C) _vec_fma_ps(A, B, C)
+		#define vec_add(A, B) _mm256_add_ps(A, B)
+		#define vec_sub(A, B) _mm256_sub_ps(A, B)
+		#define vec_mul(A, B) _mm256_mul_ps(A, B)
+		#define vec_div(A, B) _mm256_div_ps(A, B)
+		#define vec_max(A, B) _mm256_max_ps(A, B)
+		#define vec_min(A, B) _mm256_min_ps(A, B)
+		#define vec_sqrt(A) _mm256_sqrt_ps(A)
+		#define vec_select_pos(X, A, B) _mm256_blendv_ps(B, A, _mm256_cmp_ps(X, _mm256_setzero_ps(), _CMP_GE_OQ))
+		#define vec_round(A) _mm256_round_ps(A, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+
+		#if defined __AVX2__
+			#define vec_scale_pow2(A, N) _mm256_mul_ps(A, _mm256_castsi256_ps(_mm256_slli_epi32(	\
+				_mm256_add_epi32(_mm256_cvtps_epi32(N), _mm256_set1_epi32(127)), 23)))
+		#endif
+
+	#elif defined _DOUBLE
+
+		#define VEC_SIZE 4
+		typedef __m256d Vec;
+
+		#define vec_load(ptr) _mm256_loadu_pd(ptr)
+		#define vec_store(ptr, X) _mm256_storeu_pd(ptr, X)
+		#define vec_set1(x) _mm256_set1_pd(x)
+		#define vec_zero() _mm256_setzero_pd()
+		#define vec_fma(A, B, C) _vec_fma_pd(A, B, C)
+		#define vec_add(A, B) _mm256_add_pd(A, B)
+		#define vec_sub(A, B) _mm256_sub_pd(A, B)
+		#define vec_mul(A, B) _mm256_mul_pd(A, B)
+		#define vec_div(A, B) _mm256_div_pd(A, B)
+		#define vec_max(A, B) _mm256_max_pd(A, B)
+		#define vec_min(A, B) _mm256_min_pd(A, B)
+		#define vec_sqrt(A) _mm256_sqrt_pd(A)
+		#define vec_select_pos(X, A, B) _mm256_blendv_pd(B, A, _mm256_cmp_pd(X, _mm256_setzero_pd(), _CMP_GE_OQ))
+		#define vec_round(A) _mm256_round_pd(A, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+
+		#if defined __AVX2__
+			#define vec_scale_pow2(A, N) _mm256_mul_pd(A, _mm256_castsi256_pd(_mm256_slli_epi64(	\
+				_mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(N)), _mm256_set1_epi64x(1023)), 52)))
+		#endif
+	#endif
+
+
+#elif defined __ARM_NEON && defined __aarch64__
+
+	#include <arm_neon.h>
+
+	#define SIMD_NAME "NEON"
+
+	#if defined _FLOAT
+
+		#define VEC_SIZE 4
+		typedef float32x4_t Vec;
+
+		#define vec_load(ptr) vld1q_f32(ptr)
+		#define vec_store(ptr, X) vst1q_f32(ptr, X)
+		#define vec_set1(x) vdupq_n_f32(x)
+		#define vec_zero() vdupq_n_f32(0.f)
+		#define vec_fma(A, B, C) vfmaq_f32(C, A, B)
+		#define vec_add(A, B) vaddq_f32(A, B)
+		#define vec_sub(A, B) vsubq_f32(A, B)
+		#define vec_mul(A, B) vmulq_f32(A, B)
+		#define vec_div(A, B) vdivq_f32(A, B)
+		#define vec_max(A, B) vmaxq_f32(A, B)
+		#define vec_min(A, B) vminq_f32(A, B)
+		#define vec_sqrt(A) vsqrtq_f32(A)
+		#define vec_select_pos(X, A, B) vbslq_f32(vcgezq_f32(X), A, B)
+		#define vec_round(A) vrndnq_f32(A)
+		#define vec_scale_pow2(A, N) vmulq_f32(A, vreinterpretq_f32_s32(vshlq_n_s32(	\
+			vaddq_s32(vcvtnq_s32_f32(N), vdupq_n_s32(127)), 23)))
+
+	#elif defined _DOUBLE
+
+		#define VEC_SIZE 2
+		typedef float64x2_t Vec;
+
+		#define vec_load(ptr) vld1q_f64(ptr)
+		#define vec_store(ptr, X) vst1q_f64(ptr, X)
+		#define vec_set1(x) vdupq_n_f64(x)
+		#define vec_zero() vdupq_n_f64(0.)
+		#define vec_fma(A, B, C) vfmaq_f64(C, A, B)
+		#define vec_add(A, B) vaddq_f64(A, B)
+		#define vec_sub(A, B) vsubq_f64(A, B)
+		#define vec_mul(A, B) vmulq_f64(A, B)
+		#define vec_div(A, B) vdivq_f64(A, B)
+		#define vec_max(A, B) vmaxq_f64(A, B)
+		#define vec_min(A, B) vminq_f64(A, B)
+		#define vec_sqrt(A) vsqrtq_f64(A)
+		#define vec_select_pos(X, A, B) vbslq_f64(vcgezq_f64(X), A, B)
+		#define vec_round(A) vrndnq_f64(A)
+		#define vec_scale_pow2(A, N) vmulq_f64(A, vreinterpretq_f64_s64(vshlq_n_s64(	\
+			vaddq_s64(vcvtnq_s64_f64(N), vdupq_n_s64(1023)), 52)))
+	#endif
+
+
+#else // Scalar fallback, left to the compiler:
+
+	#define SIMD_NAME "none"
+
+	#define VEC_SIZE 1
+	typedef Number Vec;
+
+	#define vec_load(ptr) (*(ptr))
+	#define vec_store(ptr, X) (*(ptr) = (X))
+	#define vec_set1(x) ((Number) (x))
+	#define vec_zero() ((Number) 0)
+	#define vec_fma(A, B, C) ((A) * (B) + (C))
+	#define vec_add(A, B) ((A) + (B))
+	#define vec_sub(A, B) ((A) - (B))
+	#define vec_mul(A, B) ((A) * (B))
+	#define vec_div(A, B) ((A) / (B))
+	#define vec_max(A, B) ((A) < (B) ? (B) : (A))
+	#define vec_min(A, B) ((A) < (B) ? (A) : (B))
+	#define vec_sqrt(A) number_sqrt(A)
+	#define vec_select_pos(X, A, B) ((X) >= 0 ? (A) : (B))
+	#define vec_exp(A) number_exp(A)
+#endif
+
+
+// Vectorized exponential: exp(x) = 2^n * exp(r), with n = round(x / ln(2)) and |r| <= ln(2) / 2,
+// exp(r) being approximated by its Taylor polynomial. Without any 'vec_scale_pow2' (e.g AVX without AVX2),
+// the elements are processed one by one:
+
+#if !defined vec_exp
+
+	#if defined _FLOAT
+		#define EXP_MAX_ARG 88.f
+		#define EXP_MIN_ARG -87.f
+		#define EXP_POLY_DEGREE 7
+	#elif defined _DOUBLE
+		#define EXP_MAX_ARG 709.
+		#define EXP_MIN_ARG -708.
+		#define EXP_POLY_DEGREE 12
+	#endif
+
+	static inline Vec vec_exp(Vec X)
+	{
+	#if defined vec_scale_pow2
+
+		X = vec_min(vec_max(X, vec_set1(EXP_MIN_ARG)), vec_set1(EXP_MAX_ARG));
+
+		Vec N = vec_round(vec_mul(X, vec_set1(1.44269504088896340736))); // 1 / ln(2)
+
+		// r = x - n * ln(2), ln(2) being split in two parts for precision:
+		Vec R = vec_fma(N, vec_set1(-0.693145751953125), X);
+		R = vec_fma(N, vec_set1(-1.42860682030941723212e-6), R);
+
+		// Horner scheme, with the coefficients 1 / k!:
+		static const Number exp_coeffs[] = {1., 1., 1. / 2, 1. / 6, 1. / 24, 1. / 120, 1. / 720, 1. / 5040, 1. / 40320,
+			1. / 362880, 1. / 3628800, 1. / 39916800, 1. / 479001600};
+
+		Vec P = vec_set1(exp_coeffs[EXP_POLY_DEGREE]);
+
+		for (int k = EXP_POLY_DEGREE - 1; k >= 0; --k)
+			P = vec_fma(P, R, vec_set1(exp_coeffs[k]));
+
+		return vec_scale_pow2(P, N);
+
+	#else
+
+		Number buffer[VEC_SIZE];
+		vec_store(buffer, X);
+
+		for (int i = 0; i < VEC_SIZE; ++i)
+			buffer[i] = number_exp(buffer[i]);
+
+		return vec_load(buffer);
+	#endif
+	}
+
+#endif
+
+
+#endif
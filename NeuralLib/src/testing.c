@@ -1,12 +1,19 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
+#include <stdint.h>
 
 #include "testing.h"
 #include "matrix.h"
 #include "learning.h"
 #include "random.h"
 #include "benchmarking.h"
+#include "gemm.h"
+#include "activation.h"
+#include "quantization.h"
+#include "half_precision.h"
+#include "optimizers.h"
 
 
 // Normalization of some inputs:
@@ -42,21 +49,21 @@ void test_Box_Muller(void)
 
 	int sampling = 100000;
 
-	// Number of bits of RAND_MAX. Should be 32:
-	int bits_number = (int) log(RAND_MAX) / log(2) + 2;
+	// Number of random bits used for the uniform numbers:
+	int bits_number = 53;
 
-	// Smallest positive real generated by rand():
+	// Smallest positive real generated:
 	double smallest_pos_real = pow(2., -bits_number);
 
-	// Greatest positive real generated using the Box-Muller transform with rand():
+	// Greatest positive real generated using the Box-Muller transform:
 	double max_reachable_real = sqrt(-2. * log(smallest_pos_real));
 
-	printf("\nRAND_MAX: %d bits.\nmax_reachable_real = %f\n", bits_number, max_reachable_real);
+	printf("\nRandom bits: %d.\nmax_reachable_real = %f\n", bits_number, max_reachable_real);
 
 	int max_std_dev = (int) max_reachable_real + 1;
 	int len = 2 * max_std_dev;
 
-	// Slices from -7 to +7 standard deviations. Cannot go over that due to finite precision of rand():
+	// Slices from -9 to +9 standard deviations. Cannot go over that due to the finite precision of the uniform numbers:
 	int *slices = (int*) calloc(len, sizeof(int)); 
 
 	Number x1, x2;
@@ -83,6 +90,61 @@ void test_Box_Muller(void)
 }
 
 
+// Checking the seeding and splitting of random states, and comparing their speed to rand():
+void test_random_state(void)
+{
+	printf("\n === Test: random states ===\n\n");
+
+	int len = 10000000;
+
+	Number *vector = createVector(len);
+
+	RandomState state_1, state_2, stream;
+
+	seedRandomState(&state_1, 42);
+	seedRandomState(&state_2, 42);
+
+	int same_sequence = 1;
+
+	for (int i = 0; i < 1000; ++i)
+		same_sequence &= nextRandom(&state_1) == nextRandom(&state_2);
+
+	splitRandomState(&state_1, &stream);
+
+	int different_streams = nextRandom(&state_1) != nextRandom(&stream);
+
+	// Unbiased integers: each of the 3 values must be drawn about a third of the time.
+
+	int counts[3] = {0};
+
+	for (int i = 0; i < 300000; ++i)
+		++counts[random_below(&state_1, 3)];
+
+	double time_1 = get_time();
+
+	for (int i = 0; i < len; ++i)
+		vector[i] = (Number) rand() / RAND_MAX;
+
+	double time_2 = get_time();
+
+	uniformRandomFill(&state_1, vector, len, 0, 1);
+
+	double time_3 = get_time();
+
+	gaussianRandomFill(&state_1, vector, len, 0, 1);
+
+	double time_4 = get_time();
+
+	printf("Same sequence: %s, different streams: %s, random_below(3): %d %d %d\n", same_sequence ? "yes" : "no",
+		different_streams ? "yes" : "no", counts[0], counts[1], counts[2]);
+
+	printf("Filling %d numbers, rand(): %.3f s, uniform: %.3f s, gaussian: %.3f s\n\n", len,
+		time_2 - time_1, time_3 - time_2, time_4 - time_3);
+
+	free(vector);
+}
+
+
 // Shuffle demo:
 void test_shuffle(void)
 {
@@ -131,6 +193,822 @@ void test_shuffle(void)
 }
 
 
+// Comparing the built-in blocked matrix product to the naive one, for each transposition case:
+void test_matrix_multiply(void)
+{
+	printf("\n === Test: blocked matrix product (%s) ===\n\n", gemm_simdName());
+
+	const TransposeOptions options[4][2] = {{NoTrans, NoTrans}, {NoTrans, Trans}, {Trans, NoTrans}, {Trans, Trans}};
+	const int sizes[][3] = {{1, 7, 5}, {5, 33, 17}, {13, 29, 300}, {64, 256, 389}, {389, 256, 64}, {150, 137, 257}};
+
+	for (int s = 0; s < ARRAY_LENGTH(sizes); ++s)
+	{
+		const int M = sizes[s][0], N = sizes[s][1], K = sizes[s][2];
+
+		Number *A = createVector(M * K);
+		Number *B = createVector(K * N);
+		Number *C_naive = createVector(M * N);
+		Number *C_blocked = createVector(M * N);
+
+		randomFillVector_uniform(A, M * K, 1);
+		randomFillVector_uniform(B, K * N, 1);
+
+		for (int o = 0; o < 4; ++o)
+		{
+			double time_1 = get_time();
+
+			naive_matrix_multiply(options[o][0], options[o][1], A, B, C_naive, M, N, K);
+
+			double time_2 = get_time();
+
+			blocked_matrix_multiply(options[o][0], options[o][1], A, B, C_blocked, M, N, K);
+
+			double time_3 = get_time();
+
+			Number max_error = 0;
+
+			for (int i = 0; i < M * N; ++i)
+				max_error = number_max(max_error, number_abs(C_naive[i] - C_blocked[i]));
+
+			printf("M = %3d, N = %3d, K = %3d, op(A): %d, op(B): %d -> max error: %.2e, naive: %.6f s, blocked: %.6f s\n",
+				M, N, K, options[o][0], options[o][1], (double) max_error, time_2 - time_1, time_3 - time_2);
+		}
+
+		freeVector(&A);
+		freeVector(&B);
+		freeVector(&C_naive);
+		freeVector(&C_blocked);
+	}
+
+	printf("\n");
+}
+
+
+// Comparing the vectorized activation kernels to the scalar functions:
+void test_activations(void)
+{
+	printf("\n === Test: activation kernels ===\n\n");
+
+	const int rows = 64, cols = 150, len = rows * cols;
+
+	Number *sum = createVector(len);
+	Number *output = createVector(rows * (cols + 1));
+	Number *grad = createVector(len);
+
+	randomFillVector_uniform(sum, len, 10);
+
+	for (int f = 0; f < getActivationNumber(); ++f)
+	{
+		Activation fun = f;
+
+		double time_1 = get_time();
+
+		activationBlock(fun, output, cols + 1, sum, rows, cols);
+
+		double time_2 = get_time();
+
+		for (int i = 0; i < len; ++i)
+			grad[i] = 1;
+
+		der_activationMultiply(fun, grad, sum, len);
+
+		double time_3 = get_time();
+
+		Number max_rel_error = 0, max_der_rel_error = 0;
+
+		for (int r = 0; r < rows; ++r)
+		{
+			Number exp_sum = 0; // For softmax.
+
+			for (int j = 0; j < cols; ++j)
+				exp_sum += number_exp(sum[r * cols + j]);
+
+			for (int j = 0; j < cols; ++j)
+			{
+				Number x = sum[r * cols + j];
+				Number y = fun == Softmax ? number_exp(x) / exp_sum : activation(fun, x);
+				Number dy = fun == Softmax ? 1 : der_activation(fun, x);
+
+				max_rel_error = number_max(max_rel_error, number_abs(output[r * (cols + 1) + j] - y) / (number_abs(y) + 1));
+				max_der_rel_error = number_max(max_der_rel_error, number_abs(grad[r * cols + j] - dy) / (number_abs(dy) + 1));
+			}
+		}
+
+		printf("%-10s -> max error: %.2e, derivative max error: %.2e, activation: %.6f s, derivative: %.6f s\n",
+			getActivationString(fun), (double) max_rel_error, (double) max_der_rel_error, time_2 - time_1, time_3 - time_2);
+	}
+
+	freeVector(&sum);
+	freeVector(&output);
+	freeVector(&grad);
+
+	printf("\n");
+}
+
+
+// Saving a network in a single file, and mapping it back:
+void test_network_file(void)
+{
+	printf("\n === Test: single file network ===\n\n");
+
+	int input_size = 20, max_batch_size = 4;
+	int NeuronsNumberArray[] = {30, 10};
+	Activation funArray[] = {ReLu, Softmax};
+
+	const int layers_number = ARRAYS_COMPARE_LENGTH(NeuronsNumberArray, funArray);
+
+	NeuralNetwork *network = createNetwork(input_size, layers_number, NeuronsNumberArray, funArray, max_batch_size);
+
+	for (int l = 0; l < layers_number; ++l)
+	{
+		NeuronLayer *layer = network -> Layers + l;
+
+		randomFillVector_uniform(layer -> Net, (layer -> InputSize + 1) * layer -> NeuronsNumber, 1);
+	}
+
+	network -> HasLearned = 1;
+
+	saveNetworkFile(network, "saves/test_network.bin");
+
+	double time_1 = get_time();
+
+	NeuralNetwork *network_mapped = mapNetworkFile("saves/test_network.bin", max_batch_size);
+
+	double time_2 = get_time();
+
+	int same_nets = network_mapped != NULL && network_mapped -> LayersNumber == layers_number;
+
+	for (int l = 0; same_nets && l < layers_number; ++l)
+	{
+		const NeuronLayer *layer = network -> Layers + l, *layer_mapped = network_mapped -> Layers + l;
+
+		same_nets = layer -> InputSize == layer_mapped -> InputSize && layer -> NeuronsNumber == layer_mapped -> NeuronsNumber &&
+			layer -> Fun == layer_mapped -> Fun && (uintptr_t) layer_mapped -> Net % 64 == 0 &&
+			memcmp(layer -> Net, layer_mapped -> Net, sizeof(Number) * (layer -> InputSize + 1) * layer -> NeuronsNumber) == 0;
+	}
+
+	// Files with another format must be rejected:
+	NeuralNetwork *network_invalid = mapNetworkFile("saves/test_AND/infos.txt", max_batch_size);
+
+	printf("Same nets: %s, invalid file rejected: %s, mapping: %.6f s\n\n", same_nets ? "yes" : "no",
+		network_invalid == NULL ? "yes" : "no", time_2 - time_1);
+
+	freeNetwork(&network_invalid);
+	freeNetwork(&network_mapped);
+	freeNetwork(&network);
+}
+
+
+// Predicting contiguous inputs in place, compared to the same inputs stored row by row:
+void test_contiguous_inputs(void)
+{
+	printf("\n === Test: contiguous inputs ===\n\n");
+
+	int input_number = 10000, input_size = 100, answer_size = 10, max_batch_size = 64;
+	int NeuronsNumberArray[] = {50, answer_size};
+	Activation funArray[] = {ReLu, Softmax};
+
+	const int layers_number = ARRAYS_COMPARE_LENGTH(NeuronsNumberArray, funArray);
+
+	NeuralNetwork *network = createNetwork(input_size, layers_number, NeuronsNumberArray, funArray, max_batch_size);
+
+	for (int l = 0; l < layers_number; ++l)
+	{
+		NeuronLayer *layer = network -> Layers + l;
+
+		randomFillVector_uniform(layer -> Net, (layer -> InputSize + 1) * layer -> NeuronsNumber, 1);
+	}
+
+	network -> HasLearned = 1;
+
+	Number **Questions = createMatrix(input_number, input_size);
+
+	Inputs *inputs = createInputs(input_number, input_size, answer_size, Questions, NULL);
+	Inputs *inputs_contiguous = createContiguousInputs(input_number, input_size, answer_size);
+
+	for (int i = 0; i < input_number; ++i)
+	{
+		randomFillVector_uniform(Questions[i], input_size, 1);
+
+		copyVector(inputs_contiguous -> Questions[i], Questions[i], input_size);
+	}
+
+	double time_1 = get_time();
+
+	prediction(network, inputs);
+
+	double time_2 = get_time();
+
+	prediction(network, inputs_contiguous);
+
+	double time_3 = get_time();
+
+	int same_answers = 1;
+
+	for (int i = 0; i < input_number; ++i)
+		same_answers &= memcmp(inputs -> Answers[i], inputs_contiguous -> Answers[i], sizeof(Number) * answer_size) == 0;
+
+	// Shuffled rows are gathered by batch, and must give the same answers:
+
+	shuffleInputs(inputs_contiguous);
+
+	prediction(network, inputs_contiguous);
+
+	Number max_diff = 0;
+
+	for (int i = 0; i < input_number; ++i)
+	{
+		int row = (inputs_contiguous -> Answers[i] - inputs_contiguous -> AnswersData) / answer_size;
+
+		for (int j = 0; j < answer_size; ++j)
+			max_diff = MAX(max_diff, fabs(inputs_contiguous -> Answers[i][j] - inputs -> Answers[row][j]));
+	}
+
+	printf("Same answers: %s, after shuffling: %s (max diff: %g)\n", same_answers ? "yes" : "no",
+		max_diff < 1e-5 ? "yes" : "no", (double) max_diff);
+
+	printf("Prediction time, rows: %.4f s, contiguous: %.4f s\n\n", time_2 - time_1, time_3 - time_2);
+
+	freeInputs(&inputs_contiguous);
+	freeInputs(&inputs);
+	freeNetwork(&network);
+}
+
+
+// Learning inputs streamed from the disk by chunks, compared to the same inputs learned from memory:
+void test_input_stream(void)
+{
+	printf("\n === Test: streamed inputs ===\n\n");
+
+	int input_number = 8192, input_size = 64, answer_size = 10, chunk_size = 1024, max_batch_size = 32;
+	const double min_accuracy = 0.7;
+	int NeuronsNumberArray[] = {32, answer_size};
+	Activation funArray[] = {ReLu, Softmax};
+
+	const int layers_number = ARRAYS_COMPARE_LENGTH(NeuronsNumberArray, funArray);
+
+	Inputs *inputs = createContiguousInputs(input_number, input_size, answer_size);
+
+	// Each answer is the index of the greatest of the first 'answer_size' question elements:
+
+	for (int i = 0; i < input_number; ++i)
+	{
+		randomFillVector_uniform(inputs -> Questions[i], input_size, 1);
+
+		inputs -> Answers[i][findMostProbable(inputs -> Questions[i], answer_size, NULL)] = 1;
+	}
+
+	saveInputs(inputs, "saves/toLearn_stream");
+
+	NeuralNetwork *network = createNetwork(input_size, layers_number, NeuronsNumberArray, funArray, max_batch_size);
+	NeuralNetwork *network_streamed = createNetwork(input_size, layers_number, NeuronsNumberArray, funArray, max_batch_size);
+
+	InputStream *stream = openInputStream("saves/toLearn_stream", chunk_size);
+
+	LearningParameters *params = initLearningParameters();
+
+	params -> Shuffle = NO_SHUFFLE;
+	params -> EpochNumber = 2;
+	params -> PrintEstimates = 0;
+
+	// Without shuffling, both learnings see the same batches and must give the same nets:
+
+	setRandomSeed(1);
+	learn(network, inputs, params);
+
+	setRandomSeed(1);
+	learnStream(network_streamed, stream, params);
+
+	int same_nets = 1;
+
+	for (int l = 0; l < layers_number; ++l)
+	{
+		const NeuronLayer *layer = network -> Layers + l;
+
+		same_nets &= memcmp(layer -> Net, network_streamed -> Layers[l].Net,
+			sizeof(Number) * (layer -> InputSize + 1) * layer -> NeuronsNumber) == 0;
+	}
+
+	// Shuffled chunks:
+
+	params -> Shuffle = SHUFFLE;
+	params -> PrintEstimates = 1;
+
+	learnStream(network_streamed, stream, params);
+
+	validation(network_streamed, inputs, MAX_VALUE);
+
+	// The shuffled chunks must keep each question with its answer:
+
+	Inputs *inputs_prediction = createContiguousInputs(input_number, input_size, answer_size);
+
+	for (int i = 0; i < input_number; ++i)
+		copyVector(inputs_prediction -> Questions[i], inputs -> Questions[i], input_size);
+
+	prediction(network_streamed, inputs_prediction);
+
+	int correct_answers = 0;
+
+	for (int i = 0; i < input_number; ++i)
+	{
+		correct_answers += findMostProbable(inputs_prediction -> Answers[i], answer_size, NULL) ==
+			findMostProbable(inputs -> Answers[i], answer_size, NULL);
+	}
+
+	const double accuracy = (double) correct_answers / input_number;
+
+	printf("Same nets as in memory: %s, accuracy after shuffling: %.2f %% (above %.0f %%: %s)\n\n",
+		same_nets ? "yes" : "no", 100. * accuracy, 100. * min_accuracy, accuracy > min_accuracy ? "yes" : "no");
+
+	freeInputs(&inputs_prediction);
+	closeInputStream(&stream);
+	freeParameters(&params);
+	freeNetwork(&network_streamed);
+	freeNetwork(&network);
+	freeInputs(&inputs);
+}
+
+
+// Int8 copy of a network shaped like Doc9000's one: speed, size and agreement with the full precision answers.
+void test_quantization(void)
+{
+	printf("\n === Test: int8 quantized inference ===\n\n");
+
+	int input_number = 20000, input_size = 388, answer_size = 136, max_batch_size = 64;
+	int NeuronsNumberArray[] = {256, 150, answer_size};
+	Activation funArray[] = {ReLu, ReLu, Softmax};
+
+	const int layers_number = ARRAYS_COMPARE_LENGTH(NeuronsNumberArray, funArray);
+
+	// Sparse binary questions: each class has a few symptoms, and some noise is added:
+
+	Inputs *inputs = createContiguousInputs(input_number, input_size, answer_size);
+
+	for (int i = 0; i < input_number; ++i)
+	{
+		const int answer = i % answer_size;
+
+		for (int k = 0; k < 5; ++k)
+		{
+			if (uniform_random(0, 1) < 0.8)
+				inputs -> Questions[i][(answer * 3 + k * 7) % input_size] = 1;
+		}
+
+		inputs -> Questions[i][random_below(defaultRandomState(), input_size)] = 1;
+		inputs -> Answers[i][answer] = 1;
+	}
+
+	NeuralNetwork *network = createNetwork(input_size, layers_number, NeuronsNumberArray, funArray, max_batch_size);
+
+	LearningParameters *params = initLearningParameters();
+
+	params -> EpochNumber = 2;
+	params -> PrintEstimates = 0;
+
+	learn(network, inputs, params);
+
+	QuantizedNetwork *qnet = quantizeNetwork(network, max_batch_size);
+
+	long int full_size = 0;
+
+	for (int l = 0; l < layers_number; ++l)
+		full_size += sizeof(Number) * (network -> Layers[l].InputSize + 1) * network -> Layers[l].NeuronsNumber;
+
+	double time_1 = get_time();
+
+	prediction(network, inputs);
+
+	double time_2 = get_time();
+
+	quantizedPrediction(qnet, inputs);
+
+	double time_3 = get_time();
+
+	quantizedAgreement(network, qnet, inputs, 5);
+
+	printf("Nets size: %ld bytes, quantized: %ld bytes\n", full_size, quantizedNetworkSize(qnet));
+
+	printf("Prediction time, full precision: %.4f s, int8 (%s): %.4f s\n\n", time_2 - time_1,
+		quantization_simdName(), time_3 - time_2);
+
+	freeQuantizedNetwork(&qnet);
+	freeParameters(&params);
+	freeNetwork(&network);
+	freeInputs(&inputs);
+}
+
+
+// Sparse first layer products, compared to the blocked ones on the same questions, for several numbers of non zero elements:
+void test_sparse_products(void)
+{
+	printf("\n === Test: sparse products (%s) ===\n\n", gemm_simdName());
+
+	const int rows = 64, cols_A = 389, cols_B = 256; // Batch x (questions size + 1) x neurons number.
+	const int nonzero_numbers[] = {5, 15, 50, 100, 200};
+
+	Number *A = createVector(rows * cols_A);
+	Number *B = createVector(cols_A * cols_B);
+	Number *G = createVector(rows * cols_B);
+	Number *C_blocked = createVector(cols_A * cols_B);
+	Number *C_sparse = createVector(cols_A * cols_B);
+
+	int *row_start = (int*) calloc(rows + 1, sizeof(int));
+	int *indices = (int*) calloc(rows * cols_A, sizeof(int));
+	Number *values = createVector(rows * cols_A);
+
+	int *col_start = (int*) calloc(cols_A + 1, sizeof(int));
+	int *col_rows = (int*) calloc(rows * cols_A, sizeof(int));
+	Number *col_values = createVector(rows * cols_A);
+
+	randomFillVector_uniform(B, cols_A * cols_B, 1);
+	randomFillVector_uniform(G, rows * cols_B, 1);
+
+	for (int n = 0; n < ARRAY_LENGTH(nonzero_numbers); ++n)
+	{
+		resetVector(A, rows * cols_A);
+
+		for (int i = 0; i < rows; ++i)
+		{
+			for (int k = 0; k < nonzero_numbers[n]; ++k)
+				A[i * cols_A + random_below(defaultRandomState(), cols_A)] = uniform_random(-1, 1);
+		}
+
+		int e = 0;
+
+		for (int i = 0; i < rows; ++i)
+		{
+			row_start[i] = e;
+
+			for (int k = 0; k < cols_A; ++k)
+			{
+				if (A[i * cols_A + k] != 0)
+				{
+					indices[e] = k;
+					values[e] = A[i * cols_A + k];
+					++e;
+				}
+			}
+		}
+
+		row_start[rows] = e;
+
+		// C = A * B:
+
+		double time_1 = get_time();
+
+		blocked_matrix_multiply(NoTrans, NoTrans, A, B, C_blocked, rows, cols_B, cols_A);
+
+		double time_2 = get_time();
+
+		sparse_matrix_multiply(row_start, indices, values, B, C_sparse, rows, cols_B);
+
+		double time_3 = get_time();
+
+		Number max_error = 0;
+
+		for (int i = 0; i < rows * cols_B; ++i)
+			max_error = number_max(max_error, number_abs(C_blocked[i] - C_sparse[i]));
+
+		// C = tr(A) * G:
+
+		double time_4 = get_time();
+
+		blocked_matrix_multiply(Trans, NoTrans, A, G, C_blocked, cols_A, cols_B, rows);
+
+		double time_5 = get_time();
+
+		sparse_transposed_multiply(row_start, indices, values, G, C_sparse, rows, cols_A, cols_B, col_start, col_rows, col_values);
+
+		double time_6 = get_time();
+
+		Number max_error_trans = 0;
+
+		for (int i = 0; i < cols_A * cols_B; ++i)
+			max_error_trans = number_max(max_error_trans, number_abs(C_blocked[i] - C_sparse[i]));
+
+		printf("Density: %5.2f %% -> A * B max error: %.2e, blocked: %.6f s, sparse: %.6f s | "
+			"tr(A) * G max error: %.2e, blocked: %.6f s, sparse: %.6f s\n", 100. * e / (rows * cols_A),
+			(double) max_error, time_2 - time_1, time_3 - time_2, (double) max_error_trans, time_5 - time_4, time_6 - time_5);
+	}
+
+	free(row_start);
+	free(indices);
+	freeVector(&values);
+	free(col_start);
+	free(col_rows);
+	freeVector(&col_values);
+	freeVector(&A);
+	freeVector(&B);
+	freeVector(&G);
+	freeVector(&C_blocked);
+	freeVector(&C_sparse);
+
+	printf("\n");
+}
+
+
+// Fused optimizer kernels, compared to the naive passes they replace, with a weight decay:
+void test_optimizers(void)
+{
+	printf("\n === Test: fused optimizer kernels (%s) ===\n\n", optimizers_simdName());
+
+	const long len = 389 * 256 + 7; // Not a multiple of the vectors size.
+	const Number decay = 0.9999, rate = 0.01, beta_1 = 0.9, beta_2 = 0.999;
+
+	Number *grad = createVector(len);
+
+	Number *net[2], *M[2], *V[2];
+
+	for (int k = 0; k < 2; ++k)
+	{
+		net[k] = createVector(len);
+		M[k] = createVector(len);
+		V[k] = createVector(len);
+	}
+
+	randomFillVector_uniform(grad, len, 1);
+
+	const char *names[] = {"SGD", "Momentum", "RMSprop", "Adam"};
+
+	for (int opt = 0; opt < 4; ++opt)
+	{
+		randomFillVector_uniform(net[0], len, 1);
+		randomFillVector_uniform(M[0], len, 1);
+		randomFillVector_uniform(V[0], len, 1);
+
+		for (long i = 0; i < len; ++i)
+			V[0][i] = number_abs(V[0][i]);
+
+		memcpy(net[1], net[0], len * sizeof(Number));
+		memcpy(M[1], M[0], len * sizeof(Number));
+		memcpy(V[1], V[0], len * sizeof(Number));
+
+		// Naive passes:
+
+		double time_1 = get_time();
+
+		for (long i = 0; i < len; ++i)
+			net[0][i] *= decay;
+
+		for (long i = 0; i < len; ++i)
+		{
+			switch (opt)
+			{
+				case 0:
+					net[0][i] -= rate * grad[i];
+					break;
+
+				case 1:
+					M[0][i] = beta_1 * M[0][i] + rate * grad[i];
+					net[0][i] -= M[0][i];
+					break;
+
+				case 2:
+					V[0][i] = beta_2 * V[0][i] + (1 - beta_2) * grad[i] * grad[i];
+					net[0][i] -= rate * grad[i] / (number_sqrt(V[0][i]) + EPSILON);
+					break;
+
+				default:
+					M[0][i] = beta_1 * M[0][i] + (1 - beta_1) * grad[i];
+					V[0][i] = beta_2 * V[0][i] + (1 - beta_2) * grad[i] * grad[i];
+					net[0][i] -= rate * M[0][i] / (number_sqrt(V[0][i]) + EPSILON);
+					break;
+			}
+		}
+
+		// Fused kernels:
+
+		double time_2 = get_time();
+
+		switch (opt)
+		{
+			case 0:
+				sgdStep(net[1], grad, len, decay, rate);
+				break;
+
+			case 1:
+				momentumStep(net[1], grad, M[1], len, decay, rate, beta_1);
+				break;
+
+			case 2:
+				rmspropStep(net[1], grad, V[1], len, decay, rate, beta_2);
+				break;
+
+			default:
+				adamStep(net[1], grad, M[1], V[1], len, decay, rate, beta_1, beta_2);
+				break;
+		}
+
+		double time_3 = get_time();
+
+		Number max_error = 0;
+
+		for (long i = 0; i < len; ++i)
+		{
+			max_error = number_max(max_error, number_abs(net[1][i] - net[0][i]) / (number_abs(net[0][i]) + 1));
+			max_error = number_max(max_error, number_abs(M[1][i] - M[0][i]) / (number_abs(M[0][i]) + 1));
+			max_error = number_max(max_error, number_abs(V[1][i] - V[0][i]) / (number_abs(V[0][i]) + 1));
+		}
+
+		printf("%-10s -> max error: %.2e, naive: %.6f s, fused: %.6f s\n", names[opt], (double) max_error,
+			time_2 - time_1, time_3 - time_2);
+	}
+
+	for (int k = 0; k < 2; ++k)
+	{
+		freeVector(&net[k]);
+		freeVector(&M[k]);
+		freeVector(&V[k]);
+	}
+
+	freeVector(&grad);
+
+	printf("\n");
+}
+
+
+// 16 bits conversions of edge values, then the same network learned with full precision, bfloat16 and float16 products:
+void test_mixed_precision(void)
+{
+	printf("\n === Test: mixed precision learning ===\n\n");
+
+	// Values exactly representable in both formats, followed by rounding, range and subnormal cases:
+
+	const int values_number = 19;
+
+	const Number values[] = {0., -0., 1., -2.5, 0.15625, 3.0517578125e-05, 1024., 1.00390625, 1.01171875,
+		1.0009765625, 70000., 1e-7, 65504., INFINITY, -INFINITY, 1e-30, 3e38, 0.1, -123.456};
+
+	const Half expected_bf16[] = {0x0000, 0x8000, 0x3F80, 0xC020, 0x3E20, 0x3800, 0x4480, 0x3F80, 0x3F82,
+		0x3F80, 0x4789, 0x33D7, 0x4780, 0x7F80, 0xFF80, 0x0DA2, 0x7F62, 0x3DCD, 0xC2F7};
+
+	const Half expected_fp16[] = {0x0000, 0x8000, 0x3C00, 0xC100, 0x3100, 0x0200, 0x6400, 0x3C04, 0x3C0C,
+		0x3C01, 0x7C00, 0x0002, 0x7BFF, 0x7C00, 0xFC00, 0x0000, 0x7C00, 0x2E66, 0xD7B7};
+
+	Number padded_values[64] = {0}, back[64];
+	Half halves[64];
+
+	int errors = 0;
+
+	// Converting the values at several offsets, so that both the vectorized and the scalar conversions are checked:
+
+	for (int offset = 0; offset < 64 - values_number; offset += 13)
+	{
+		memcpy(padded_values + offset, values, values_number * sizeof(Number));
+
+		for (Precision format = BFLOAT16; format <= FLOAT16; ++format)
+		{
+			const Half *expected = format == BFLOAT16 ? expected_bf16 : expected_fp16;
+
+			toHalf(format, halves, padded_values, 64);
+			fromHalf(format, back, halves, 64);
+
+			for (int i = 0; i < values_number; ++i)
+			{
+				Half reconverted;
+				toHalf(format, &reconverted, back + offset + i, 1);
+
+				if (halves[offset + i] != expected[i] || reconverted != expected[i])
+				{
+					printf("%s conversion error: %g -> 0x%04X, expected 0x%04X\n", getPrecisionString(format),
+						values[i], halves[offset + i], expected[i]);
+					++errors;
+				}
+			}
+		}
+
+		memset(padded_values, 0, sizeof(padded_values));
+	}
+
+	printf("Conversions (%s): %d errors\n", half_simdName(), errors);
+
+	// Learning:
+
+	int input_number = 20000, input_size = 388, answer_size = 136, max_batch_size = 64;
+	int NeuronsNumberArray[] = {256, 150, answer_size};
+	Activation funArray[] = {ReLu, ReLu, Softmax};
+
+	const int layers_number = ARRAYS_COMPARE_LENGTH(NeuronsNumberArray, funArray);
+
+	Inputs *inputs = createContiguousInputs(input_number, input_size, answer_size);
+
+	for (int i = 0; i < input_number; ++i)
+	{
+		const int answer = i % answer_size;
+
+		for (int k = 0; k < 5; ++k)
+		{
+			if (uniform_random(0, 1) < 0.8)
+				inputs -> Questions[i][(answer * 3 + k * 7) % input_size] = 1;
+		}
+
+		inputs -> Questions[i][random_below(defaultRandomState(), input_size)] = 1;
+		inputs -> Answers[i][answer] = 1;
+	}
+
+	LearningParameters *params = initLearningParameters();
+
+	params -> EpochNumber = 2;
+	params -> PrintEstimates = 0;
+
+	for (Precision format = FULL_PRECISION; format <= FLOAT16; ++format)
+	{
+		setRandomSeed(42); // Same initial nets and shuffling.
+
+		NeuralNetwork *network = createNetwork(input_size, layers_number, NeuronsNumberArray, funArray, max_batch_size);
+
+		params -> ProductsPrecision = format;
+
+		double time_1 = get_time();
+
+		learn(network, inputs, params);
+
+		double time_2 = get_time();
+
+		printf("\nLearning time, %s products: %.4f s\n", getPrecisionString(format), time_2 - time_1);
+
+		validation(network, inputs, MAX_VALUE);
+
+		freeNetwork(&network);
+	}
+
+	freeParameters(&params);
+	freeInputs(&inputs);
+}
+
+
+// Profiled learnings, with 1 and 2 threads. The profiling must not change the learned nets:
+void test_learning_profile(void)
+{
+	printf("\n === Test: learning profile ===\n\n");
+
+	int input_number = 10000, input_size = 388, answer_size = 136, max_batch_size = 64;
+	int NeuronsNumberArray[] = {256, 150, answer_size};
+	Activation funArray[] = {ReLu, ReLu, Softmax};
+
+	const int layers_number = ARRAYS_COMPARE_LENGTH(NeuronsNumberArray, funArray);
+
+	Inputs *inputs = createContiguousInputs(input_number, input_size, answer_size);
+
+	for (int i = 0; i < input_number; ++i)
+	{
+		const int answer = i % answer_size;
+
+		for (int k = 0; k < 5; ++k)
+			inputs -> Questions[i][(answer * 3 + k * 7) % input_size] = 1;
+
+		inputs -> Answers[i][answer] = 1;
+	}
+
+	LearningParameters *params = initLearningParameters();
+
+	params -> EpochNumber = 2;
+	params -> PrintEstimates = 0;
+	params -> Optim = ADAM;
+	params -> Shuffle = NO_SHUFFLE; // The inputs order must be the same for each learning.
+
+	NeuralNetwork *networks[3];
+
+	for (int n = 0; n < 3; ++n)
+	{
+		setRandomSeed(42); // Same initial nets and shuffling.
+
+		networks[n] = createNetwork(input_size, layers_number, NeuronsNumberArray, funArray, max_batch_size);
+
+		params -> Profile = n > 0;
+		params -> ThreadNumber = n < 2 ? 1 : 2;
+
+		printf("\nLearning with %d thread(s), profiling %s:\n", params -> ThreadNumber, params -> Profile ? "on" : "off");
+
+		double time_1 = get_time();
+
+		learn(networks[n], inputs, params);
+
+		double time_2 = get_time();
+
+		printf("\nLearning time: %.4f s\n", time_2 - time_1);
+	}
+
+	int differences = 0;
+
+	for (int l = 0; l < layers_number; ++l)
+	{
+		const NeuronLayer *layer = networks[0] -> Layers + l;
+
+		differences += memcmp(layer -> Net, networks[1] -> Layers[l].Net,
+			(layer -> InputSize + 1) * layer -> NeuronsNumber * sizeof(Number)) != 0;
+	}
+
+	printf("\nLayers changed by the profiling: %d\n", differences);
+
+	for (int n = 0; n < 3; ++n)
+		freeNetwork(&networks[n]);
+
+	freeParameters(&params);
+	freeInputs(&inputs);
+}
+
+
 // 1 layer neural network for the logical gate 'AND':
 void test_AND(void)
 {
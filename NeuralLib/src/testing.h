@@ -13,10 +13,54 @@ void test_normalize(void);
 void test_Box_Muller(void);
 
 
+// Checking the seeding and splitting of random states, and comparing their speed to rand():
+void test_random_state(void);
+
+
 // Shuffle demo:
 void test_shuffle(void);
 
 
+// Comparing the built-in blocked matrix product to the naive one, for each transposition case:
+void test_matrix_multiply(void);
+
+
+// Comparing the vectorized activation kernels to the scalar functions:
+void test_activations(void);
+
+
+// Saving a network in a single file, and mapping it back:
+void test_network_file(void);
+
+
+// Predicting contiguous inputs in place, compared to the same inputs stored row by row:
+void test_contiguous_inputs(void);
+
+
+// Learning inputs streamed from the disk by chunks, compared to the same inputs learned from memory:
+void test_input_stream(void);
+
+
+// Int8 copy of a network shaped like Doc9000's one: speed, size and agreement with the full precision answers.
+void test_quantization(void);
+
+
+// Sparse first layer products, compared to the blocked ones on the same questions, for several numbers of non zero elements:
+void test_sparse_products(void);
+
+
+// Fused optimizer kernels, compared to the naive passes they replace, with a weight decay:
+void test_optimizers(void);
+
+
+// 16 bits conversions of edge values, then the same network learned with full precision, bfloat16 and float16 products:
+void test_mixed_precision(void);
+
+
+// Profiled learnings, with 1 and 2 threads. The profiling must not change the learned nets:
+void test_learning_profile(void);
+
+
 // 1 layer neural network for the logical gate 'AND':
 void test_AND(void);
 